@@ -0,0 +1,622 @@
+#include "matrix.h"
+
+// vctr
+#include "binary.h"
+#include "hnsw.h"
+#include "ivfpq.h"
+#include "knn.h"
+#include "vector.h"
+
+// std
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// benchmark
+#include <benchmark/benchmark.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+/**
+ * @brief Square matrices from 3x3 (9 elements) up to 10000x10000 (100M elements).
+*/
+void matrix_sizes(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t dimension : {3, 8, 32, 128, 512, 2048, 4096, 10000})
+    {
+        bench->Args({dimension, dimension});
+    }
+    bench->Unit(benchmark::kMicrosecond);
+}
+
+/**
+ * @brief Square matrices given by a single dimension argument, 16 up to 8192.
+*/
+void square_sizes(benchmark::internal::Benchmark* bench)
+{
+    bench->RangeMultiplier(4)->Range(16, 8192)->Unit(benchmark::kMicrosecond);
+}
+
+/**
+ * @brief Records the element throughput and the bytes touched per iteration.
+*/
+template<typename T>
+void set_throughput(benchmark::State& state, size_t matrices_touched)
+{
+    const int64_t elements = state.range(0) * state.range(1);
+    state.SetItemsProcessed(state.iterations() * elements);
+    state.SetBytesProcessed(state.iterations() * elements * matrices_touched * sizeof(T));
+}
+
+template<typename T>
+void BM_MatrixConstructDefaultValue(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        Matrix<T> m(state.range(0), state.range(1), T(1));
+        benchmark::DoNotOptimize(m);
+    }
+    set_throughput<T>(state, 1);
+}
+
+template<typename T>
+void BM_MatrixCopyConstruct(benchmark::State& state)
+{
+    Matrix<T> m(state.range(0), state.range(1), T(1));
+
+    for (auto _ : state)
+    {
+        Matrix<T> copy(m);
+        benchmark::DoNotOptimize(copy);
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_MatrixMoveConstruct(benchmark::State& state)
+{
+    Matrix<T> m(state.range(0), state.range(1), T(1));
+
+    for (auto _ : state)
+    {
+        Matrix<T> moved(std::move(m));
+        benchmark::DoNotOptimize(moved);
+        m = std::move(moved);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<typename T>
+void BM_MatrixConstructInitList(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        Matrix<T> m{
+            {T(1), T(2), T(3), T(4)},
+            {T(5), T(6), T(7), T(8)},
+            {T(9), T(10), T(11), T(12)},
+            {T(13), T(14), T(15), T(16)}};
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(state.iterations() * 16);
+}
+
+template<typename T>
+void BM_MatrixConstructVectors(benchmark::State& state)
+{
+    const Vector<T> row(state.range(1), T(1));
+
+    for (auto _ : state)
+    {
+        Matrix<T> m{row, row, row, row};
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(state.iterations() * 4 * state.range(1));
+}
+
+template<typename T>
+void BM_MatrixMultiply(benchmark::State& state)
+{
+    const size_t dimension = state.range(0);
+    Matrix<T> a(dimension, dimension, T(1));
+    Matrix<T> b(dimension, dimension, T(1));
+    Matrix<T> c(dimension, dimension, T(0));
+
+    for (auto _ : state)
+    {
+        gemm(T(1), a, b, T(0), c);
+        benchmark::ClobberMemory();
+    }
+    const double flops = 2.0 * dimension * dimension * dimension;
+    state.counters["flops"] = benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+template<typename T>
+void BM_MatrixVectorMultiply(benchmark::State& state)
+{
+    const size_t dimension = state.range(0);
+    Matrix<T> a(dimension, dimension, T(1));
+    Vector<T> x(dimension, T(1));
+
+    for (auto _ : state)
+    {
+        Vector<T> y = a * x;
+        benchmark::DoNotOptimize(y);
+    }
+    state.SetBytesProcessed(state.iterations() * dimension * dimension * sizeof(T));
+}
+
+template<typename T>
+void BM_VectorMatrixMultiply(benchmark::State& state)
+{
+    const size_t dimension = state.range(0);
+    Matrix<T> a(dimension, dimension, T(1));
+    Vector<T> x(dimension, T(1));
+
+    for (auto _ : state)
+    {
+        Vector<T> y = x * a;
+        benchmark::DoNotOptimize(y);
+    }
+    state.SetBytesProcessed(state.iterations() * dimension * dimension * sizeof(T));
+}
+
+/**
+ * @brief Embedding-shaped batches: range(0) rows of range(1) columns.
+*/
+template<typename T>
+void BM_MatrixNormalizeRows(benchmark::State& state)
+{
+    Matrix<T> a(state.range(0), state.range(1), T(1));
+
+    for (auto _ : state)
+    {
+        normalize_rows(a);
+        benchmark::DoNotOptimize(a.data());
+    }
+    set_throughput<T>(state, 1);
+}
+
+/**
+ * @brief One query of range(1) dimensions against range(0) candidates, one
+ *        dot_product call per pair. The baseline for BM_DotProductBatch.
+*/
+template<typename T>
+void BM_DotProductPairs(benchmark::State& state)
+{
+    std::vector<Vector<T>> candidates(state.range(0), Vector<T>(state.range(1), T(1)));
+    Vector<T> query(state.range(1), T(1));
+    Vector<T> scores(state.range(0));
+
+    for (auto _ : state)
+    {
+        for(size_t i = 0; i < candidates.size(); ++i)
+        {
+            scores[i] = dot_product(query, candidates[i]);
+        }
+        benchmark::DoNotOptimize(scores.data());
+    }
+    set_throughput<T>(state, 1);
+}
+
+/**
+ * @brief Scores a query against every row of a matrix, through row views (1) or by
+ *        first copying each row into a Vector (0).
+*/
+template<typename T>
+void BM_DotProductRows(benchmark::State& state)
+{
+    const Matrix<T> candidates(state.range(0), state.range(1), T(1));
+    const Vector<T> query(state.range(1), T(1));
+    Vector<T> scores(state.range(0));
+    const bool use_views = state.range(2) == 1;
+
+    for (auto _ : state)
+    {
+        for(size_t i = 0; i < candidates.num_rows(); ++i)
+        {
+            scores[i] = use_views
+                ? dot_product(query, candidates.row(i))
+                : dot_product(query, Vector<T>(candidates.row(i)));
+        }
+        benchmark::DoNotOptimize(scores.data());
+    }
+    set_throughput<T>(state, 1);
+}
+
+/**
+ * @brief Dots every column of a matrix with the next one, through strided column
+ *        views (1) or by first copying each column into a Vector (0).
+*/
+template<typename T>
+void BM_DotProductCols(benchmark::State& state)
+{
+    const Matrix<T> m(state.range(0), state.range(1), T(1));
+    Vector<T> scores(m.num_cols());
+    const bool use_views = state.range(2) == 1;
+
+    for (auto _ : state)
+    {
+        for(size_t j = 0; j + 1 < m.num_cols(); ++j)
+        {
+            scores[j] = use_views
+                ? dot_product(m.col(j), m.col(j + 1))
+                : dot_product(Vector<T>(m.col(j)), Vector<T>(m.col(j + 1)));
+        }
+        benchmark::DoNotOptimize(scores.data());
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_DotProductBatch(benchmark::State& state)
+{
+    Matrix<T> candidates(state.range(0), state.range(1), T(1));
+    Vector<T> query(state.range(1), T(1));
+    Vector<T> scores(state.range(0));
+
+    for (auto _ : state)
+    {
+        dot_product_batch(query, candidates, scores);
+        benchmark::DoNotOptimize(scores.data());
+    }
+    set_throughput<T>(state, 1);
+}
+
+/**
+ * @brief range(0) queries against 50000 candidates of 256 dimensions.
+*/
+template<typename T>
+void BM_DotProductBatchManyToMany(benchmark::State& state)
+{
+    Matrix<T> queries(state.range(0), 256, T(1));
+    Matrix<T> candidates(50000, 256, T(1));
+    Matrix<T> scores(state.range(0), 50000, T(0));
+
+    for (auto _ : state)
+    {
+        dot_product_batch(queries, candidates, scores);
+        benchmark::DoNotOptimize(scores.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 50000);
+}
+
+/**
+ * @brief A KnnIndex of range(0) rows of 256 dimensions, filled with a fixed pattern
+ *        so the top-k heaps see distinct scores.
+*/
+template<typename T>
+KnnIndex<T> knn_index(size_t rows)
+{
+    Matrix<T> m(rows, 256, T(0));
+    for(size_t i = 0; i < rows; ++i)
+    {
+        for(size_t j = 0; j < 256; ++j)
+        {
+            m(i, j) = static_cast<T>((i * 7919 + j * 31) % 101) / T(101);
+        }
+    }
+    KnnIndex<T> index(256);
+    index.add(m);
+    return index;
+}
+
+/**
+ * @brief Top 10 of range(0) rows for one query.
+*/
+template<typename T>
+void BM_KnnSearch(benchmark::State& state)
+{
+    const KnnIndex<T> index = knn_index<T>(state.range(0));
+    Vector<T> query(256, T(0.5));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(index.search(query, 10));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief Top 10 of 50000 rows for each of range(0) queries.
+*/
+template<typename T>
+void BM_KnnSearchBatch(benchmark::State& state)
+{
+    const KnnIndex<T> index = knn_index<T>(50000);
+    Matrix<T> queries(state.range(0), 256, T(0.5));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(index.search(queries, 10));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 50000);
+}
+
+/**
+ * @brief 20000 rows and 100 queries of 64 random dimensions, with the exact top 10
+ *        of every query, shared by the approximate-search benchmarks.
+*/
+struct AnnDataset
+{
+    Matrix<float> rows;
+    Matrix<float> queries;
+    std::vector<std::vector<Neighbor<float>>> exact;
+
+    static const AnnDataset& get()
+    {
+        static const AnnDataset dataset;
+        return dataset;
+    }
+
+private:
+    AnnDataset()
+        : rows(20000, 64, 0.0f)
+        , queries(100, 64, 0.0f)
+    {
+        std::mt19937 rng(1);
+        std::normal_distribution<float> dist;
+        for(size_t i = 0; i < rows.num_rows(); ++i)
+        {
+            for(size_t j = 0; j < 64; ++j)
+            {
+                rows(i, j) = dist(rng);
+            }
+        }
+        for(size_t i = 0; i < queries.num_rows(); ++i)
+        {
+            for(size_t j = 0; j < 64; ++j)
+            {
+                queries(i, j) = dist(rng);
+            }
+        }
+        KnnIndex<float> index(64);
+        index.add(rows);
+        exact = index.search(queries, 10);
+    }
+};
+
+/**
+ * @brief Builds an HNSW graph (M = 16, efConstruction = 100) over the AnnDataset rows.
+*/
+void BM_HnswBuild(benchmark::State& state)
+{
+    const AnnDataset& dataset = AnnDataset::get();
+    HnswOptions options;
+    options.efConstruction = 100;
+
+    for (auto _ : state)
+    {
+        HnswIndex<float> index(64, Metric::SquaredL2, options);
+        index.add(dataset.rows);
+        benchmark::DoNotOptimize(index.size());
+    }
+    state.SetItemsProcessed(state.iterations() * dataset.rows.num_rows());
+}
+
+/**
+ * @brief Top 10 of the AnnDataset queries from an HNSW graph with efSearch =
+ *        range(0), one query at a time. items_per_second is queries per second,
+ *        and recall the fraction of the exact top 10 found; compare with
+ *        BM_AnnBruteForce.
+*/
+void BM_HnswSearch(benchmark::State& state)
+{
+    const AnnDataset& dataset = AnnDataset::get();
+    static const HnswIndex<float>& index = [&dataset]() -> const HnswIndex<float>& {
+        HnswOptions options;
+        options.efConstruction = 100;
+        static HnswIndex<float> built(64, Metric::SquaredL2, options);
+        built.add(dataset.rows);
+        return built;
+    }();
+
+    std::vector<std::vector<Neighbor<float>>> results(dataset.queries.num_rows());
+    for (auto _ : state)
+    {
+        for(size_t q = 0; q < dataset.queries.num_rows(); ++q)
+        {
+            Vector<float> query(64);
+            std::copy(&dataset.queries(q, 0), &dataset.queries(q, 0) + 64, query.data());
+            results[q] = index.search(query, 10, state.range(0));
+        }
+    }
+
+    size_t hits = 0;
+    for(size_t q = 0; q < results.size(); ++q)
+    {
+        for(const Neighbor<float>& expected : dataset.exact[q])
+        {
+            hits += std::any_of(results[q].begin(), results[q].end(), [&expected](const Neighbor<float>& n) {
+                return n.index == expected.index;
+            });
+        }
+    }
+    state.counters["recall"] = static_cast<double>(hits) / (10.0 * results.size());
+    state.SetItemsProcessed(state.iterations() * dataset.queries.num_rows());
+}
+
+/**
+ * @brief Exact top 10 of the AnnDataset queries with KnnIndex, one query at a time:
+ *        the recall 1 baseline for BM_HnswSearch.
+*/
+void BM_AnnBruteForce(benchmark::State& state)
+{
+    const AnnDataset& dataset = AnnDataset::get();
+    KnnIndex<float> index(64);
+    index.add(dataset.rows);
+
+    for (auto _ : state)
+    {
+        for(size_t q = 0; q < dataset.queries.num_rows(); ++q)
+        {
+            Vector<float> query(64);
+            std::copy(&dataset.queries(q, 0), &dataset.queries(q, 0) + 64, query.data());
+            benchmark::DoNotOptimize(index.search(query, 10));
+        }
+    }
+    state.counters["recall"] = 1.0;
+    state.SetItemsProcessed(state.iterations() * dataset.queries.num_rows());
+}
+
+/**
+ * @brief Top 10 of the AnnDataset queries from an IVF-PQ index (256 lists, 32
+ *        subquantizers, so 16 bytes a vector) scanning range(0) lists per query.
+ *        Reports recall and queries per second like BM_HnswSearch.
+*/
+void BM_IvfPqSearch(benchmark::State& state)
+{
+    const AnnDataset& dataset = AnnDataset::get();
+    static const IvfPqIndex<float>& index = [&dataset]() -> const IvfPqIndex<float>& {
+        IvfPqOptions options;
+        options.numLists = 256;
+        options.numSubquantizers = 32;
+        static IvfPqIndex<float> built(64, options);
+        built.train(dataset.rows);
+        built.add(dataset.rows);
+        return built;
+    }();
+
+    std::vector<std::vector<Neighbor<float>>> results(dataset.queries.num_rows());
+    for (auto _ : state)
+    {
+        for(size_t q = 0; q < dataset.queries.num_rows(); ++q)
+        {
+            Vector<float> query(64);
+            std::copy(&dataset.queries(q, 0), &dataset.queries(q, 0) + 64, query.data());
+            results[q] = index.search(query, 10, state.range(0));
+        }
+    }
+
+    size_t hits = 0;
+    for(size_t q = 0; q < results.size(); ++q)
+    {
+        for(const Neighbor<float>& expected : dataset.exact[q])
+        {
+            hits += std::any_of(results[q].begin(), results[q].end(), [&expected](const Neighbor<float>& n) {
+                return n.index == expected.index;
+            });
+        }
+    }
+    state.counters["recall"] = static_cast<double>(hits) / (10.0 * results.size());
+    state.SetItemsProcessed(state.iterations() * dataset.queries.num_rows());
+}
+
+/**
+ * @brief simd::pq4_scan over 100000 codes of range(0) subquantizers.
+*/
+void BM_Pq4Scan(benchmark::State& state)
+{
+    const size_t num_blocks = 100000 / simd::Pq4Constants::blockSize;
+    const size_t num_subquantizers = state.range(0);
+    std::vector<uint8_t> codes(num_blocks * num_subquantizers * simd::Pq4Constants::bytesPerSubquantizer);
+    std::vector<uint8_t> luts(num_subquantizers * 16);
+    for(size_t i = 0; i < codes.size(); ++i)
+    {
+        codes[i] = static_cast<uint8_t>(i * 7919);
+    }
+    for(size_t i = 0; i < luts.size(); ++i)
+    {
+        luts[i] = static_cast<uint8_t>(i * 31 % 17);
+    }
+    std::vector<uint16_t> sums(num_blocks * simd::Pq4Constants::blockSize);
+
+    for (auto _ : state)
+    {
+        simd::pq4_scan(codes.data(), num_blocks, num_subquantizers, luts.data(), sums.data());
+        benchmark::DoNotOptimize(sums.data());
+    }
+    state.SetItemsProcessed(state.iterations() * sums.size());
+}
+
+/**
+ * @brief One query of range(0) bits against 100k packed signatures, with the
+ *        popcount kernels (range(1) == 1) or the word-by-word loop.
+*/
+void BM_HammingBatch(benchmark::State& state)
+{
+    const size_t bits = state.range(0);
+    BinaryMatrix candidates(100000, bits);
+    for(size_t r = 0; r < candidates.num_rows(); ++r)
+    {
+        for(size_t i = 0; i < bits; ++i)
+        {
+            candidates.set(r, i, (r * 7919 + i * 31) % 3 == 0);
+        }
+    }
+    const BinaryVector query = BinaryVector::from_signs(Vector<float>(bits, 1.0f));
+    Vector<uint32_t> distances(candidates.num_rows());
+    const ExecutionPolicy& policy = state.range(1) == 1 ? execution::simd : execution::seq;
+
+    for (auto _ : state)
+    {
+        hamming_distance_batch(policy, query, candidates, distances);
+        benchmark::DoNotOptimize(distances.data());
+    }
+    state.SetItemsProcessed(state.iterations() * candidates.num_rows());
+    state.SetBytesProcessed(state.iterations() * candidates.num_rows() * candidates.words_per_row() * sizeof(uint64_t));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_MatrixConstructDefaultValue, int)->Apply(matrix_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixConstructDefaultValue, float)->Apply(matrix_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixConstructDefaultValue, double)->Apply(matrix_sizes);
+
+BENCHMARK_TEMPLATE(BM_MatrixCopyConstruct, int)->Apply(matrix_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixCopyConstruct, float)->Apply(matrix_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixCopyConstruct, double)->Apply(matrix_sizes);
+
+BENCHMARK_TEMPLATE(BM_MatrixMoveConstruct, int)->Apply(matrix_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixMoveConstruct, float)->Apply(matrix_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixMoveConstruct, double)->Apply(matrix_sizes);
+
+BENCHMARK_TEMPLATE(BM_MatrixMultiply, float)->RangeMultiplier(2)->Range(16, 2048)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultiply, double)->RangeMultiplier(2)->Range(16, 2048)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultiply, int)->RangeMultiplier(2)->Range(16, 512)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_MatrixVectorMultiply, float)->Apply(square_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixVectorMultiply, double)->Apply(square_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixVectorMultiply, int)->Apply(square_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorMatrixMultiply, float)->Apply(square_sizes);
+BENCHMARK_TEMPLATE(BM_VectorMatrixMultiply, double)->Apply(square_sizes);
+BENCHMARK_TEMPLATE(BM_VectorMatrixMultiply, int)->Apply(square_sizes);
+
+BENCHMARK_TEMPLATE(BM_MatrixNormalizeRows, float)->ArgsProduct({{1000, 100000}, {128, 768}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_MatrixNormalizeRows, double)->ArgsProduct({{1000, 100000}, {128, 768}})->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_TEMPLATE(BM_DotProductPairs, float)->ArgsProduct({{1000, 50000}, {256}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_DotProductRows, float)->ArgsProduct({{1000, 50000}, {256}, {0, 1}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_DotProductCols, float)->ArgsProduct({{1000, 50000}, {256}, {0, 1}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_DotProductBatch, float)->ArgsProduct({{1000, 50000}, {256}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_DotProductBatch, double)->ArgsProduct({{1000, 50000}, {256}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_DotProductBatchManyToMany, float)->RangeMultiplier(4)->Range(1, 256)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_KnnSearch, float)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_KnnSearchBatch, float)->RangeMultiplier(4)->Range(1, 256)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_HnswBuild)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_HnswSearch)->RangeMultiplier(2)->Range(10, 320)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AnnBruteForce)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IvfPqSearch)->RangeMultiplier(2)->Range(1, 64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Pq4Scan)->Arg(16)->Arg(64)->Arg(384)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_HammingBatch)->ArgsProduct({{256, 1024}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_TEMPLATE(BM_MatrixConstructInitList, int);
+BENCHMARK_TEMPLATE(BM_MatrixConstructInitList, float);
+BENCHMARK_TEMPLATE(BM_MatrixConstructInitList, double);
+
+BENCHMARK_TEMPLATE(BM_MatrixConstructVectors, int)->Apply(matrix_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixConstructVectors, float)->Apply(matrix_sizes);
+BENCHMARK_TEMPLATE(BM_MatrixConstructVectors, double)->Apply(matrix_sizes);
+
+} // vctr
+} // arondina
@@ -0,0 +1,388 @@
+#include "vector.h"
+
+// vctr
+#include "distance.h"
+#include "quantized.h"
+
+// std
+#include <cstdint>
+#include <utility>
+
+// benchmark
+#include <benchmark/benchmark.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+/**
+ * @brief Dimensions from 8 up to 100M elements, growing by a factor of 8.
+*/
+void vector_sizes(benchmark::internal::Benchmark* bench)
+{
+    bench->RangeMultiplier(8)->Range(8, 100'000'000)->Unit(benchmark::kMicrosecond);
+}
+
+/**
+ * @brief Records the element throughput and the bytes touched per iteration.
+*/
+template<typename T>
+void set_throughput(benchmark::State& state, size_t vectors_touched)
+{
+    const int64_t dimensions = state.range(0);
+    state.SetItemsProcessed(state.iterations() * dimensions);
+    state.SetBytesProcessed(state.iterations() * dimensions * vectors_touched * sizeof(T));
+}
+
+template<typename T>
+void BM_VectorAdd(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(3));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        Vector<T> result = v1 + v2;
+        benchmark::DoNotOptimize(result);
+    }
+    set_throughput<T>(state, 3);
+}
+
+template<typename T>
+void BM_VectorSubtract(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(3));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        Vector<T> result = v1 - v2;
+        benchmark::DoNotOptimize(result);
+    }
+    set_throughput<T>(state, 3);
+}
+
+template<typename T>
+void BM_VectorFusedExpression(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(3));
+    Vector<T> v2(state.range(0), T(1));
+    Vector<T> v3(state.range(0), T(2));
+
+    for (auto _ : state)
+    {
+        Vector<T> result = v1 + v2 - v3 * T(2);
+        benchmark::DoNotOptimize(result);
+    }
+    set_throughput<T>(state, 4);
+}
+
+template<typename T>
+void BM_VectorFusedUpdate(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(3));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        v1 = v1 + v2 - v2;
+        benchmark::ClobberMemory();
+    }
+    set_throughput<T>(state, 3);
+}
+
+template<typename T>
+void BM_VectorScale(benchmark::State& state)
+{
+    Vector<T> v(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        v.scale(1.0);
+        benchmark::ClobberMemory();
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_VectorAddAssign(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(1));
+    Vector<T> v2(state.range(0), T(0));
+
+    for (auto _ : state)
+    {
+        v1 += v2;
+        benchmark::ClobberMemory();
+    }
+    set_throughput<T>(state, 3);
+}
+
+template<typename T>
+void BM_VectorAxpy(benchmark::State& state)
+{
+    Vector<T> x(state.range(0), T(1));
+    Vector<T> y(state.range(0), T(0));
+
+    for (auto _ : state)
+    {
+        axpy(T(1), x, y);
+        benchmark::ClobberMemory();
+    }
+    set_throughput<T>(state, 3);
+}
+
+template<typename T>
+void BM_VectorMagnitude(benchmark::State& state)
+{
+    Vector<T> v(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v.magnitude());
+    }
+    set_throughput<T>(state, 1);
+}
+
+template<typename T>
+void BM_VectorNorm2(benchmark::State& state)
+{
+    Vector<T> v(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v.norm2());
+    }
+    set_throughput<T>(state, 1);
+}
+
+template<typename T>
+void BM_VectorDotProduct(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(1));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dot_product(v1, v2));
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_VectorDotProductCompensated(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(1));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dot_product(execution::compensated, v1, v2));
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_VectorDotProductWide(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(1));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dot_product<wide_accumulator_t<T>>(v1, v2));
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_VectorL2Distance(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(3));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(l2_distance(v1, v2));
+    }
+    set_throughput<T>(state, 2);
+}
+
+/**
+ * @brief Dot product on compact storage E, against BM_VectorDotProduct<float>.
+*/
+template<typename E>
+void BM_QuantizedDotProduct(benchmark::State& state)
+{
+    QuantizedVector<E> v1(Vector<float>(state.range(0), 0.5f));
+    QuantizedVector<E> v2(Vector<float>(state.range(0), 0.25f));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dot_product(v1, v2));
+    }
+    set_throughput<E>(state, 2);
+}
+
+template<typename E>
+void BM_QuantizedL2Distance(benchmark::State& state)
+{
+    QuantizedVector<E> v1(Vector<float>(state.range(0), 0.5f));
+    QuantizedVector<E> v2(Vector<float>(state.range(0), 0.25f));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(squared_l2_distance(v1, v2));
+    }
+    set_throughput<E>(state, 2);
+}
+
+/**
+ * @brief The same distance through a materialized difference, for comparison.
+*/
+template<typename T>
+void BM_VectorL2DistanceMaterialized(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(3));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(Vector<T>(v1 - v2).magnitude());
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_VectorCosineSimilarity(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(3));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cosine_similarity(v1, v2));
+    }
+    set_throughput<T>(state, 2);
+}
+
+/**
+ * @brief The same similarity from three separate reductions, for comparison.
+*/
+template<typename T>
+void BM_VectorCosineSimilarityThreePass(benchmark::State& state)
+{
+    Vector<T> v1(state.range(0), T(3));
+    Vector<T> v2(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dot_product(v1, v2) / (v1.magnitude() * v2.magnitude()));
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_VectorCopyConstruct(benchmark::State& state)
+{
+    Vector<T> v(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        Vector<T> copy(v);
+        benchmark::DoNotOptimize(copy);
+    }
+    set_throughput<T>(state, 2);
+}
+
+template<typename T>
+void BM_VectorMoveConstruct(benchmark::State& state)
+{
+    Vector<T> v(state.range(0), T(1));
+
+    for (auto _ : state)
+    {
+        Vector<T> moved(std::move(v));
+        benchmark::DoNotOptimize(moved);
+        v = std::move(moved);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_VectorAdd, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorAdd, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorAdd, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorSubtract, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorSubtract, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorSubtract, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorFusedExpression, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorFusedExpression, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorFusedExpression, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorFusedUpdate, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorFusedUpdate, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorFusedUpdate, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorScale, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorScale, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorScale, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorAddAssign, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorAddAssign, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorAddAssign, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorAxpy, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorAxpy, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorAxpy, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorMagnitude, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorMagnitude, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorMagnitude, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorNorm2, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorNorm2, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorDotProduct, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorDotProduct, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorDotProduct, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorDotProductCompensated, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorDotProductCompensated, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorDotProductWide, int8_t)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorDotProductWide, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorDotProductWide, float)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_QuantizedDotProduct, int8_t)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_QuantizedDotProduct, Float16)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_QuantizedDotProduct, BFloat16)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_QuantizedL2Distance, int8_t)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_QuantizedL2Distance, Float16)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_QuantizedL2Distance, BFloat16)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorL2Distance, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorL2Distance, double)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorL2DistanceMaterialized, float)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorCosineSimilarity, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorCosineSimilarity, double)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorCosineSimilarityThreePass, float)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorCopyConstruct, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorCopyConstruct, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorCopyConstruct, double)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_VectorMoveConstruct, int)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorMoveConstruct, float)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_VectorMoveConstruct, double)->Apply(vector_sizes);
+
+} // vctr
+} // arondina
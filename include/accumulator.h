@@ -0,0 +1,48 @@
+#ifndef INCLUDED_ARONDINA_VCTR_ACCUMULATOR
+#define INCLUDED_ARONDINA_VCTR_ACCUMULATOR
+
+// vctr
+
+// std
+#include <cstdint>
+#include <type_traits>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief The type a reduction over T accumulates in when it is asked to widen: sums
+ *        of products of small integers stay exact, and float keeps its data compact
+ *        in memory while summing in double. Types without a wider counterpart
+ *        accumulate in themselves.
+*/
+template<typename T>
+struct wide_accumulator
+{
+    using type = T;
+};
+
+template<> struct wide_accumulator<float> { using type = double; };
+template<> struct wide_accumulator<int8_t> { using type = int32_t; };
+template<> struct wide_accumulator<int16_t> { using type = int32_t; };
+template<> struct wide_accumulator<int32_t> { using type = int64_t; };
+template<> struct wide_accumulator<uint8_t> { using type = uint32_t; };
+template<> struct wide_accumulator<uint16_t> { using type = uint32_t; };
+template<> struct wide_accumulator<uint32_t> { using type = uint64_t; };
+
+template<typename T>
+using wide_accumulator_t = typename wide_accumulator<T>::type;
+
+/**
+ * @brief Acc, or T itself when Acc is void. Lets a reduction take the accumulator as
+ *        its first, defaulted template argument, e.g. dot_product<double>(v1, v2).
+*/
+template<typename Acc, typename T>
+using accumulator_t = std::conditional_t<std::is_void_v<Acc>, T, Acc>;
+
+} // vctr
+} // arondina
+
+#endif
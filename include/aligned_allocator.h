@@ -0,0 +1,73 @@
+#ifndef INCLUDED_ARONDINA_VCTR_ALIGNED_ALLOCATOR
+#define INCLUDED_ARONDINA_VCTR_ALIGNED_ALLOCATOR
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief Stateless standard allocator that returns storage aligned to at least
+ *        Alignment bytes (and never less than alignof(T)). Any two instances are
+ *        interchangeable.
+*/
+template<typename T, size_t Alignment>
+class AlignedAllocator
+{
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    static constexpr size_t alignment = std::max(Alignment, alignof(T));
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        if(count > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignment)));
+    }
+
+    void deallocate(T* data, size_t) noexcept
+    {
+        ::operator delete(data, std::align_val_t(alignment));
+    }
+};
+
+template<typename T, typename U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&)
+{
+    return true;
+}
+
+template<typename T, typename U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&)
+{
+    return false;
+}
+
+} // vctr
+} // arondina
+
+#endif
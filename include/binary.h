@@ -0,0 +1,279 @@
+#ifndef INCLUDED_ARONDINA_VCTR_BINARY
+#define INCLUDED_ARONDINA_VCTR_BINARY
+
+// vctr
+#include "aligned_allocator.h"
+#include "calibration.h"
+#include "execution_policy.h"
+#include "matrix.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+namespace arondina
+{
+namespace vctr
+{
+
+struct BinaryConstants
+{
+    static constexpr size_t bitsPerWord = 64;
+};
+
+/**
+ * @brief A fixed-size string of bits, packed 64 to a word. Bit i lives in word i / 64
+ *        at position i % 64; the unused bits of the last word are always zero, so
+ *        the kernels can work on whole words.
+*/
+class BinaryVector
+{
+public:
+    /**
+     * @brief bits zero bits.
+    */
+    explicit BinaryVector(size_t bits)
+        : m_bits(bits)
+        , m_words(words_for(bits), 0)
+    {
+    }
+
+    BinaryVector(std::initializer_list<bool> list)
+        : BinaryVector(list.size())
+    {
+        size_t i = 0;
+        for(bool bit : list)
+        {
+            set(i++, bit);
+        }
+    }
+
+    /**
+     * @brief Sign hashing: bit i is set when v[i] > 0.
+    */
+    template<typename T, typename Alloc>
+    static BinaryVector from_signs(const Vector<T, Alloc>& v)
+    {
+        BinaryVector result(v.dimensions());
+        for(size_t i = 0; i < v.dimensions(); ++i)
+        {
+            result.set(i, v[i] > T(0));
+        }
+        return result;
+    }
+
+    size_t size() const { return m_bits; }
+
+    size_t num_words() const { return m_words.size(); }
+
+    const uint64_t* data() const { return m_words.data(); }
+
+    bool test(size_t i) const
+    {
+        return (m_words[i / BinaryConstants::bitsPerWord] >> (i % BinaryConstants::bitsPerWord)) & 1;
+    }
+
+    void set(size_t i, bool value = true)
+    {
+        const uint64_t mask = uint64_t(1) << (i % BinaryConstants::bitsPerWord);
+        uint64_t& word = m_words[i / BinaryConstants::bitsPerWord];
+        word = value ? word | mask : word & ~mask;
+    }
+
+    /**
+     * @brief The number of set bits.
+    */
+    size_t count() const
+    {
+        return simd::bit_counts(data(), data(), num_words()).both;
+    }
+
+    bool operator==(const BinaryVector& rhs) const
+    {
+        return m_bits == rhs.m_bits && m_words == rhs.m_words;
+    }
+
+    bool operator!=(const BinaryVector& rhs) const { return !(*this == rhs); }
+
+    static size_t words_for(size_t bits)
+    {
+        return (bits + BinaryConstants::bitsPerWord - 1) / BinaryConstants::bitsPerWord;
+    }
+
+private:
+    size_t m_bits;
+    std::vector<uint64_t, AlignedAllocator<uint64_t, VectorConstants::alignment>> m_words;
+};
+
+/**
+ * @brief num_rows bit strings of the same length, stored back to back: row r starts
+ *        at word r * words_per_row(). The collection side of a one-to-many scan.
+*/
+class BinaryMatrix
+{
+public:
+    BinaryMatrix(size_t num_rows, size_t bits)
+        : m_num_rows(num_rows)
+        , m_bits(bits)
+        , m_words_per_row(BinaryVector::words_for(bits))
+        , m_words(num_rows * m_words_per_row, 0)
+    {
+    }
+
+    /**
+     * @brief Sign hashing of every row of m, see BinaryVector::from_signs.
+    */
+    template<typename T, typename Alloc>
+    static BinaryMatrix from_signs(const Matrix<T, Alloc>& m)
+    {
+        BinaryMatrix result(m.num_rows(), m.num_cols());
+        for(size_t r = 0; r < m.num_rows(); ++r)
+        {
+            for(size_t i = 0; i < m.num_cols(); ++i)
+            {
+                result.set(r, i, m(r, i) > T(0));
+            }
+        }
+        return result;
+    }
+
+    size_t num_rows() const { return m_num_rows; }
+
+    size_t bits() const { return m_bits; }
+
+    size_t words_per_row() const { return m_words_per_row; }
+
+    const uint64_t* data() const { return m_words.data(); }
+
+    bool test(size_t row, size_t i) const
+    {
+        return (m_words[row * m_words_per_row + i / BinaryConstants::bitsPerWord] >> (i % BinaryConstants::bitsPerWord)) & 1;
+    }
+
+    void set(size_t row, size_t i, bool value = true)
+    {
+        const uint64_t mask = uint64_t(1) << (i % BinaryConstants::bitsPerWord);
+        uint64_t& word = m_words[row * m_words_per_row + i / BinaryConstants::bitsPerWord];
+        word = value ? word | mask : word & ~mask;
+    }
+
+    /**
+     * @brief Overwrites row with v. Throws if the lengths differ.
+    */
+    void set_row(size_t row, const BinaryVector& v)
+    {
+        if(v.size() != m_bits)
+        {
+            throw std::runtime_error("binary vector length does not match the matrix.");
+        }
+        std::copy(v.data(), v.data() + m_words_per_row, m_words.begin() + row * m_words_per_row);
+    }
+
+private:
+    size_t m_num_rows;
+    size_t m_bits;
+    size_t m_words_per_row;
+    std::vector<uint64_t, AlignedAllocator<uint64_t, VectorConstants::alignment>> m_words;
+};
+
+/**
+ * @brief The number of positions at which a and b differ, popcount(a ^ b). Throws if
+ *        the lengths differ.
+*/
+inline size_t hamming_distance(const BinaryVector& a, const BinaryVector& b)
+{
+    if(a.size() != b.size())
+    {
+        throw std::runtime_error("unequal vector sizes.");
+    }
+    return simd::hamming_distance(a.data(), b.data(), a.num_words());
+}
+
+/**
+ * @brief |a & b| / |a | b|, counted in one pass over both; 1 when neither has a bit
+ *        set. Throws if the lengths differ.
+*/
+inline double jaccard_similarity(const BinaryVector& a, const BinaryVector& b)
+{
+    if(a.size() != b.size())
+    {
+        throw std::runtime_error("unequal vector sizes.");
+    }
+    const simd::BitCounts counts = simd::bit_counts(a.data(), b.data(), a.num_words());
+    return counts.either == 0 ? 1.0 : static_cast<double>(counts.both) / static_cast<double>(counts.either);
+}
+
+/**
+ * @brief The Hamming distance from query to every row of candidates into out, which
+ *        must already hold candidates.num_rows() elements. Throws if the lengths do
+ *        not line up.
+ *
+ *        Like dot_product_batch, dispatch and the parallel decision are made once for
+ *        the whole batch and each thread scans its block of rows with the query in
+ *        L1. Under the non-SIMD policies the rows are counted word by word.
+*/
+template<typename AllocOut>
+void hamming_distance_batch(
+    const ExecutionPolicy& policy
+    , const BinaryVector& query
+    , const BinaryMatrix& candidates
+    , Vector<uint32_t, AllocOut>& out)
+{
+    if(query.size() != candidates.bits())
+    {
+        throw std::runtime_error("mismatched matrix dimensions.");
+    }
+    if(out.dimensions() != candidates.num_rows())
+    {
+        throw std::runtime_error("output size does not match the number of candidates.");
+    }
+
+    const uint64_t* rows = candidates.data();
+    const size_t words = candidates.words_per_row();
+    const uint64_t* x = query.data();
+    uint32_t* distances = out.data();
+    const bool use_kernels = policy.uses_simd();
+    auto scan_block = [rows, words, x, distances, use_kernels](size_t begin, size_t end) {
+        if(use_kernels)
+        {
+            simd::hamming_distance_rows(rows + begin * words, words, end - begin, x, words, distances + begin);
+            return;
+        }
+        for(size_t r = begin; r < end; ++r)
+        {
+            uint64_t distance = 0;
+            for(size_t i = 0; i < words; ++i)
+            {
+                distance += simd::popcount(rows[r * words + i] ^ x[i]);
+            }
+            distances[r] = static_cast<uint32_t>(distance);
+        }
+    };
+
+    if(policy.is_parallel(candidates.num_rows() * words, max_dimensions_for_sequential<uint64_t>(Operation::DotProduct)))
+    {
+        parallel_for_blocks(policy.pool(), candidates.num_rows(), scan_block);
+    }
+    else
+    {
+        scan_block(0, candidates.num_rows());
+    }
+}
+
+template<typename AllocOut>
+void hamming_distance_batch(const BinaryVector& query, const BinaryMatrix& candidates, Vector<uint32_t, AllocOut>& out)
+{
+    hamming_distance_batch(execution::automatic, query, candidates, out);
+}
+
+} // vctr
+} // arondina
+
+#endif
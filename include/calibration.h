@@ -0,0 +1,109 @@
+#ifndef INCLUDED_ARONDINA_VCTR_CALIBRATION
+#define INCLUDED_ARONDINA_VCTR_CALIBRATION
+
+// vctr
+
+// std
+#include <cstddef>
+#include <type_traits>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief Operations that choose between a sequential and a parallel implementation.
+ *        Arithmetic covers operator+ and operator-.
+*/
+enum class Operation
+{
+    Arithmetic,
+    Scale,
+    Magnitude,
+    DotProduct
+};
+
+/**
+ * @brief Element types that get their own calibrated crossover.
+ *        Every other element type shares the Other slot.
+*/
+enum class ElementType
+{
+    Int,
+    Float,
+    Double,
+    Other
+};
+
+/**
+ * @brief Maps T onto its ElementType.
+*/
+template<typename T>
+constexpr ElementType element_type_of()
+{
+    if constexpr (std::is_same_v<T, int>)
+    {
+        return ElementType::Int;
+    }
+    else if constexpr (std::is_same_v<T, float>)
+    {
+        return ElementType::Float;
+    }
+    else if constexpr (std::is_same_v<T, double>)
+    {
+        return ElementType::Double;
+    }
+    else
+    {
+        return ElementType::Other;
+    }
+}
+
+/**
+ * @brief The largest number of dimensions for which operation is still run sequentially.
+ *        Until calibrate() is called this is the matching value from VectorConstants.
+*/
+size_t max_dimensions_for_sequential(Operation operation, ElementType type);
+
+/**
+ * @brief Convenience overload that deduces the ElementType from T.
+*/
+template<typename T>
+size_t max_dimensions_for_sequential(Operation operation)
+{
+    return max_dimensions_for_sequential(operation, element_type_of<T>());
+}
+
+/**
+ * @brief Overrides the crossover for one operation and element type.
+ *        0 always runs in parallel, SIZE_MAX never does.
+*/
+void set_max_dimensions_for_sequential(Operation operation, ElementType type, size_t dimensions);
+
+/**
+ * @brief Measures the sequential and parallel implementation of every operation for
+ *        int, float and double on this host and stores the size at which the parallel
+ *        version starts to win by a clear margin. If it never does, or the thread pool
+ *        has a single worker, the operation stays sequential.
+ *
+ *        Calibration temporarily rewrites the crossovers, so call it before starting
+ *        concurrent work. Setting the VCTR_CALIBRATE environment variable runs it once
+ *        at program startup.
+*/
+void calibrate();
+
+/**
+ * @brief Returns true once calibrate() has completed.
+*/
+bool is_calibrated();
+
+/**
+ * @brief Restores the defaults from VectorConstants and discards any calibration.
+*/
+void reset_calibration();
+
+} // vctr
+} // arondina
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef INCLUDED_ARONDINA_VCTR_DISTANCE
+#define INCLUDED_ARONDINA_VCTR_DISTANCE
+
+// vctr
+#include "calibration.h"
+#include "execution_policy.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector.h"
+
+// std
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief A running maximum that combines with +=, so the blocks of an L-infinity
+ *        distance reduce through sum_blocks like every other sum.
+*/
+template<typename T>
+struct Maximum
+{
+    T value = T();
+
+    Maximum& operator+=(const Maximum& rhs)
+    {
+        value = rhs.value > value ? rhs.value : value;
+        return *this;
+    }
+};
+
+/**
+ * @brief Reduces a and b to an R as policy asks: fn(a, b, n, use_kernels) reduces
+ *        one block of n elements of each, and the blocks are combined with +=. Every
+ *        metric below is a single pass over both vectors, split across threads above
+ *        the dot product crossover. Throws if the dimensions differ.
+*/
+template<typename R, typename T, typename AllocA, typename AllocB, typename Fn>
+R reduce_pair(const ExecutionPolicy& policy, const Vector<T, AllocA>& a, const Vector<T, AllocB>& b, Fn&& fn)
+{
+    if(a.dimensions() != b.dimensions())
+    {
+        throw std::runtime_error("unequal vector sizes.");
+    }
+
+    const T* a_data = a.data();
+    const T* b_data = b.data();
+    const bool use_kernels = policy.uses_simd();
+    return sum_blocks(
+        policy
+        , a.dimensions()
+        , max_dimensions_for_sequential<T>(Operation::DotProduct)
+        , R()
+        , [a_data, b_data, use_kernels, &fn](size_t begin, size_t end) {
+            return R(fn(a_data + begin, b_data + begin, end - begin, use_kernels));
+        });
+}
+
+/**
+ * @brief The L1 (Manhattan) distance, the sum of |a[i] - b[i]|.
+*/
+template<typename T, typename AllocA, typename AllocB>
+T l1_distance(const ExecutionPolicy& policy, const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return reduce_pair<T>(policy, a, b, [](const T* x, const T* y, size_t n, bool use_kernels) {
+        return use_kernels ? simd::sum_abs_difference(x, y, n) : simd::sum_abs_difference<T>(x, y, n);
+    });
+}
+
+template<typename T, typename AllocA, typename AllocB>
+T l1_distance(const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return l1_distance(execution::automatic, a, b);
+}
+
+/**
+ * @brief The squared L2 (Euclidean) distance, the sum of (a[i] - b[i])^2. Ranks
+ *        neighbours like l2_distance without the square root, and without the
+ *        temporary that (a - b).magnitude() would materialize.
+*/
+template<typename T, typename AllocA, typename AllocB>
+T squared_l2_distance(const ExecutionPolicy& policy, const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return reduce_pair<T>(policy, a, b, [](const T* x, const T* y, size_t n, bool use_kernels) {
+        return use_kernels ? simd::sum_squared_difference(x, y, n) : simd::sum_squared_difference<T>(x, y, n);
+    });
+}
+
+template<typename T, typename AllocA, typename AllocB>
+T squared_l2_distance(const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return squared_l2_distance(execution::automatic, a, b);
+}
+
+/**
+ * @brief The L2 (Euclidean) distance, the square root of squared_l2_distance.
+*/
+template<typename T, typename AllocA, typename AllocB>
+double l2_distance(const ExecutionPolicy& policy, const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return std::sqrt(static_cast<double>(squared_l2_distance(policy, a, b)));
+}
+
+template<typename T, typename AllocA, typename AllocB>
+double l2_distance(const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return l2_distance(execution::automatic, a, b);
+}
+
+/**
+ * @brief The L-infinity (Chebyshev) distance, the largest |a[i] - b[i]|.
+*/
+template<typename T, typename AllocA, typename AllocB>
+T linf_distance(const ExecutionPolicy& policy, const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return reduce_pair<Maximum<T>>(policy, a, b, [](const T* x, const T* y, size_t n, bool use_kernels) {
+        return Maximum<T>{use_kernels ? simd::max_abs_difference(x, y, n) : simd::max_abs_difference<T>(x, y, n)};
+    }).value;
+}
+
+template<typename T, typename AllocA, typename AllocB>
+T linf_distance(const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return linf_distance(execution::automatic, a, b);
+}
+
+/**
+ * @brief The cosine of the angle between a and b, a . b / (|a| |b|). The dot product
+ *        and both squared norms come out of one pass over the two vectors (see
+ *        simd::cosine_sums) instead of three. 0 when either vector is zero.
+*/
+template<typename T, typename AllocA, typename AllocB>
+double cosine_similarity(const ExecutionPolicy& policy, const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    const simd::CosineSums<T> sums = reduce_pair<simd::CosineSums<T>>(policy, a, b, [](const T* x, const T* y, size_t n, bool use_kernels) {
+        return use_kernels ? simd::cosine_sums(x, y, n) : simd::cosine_sums<T>(x, y, n);
+    });
+
+    // two square roots rather than one of the product, which could overflow
+    const double norms = std::sqrt(static_cast<double>(sums.squares_a)) * std::sqrt(static_cast<double>(sums.squares_b));
+    if(norms == 0.0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(sums.dot) / norms;
+}
+
+template<typename T, typename AllocA, typename AllocB>
+double cosine_similarity(const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return cosine_similarity(execution::automatic, a, b);
+}
+
+/**
+ * @brief 1 - cosine_similarity, in [0, 2].
+*/
+template<typename T, typename AllocA, typename AllocB>
+double cosine_distance(const ExecutionPolicy& policy, const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return 1.0 - cosine_similarity(policy, a, b);
+}
+
+template<typename T, typename AllocA, typename AllocB>
+double cosine_distance(const Vector<T, AllocA>& a, const Vector<T, AllocB>& b)
+{
+    return cosine_distance(execution::automatic, a, b);
+}
+
+} // vctr
+} // arondina
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef INCLUDED_ARONDINA_VCTR_EXECUTION_POLICY
+#define INCLUDED_ARONDINA_VCTR_EXECUTION_POLICY
+
+// vctr
+#include "thread_pool.h"
+
+// std
+#include <cstddef>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief How a single operation is carried out. Passed explicitly to an operation,
+ *        it overrides the calibrated sequential/parallel crossover for that call
+ *        only; nothing global changes.
+ *
+ *        Automatic  - the default: parallel above the crossover, SIMD kernels always.
+ *        Sequenced  - the calling thread only, plain loops.
+ *        Simd       - the calling thread only, hand-written SIMD kernels.
+ *        Parallel   - split across threads, plain loops in each block.
+ *        ParallelSimd - split across threads, SIMD kernels in each block.
+ *
+ *        The parallel modes run on pool() when one is given, otherwise on the
+ *        default pool (or oneTBB, see parallel.h).
+ *
+ *        Reductions (dot_product, magnitude) are Fast by default: blocks follow the
+ *        thread count, so floating-point results can differ in the last bits between
+ *        machines. Reproducible cuts them into fixed blocks combined in a fixed
+ *        pairwise tree with kernels that round identically on every instruction
+ *        set, so the result is bitwise identical whatever the mode, thread count or
+ *        CPU. Compensated carries the rounding error of every product and addition
+ *        alongside the sum (Dot2), for results about as accurate as computing in twice
+ *        the precision, at a few times the cost of Fast.
+*/
+class ExecutionPolicy
+{
+public:
+    enum class Mode
+    {
+        Automatic,
+        Sequenced,
+        Simd,
+        Parallel,
+        ParallelSimd
+    };
+
+    enum class Reduction
+    {
+        Fast,
+        Reproducible,
+        Compensated
+    };
+
+    constexpr ExecutionPolicy(Mode mode = Mode::Automatic, ThreadPool* pool = nullptr, Reduction reduction = Reduction::Fast)
+        : m_mode(mode)
+        , m_pool(pool)
+        , m_reduction(reduction)
+    {
+    }
+
+    constexpr Mode mode() const
+    {
+        return m_mode;
+    }
+
+    constexpr Reduction reduction() const
+    {
+        return m_reduction;
+    }
+
+    /**
+     * @brief The same policy with reproducible reductions, e.g. execution::par.reproducible().
+    */
+    constexpr ExecutionPolicy reproducible() const
+    {
+        return ExecutionPolicy(m_mode, m_pool, Reduction::Reproducible);
+    }
+
+    /**
+     * @brief The same policy with compensated reductions, e.g. execution::par.compensated().
+    */
+    constexpr ExecutionPolicy compensated() const
+    {
+        return ExecutionPolicy(m_mode, m_pool, Reduction::Compensated);
+    }
+
+    /**
+     * @brief The pool parallel work goes to, or nullptr for the default.
+    */
+    constexpr ThreadPool* pool() const
+    {
+        return m_pool;
+    }
+
+    /**
+     * @brief Whether an operation over n elements should be split across threads,
+     *        given the operation's sequential crossover for Automatic.
+    */
+    constexpr bool is_parallel(size_t n, size_t max_dimensions_for_sequential) const
+    {
+        switch(m_mode)
+        {
+            case Mode::Automatic:
+                return n > max_dimensions_for_sequential;
+            case Mode::Parallel:
+            case Mode::ParallelSimd:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Whether the hand-written kernels from simd.h may be used.
+    */
+    constexpr bool uses_simd() const
+    {
+        return m_mode != Mode::Sequenced && m_mode != Mode::Parallel;
+    }
+
+private:
+    Mode m_mode;
+    ThreadPool* m_pool;
+    Reduction m_reduction;
+};
+
+namespace execution
+{
+
+inline constexpr ExecutionPolicy automatic{ExecutionPolicy::Mode::Automatic};
+inline constexpr ExecutionPolicy seq{ExecutionPolicy::Mode::Sequenced};
+inline constexpr ExecutionPolicy simd{ExecutionPolicy::Mode::Simd};
+inline constexpr ExecutionPolicy par{ExecutionPolicy::Mode::Parallel};
+inline constexpr ExecutionPolicy par_simd{ExecutionPolicy::Mode::ParallelSimd};
+inline constexpr ExecutionPolicy reproducible = automatic.reproducible();
+inline constexpr ExecutionPolicy compensated = automatic.compensated();
+
+/**
+ * @brief Parallel SIMD execution on a caller-owned pool, e.g. one sized and pinned
+ *        for a batch job, so it does not compete with the default pool.
+*/
+inline ExecutionPolicy on(ThreadPool& pool)
+{
+    return ExecutionPolicy(ExecutionPolicy::Mode::ParallelSimd, &pool);
+}
+
+} // execution
+
+} // vctr
+} // arondina
+
+#endif
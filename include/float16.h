@@ -0,0 +1,131 @@
+#ifndef INCLUDED_ARONDINA_VCTR_FLOAT16
+#define INCLUDED_ARONDINA_VCTR_FLOAT16
+
+// std
+#include <cstdint>
+#include <cstring>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief An IEEE 754 binary16 value (1 sign, 5 exponent, 10 mantissa bits), kept as
+ *        its bit pattern. Storage only: convert to float to compute. Holds about
+ *        three significant digits up to 65504.
+*/
+struct Float16
+{
+    uint16_t bits;
+
+    /**
+     * @brief The nearest Float16 to value, ties to even. Values past the largest
+     *        finite Float16 become infinity and NaN stays NaN.
+    */
+    static Float16 from_float(float value)
+    {
+        uint32_t x;
+        std::memcpy(&x, &value, sizeof(x));
+        const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+        x &= 0x7FFFFFFF;
+
+        if(x >= 0x7F800000)
+        {
+            // infinity, or a quiet NaN
+            return {static_cast<uint16_t>(sign | (x > 0x7F800000 ? 0x7E00 : 0x7C00))};
+        }
+        if(x >= 0x477FF000)
+        {
+            // 65520 and above round past the largest finite value
+            return {static_cast<uint16_t>(sign | 0x7C00)};
+        }
+        if(x < 0x38800000)
+        {
+            // below 2^-14 the result is subnormal: adding 0.5 leaves the float's
+            // last place at 2^-24, so the addition itself rounds to the nearest
+            // Float16 step, ties to even
+            float magnitude;
+            std::memcpy(&magnitude, &x, sizeof(x));
+            const float shifted = magnitude + 0.5f;
+            uint32_t shifted_bits;
+            std::memcpy(&shifted_bits, &shifted, sizeof(shifted_bits));
+            return {static_cast<uint16_t>(sign | (shifted_bits - 0x3F000000))};
+        }
+
+        // rebias the exponent from 127 to 15 and round off 13 mantissa bits
+        const uint32_t odd = (x >> 13) & 1;
+        x += 0xC8000FFF + odd;
+        return {static_cast<uint16_t>(sign | (x >> 13))};
+    }
+
+    float to_float() const
+    {
+        const uint32_t sign = static_cast<uint32_t>(bits & 0x8000) << 16;
+        const uint32_t exponent = (bits >> 10) & 0x1F;
+        const uint32_t mantissa = bits & 0x3FF;
+
+        uint32_t x;
+        if(exponent == 0x1F)
+        {
+            x = sign | 0x7F800000 | (mantissa << 13);
+        }
+        else if(exponent == 0)
+        {
+            // zero or subnormal: mantissa * 2^-24, exact in float
+            const float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+            std::memcpy(&x, &magnitude, sizeof(x));
+            x |= sign;
+        }
+        else
+        {
+            x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &x, sizeof(value));
+        return value;
+    }
+
+    explicit operator float() const { return to_float(); }
+};
+
+/**
+ * @brief A bfloat16 value: the upper half of a float (1 sign, 8 exponent, 7 mantissa
+ *        bits), kept as its bit pattern. Same range as float with about two
+ *        significant digits; widening back to float is a shift.
+*/
+struct BFloat16
+{
+    uint16_t bits;
+
+    /**
+     * @brief The nearest BFloat16 to value, ties to even. NaN stays NaN.
+    */
+    static BFloat16 from_float(float value)
+    {
+        uint32_t x;
+        std::memcpy(&x, &value, sizeof(x));
+        if((x & 0x7FFFFFFF) > 0x7F800000)
+        {
+            return {static_cast<uint16_t>((x >> 16) | 0x0040)};
+        }
+        x += 0x7FFF + ((x >> 16) & 1);
+        return {static_cast<uint16_t>(x >> 16)};
+    }
+
+    float to_float() const
+    {
+        const uint32_t x = static_cast<uint32_t>(bits) << 16;
+        float value;
+        std::memcpy(&value, &x, sizeof(value));
+        return value;
+    }
+
+    explicit operator float() const { return to_float(); }
+};
+
+} // vctr
+} // arondina
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef INCLUDED_ARONDINA_VCTR_GEMM
+#define INCLUDED_ARONDINA_VCTR_GEMM
+
+// vctr
+#include "execution_policy.h"
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief Blocking parameters of the GEMM driver, in elements.
+ *        One packed mc x kc block of A is sized for L2, one kc-deep sliver of the
+ *        packed B panel for L1, and the whole kc x nc panel of B for L3.
+ *        mc and nc are multiples of every micro-kernel's tile size.
+*/
+struct GemmConstants
+{
+    static constexpr size_t mc = 120;
+    static constexpr size_t kc = 256;
+    static constexpr size_t nc = 3072;
+
+    /**
+     * @brief Products with m * n * k at or below this run on the calling thread only.
+    */
+    static constexpr double maxOperationsForSequential = 64.0 * 64.0 * 64.0;
+};
+
+/**
+ * @brief General matrix multiply on row-major buffers:
+ *        c = alpha * a * b + beta * c, with a m x k, b k x n and c m x n.
+ *        lda, ldb and ldc are the row strides of each buffer. When beta is zero,
+ *        c is not read, so it may hold garbage. c must not overlap a or b.
+ *
+ *        float, double, int32_t and int64_t use packed, cache-blocked panels and
+ *        register-tiled micro-kernels for the active instruction set (see simd.h),
+ *        split across threads over blocks of rows of c.
+*/
+void gemm(size_t m, size_t n, size_t k, float alpha, const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc);
+void gemm(size_t m, size_t n, size_t k, double alpha, const double* a, size_t lda, const double* b, size_t ldb, double beta, double* c, size_t ldc);
+void gemm(size_t m, size_t n, size_t k, int32_t alpha, const int32_t* a, size_t lda, const int32_t* b, size_t ldb, int32_t beta, int32_t* c, size_t ldc);
+void gemm(size_t m, size_t n, size_t k, int64_t alpha, const int64_t* a, size_t lda, const int64_t* b, size_t ldb, int64_t beta, int64_t* c, size_t ldc);
+
+/**
+ * @brief Reference implementation for every other element type.
+*/
+template<typename T>
+void gemm(size_t m, size_t n, size_t k, T alpha, const T* a, size_t lda, const T* b, size_t ldb, T beta, T* c, size_t ldc)
+{
+    for(size_t i = 0; i < m; ++i)
+    {
+        T* c_row = c + i * ldc;
+        for(size_t j = 0; j < n; ++j)
+        {
+            c_row[j] = beta == T(0) ? T(0) : beta * c_row[j];
+        }
+        for(size_t p = 0; p < k; ++p)
+        {
+            const T a_ip = alpha * a[i * lda + p];
+            const T* b_row = b + p * ldb;
+            for(size_t j = 0; j < n; ++j)
+            {
+                c_row[j] += a_ip * b_row[j];
+            }
+        }
+    }
+}
+
+/**
+ * @brief c = alpha * a * b^T + beta * c, with a m x k, b n x k and c m x n, all
+ *        row-major with row strides lda, ldb and ldc. Every c(i, j) is the dot
+ *        product of row i of a with row j of b, which is how many-to-many scoring is
+ *        laid out: b is never transposed in memory, its rows are read column by
+ *        column while the panels are packed, so it costs the same as gemm.
+ *
+ *        Splits blocks of rows of c across threads as policy asks, on its pool if
+ *        it has one. The packed micro-kernels are used whatever the policy.
+*/
+void gemm_transposed_b(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, float alpha, const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc);
+void gemm_transposed_b(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, double alpha, const double* a, size_t lda, const double* b, size_t ldb, double beta, double* c, size_t ldc);
+void gemm_transposed_b(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, int32_t alpha, const int32_t* a, size_t lda, const int32_t* b, size_t ldb, int32_t beta, int32_t* c, size_t ldc);
+void gemm_transposed_b(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, int64_t alpha, const int64_t* a, size_t lda, const int64_t* b, size_t ldb, int64_t beta, int64_t* c, size_t ldc);
+
+/**
+ * @brief Reference implementation for every other element type.
+*/
+template<typename T>
+void gemm_transposed_b(const ExecutionPolicy&, size_t m, size_t n, size_t k, T alpha, const T* a, size_t lda, const T* b, size_t ldb, T beta, T* c, size_t ldc)
+{
+    for(size_t i = 0; i < m; ++i)
+    {
+        const T* a_row = a + i * lda;
+        T* c_row = c + i * ldc;
+        for(size_t j = 0; j < n; ++j)
+        {
+            const T* b_row = b + j * ldb;
+            T sum = T(0);
+            for(size_t p = 0; p < k; ++p)
+            {
+                sum += a_row[p] * b_row[p];
+            }
+            c_row[j] = beta == T(0) ? alpha * sum : alpha * sum + beta * c_row[j];
+        }
+    }
+}
+
+} // vctr
+} // arondina
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef INCLUDED_ARONDINA_VCTR_GEMV
+#define INCLUDED_ARONDINA_VCTR_GEMV
+
+// vctr
+#include "calibration.h"
+#include "parallel.h"
+#include "simd.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+
+namespace arondina
+{
+namespace vctr
+{
+
+struct GemvConstants
+{
+    /**
+     * @brief Rows whose dot products are buffered before alpha and beta are applied.
+    */
+    static constexpr size_t rowBlock = 64;
+
+    /**
+     * @brief Width of the slice of y that gemv_transposed keeps in cache while it
+     *        streams every row of the matrix over it.
+    */
+    static constexpr size_t columnBlock = 2048;
+};
+
+/**
+ * @brief Matrix-vector product on a row-major buffer: y = alpha * a * x + beta * y,
+ *        with a m x n (row stride lda), x of length n and y of length m. When beta is
+ *        zero, y is not read.
+ *
+ *        Each row of a is read exactly once, four rows per pass over x, with the
+ *        dot-product kernels from simd.h. Blocks of rows are split across threads
+ *        once m * n exceeds the calibrated dot product crossover.
+*/
+template<typename T>
+void gemv(size_t m, size_t n, T alpha, const T* a, size_t lda, const T* x, T beta, T* y)
+{
+    auto rows_block = [=](size_t begin, size_t end) {
+        T dots[GemvConstants::rowBlock];
+        for(size_t row = begin; row < end; row += GemvConstants::rowBlock)
+        {
+            const size_t rows = std::min(GemvConstants::rowBlock, end - row);
+            simd::dot_rows(a + row * lda, lda, rows, x, n, dots);
+            for(size_t r = 0; r < rows; ++r)
+            {
+                y[row + r] = beta == T(0) ? alpha * dots[r] : alpha * dots[r] + beta * y[row + r];
+            }
+        }
+    };
+
+    if(m * n > max_dimensions_for_sequential<T>(Operation::DotProduct))
+    {
+        parallel_for_blocks(m, rows_block);
+    }
+    else
+    {
+        rows_block(0, m);
+    }
+}
+
+/**
+ * @brief Transposed matrix-vector product: y = alpha * a^T * x + beta * y, with a
+ *        m x n (row stride lda), x of length m and y of length n. When beta is zero,
+ *        y is not read.
+ *
+ *        Rows of a are accumulated into y four at a time with the axpy kernels from
+ *        simd.h. y is processed in column slices so the slice stays in cache while
+ *        the rows stream past it; slices are split across threads once m * n
+ *        exceeds the calibrated dot product crossover. Each element of a is still
+ *        read exactly once.
+*/
+template<typename T>
+void gemv_transposed(size_t m, size_t n, T alpha, const T* a, size_t lda, const T* x, T beta, T* y)
+{
+    auto columns_block = [=](size_t begin, size_t end) {
+        T alphas[4];
+        for(size_t col = begin; col < end; col += GemvConstants::columnBlock)
+        {
+            const size_t cols = std::min(GemvConstants::columnBlock, end - col);
+            T* y_slice = y + col;
+            for(size_t j = 0; j < cols; ++j)
+            {
+                y_slice[j] = beta == T(0) ? T(0) : beta * y_slice[j];
+            }
+            for(size_t row = 0; row < m; row += 4)
+            {
+                const size_t rows = std::min<size_t>(4, m - row);
+                for(size_t r = 0; r < rows; ++r)
+                {
+                    alphas[r] = alpha * x[row + r];
+                }
+                simd::axpy_rows(a + row * lda + col, lda, rows, alphas, cols, y_slice);
+            }
+        }
+    };
+
+    if(m * n > max_dimensions_for_sequential<T>(Operation::DotProduct))
+    {
+        parallel_for_blocks(n, columns_block);
+    }
+    else
+    {
+        columns_block(0, n);
+    }
+}
+
+} // vctr
+} // arondina
+
+#endif
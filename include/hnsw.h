@@ -0,0 +1,737 @@
+#ifndef INCLUDED_ARONDINA_VCTR_HNSW
+#define INCLUDED_ARONDINA_VCTR_HNSW
+
+// vctr
+#include "aligned_allocator.h"
+#include "execution_policy.h"
+#include "knn.h"
+#include "matrix.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace arondina
+{
+namespace vctr
+{
+
+struct HnswOptions
+{
+    /**
+     * @brief Links kept per node on the upper layers. Layer 0 keeps twice as many.
+    */
+    size_t M = 16;
+
+    /**
+     * @brief Candidates kept while looking for the neighbours of a new node. Larger
+     *        builds a better graph, more slowly.
+    */
+    size_t efConstruction = 200;
+
+    /**
+     * @brief Candidates kept while searching, raised to k when smaller. The
+     *        recall/speed knob of search; see HnswIndex::set_ef_search.
+    */
+    size_t efSearch = 64;
+
+    /**
+     * @brief Seed of the random layer assignment.
+    */
+    uint64_t seed = 100;
+};
+
+struct HnswConstants
+{
+    /**
+     * @brief Batches of at most this many rows, inserted or searched, stay on the
+     *        calling thread under execution::automatic.
+    */
+    static constexpr size_t maxBatchForSequential = 16;
+};
+
+/**
+ * @brief Approximate k-nearest-neighbour search over a Hierarchical Navigable Small
+ *        World graph (Malkov and Yashunin). Scores, metrics and result order are
+ *        those of KnnIndex.
+ *
+ *        Every node keeps its vector, padded to a whole number of
+ *        VectorConstants::alignment bytes, in one buffer from Alloc, and its layer-0
+ *        links in a second buffer of fixed-size records [count, 2M ids]. The few
+ *        nodes that reach the upper layers keep [count, M ids] per layer in a third
+ *        buffer. A search touches three flat arrays and no per-node allocations.
+ *
+ *        add(rows, policy) lays the storage for the whole batch out up front and
+ *        then inserts the rows in parallel, locking one node's links at a time.
+ *        search may run concurrently with other searches, but not with add.
+*/
+template<typename T, typename Alloc = AlignedAllocator<T, VectorConstants::alignment>>
+class HnswIndex
+{
+    static_assert(std::is_floating_point_v<T>, "HnswIndex needs a floating-point element type.");
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+
+    explicit HnswIndex(size_t dimensions, Metric metric = Metric::SquaredL2, const HnswOptions& options = HnswOptions(), const Alloc& allocator = Alloc())
+        : m_dimensions(dimensions)
+        , m_leading_dimension(index_leading_dimension<T>(dimensions))
+        , m_metric(metric)
+        , m_options(options)
+        , m_level_scale(options.M > 1 ? 1.0 / std::log(static_cast<double>(options.M)) : 0.0)
+        , m_rng(options.seed)
+        , m_data(allocator)
+    {
+        if(dimensions == 0)
+        {
+            throw std::runtime_error("hnsw index needs at least one dimension.");
+        }
+        if(options.M < 2)
+        {
+            throw std::runtime_error("hnsw index needs M of at least 2.");
+        }
+    }
+
+    size_t dimensions() const
+    {
+        return m_dimensions;
+    }
+
+    Metric metric() const
+    {
+        return m_metric;
+    }
+
+    const HnswOptions& options() const
+    {
+        return m_options;
+    }
+
+    /**
+     * @brief Number of rows in the index.
+    */
+    size_t size() const
+    {
+        return m_levels.size();
+    }
+
+    /**
+     * @brief Sets the default candidate list size of search. Not safe while another
+     *        thread is searching.
+    */
+    void set_ef_search(size_t ef)
+    {
+        m_options.efSearch = ef;
+    }
+
+    /**
+     * @brief Inserts a copy of v and returns its index. Throws if the dimensions do
+     *        not match.
+    */
+    template<typename VectorAlloc>
+    size_t add(const Vector<T, VectorAlloc>& v)
+    {
+        if(v.dimensions() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+        check_capacity(1);
+
+        const size_t index = stage(v.data());
+        insert(static_cast<id_type>(index));
+        return index;
+    }
+
+    /**
+     * @brief Inserts a copy of every row of rows, in parallel as policy asks, and
+     *        returns the index of the first. The graph built depends on the order the
+     *        threads get to the rows, so a parallel build is not reproducible.
+    */
+    template<typename MatrixAlloc>
+    size_t add(const Matrix<T, MatrixAlloc>& rows, const ExecutionPolicy& policy = execution::automatic)
+    {
+        if(rows.num_cols() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+        check_capacity(rows.num_rows());
+
+        const size_t first = size();
+        const size_t count = rows.num_rows();
+        m_data.reserve((first + count) * m_leading_dimension);
+        m_links0.reserve((first + count) * (1 + max_links(0)));
+        for(size_t i = 0; i < count; ++i)
+        {
+            stage(rows.data() + i * rows.leading_dimension());
+        }
+
+        size_t next = first;
+        if(m_max_level < 0 && count > 0)
+        {
+            // the first node only becomes the entry point; nothing to link it to
+            insert(static_cast<id_type>(next++));
+        }
+
+        const size_t remaining = first + count - next;
+        if(policy.is_parallel(remaining, HnswConstants::maxBatchForSequential))
+        {
+            parallel_for(policy.pool(), remaining, [this, next](size_t i) {
+                insert(static_cast<id_type>(next + i));
+            });
+        }
+        else
+        {
+            for(size_t i = 0; i < remaining; ++i)
+            {
+                insert(static_cast<id_type>(next + i));
+            }
+        }
+        return first;
+    }
+
+    /**
+     * @brief The min(k, size()) rows closest to query that the graph search finds,
+     *        best first, keeping max(ef, k) candidates.
+    */
+    template<typename VectorAlloc>
+    std::vector<Neighbor<T>> search(const Vector<T, VectorAlloc>& query, size_t k, size_t ef) const
+    {
+        if(query.dimensions() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+
+        Vector<T> prepared(query.dimensions());
+        std::copy(query.data(), query.data() + query.dimensions(), prepared.data());
+        if(m_metric == Metric::Cosine)
+        {
+            prepared.normalize(execution::simd);
+        }
+        return search_prepared(prepared.data(), k, ef);
+    }
+
+    /**
+     * @brief search(query, k, options().efSearch).
+    */
+    template<typename VectorAlloc>
+    std::vector<Neighbor<T>> search(const Vector<T, VectorAlloc>& query, size_t k) const
+    {
+        return search(query, k, m_options.efSearch);
+    }
+
+    /**
+     * @brief For every row of queries, search(row, k), the rows spread across threads
+     *        as policy asks.
+    */
+    template<typename MatrixAlloc>
+    std::vector<std::vector<Neighbor<T>>> search(const Matrix<T, MatrixAlloc>& queries, size_t k, const ExecutionPolicy& policy = execution::automatic) const
+    {
+        if(queries.num_cols() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+
+        const size_t num_queries = queries.num_rows();
+        Matrix<T> prepared(num_queries, m_dimensions, T(0), m_leading_dimension);
+        for(size_t i = 0; i < num_queries; ++i)
+        {
+            const T* row = queries.data() + i * queries.leading_dimension();
+            std::copy(row, row + m_dimensions, prepared.data() + i * m_leading_dimension);
+        }
+        if(m_metric == Metric::Cosine)
+        {
+            normalize_rows(prepared, policy);
+        }
+
+        std::vector<std::vector<Neighbor<T>>> results(num_queries);
+        const T* q = prepared.data();
+        auto search_query = [this, q, k, &results](size_t i) {
+            results[i] = search_prepared(q + i * m_leading_dimension, k, m_options.efSearch);
+        };
+        if(policy.is_parallel(num_queries, HnswConstants::maxBatchForSequential))
+        {
+            parallel_for(policy.pool(), num_queries, search_query);
+        }
+        else
+        {
+            for(size_t i = 0; i < num_queries; ++i)
+            {
+                search_query(i);
+            }
+        }
+        return results;
+    }
+
+private:
+    using id_type = uint32_t;
+
+    // (distance to the query, node), ordered by distance then node
+    using Candidate = std::pair<T, id_type>;
+
+    /**
+     * @brief Marks the nodes one search has seen. Clearing is a bump of the epoch, so
+     *        a set is reused across searches without touching its memory.
+    */
+    class VisitedSet
+    {
+    public:
+        void reset(size_t n)
+        {
+            if(m_tags.size() < n)
+            {
+                m_tags.resize(n, 0);
+            }
+            if(++m_epoch == 0)
+            {
+                std::fill(m_tags.begin(), m_tags.end(), 0);
+                m_epoch = 1;
+            }
+        }
+
+        /**
+         * @brief Marks node, returning whether it was unmarked.
+        */
+        bool insert(id_type node)
+        {
+            if(m_tags[node] == m_epoch)
+            {
+                return false;
+            }
+            m_tags[node] = m_epoch;
+            return true;
+        }
+
+    private:
+        std::vector<uint32_t> m_tags;
+        uint32_t m_epoch = 0;
+    };
+
+    /**
+     * @brief A VisitedSet borrowed from the index for the length of one search.
+    */
+    class VisitedLease
+    {
+    public:
+        explicit VisitedLease(const HnswIndex& index)
+            : m_index(index)
+        {
+            {
+                std::lock_guard<std::mutex> lock(index.m_visited_lock);
+                if(!index.m_visited.empty())
+                {
+                    m_set = std::move(index.m_visited.back());
+                    index.m_visited.pop_back();
+                }
+            }
+            if(!m_set)
+            {
+                m_set = std::make_unique<VisitedSet>();
+            }
+            m_set->reset(index.size());
+        }
+
+        ~VisitedLease()
+        {
+            std::lock_guard<std::mutex> lock(m_index.m_visited_lock);
+            m_index.m_visited.push_back(std::move(m_set));
+        }
+
+        VisitedLease(const VisitedLease&) = delete;
+        VisitedLease& operator=(const VisitedLease&) = delete;
+
+        VisitedSet& operator*() const
+        {
+            return *m_set;
+        }
+
+        VisitedSet* operator->() const
+        {
+            return m_set.get();
+        }
+
+    private:
+        const HnswIndex& m_index;
+        std::unique_ptr<VisitedSet> m_set;
+    };
+
+    size_t m_dimensions;
+    size_t m_leading_dimension;
+    Metric m_metric;
+    HnswOptions m_options;
+    double m_level_scale;
+    std::mt19937_64 m_rng;
+
+    // rows, leading dimension apart
+    std::vector<T, Alloc> m_data;
+    // top layer of every node
+    std::vector<int> m_levels;
+    // per node: [count, max_links(0) ids]
+    std::vector<id_type> m_links0;
+    // per node, where its layers 1..level start in m_upper
+    std::vector<size_t> m_upper_offsets;
+    // per node and layer above 0: [count, max_links(layer) ids]
+    std::vector<id_type> m_upper;
+    // guards the links of one node during add; a deque never moves its elements
+    mutable std::deque<std::mutex> m_node_locks;
+
+    std::mutex m_entry_lock;
+    id_type m_entry = 0;
+    int m_max_level = -1;
+
+    mutable std::mutex m_visited_lock;
+    mutable std::vector<std::unique_ptr<VisitedSet>> m_visited;
+
+    size_t max_links(int level) const
+    {
+        return level == 0 ? 2 * m_options.M : m_options.M;
+    }
+
+    const T* row(id_type node) const
+    {
+        return m_data.data() + static_cast<size_t>(node) * m_leading_dimension;
+    }
+
+    id_type* links(id_type node, int level)
+    {
+        if(level == 0)
+        {
+            return m_links0.data() + static_cast<size_t>(node) * (1 + max_links(0));
+        }
+        return m_upper.data() + m_upper_offsets[node] + static_cast<size_t>(level - 1) * (1 + max_links(level));
+    }
+
+    const id_type* links(id_type node, int level) const
+    {
+        return const_cast<HnswIndex*>(this)->links(node, level);
+    }
+
+    /**
+     * @brief The distance used inside the graph, smaller is closer: the squared L2
+     *        distance or the negated dot product.
+    */
+    T distance(const T* a, const T* b) const
+    {
+        if(m_metric == Metric::SquaredL2)
+        {
+            return simd::sum_squared_difference(a, b, m_dimensions);
+        }
+        return -dot_block<T>(a, b, m_dimensions, true);
+    }
+
+    void check_capacity(size_t count) const
+    {
+        if(size() + count > std::numeric_limits<id_type>::max())
+        {
+            throw std::runtime_error("hnsw index is full.");
+        }
+    }
+
+    /**
+     * @brief Copies a row in and gives it a layer and empty link lists, without
+     *        linking it into the graph.
+    */
+    size_t stage(const T* source)
+    {
+        const size_t index = size();
+        m_data.resize(m_data.size() + m_leading_dimension, T(0));
+        T* dest = m_data.data() + index * m_leading_dimension;
+        std::copy(source, source + m_dimensions, dest);
+        prepare_index_row(dest, m_dimensions, m_metric);
+
+        // P(level >= l) = M^-l
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        const int level = static_cast<int>(-std::log(1.0 - uniform(m_rng)) * m_level_scale);
+
+        m_levels.push_back(level);
+        m_links0.resize(m_links0.size() + 1 + max_links(0), 0);
+        m_upper_offsets.push_back(m_upper.size());
+        m_upper.resize(m_upper.size() + static_cast<size_t>(level) * (1 + max_links(1)), 0);
+        m_node_locks.emplace_back();
+        return index;
+    }
+
+    /**
+     * @brief The links of node on level as (first id, count). While add may be
+     *        writing them (Locked) they are copied into buffer under the node's lock;
+     *        otherwise they are read in place.
+    */
+    template<bool Locked>
+    std::pair<const id_type*, id_type> read_links(id_type node, int level, std::vector<id_type>& buffer) const
+    {
+        const id_type* list = links(node, level);
+        if constexpr (Locked)
+        {
+            std::lock_guard<std::mutex> lock(m_node_locks[node]);
+            buffer.assign(list + 1, list + 1 + list[0]);
+            return {buffer.data(), static_cast<id_type>(buffer.size())};
+        }
+        else
+        {
+            return {list + 1, list[0]};
+        }
+    }
+
+    /**
+     * @brief Greedy walk from entry through the layers above to_level, moving to a
+     *        closer neighbour while there is one. Returns the node it stops at.
+    */
+    template<bool Locked>
+    id_type descend(const T* q, id_type entry, int from_level, int to_level) const
+    {
+        T best = distance(q, row(entry));
+        std::vector<id_type> buffer;
+        for(int level = from_level; level > to_level; --level)
+        {
+            bool moved = true;
+            while(moved)
+            {
+                moved = false;
+                const auto [ids, count] = read_links<Locked>(entry, level, buffer);
+                for(id_type i = 0; i < count; ++i)
+                {
+                    const id_type neighbor = ids[i];
+                    const T d = distance(q, row(neighbor));
+                    if(d < best)
+                    {
+                        best = d;
+                        entry = neighbor;
+                        moved = true;
+                    }
+                }
+            }
+        }
+        return entry;
+    }
+
+    /**
+     * @brief Best-first search of one layer from entry, keeping the ef closest nodes
+     *        found. Returns them in no particular order.
+    */
+    template<bool Locked>
+    std::vector<Candidate> search_layer(const T* q, id_type entry, size_t ef, int level) const
+    {
+        VisitedLease visited(*this);
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+        // max-heap, the furthest of the ef closest at the front
+        std::vector<Candidate> found;
+        found.reserve(ef + 1);
+
+        const Candidate start{distance(q, row(entry)), entry};
+        visited->insert(entry);
+        candidates.push(start);
+        found.push_back(start);
+
+        std::vector<id_type> buffer;
+        while(!candidates.empty())
+        {
+            const Candidate closest = candidates.top();
+            if(found.size() >= ef && closest.first > found.front().first)
+            {
+                break;
+            }
+            candidates.pop();
+
+            const auto [ids, count] = read_links<Locked>(closest.second, level, buffer);
+            for(id_type i = 0; i < count; ++i)
+            {
+                const id_type neighbor = ids[i];
+                if(!visited->insert(neighbor))
+                {
+                    continue;
+                }
+                const T d = distance(q, row(neighbor));
+                if(found.size() < ef || d < found.front().first)
+                {
+                    candidates.push({d, neighbor});
+                    found.push_back({d, neighbor});
+                    std::push_heap(found.begin(), found.end());
+                    if(found.size() > ef)
+                    {
+                        std::pop_heap(found.begin(), found.end());
+                        found.pop_back();
+                    }
+                }
+            }
+        }
+        return found;
+    }
+
+    /**
+     * @brief Up to max of candidates (distances to a common base), closest first,
+     *        skipping any that is closer to an already selected one than to the base.
+     *        Keeps the links spread out in different directions rather than bunched
+     *        in one cluster.
+    */
+    std::vector<Candidate> select_neighbors(std::vector<Candidate> candidates, size_t max) const
+    {
+        std::sort(candidates.begin(), candidates.end());
+        if(candidates.size() <= max)
+        {
+            return candidates;
+        }
+
+        std::vector<Candidate> selected;
+        selected.reserve(max);
+        for(const Candidate& candidate : candidates)
+        {
+            if(selected.size() == max)
+            {
+                break;
+            }
+            bool keep = true;
+            for(const Candidate& other : selected)
+            {
+                if(distance(row(candidate.second), row(other.second)) < candidate.first)
+                {
+                    keep = false;
+                    break;
+                }
+            }
+            if(keep)
+            {
+                selected.push_back(candidate);
+            }
+        }
+        return selected;
+    }
+
+    /**
+     * @brief Points node at selected on level and each of selected back at node,
+     *        pruning a full list of a neighbour with select_neighbors.
+    */
+    void link(id_type node, const std::vector<Candidate>& selected, int level)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_node_locks[node]);
+            id_type* list = links(node, level);
+            list[0] = static_cast<id_type>(selected.size());
+            for(size_t i = 0; i < selected.size(); ++i)
+            {
+                list[1 + i] = selected[i].second;
+            }
+        }
+
+        const size_t max = max_links(level);
+        for(const Candidate& neighbor : selected)
+        {
+            std::lock_guard<std::mutex> lock(m_node_locks[neighbor.second]);
+            id_type* list = links(neighbor.second, level);
+            const id_type count = list[0];
+            if(std::find(list + 1, list + 1 + count, node) != list + 1 + count)
+            {
+                continue;
+            }
+            if(count < max)
+            {
+                list[1 + count] = node;
+                list[0] = count + 1;
+                continue;
+            }
+
+            std::vector<Candidate> candidates;
+            candidates.reserve(count + 1);
+            candidates.push_back({neighbor.first, node});
+            for(id_type i = 0; i < count; ++i)
+            {
+                candidates.push_back({distance(row(neighbor.second), row(list[1 + i])), list[1 + i]});
+            }
+            const std::vector<Candidate> pruned = select_neighbors(std::move(candidates), max);
+            list[0] = static_cast<id_type>(pruned.size());
+            for(size_t i = 0; i < pruned.size(); ++i)
+            {
+                list[1 + i] = pruned[i].second;
+            }
+        }
+    }
+
+    void insert(id_type node)
+    {
+        const int level = m_levels[node];
+        const T* q = row(node);
+
+        // a node that opens a new top layer keeps the entry point locked until it
+        // has been linked and can take over as the entry point
+        std::unique_lock<std::mutex> entry_lock(m_entry_lock);
+        if(m_max_level < 0)
+        {
+            m_entry = node;
+            m_max_level = level;
+            return;
+        }
+        const id_type entry = m_entry;
+        const int max_level = m_max_level;
+        if(level <= max_level)
+        {
+            entry_lock.unlock();
+        }
+
+        id_type current = descend<true>(q, entry, max_level, level);
+        for(int l = std::min(level, max_level); l >= 0; --l)
+        {
+            std::vector<Candidate> found = search_layer<true>(q, current, m_options.efConstruction, l);
+            // another thread may already have linked node to a neighbour
+            found.erase(std::remove_if(found.begin(), found.end(), [node](const Candidate& c) { return c.second == node; }), found.end());
+            if(found.empty())
+            {
+                continue;
+            }
+
+            const std::vector<Candidate> selected = select_neighbors(std::move(found), m_options.M);
+            current = selected.front().second;
+            link(node, selected, l);
+        }
+
+        if(level > max_level)
+        {
+            m_entry = node;
+            m_max_level = level;
+        }
+    }
+
+    std::vector<Neighbor<T>> search_prepared(const T* q, size_t k, size_t ef) const
+    {
+        if(m_max_level < 0 || k == 0)
+        {
+            return {};
+        }
+
+        const id_type entry = descend<false>(q, m_entry, m_max_level, 0);
+        const std::vector<Candidate> found = search_layer<false>(q, entry, std::max(ef, k), 0);
+
+        TopK<T> top(k);
+        for(const Candidate& candidate : found)
+        {
+            top.push(candidate.second, candidate.first);
+        }
+        std::vector<Neighbor<T>> neighbors = top.take_sorted();
+        if(m_metric != Metric::SquaredL2)
+        {
+            for(Neighbor<T>& neighbor : neighbors)
+            {
+                neighbor.score = -neighbor.score;
+            }
+        }
+        return neighbors;
+    }
+};
+
+} // vctr
+} // arondina
+
+#endif
@@ -0,0 +1,531 @@
+#ifndef INCLUDED_ARONDINA_VCTR_IVFPQ
+#define INCLUDED_ARONDINA_VCTR_IVFPQ
+
+// vctr
+#include "execution_policy.h"
+#include "kmeans.h"
+#include "knn.h"
+#include "matrix.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace arondina
+{
+namespace vctr
+{
+
+struct IvfPqOptions
+{
+    /**
+     * @brief Coarse centroids, one inverted list each.
+    */
+    size_t numLists = 256;
+
+    /**
+     * @brief Subvectors every vector is split into, each encoded in 4 bits. Must
+     *        divide the dimensions; a code takes numSubquantizers / 2 bytes.
+    */
+    size_t numSubquantizers = 16;
+
+    /**
+     * @brief Lists scanned per query. The recall/speed knob of search; see
+     *        IvfPqIndex::set_num_probes.
+    */
+    size_t numProbes = 8;
+
+    /**
+     * @brief k-means settings for the coarse centroids and the codebooks.
+    */
+    KMeansOptions training;
+};
+
+struct IvfPqConstants
+{
+    /**
+     * @brief Batches of at most this many rows, encoded or searched, stay on the
+     *        calling thread under execution::automatic.
+    */
+    static constexpr size_t maxBatchForSequential = 16;
+};
+
+/**
+ * @brief Approximate k-nearest-neighbour search by squared L2 distance over
+ *        compressed vectors: an inverted file with product quantization (IVF-PQ).
+ *
+ *        train() runs k-means for numLists coarse centroids, then splits the
+ *        residuals (vector minus its centroid) into numSubquantizers subvectors and
+ *        runs k-means for a codebook of 16 centroids per subvector. add() files each
+ *        vector in the list of its nearest centroid as one 4-bit code per subvector,
+ *        laid out for simd::pq4_scan in blocks of 32 vectors. No vector is kept.
+ *
+ *        search() scores the numProbes lists nearest the query. Per list it builds a
+ *        16-entry table of residual-to-codebook distances for every subquantizer
+ *        (from terms tabulated at training plus one set of query terms, so a table
+ *        costs one addition per entry), quantizes the tables to 8 bits, and lets
+ *        pq4_scan sum them over the codes with register shuffles. Scores are those
+ *        approximate squared distances.
+*/
+template<typename T>
+class IvfPqIndex
+{
+    static_assert(std::is_floating_point_v<T>, "IvfPqIndex needs a floating-point element type.");
+
+public:
+    using value_type = T;
+
+    explicit IvfPqIndex(size_t dimensions, const IvfPqOptions& options = IvfPqOptions())
+        : m_dimensions(dimensions)
+        , m_options(options)
+        , m_subdimensions(options.numSubquantizers > 0 ? dimensions / options.numSubquantizers : 0)
+        , m_coarse(dimensions > 0 ? dimensions : 1)
+    {
+        if(dimensions == 0)
+        {
+            throw std::runtime_error("ivf-pq index needs at least one dimension.");
+        }
+        if(options.numLists == 0 || options.numSubquantizers == 0)
+        {
+            throw std::runtime_error("ivf-pq index needs at least one list and one subquantizer.");
+        }
+        if(dimensions % options.numSubquantizers != 0)
+        {
+            throw std::runtime_error("dimensions must be a multiple of the number of subquantizers.");
+        }
+    }
+
+    size_t dimensions() const
+    {
+        return m_dimensions;
+    }
+
+    const IvfPqOptions& options() const
+    {
+        return m_options;
+    }
+
+    /**
+     * @brief Number of vectors in the index.
+    */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool is_trained() const
+    {
+        return m_coarse.size() > 0;
+    }
+
+    /**
+     * @brief Bytes of code stored per vector, besides its 4-byte id.
+    */
+    size_t code_size() const
+    {
+        return (m_options.numSubquantizers + 1) / 2;
+    }
+
+    /**
+     * @brief Sets the default number of lists search scans. Not safe while another
+     *        thread is searching.
+    */
+    void set_num_probes(size_t num_probes)
+    {
+        m_options.numProbes = num_probes;
+    }
+
+    /**
+     * @brief Learns the coarse centroids and the codebooks from the rows of samples,
+     *        which must number at least max(numLists, 16). Throws if the index
+     *        already holds vectors.
+    */
+    template<typename MatrixAlloc>
+    void train(const Matrix<T, MatrixAlloc>& samples, const ExecutionPolicy& policy = execution::automatic)
+    {
+        if(samples.num_cols() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+        if(m_size > 0)
+        {
+            throw std::runtime_error("cannot retrain a non-empty ivf-pq index.");
+        }
+
+        const Matrix<T> centroids = kmeans(samples, m_options.numLists, m_options.training, policy);
+        m_coarse = KnnIndex<T>(m_dimensions);
+        m_coarse.add(centroids);
+
+        const Matrix<T> residuals = residuals_of(samples, policy);
+        m_codebooks.assign(m_options.numSubquantizers * 16 * m_subdimensions, T(0));
+        Matrix<T> subvectors(samples.num_rows(), m_subdimensions, T(0));
+        for(size_t s = 0; s < m_options.numSubquantizers; ++s)
+        {
+            for(size_t i = 0; i < samples.num_rows(); ++i)
+            {
+                for(size_t t = 0; t < m_subdimensions; ++t)
+                {
+                    subvectors(i, t) = residuals(i, s * m_subdimensions + t);
+                }
+            }
+
+            const Matrix<T> codebook = kmeans(subvectors, 16, m_options.training, policy);
+            for(size_t j = 0; j < 16; ++j)
+            {
+                for(size_t t = 0; t < m_subdimensions; ++t)
+                {
+                    m_codebooks[(s * 16 + j) * m_subdimensions + t] = codebook(j, t);
+                }
+            }
+        }
+
+        m_list_terms.resize(m_options.numLists * m_options.numSubquantizers * 16);
+        for(size_t list = 0; list < m_options.numLists; ++list)
+        {
+            const T* centroid = m_coarse.data() + list * m_coarse.leading_dimension();
+            for(size_t s = 0; s < m_options.numSubquantizers; ++s)
+            {
+                for(size_t j = 0; j < 16; ++j)
+                {
+                    const T* c = m_codebooks.data() + (s * 16 + j) * m_subdimensions;
+                    m_list_terms[(list * m_options.numSubquantizers + s) * 16 + j]
+                        = subvector_dot(c, s, j) + T(2) * subvector_dot(centroid + s * m_subdimensions, s, j);
+                }
+            }
+        }
+
+        m_lists.assign(m_options.numLists, InvertedList());
+    }
+
+    /**
+     * @brief Encodes and files a vector, returning its index. Throws if the index is
+     *        not trained or the dimensions do not match.
+    */
+    template<typename VectorAlloc>
+    size_t add(const Vector<T, VectorAlloc>& v)
+    {
+        Matrix<T> row(1, v.dimensions(), T(0));
+        std::copy(v.data(), v.data() + v.dimensions(), row.data());
+        return add(row, execution::seq);
+    }
+
+    /**
+     * @brief Encodes and files every row of rows, the encoding split across threads as
+     *        policy asks, and returns the index of the first.
+    */
+    template<typename MatrixAlloc>
+    size_t add(const Matrix<T, MatrixAlloc>& rows, const ExecutionPolicy& policy = execution::automatic)
+    {
+        if(rows.num_cols() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+        if(!is_trained())
+        {
+            throw std::runtime_error("ivf-pq index is not trained.");
+        }
+        if(m_size + rows.num_rows() > std::numeric_limits<id_type>::max())
+        {
+            throw std::runtime_error("ivf-pq index is full.");
+        }
+
+        const size_t count = rows.num_rows();
+        const size_t num_subquantizers = m_options.numSubquantizers;
+        std::vector<size_t> lists(count);
+        std::vector<uint8_t> codes(count * num_subquantizers);
+        const Matrix<T> residuals = residuals_of(rows, policy, &lists);
+        auto encode_block = [this, &residuals, &codes, num_subquantizers](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; ++i)
+            {
+                encode(&residuals(i, 0), codes.data() + i * num_subquantizers);
+            }
+        };
+        if(policy.is_parallel(count, IvfPqConstants::maxBatchForSequential))
+        {
+            parallel_for_blocks(policy.pool(), count, encode_block);
+        }
+        else
+        {
+            encode_block(0, count);
+        }
+
+        const size_t first = m_size;
+        for(size_t i = 0; i < count; ++i)
+        {
+            append(m_lists[lists[i]], static_cast<id_type>(first + i), codes.data() + i * num_subquantizers);
+        }
+        m_size += count;
+        return first;
+    }
+
+    /**
+     * @brief The min(k, size()) vectors with the smallest approximate squared
+     *        distance to query among the num_probes lists nearest to it, best first.
+    */
+    template<typename VectorAlloc>
+    std::vector<Neighbor<T>> search(const Vector<T, VectorAlloc>& query, size_t k, size_t num_probes) const
+    {
+        if(query.dimensions() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+        if(!is_trained() || k == 0)
+        {
+            return {};
+        }
+        return search_lists(query.data(), m_coarse.search(query, num_probes, execution::simd), k);
+    }
+
+    /**
+     * @brief search(query, k, options().numProbes).
+    */
+    template<typename VectorAlloc>
+    std::vector<Neighbor<T>> search(const Vector<T, VectorAlloc>& query, size_t k) const
+    {
+        return search(query, k, m_options.numProbes);
+    }
+
+    /**
+     * @brief For every row of queries, search(row, k). The nearest lists of all the
+     *        queries come out of one batch search of the coarse centroids; the
+     *        queries are then spread across threads as policy asks.
+    */
+    template<typename MatrixAlloc>
+    std::vector<std::vector<Neighbor<T>>> search(const Matrix<T, MatrixAlloc>& queries, size_t k, const ExecutionPolicy& policy = execution::automatic) const
+    {
+        if(queries.num_cols() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+
+        const size_t num_queries = queries.num_rows();
+        std::vector<std::vector<Neighbor<T>>> results(num_queries);
+        if(!is_trained() || k == 0)
+        {
+            return results;
+        }
+
+        const std::vector<std::vector<Neighbor<T>>> probes = m_coarse.search(queries, m_options.numProbes, policy);
+        auto search_query = [this, &queries, &probes, &results, k](size_t i) {
+            results[i] = search_lists(queries.data() + i * queries.leading_dimension(), probes[i], k);
+        };
+        if(policy.is_parallel(num_queries, IvfPqConstants::maxBatchForSequential))
+        {
+            parallel_for(policy.pool(), num_queries, search_query);
+        }
+        else
+        {
+            for(size_t i = 0; i < num_queries; ++i)
+            {
+                search_query(i);
+            }
+        }
+        return results;
+    }
+
+private:
+    using id_type = uint32_t;
+
+    /**
+     * @brief The vectors filed under one coarse centroid: ids in insertion order and
+     *        their codes in pq4_scan blocks, the last block zero-padded.
+    */
+    struct InvertedList
+    {
+        std::vector<id_type> ids;
+        std::vector<uint8_t> codes;
+    };
+
+    size_t m_dimensions;
+    IvfPqOptions m_options;
+    size_t m_subdimensions;
+    size_t m_size = 0;
+    KnnIndex<T> m_coarse;
+    // per subquantizer, 16 centroids of m_subdimensions each
+    std::vector<T> m_codebooks;
+    // per list, subquantizer and codebook centroid c: |c|^2 + 2 y . c, with y the
+    // list's coarse centroid
+    std::vector<T> m_list_terms;
+    std::vector<InvertedList> m_lists;
+
+    /**
+     * @brief Every row of rows minus its nearest coarse centroid, whose list goes into
+     *        lists when given.
+    */
+    template<typename MatrixAlloc>
+    Matrix<T> residuals_of(const Matrix<T, MatrixAlloc>& rows, const ExecutionPolicy& policy, std::vector<size_t>* lists = nullptr) const
+    {
+        const std::vector<std::vector<Neighbor<T>>> nearest = m_coarse.search(rows, 1, policy);
+        Matrix<T> residuals(rows.num_rows(), m_dimensions, T(0));
+        for(size_t i = 0; i < rows.num_rows(); ++i)
+        {
+            const size_t list = nearest[i].front().index;
+            const T* centroid = m_coarse.data() + list * m_coarse.leading_dimension();
+            for(size_t j = 0; j < m_dimensions; ++j)
+            {
+                residuals(i, j) = rows(i, j) - centroid[j];
+            }
+            if(lists != nullptr)
+            {
+                (*lists)[i] = list;
+            }
+        }
+        return residuals;
+    }
+
+    /**
+     * @brief table[16 * s + j] = squared distance from subvector s of residual to
+     *        centroid j of codebook s.
+    */
+    void distance_tables(const T* residual, T* table) const
+    {
+        for(size_t s = 0; s < m_options.numSubquantizers; ++s)
+        {
+            const T* sub = residual + s * m_subdimensions;
+            for(size_t j = 0; j < 16; ++j)
+            {
+                const T* centroid = m_codebooks.data() + (s * 16 + j) * m_subdimensions;
+                T distance = T(0);
+                for(size_t t = 0; t < m_subdimensions; ++t)
+                {
+                    const T difference = sub[t] - centroid[t];
+                    distance += difference * difference;
+                }
+                table[s * 16 + j] = distance;
+            }
+        }
+    }
+
+    /**
+     * @brief x . (centroid j of codebook s), x being m_subdimensions long.
+    */
+    T subvector_dot(const T* x, size_t s, size_t j) const
+    {
+        const T* centroid = m_codebooks.data() + (s * 16 + j) * m_subdimensions;
+        T sum = T(0);
+        for(size_t t = 0; t < m_subdimensions; ++t)
+        {
+            sum += x[t] * centroid[t];
+        }
+        return sum;
+    }
+
+    /**
+     * @brief The nearest codebook centroid of every subvector of residual.
+    */
+    void encode(const T* residual, uint8_t* codes) const
+    {
+        std::vector<T> table(m_options.numSubquantizers * 16);
+        distance_tables(residual, table.data());
+        for(size_t s = 0; s < m_options.numSubquantizers; ++s)
+        {
+            const T* row = table.data() + s * 16;
+            codes[s] = static_cast<uint8_t>(std::min_element(row, row + 16) - row);
+        }
+    }
+
+    void append(InvertedList& list, id_type id, const uint8_t* codes) const
+    {
+        const size_t num_subquantizers = m_options.numSubquantizers;
+        const size_t position = list.ids.size();
+        const size_t slot = position % simd::Pq4Constants::blockSize;
+        if(slot == 0)
+        {
+            list.codes.resize(list.codes.size() + num_subquantizers * simd::Pq4Constants::bytesPerSubquantizer, 0);
+        }
+
+        uint8_t* block = list.codes.data() + (position / simd::Pq4Constants::blockSize) * num_subquantizers * simd::Pq4Constants::bytesPerSubquantizer;
+        const size_t half = simd::Pq4Constants::blockSize / 2;
+        for(size_t s = 0; s < num_subquantizers; ++s)
+        {
+            uint8_t& packed = block[s * simd::Pq4Constants::bytesPerSubquantizer + slot % half];
+            packed |= static_cast<uint8_t>(slot < half ? codes[s] : codes[s] << 4);
+        }
+        list.ids.push_back(id);
+    }
+
+    std::vector<Neighbor<T>> search_lists(const T* query, const std::vector<Neighbor<T>>& probes, size_t k) const
+    {
+        const size_t num_subquantizers = m_options.numSubquantizers;
+        std::vector<T> query_terms(num_subquantizers * 16);
+        std::vector<T> table(num_subquantizers * 16);
+        std::vector<T> lows(num_subquantizers);
+        std::vector<uint8_t> quantized(num_subquantizers * 16);
+        std::vector<uint16_t> sums;
+        for(size_t s = 0; s < num_subquantizers; ++s)
+        {
+            for(size_t j = 0; j < 16; ++j)
+            {
+                query_terms[s * 16 + j] = T(-2) * subvector_dot(query + s * m_subdimensions, s, j);
+            }
+        }
+
+        TopK<T> top(k);
+        for(const Neighbor<T>& probe : probes)
+        {
+            const InvertedList& list = m_lists[probe.index];
+            if(list.ids.empty())
+            {
+                continue;
+            }
+
+            // |q - y - c|^2 = |q - y|^2 + (|c|^2 + 2 y . c) - 2 q . c, with y the
+            // list's centroid: the first term is the probe's score and the second was
+            // tabulated at training, so only a sum is left per list
+            const T* list_terms = m_list_terms.data() + probe.index * num_subquantizers * 16;
+            for(size_t i = 0; i < num_subquantizers * 16; ++i)
+            {
+                table[i] = list_terms[i] + query_terms[i];
+            }
+
+            // One scale for every table, as large as lets an entry fit 8 bits and a
+            // full sum fit 16; each table keeps its own minimum as an offset.
+            T offset = probe.score;
+            T widest = T(0);
+            T total = T(0);
+            for(size_t s = 0; s < num_subquantizers; ++s)
+            {
+                const T* row = table.data() + s * 16;
+                const auto [low, high] = std::minmax_element(row, row + 16);
+                lows[s] = *low;
+                offset += *low;
+                widest = std::max(widest, *high - *low);
+                total += *high - *low;
+            }
+            const T scale = widest > T(0) ? std::min(T(255) / widest, T(65535) / total) : T(1);
+            for(size_t s = 0; s < num_subquantizers; ++s)
+            {
+                const T* row = table.data() + s * 16;
+                for(size_t j = 0; j < 16; ++j)
+                {
+                    // entries are non-negative, so adding a half and truncating rounds
+                    quantized[s * 16 + j] = static_cast<uint8_t>(std::min(T(255), (row[j] - lows[s]) * scale + T(0.5)));
+                }
+            }
+
+            const size_t num_blocks = (list.ids.size() + simd::Pq4Constants::blockSize - 1) / simd::Pq4Constants::blockSize;
+            sums.resize(num_blocks * simd::Pq4Constants::blockSize);
+            simd::pq4_scan(list.codes.data(), num_blocks, num_subquantizers, quantized.data(), sums.data());
+
+            const T inverse_scale = T(1) / scale;
+            for(size_t i = 0; i < list.ids.size(); ++i)
+            {
+                top.push(list.ids[i], offset + static_cast<T>(sums[i]) * inverse_scale);
+            }
+        }
+        return top.take_sorted();
+    }
+};
+
+} // vctr
+} // arondina
+
+#endif
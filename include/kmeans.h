@@ -0,0 +1,124 @@
+#ifndef INCLUDED_ARONDINA_VCTR_KMEANS
+#define INCLUDED_ARONDINA_VCTR_KMEANS
+
+// vctr
+#include "execution_policy.h"
+#include "knn.h"
+#include "matrix.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace arondina
+{
+namespace vctr
+{
+
+struct KMeansOptions
+{
+    /**
+     * @brief Upper bound on the Lloyd iterations; training stops early once no
+     *        sample changes cluster.
+    */
+    size_t iterations = 20;
+
+    /**
+     * @brief Seed of the initial centroids and of the samples that reseed empty
+     *        clusters.
+    */
+    uint64_t seed = 100;
+};
+
+/**
+ * @brief Lloyd's k-means over the rows of samples: k centroids, as the rows of the
+ *        returned matrix. Starts from k distinct samples chosen at random; a cluster
+ *        that loses all its samples is restarted at another random sample.
+ *
+ *        Each iteration assigns every sample to its nearest centroid through a
+ *        KnnIndex batch search, so the distances go through the GEMM kernels and
+ *        the samples are split across threads as policy asks. Throws if there are
+ *        fewer than k samples.
+*/
+template<typename T, typename Alloc>
+Matrix<T> kmeans(const Matrix<T, Alloc>& samples, size_t k, const KMeansOptions& options = KMeansOptions(), const ExecutionPolicy& policy = execution::automatic)
+{
+    const size_t n = samples.num_rows();
+    const size_t d = samples.num_cols();
+    if(k == 0 || n < k)
+    {
+        throw std::runtime_error("kmeans needs at least k samples.");
+    }
+
+    std::mt19937_64 rng(options.seed);
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::shuffle(order.begin(), order.end(), rng);
+
+    Matrix<T> centroids(k, d, T(0));
+    for(size_t c = 0; c < k; ++c)
+    {
+        for(size_t j = 0; j < d; ++j)
+        {
+            centroids(c, j) = samples(order[c], j);
+        }
+    }
+
+    std::vector<size_t> assignment(n, k);
+    std::vector<double> sums(k * d);
+    std::vector<size_t> counts(k);
+    std::uniform_int_distribution<size_t> any_sample(0, n - 1);
+    for(size_t iteration = 0; iteration < options.iterations; ++iteration)
+    {
+        KnnIndex<T> index(d);
+        index.add(centroids);
+        const std::vector<std::vector<Neighbor<T>>> nearest = index.search(samples, 1, policy);
+
+        bool changed = false;
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), size_t(0));
+        for(size_t i = 0; i < n; ++i)
+        {
+            const size_t c = nearest[i].front().index;
+            changed = changed || c != assignment[i];
+            assignment[i] = c;
+            ++counts[c];
+            for(size_t j = 0; j < d; ++j)
+            {
+                sums[c * d + j] += static_cast<double>(samples(i, j));
+            }
+        }
+        if(!changed)
+        {
+            break;
+        }
+
+        for(size_t c = 0; c < k; ++c)
+        {
+            if(counts[c] == 0)
+            {
+                const size_t restart = any_sample(rng);
+                for(size_t j = 0; j < d; ++j)
+                {
+                    centroids(c, j) = samples(restart, j);
+                }
+                continue;
+            }
+            for(size_t j = 0; j < d; ++j)
+            {
+                centroids(c, j) = static_cast<T>(sums[c * d + j] / static_cast<double>(counts[c]));
+            }
+        }
+    }
+    return centroids;
+}
+
+} // vctr
+} // arondina
+
+#endif
@@ -0,0 +1,544 @@
+#ifndef INCLUDED_ARONDINA_VCTR_KNN
+#define INCLUDED_ARONDINA_VCTR_KNN
+
+// vctr
+#include "aligned_allocator.h"
+#include "calibration.h"
+#include "execution_policy.h"
+#include "gemm.h"
+#include "matrix.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace arondina
+{
+namespace vctr
+{
+
+struct KnnConstants
+{
+    /**
+     * @brief Candidate rows scored per kernel call. Their scores against a tile of
+     *        queries fit in L2 next to the rows themselves.
+    */
+    static constexpr size_t candidateTile = 512;
+
+    /**
+     * @brief Queries of a batch scored against one tile of candidates at a time.
+    */
+    static constexpr size_t queryTile = 128;
+};
+
+/**
+ * @brief How a nearest-neighbour search ranks the collection against a query.
+ *
+ *        SquaredL2    - smallest squared Euclidean distance first.
+ *        InnerProduct - largest dot product first.
+ *        Cosine       - largest cosine similarity first. Rows and queries are scaled
+ *                       to unit length, so this is InnerProduct on unit vectors.
+*/
+enum class Metric
+{
+    SquaredL2,
+    InnerProduct,
+    Cosine
+};
+
+/**
+ * @brief The leading dimension an index stores rows of dimensions elements at:
+ *        rounded up to whole VectorConstants::alignment bytes, so every row starts
+ *        aligned and the kernels may read through its zeroed padding.
+*/
+template<typename T>
+size_t index_leading_dimension(size_t dimensions)
+{
+    constexpr size_t granularity = VectorConstants::alignment / sizeof(T);
+    return (dimensions + granularity - 1) / granularity * granularity;
+}
+
+/**
+ * @brief Brings a row just copied into an index into the form metric compares:
+ *        Cosine rows are scaled to unit length, a zero row is left as it is, and
+ *        the other metrics keep the row unchanged.
+*/
+template<typename T>
+void prepare_index_row(T* row, size_t dimensions, Metric metric)
+{
+    if(metric == Metric::Cosine)
+    {
+        const double norm = norm2_block(row, dimensions, true);
+        if(norm != 0.0)
+        {
+            scale_to_unit_block(row, dimensions, norm, true);
+        }
+    }
+}
+
+/**
+ * @brief One search result: the index of a row in the collection and its score, the
+ *        squared distance for Metric::SquaredL2 and the similarity otherwise.
+*/
+template<typename T>
+struct Neighbor
+{
+    size_t index;
+    T score;
+};
+
+/**
+ * @brief The k best candidates seen so far, in a max-heap on a key where smaller is
+ *        better, so the worst of them is at the front and a candidate that cannot
+ *        enter costs one comparison. Ties go to the smaller index, which makes the
+ *        result independent of how the collection was split across threads.
+ *
+ *        Heaps merge with +=, so per-thread heaps reduce through sum_blocks like any
+ *        other partial result.
+*/
+template<typename T>
+class TopK
+{
+public:
+    explicit TopK(size_t k = 0)
+        : m_k(k)
+        , m_bound(k > 0 ? std::numeric_limits<T>::infinity() : -std::numeric_limits<T>::infinity())
+    {
+        m_heap.reserve(k);
+    }
+
+    /**
+     * @brief Offers a candidate with the given key.
+    */
+    void push(size_t index, T key)
+    {
+        const Neighbor<T> candidate{index, key};
+        if(m_heap.size() < m_k)
+        {
+            m_heap.push_back(candidate);
+            std::push_heap(m_heap.begin(), m_heap.end(), &TopK::better);
+        }
+        else if(m_k > 0 && better(candidate, m_heap.front()))
+        {
+            std::pop_heap(m_heap.begin(), m_heap.end(), &TopK::better);
+            m_heap.back() = candidate;
+            std::push_heap(m_heap.begin(), m_heap.end(), &TopK::better);
+        }
+        if(m_heap.size() == m_k && m_k > 0)
+        {
+            m_bound = m_heap.front().score;
+        }
+    }
+
+    /**
+     * @brief Offers keys[r] for index first + r, r in [0, n). Indices rise through
+     *        the block, so a key that does not beat the current worst cannot enter
+     *        and is rejected without touching the heap.
+    */
+    void push_block(size_t first, const T* keys, size_t n)
+    {
+        for(size_t r = 0; r < n; ++r)
+        {
+            if(keys[r] < m_bound)
+            {
+                push(first + r, keys[r]);
+            }
+        }
+    }
+
+    TopK& operator+=(const TopK& rhs)
+    {
+        for(const Neighbor<T>& candidate : rhs.m_heap)
+        {
+            push(candidate.index, candidate.score);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief The candidates best first, with their keys as scores. Leaves the heap
+     *        empty.
+    */
+    std::vector<Neighbor<T>> take_sorted()
+    {
+        std::sort_heap(m_heap.begin(), m_heap.end(), &TopK::better);
+        m_bound = m_k > 0 ? std::numeric_limits<T>::infinity() : -std::numeric_limits<T>::infinity();
+        return std::move(m_heap);
+    }
+
+private:
+    static bool better(const Neighbor<T>& a, const Neighbor<T>& b)
+    {
+        return a.score < b.score || (a.score == b.score && a.index < b.index);
+    }
+
+    size_t m_k;
+    T m_bound;
+    std::vector<Neighbor<T>> m_heap;
+};
+
+/**
+ * @brief Exact (brute-force) k-nearest-neighbour search over a collection of
+ *        vectors of one dimension.
+ *
+ *        Rows are stored back to back in one buffer from Alloc, each padded to a whole
+ *        number of VectorConstants::alignment bytes, along with their squared norms.
+ *        A single query is scored against tiles of rows with the dot product kernels
+ *        (four rows per pass over the query); a batch of queries goes through
+ *        gemm_transposed_b once a tile of queries is large enough to fill the GEMM
+ *        register tiles. Squared distances are expanded as
+ *        |x|^2 - 2 x . q + |q|^2, so every metric is ranked from dot products.
+ *
+ *        Blocks of rows are split across threads as policy asks, each keeping its
+ *        own TopK per query; the heaps are merged at the end.
+*/
+template<typename T, typename Alloc = AlignedAllocator<T, VectorConstants::alignment>>
+class KnnIndex
+{
+    static_assert(std::is_floating_point_v<T>, "KnnIndex needs a floating-point element type.");
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+
+    explicit KnnIndex(size_t dimensions, Metric metric = Metric::SquaredL2, const Alloc& allocator = Alloc())
+        : m_dimensions(dimensions)
+        , m_leading_dimension(index_leading_dimension<T>(dimensions))
+        , m_metric(metric)
+        , m_data(allocator)
+    {
+        if(dimensions == 0)
+        {
+            throw std::runtime_error("knn index needs at least one dimension.");
+        }
+    }
+
+    size_t dimensions() const
+    {
+        return m_dimensions;
+    }
+
+    Metric metric() const
+    {
+        return m_metric;
+    }
+
+    /**
+     * @brief Number of rows in the collection.
+    */
+    size_t size() const
+    {
+        return m_norms.size();
+    }
+
+    /**
+     * @brief Distance in elements between the starts of two consecutive rows.
+    */
+    size_t leading_dimension() const
+    {
+        return m_leading_dimension;
+    }
+
+    /**
+     * @brief Row i starts at data() + i * leading_dimension(). For Metric::Cosine the
+     *        rows are stored at unit length.
+    */
+    const T* data() const
+    {
+        return m_data.data();
+    }
+
+    void reserve(size_t rows)
+    {
+        m_data.reserve(rows * m_leading_dimension);
+        m_norms.reserve(rows);
+    }
+
+    /**
+     * @brief Appends a copy of v to the collection and returns its index. Throws if
+     *        the dimensions do not match.
+    */
+    template<typename VectorAlloc>
+    size_t add(const Vector<T, VectorAlloc>& v)
+    {
+        if(v.dimensions() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+        return append(v.data());
+    }
+
+    /**
+     * @brief Appends a copy of every row of rows and returns the index of the first.
+    */
+    template<typename MatrixAlloc>
+    size_t add(const Matrix<T, MatrixAlloc>& rows)
+    {
+        if(rows.num_cols() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+
+        const size_t first = size();
+        reserve(first + rows.num_rows());
+        for(size_t i = 0; i < rows.num_rows(); ++i)
+        {
+            append(rows.data() + i * rows.leading_dimension());
+        }
+        return first;
+    }
+
+    /**
+     * @brief The min(k, size()) rows closest to query, best first.
+    */
+    template<typename VectorAlloc>
+    std::vector<Neighbor<T>> search(const Vector<T, VectorAlloc>& query, size_t k, const ExecutionPolicy& policy = execution::automatic) const
+    {
+        if(query.dimensions() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+
+        Vector<T> prepared(query.dimensions());
+        std::copy(query.data(), query.data() + query.dimensions(), prepared.data());
+        if(m_metric == Metric::Cosine)
+        {
+            prepared.normalize(policy);
+        }
+        const T* q = prepared.data();
+        const T query_norm = dot_block<T>(q, q, m_dimensions, true);
+        const bool use_kernels = policy.uses_simd();
+
+        auto search_block = [this, q, query_norm, k, use_kernels](size_t begin, size_t end) {
+            TopK<T> top(k);
+            T scores[KnnConstants::candidateTile];
+            for(size_t tile = begin; tile < end; tile += KnnConstants::candidateTile)
+            {
+                const size_t rows = std::min(KnnConstants::candidateTile, end - tile);
+                score_rows(tile, rows, q, scores, use_kernels);
+                to_keys(tile, rows, query_norm, scores);
+                top.push_block(tile, scores, rows);
+            }
+            return top;
+        };
+
+        TopK<T> top(k);
+        if(policy.is_parallel(size() * m_dimensions, max_dimensions_for_sequential<T>(Operation::DotProduct)))
+        {
+            top = parallel_sum_blocks(policy.pool(), size(), std::move(top), search_block);
+        }
+        else if(size() > 0)
+        {
+            top += search_block(0, size());
+        }
+        return finish(top);
+    }
+
+    /**
+     * @brief For every row of queries, the min(k, size()) rows closest to it, best
+     *        first. The collection is read once for the whole batch: each tile of
+     *        rows is scored against every query while it is in cache.
+    */
+    template<typename MatrixAlloc>
+    std::vector<std::vector<Neighbor<T>>> search(const Matrix<T, MatrixAlloc>& queries, size_t k, const ExecutionPolicy& policy = execution::automatic) const
+    {
+        if(queries.num_cols() != m_dimensions)
+        {
+            throw std::runtime_error("vector dimensions do not match the index.");
+        }
+
+        const size_t num_queries = queries.num_rows();
+        Matrix<T> prepared(num_queries, m_dimensions, T(0), m_leading_dimension);
+        std::vector<T> query_norms(num_queries);
+        for(size_t i = 0; i < num_queries; ++i)
+        {
+            const T* row = queries.data() + i * queries.leading_dimension();
+            std::copy(row, row + m_dimensions, prepared.data() + i * m_leading_dimension);
+        }
+        if(m_metric == Metric::Cosine)
+        {
+            normalize_rows(prepared, policy);
+        }
+        for(size_t i = 0; i < num_queries; ++i)
+        {
+            const T* row = prepared.data() + i * m_leading_dimension;
+            query_norms[i] = dot_block<T>(row, row, m_dimensions, true);
+        }
+
+        const T* q = prepared.data();
+        const T* norms = query_norms.data();
+        const bool use_kernels = policy.uses_simd();
+        auto search_block = [this, q, norms, num_queries, k, use_kernels](size_t begin, size_t end) {
+            TopKBatch batch(num_queries, k);
+            std::vector<T> scores(KnnConstants::queryTile * KnnConstants::candidateTile);
+            for(size_t tile = begin; tile < end; tile += KnnConstants::candidateTile)
+            {
+                const size_t rows = std::min(KnnConstants::candidateTile, end - tile);
+                for(size_t q0 = 0; q0 < num_queries; q0 += KnnConstants::queryTile)
+                {
+                    const size_t count = std::min(KnnConstants::queryTile, num_queries - q0);
+                    if(use_kernels && count >= DotProductBatchConstants::minQueriesForGemm)
+                    {
+                        gemm_transposed_b(
+                            execution::simd
+                            , count
+                            , rows
+                            , m_dimensions
+                            , T(1)
+                            , q + q0 * m_leading_dimension
+                            , m_leading_dimension
+                            , row(tile)
+                            , m_leading_dimension
+                            , T(0)
+                            , scores.data()
+                            , KnnConstants::candidateTile);
+                    }
+                    else
+                    {
+                        for(size_t i = 0; i < count; ++i)
+                        {
+                            score_rows(tile, rows, q + (q0 + i) * m_leading_dimension, scores.data() + i * KnnConstants::candidateTile, use_kernels);
+                        }
+                    }
+
+                    for(size_t i = 0; i < count; ++i)
+                    {
+                        T* query_scores = scores.data() + i * KnnConstants::candidateTile;
+                        to_keys(tile, rows, norms[q0 + i], query_scores);
+                        batch.queries[q0 + i].push_block(tile, query_scores, rows);
+                    }
+                }
+            }
+            return batch;
+        };
+
+        TopKBatch batch(num_queries, k);
+        if(policy.is_parallel(num_queries * size() * m_dimensions, max_dimensions_for_sequential<T>(Operation::DotProduct)))
+        {
+            batch = parallel_sum_blocks(policy.pool(), size(), std::move(batch), search_block);
+        }
+        else if(size() > 0)
+        {
+            batch += search_block(0, size());
+        }
+
+        std::vector<std::vector<Neighbor<T>>> results;
+        results.reserve(num_queries);
+        for(TopK<T>& top : batch.queries)
+        {
+            results.push_back(finish(top));
+        }
+        return results;
+    }
+
+private:
+    /**
+     * @brief One TopK per query of a batch, merged query by query.
+    */
+    struct TopKBatch
+    {
+        std::vector<TopK<T>> queries;
+
+        TopKBatch() = default;
+
+        TopKBatch(size_t num_queries, size_t k)
+            : queries(num_queries, TopK<T>(k))
+        {
+        }
+
+        TopKBatch& operator+=(const TopKBatch& rhs)
+        {
+            for(size_t i = 0; i < queries.size(); ++i)
+            {
+                queries[i] += rhs.queries[i];
+            }
+            return *this;
+        }
+    };
+
+    size_t m_dimensions;
+    size_t m_leading_dimension;
+    Metric m_metric;
+    std::vector<T, Alloc> m_data;
+    std::vector<T> m_norms;
+
+    const T* row(size_t index) const
+    {
+        return m_data.data() + index * m_leading_dimension;
+    }
+
+    size_t append(const T* source)
+    {
+        const size_t index = size();
+        m_data.resize(m_data.size() + m_leading_dimension, T(0));
+        T* dest = m_data.data() + index * m_leading_dimension;
+        std::copy(source, source + m_dimensions, dest);
+        prepare_index_row(dest, m_dimensions, m_metric);
+        m_norms.push_back(dot_block<T>(dest, dest, m_dimensions, true));
+        return index;
+    }
+
+    /**
+     * @brief out[r] = row(first + r) . q for r in [0, rows).
+    */
+    void score_rows(size_t first, size_t rows, const T* q, T* out, bool use_kernels) const
+    {
+        if(use_kernels)
+        {
+            simd::dot_rows(row(first), m_leading_dimension, rows, q, m_dimensions, out);
+            return;
+        }
+        for(size_t r = 0; r < rows; ++r)
+        {
+            out[r] = dot_block<T>(row(first + r), q, m_dimensions, false);
+        }
+    }
+
+    /**
+     * @brief Turns the dot products of rows [first, first + n) with a query into TopK
+     *        keys in place: the squared distance, clamped at zero against
+     *        cancellation, or the negated similarity.
+    */
+    void to_keys(size_t first, size_t n, T query_norm, T* scores) const
+    {
+        if(m_metric == Metric::SquaredL2)
+        {
+            const T* norms = m_norms.data() + first;
+            for(size_t r = 0; r < n; ++r)
+            {
+                scores[r] = std::max(T(0), norms[r] - T(2) * scores[r] + query_norm);
+            }
+            return;
+        }
+        for(size_t r = 0; r < n; ++r)
+        {
+            scores[r] = -scores[r];
+        }
+    }
+
+    std::vector<Neighbor<T>> finish(TopK<T>& top) const
+    {
+        std::vector<Neighbor<T>> neighbors = top.take_sorted();
+        if(m_metric != Metric::SquaredL2)
+        {
+            for(Neighbor<T>& neighbor : neighbors)
+            {
+                neighbor.score = -neighbor.score;
+            }
+        }
+        return neighbors;
+    }
+};
+
+} // vctr
+} // arondina
+
+#endif
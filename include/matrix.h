@@ -2,35 +2,78 @@
 #define INCLUDED_ARONDINA_VCTR_MATRIX
 
 // vctr
+#include "aligned_allocator.h"
+#include "gemm.h"
+#include "gemv.h"
 #include "vector.h"
 
 // std
+#include <algorithm>
+#include <cstdint>
 #include <initializer_list>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
 
 namespace arondina
 {
 namespace vctr
 {
 
+struct MatrixConstants
+{
+    /**
+     * @brief Byte alignment of the start of every Matrix buffer. One cache line,
+     *        and the width of the widest vector registers the kernels use.
+    */
+    static constexpr size_t alignment = 64;
+};
+
+struct DotProductBatchConstants
+{
+    /**
+     * @brief Query count from which dot_product_batch goes through the packed GEMM
+     *        kernels. Below it a tile of candidates is scored against each query in
+     *        turn with the dot product kernels, as a GEMM tile would mostly compute
+     *        padding.
+    */
+    static constexpr size_t minQueriesForGemm = 32;
+
+    /**
+     * @brief Candidate rows scored against every query while they are in cache.
+    */
+    static constexpr size_t candidateTile = 64;
+};
+
 /**
  * @brief Matrix implementation. T must support arithmetic operations.
  *        This class does not contain vctr::Vectors in order to keep the
  *        implementations decoupled. You can still initailize a Matrix with a
  *        vctr::Vector.
+ *
+ *        Elements are stored row-major in a single buffer obtained from Alloc, which
+ *        by default aligns it to MatrixConstants::alignment. Row i starts at
+ *        data() + i * leading_dimension(), where the leading dimension is at least
+ *        num_cols(). Any elements between num_cols() and the leading dimension are
+ *        value-initialized padding.
 */
-template<typename T>
+template<typename T, typename Alloc = AlignedAllocator<T, MatrixConstants::alignment>>
 class Matrix
 {
 
 public:
+    using value_type = T;
+    using allocator_type = Alloc;
+
     /**
      * @brief Initialize with an initializer list of an initializer list.
      *        Will throw before allocating memory if the columns are mismatching.
     */
-    Matrix(std::initializer_list<std::initializer_list<T>> initializer_list)
-        : m_num_rows(initializer_list.size())
+    Matrix(std::initializer_list<std::initializer_list<T>> initializer_list, const Alloc& allocator = Alloc())
+        : m_allocator(allocator)
+        , m_num_rows(initializer_list.size())
         , m_num_cols(0)
+        , m_leading_dimension(0)
         , m_data(nullptr)
     {
         if(m_num_rows > 0)
@@ -47,13 +90,13 @@ public:
                 }
             }
 
-            m_data = new T*[m_num_rows];
+            m_leading_dimension = m_num_cols;
+            m_data = allocate(m_num_rows * m_leading_dimension);
 
-            it = initializer_list.begin();
-            for(size_t row = 0; row < m_num_rows; ++row, ++it)
+            T* dest = m_data;
+            for(const std::initializer_list<T>& row : initializer_list)
             {
-                m_data[row] = new T[m_num_cols];
-                std::copy(it->begin(), it->end(), m_data[row]);
+                dest = std::uninitialized_copy(row.begin(), row.end(), dest);
             }
         }
     }
@@ -62,15 +105,17 @@ public:
      * @brief Initialize with an initializer list of vctr::Vectors.
      *        Will throw before allocating memory if the columns are mismatching.
     */
-    Matrix(std::initializer_list<const Vector<T>&> initializer_list)
-        : m_num_rows(initializer_list.size())
+    Matrix(std::initializer_list<Vector<T>> initializer_list, const Alloc& allocator = Alloc())
+        : m_allocator(allocator)
+        , m_num_rows(initializer_list.size())
         , m_num_cols(0)
+        , m_leading_dimension(0)
         , m_data(nullptr)
     {
         if(m_num_rows > 0)
         {
             auto it = initializer_list.begin();
-            m_num_cols = it->size();
+            m_num_cols = it->dimensions();
 
             for(; it != initializer_list.end(); ++it)
             {
@@ -81,15 +126,15 @@ public:
                 }
             }
 
-            m_data = new T*[m_num_rows];
-            
-            it = initializer_list.begin();
-            for(size_t row = 0; row < m_num_rows; ++row, ++it)
+            m_leading_dimension = m_num_cols;
+            m_data = allocate(m_num_rows * m_leading_dimension);
+
+            T* dest = m_data;
+            for(const Vector<T>& vec : initializer_list)
             {
-                m_data[row] = new T[m_num_cols];
-                for(size_t j = 0; j < m_num_cols; ++j)
+                for(size_t j = 0; j < m_num_cols; ++j, ++dest)
                 {
-                    m_data[i][j] = vec[j];
+                    ::new (static_cast<void*>(dest)) T(vec[j]);
                 }
             }
         }
@@ -98,31 +143,55 @@ public:
     /**
      * @brief Initialize with column, rows, and default value.
     */
-    Matrix(size_t num_rows, size_t num_cols, T default_value)
-        : m_num_rows(num_rows)
+    Matrix(size_t num_rows, size_t num_cols, T default_value, const Alloc& allocator = Alloc())
+        : Matrix(num_rows, num_cols, default_value, num_cols, allocator)
+    {
+    }
+
+    /**
+     * @brief Initialize with column, rows, default value and an explicit leading
+     *        dimension (the distance in elements between the starts of two rows).
+     *        Throws if the leading dimension is smaller than the number of columns.
+    */
+    Matrix(size_t num_rows, size_t num_cols, T default_value, size_t leading_dimension, const Alloc& allocator = Alloc())
+        : m_allocator(allocator)
+        , m_num_rows(num_rows)
         , m_num_cols(num_cols)
-        , m_data(new T*[num_rows])
+        , m_leading_dimension(leading_dimension)
+        , m_data(nullptr)
     {
-        for (size_t row = 0; row < num_rows; ++row)
+        if(leading_dimension < num_cols)
+        {
+            throw std::runtime_error("leading dimension smaller than column count.");
+        }
+
+        m_data = allocate(m_num_rows * m_leading_dimension);
+        if(m_leading_dimension == m_num_cols)
+        {
+            std::uninitialized_fill_n(m_data, m_num_rows * m_num_cols, default_value);
+        }
+        else
         {
-            m_data[row] = new T[num_cols];
-            std::fill_n(m_data[row], num_cols, default_value);
+            for(size_t row = 0; row < m_num_rows; ++row)
+            {
+                T* row_data = m_data + row * m_leading_dimension;
+                std::uninitialized_fill_n(row_data, m_num_cols, default_value);
+                std::uninitialized_value_construct_n(row_data + m_num_cols, m_leading_dimension - m_num_cols);
+            }
         }
     }
 
     /**
-     * @brief Copy constructor.
+     * @brief Copy constructor. Copies the whole buffer, padding included, in one go.
     */
-    Matrix(const Matrix<T>& rhs)
-        : m_num_rows(rhs.m_num_rows)
+    Matrix(const Matrix<T, Alloc>& rhs)
+        : m_allocator(allocator_traits::select_on_container_copy_construction(rhs.m_allocator))
+        , m_num_rows(rhs.m_num_rows)
         , m_num_cols(rhs.m_num_cols)
-        , m_data(new T*[rhs.m_num_rows])
+        , m_leading_dimension(rhs.m_leading_dimension)
+        , m_data(allocate(rhs.size_in_elements()))
     {
-        for(size_t row = 0; row < m_num_rows; ++row)
-        {
-            m_data[row] = new T[m_num_cols];
-            std::copy(rhs.m_data[row], rhs.m_data[row] + m_num_cols, m_data[row]);
-        }
+        std::uninitialized_copy_n(rhs.m_data, size_in_elements(), m_data);
     }
 
     /**
@@ -130,17 +199,16 @@ public:
      *        Transfer ownership of the rhs resources and
      *        then reset the rhs source to a valid, undefined state.
     */
-    Matrix(const Matrix<T>&& rhs)
-        : m_num_rows(rhs.m_num_rows)
+    Matrix(Matrix<T, Alloc>&& rhs) noexcept
+        : m_allocator(std::move(rhs.m_allocator))
+        , m_num_rows(rhs.m_num_rows)
         , m_num_cols(rhs.m_num_cols)
-        , m_data(new T*[rhs.m_num_rows])
+        , m_leading_dimension(rhs.m_leading_dimension)
+        , m_data(rhs.m_data)
     {
-        m_num_rows = rhs.m_num_rows;
-        m_num_cols = rhs.m_num_cols;
-        m_data = rhs.m_data;
-
         rhs.m_num_rows = 0;
         rhs.m_num_cols = 0;
+        rhs.m_leading_dimension = 0;
         rhs.m_data = nullptr;
     }
 
@@ -148,41 +216,60 @@ public:
      * @brief Assignment. Checks for self assignment, frees existing resources
      *        re-assigns data.
     */
-    Matrix<T>& operator=(const Matrix<T>& rhs)
+    Matrix<T, Alloc>& operator=(const Matrix<T, Alloc>& rhs)
     {
         if(this != &rhs)
         {
+            Alloc allocator = allocator_traits::propagate_on_container_copy_assignment::value ? rhs.m_allocator : m_allocator;
+            T* data = rhs.size_in_elements() == 0 ? nullptr : allocator_traits::allocate(allocator, rhs.size_in_elements());
+            std::uninitialized_copy_n(rhs.m_data, rhs.size_in_elements(), data);
+
             delete_heap_data();
 
+            m_allocator = std::move(allocator);
             m_num_rows = rhs.m_num_rows;
             m_num_cols = rhs.m_num_cols;
-
-            m_data = new T*[m_num_rows];
-            for(size_t row = 0; row < m_num_rows; ++row)
-            {
-                m_data[row] = new T[m_num_cols];
-                std::copy(rhs.m_data[row], rhs.m_data[row] + m_num_cols, m_data[row]);
-            }
+            m_leading_dimension = rhs.m_leading_dimension;
+            m_data = data;
         }
         return *this;
     }
 
     /**
      * @brief Move assigment. Delete existing resources, then simply move the pointer
-     *        from the rhs.m_data to the pointer in this object.
+     *        from the rhs.m_data to the pointer in this object. If the allocators differ
+     *        and do not propagate, the buffer is copied into storage from ours instead.
     */
-    Matrix<T>& operator=(Matrix<T>&& rhs)
+    Matrix<T, Alloc>& operator=(Matrix<T, Alloc>&& rhs) noexcept(
+        allocator_traits::propagate_on_container_move_assignment::value
+        || allocator_traits::is_always_equal::value)
     {
         if(this != &rhs)
         {
+            if constexpr (!allocator_traits::propagate_on_container_move_assignment::value
+                && !allocator_traits::is_always_equal::value)
+            {
+                if(m_allocator != rhs.m_allocator)
+                {
+                    return *this = static_cast<const Matrix<T, Alloc>&>(rhs);
+                }
+            }
+
             delete_heap_data();
 
+            if constexpr (allocator_traits::propagate_on_container_move_assignment::value)
+            {
+                m_allocator = std::move(rhs.m_allocator);
+            }
+
             m_num_rows = rhs.m_num_rows;
             m_num_cols = rhs.m_num_cols;
+            m_leading_dimension = rhs.m_leading_dimension;
             m_data = rhs.m_data;
 
             rhs.m_num_rows = 0;
             rhs.m_num_cols = 0;
+            rhs.m_leading_dimension = 0;
             rhs.m_data = nullptr;
         }
 
@@ -196,12 +283,61 @@ public:
         delete_heap_data();
     }
 
+    /**
+     * @brief Returns a copy of the allocator that owns the buffer.
+    */
+    allocator_type get_allocator() const
+    {
+        return m_allocator;
+    }
+
+    /**
+     * @brief Returns the number of rows.
+    */
+    size_t num_rows() const
+    {
+        return m_num_rows;
+    }
+
+    /**
+     * @brief Returns the number of columns.
+    */
+    size_t num_cols() const
+    {
+        return m_num_cols;
+    }
+
+    /**
+     * @brief Returns the distance in elements between the starts of two consecutive rows.
+    */
+    size_t leading_dimension() const
+    {
+        return m_leading_dimension;
+    }
+
+    /**
+     * @brief Pointer to the first element of row 0, aligned to MatrixConstants::alignment
+     *        with the default allocator.
+    */
+    T* data()
+    {
+        return m_data;
+    }
+
+    /**
+     * @brief Const pointer to the first element of row 0.
+    */
+    const T* data() const
+    {
+        return m_data;
+    }
+
     /**
      * @brief access non-const element.
     */
     T& operator()(size_t i, size_t j)
     {
-        return data[i][j];
+        return m_data[i * m_leading_dimension + j];
     }
 
     /**
@@ -209,25 +345,387 @@ public:
     */
     const T& operator()(size_t i, size_t j) const
     {
-        return data[i][j];
+        return m_data[i * m_leading_dimension + j];
+    }
+
+    /**
+     * @brief Row i as a contiguous view of num_cols() elements, without copying.
+     *        Throws if i is not a row.
+    */
+    VectorView<T> row(size_t i)
+    {
+        check_row(i);
+        return VectorView<T>(m_data + i * m_leading_dimension, m_num_cols);
+    }
+
+    VectorView<const T> row(size_t i) const
+    {
+        check_row(i);
+        return VectorView<const T>(m_data + i * m_leading_dimension, m_num_cols);
+    }
+
+    /**
+     * @brief Column j as a view of num_rows() elements leading_dimension() apart,
+     *        without copying. Throws if j is not a column.
+    */
+    VectorView<T> col(size_t j)
+    {
+        check_col(j);
+        return VectorView<T>(m_data + j, m_num_rows, m_leading_dimension);
+    }
+
+    VectorView<const T> col(size_t j) const
+    {
+        check_col(j);
+        return VectorView<const T>(m_data + j, m_num_rows, m_leading_dimension);
+    }
+
+    /**
+     * @brief Matrix product. Throws if the column count of this matrix does not
+     *        match the row count of rhs.
+     *
+     *        see gemm.h
+    */
+    Matrix<T, Alloc> operator*(const Matrix<T, Alloc>& rhs) const
+    {
+        if(m_num_cols != rhs.m_num_rows)
+        {
+            throw std::runtime_error("mismatched matrix dimensions.");
+        }
+
+        Matrix<T, Alloc> result(m_num_rows, rhs.m_num_cols, T(), m_allocator);
+        vctr::gemm(
+            m_num_rows
+            , rhs.m_num_cols
+            , m_num_cols
+            , T(1)
+            , m_data
+            , m_leading_dimension
+            , rhs.m_data
+            , rhs.m_leading_dimension
+            , T(0)
+            , result.m_data
+            , result.m_leading_dimension);
+        return result;
     }
 
 private:
+    using allocator_traits = std::allocator_traits<Alloc>;
+
+    static_assert(std::is_same_v<typename allocator_traits::value_type, T>, "allocator value_type must be T.");
+    static_assert(std::is_same_v<typename allocator_traits::pointer, T*>, "allocator must hand out raw pointers.");
+
+    Alloc m_allocator;
     size_t m_num_rows;
     size_t m_num_cols;
-    T** m_data;
+    size_t m_leading_dimension;
+    T* m_data;
+
+    void check_row(size_t i) const
+    {
+        if(i >= m_num_rows)
+        {
+            throw std::runtime_error("index out of bounds.");
+        }
+    }
+
+    void check_col(size_t j) const
+    {
+        if(j >= m_num_cols)
+        {
+            throw std::runtime_error("index out of bounds.");
+        }
+    }
+
+    size_t size_in_elements() const
+    {
+        return m_num_rows * m_leading_dimension;
+    }
+
+    T* allocate(size_t elements)
+    {
+        if(elements == 0)
+        {
+            return nullptr;
+        }
+        return allocator_traits::allocate(m_allocator, elements);
+    }
 
     void delete_heap_data()
     {
-        for(size_t row = 0; row < m_num_rows; ++row)
+        if(m_data != nullptr)
         {
-            delete[] m_data[row];
+            std::destroy_n(m_data, size_in_elements());
+            allocator_traits::deallocate(m_allocator, m_data, size_in_elements());
         }
-        delete[] m_data;
     }
 };
 
+/**
+ * @brief In-place general matrix multiply, c = alpha * a * b + beta * c.
+ *        Throws if the dimensions do not line up or if c is a or b.
+ *
+ *        see gemm.h
+*/
+template<typename T, typename AllocA, typename AllocB, typename AllocC>
+void gemm(T alpha, const Matrix<T, AllocA>& a, const Matrix<T, AllocB>& b, T beta, Matrix<T, AllocC>& c)
+{
+    if(a.num_cols() != b.num_rows() || c.num_rows() != a.num_rows() || c.num_cols() != b.num_cols())
+    {
+        throw std::runtime_error("mismatched matrix dimensions.");
+    }
+    if(static_cast<const void*>(&c) == &a || static_cast<const void*>(&c) == &b)
+    {
+        throw std::runtime_error("gemm output aliases an input.");
+    }
+
+    gemm(
+        a.num_rows()
+        , b.num_cols()
+        , a.num_cols()
+        , alpha
+        , a.data()
+        , a.leading_dimension()
+        , b.data()
+        , b.leading_dimension()
+        , beta
+        , c.data()
+        , c.leading_dimension());
+}
+
+/**
+ * @brief Matrix-vector product a * x. Throws if the column count of a does not match
+ *        the dimensions of x.
+ *
+ *        see gemv.h
+*/
+template<typename T, typename MatrixAlloc, typename VectorAlloc>
+Vector<T, VectorAlloc> operator*(const Matrix<T, MatrixAlloc>& a, const Vector<T, VectorAlloc>& x)
+{
+    if(a.num_cols() != x.dimensions())
+    {
+        throw std::runtime_error("mismatched matrix dimensions.");
+    }
+
+    Vector<T, VectorAlloc> y(a.num_rows(), x.get_allocator());
+    gemv(a.num_rows(), a.num_cols(), T(1), a.data(), a.leading_dimension(), x.data(), T(0), y.data());
+    return y;
+}
+
+/**
+ * @brief Transposed matrix-vector product x^T * a, i.e. a^T * x. Throws if the
+ *        dimensions of x do not match the row count of a.
+ *
+ *        see gemv.h
+*/
+template<typename T, typename VectorAlloc, typename MatrixAlloc>
+Vector<T, VectorAlloc> operator*(const Vector<T, VectorAlloc>& x, const Matrix<T, MatrixAlloc>& a)
+{
+    if(a.num_rows() != x.dimensions())
+    {
+        throw std::runtime_error("mismatched matrix dimensions.");
+    }
+
+    Vector<T, VectorAlloc> y(a.num_cols(), x.get_allocator());
+    gemv_transposed(a.num_rows(), a.num_cols(), T(1), a.data(), a.leading_dimension(), x.data(), T(0), y.data());
+    return y;
+}
+
+/**
+ * @brief Scales every row of a to unit length in place, see Vector::normalize. Rows
+ *        are independent, so blocks of rows are split across threads as policy
+ *        asks, each row normalized by a single thread in two passes over data that
+ *        is still in cache for the second. Zero rows are left unchanged.
+*/
+template<typename T, typename Alloc>
+void normalize_rows(Matrix<T, Alloc>& a, const ExecutionPolicy& policy = execution::automatic)
+{
+    static_assert(std::is_floating_point_v<T>, "normalize_rows needs a floating-point element type.");
+
+    T* data = a.data();
+    const size_t cols = a.num_cols();
+    const size_t ld = a.leading_dimension();
+    const bool use_kernels = policy.uses_simd();
+    auto normalize_block = [data, cols, ld, use_kernels](size_t begin, size_t end) {
+        for(size_t r = begin; r < end; ++r)
+        {
+            T* row = data + r * ld;
+            const double norm = norm2_block(row, cols, use_kernels);
+            if(norm == 0.0)
+            {
+                continue;
+            }
+            scale_to_unit_block(row, cols, norm, use_kernels);
+        }
+    };
+
+    if(policy.is_parallel(a.num_rows() * cols, max_dimensions_for_sequential<T>(Operation::Magnitude)))
+    {
+        parallel_for_blocks(policy.pool(), a.num_rows(), normalize_block);
+    }
+    else
+    {
+        normalize_block(0, a.num_rows());
+    }
+}
+
+/**
+ * @brief Scores one query against every row of candidates: out[i] is the dot
+ *        product of query with row i. out must already hold candidates.num_rows()
+ *        elements, so scoring in a loop allocates nothing. Throws if the dimensions
+ *        do not line up.
+ *
+ *        Dispatch and the parallel decision are made once for the whole batch, on
+ *        the total work rows * cols, and each thread streams its block of rows past
+ *        the query, four rows per pass, while the query stays in L1.
+*/
+template<typename T, typename AllocQ, typename AllocC, typename AllocOut>
+void dot_product_batch(
+    const ExecutionPolicy& policy
+    , const Vector<T, AllocQ>& query
+    , const Matrix<T, AllocC>& candidates
+    , Vector<T, AllocOut>& out)
+{
+    if(query.dimensions() != candidates.num_cols())
+    {
+        throw std::runtime_error("mismatched matrix dimensions.");
+    }
+    if(out.dimensions() != candidates.num_rows())
+    {
+        throw std::runtime_error("output size does not match the number of candidates.");
+    }
+
+    const T* rows = candidates.data();
+    const size_t cols = candidates.num_cols();
+    const size_t ld = candidates.leading_dimension();
+    const T* x = query.data();
+    T* scores = out.data();
+    const bool use_kernels = policy.uses_simd();
+    auto score_block = [rows, cols, ld, x, scores, use_kernels](size_t begin, size_t end) {
+        if(use_kernels)
+        {
+            simd::dot_rows(rows + begin * ld, ld, end - begin, x, cols, scores + begin);
+            return;
+        }
+        for(size_t r = begin; r < end; ++r)
+        {
+            scores[r] = dot_block<T>(rows + r * ld, x, cols, false);
+        }
+    };
+
+    if(policy.is_parallel(candidates.num_rows() * cols, max_dimensions_for_sequential<T>(Operation::DotProduct)))
+    {
+        parallel_for_blocks(policy.pool(), candidates.num_rows(), score_block);
+    }
+    else
+    {
+        score_block(0, candidates.num_rows());
+    }
+}
+
+template<typename T, typename AllocQ, typename AllocC, typename AllocOut>
+void dot_product_batch(const Vector<T, AllocQ>& query, const Matrix<T, AllocC>& candidates, Vector<T, AllocOut>& out)
+{
+    dot_product_batch(execution::automatic, query, candidates, out);
+}
+
+/**
+ * @brief Scores every row of queries against every row of candidates: out(i, j) is
+ *        the dot product of query i with candidate j. out must already be
+ *        queries.num_rows() x candidates.num_rows(). Throws if the dimensions do not
+ *        line up or if out is one of the inputs.
+ *
+ *        Candidates are read from memory once whatever the number of queries: a
+ *        tile of them is scored against every query while it is in cache. From
+ *        DotProductBatchConstants::minQueriesForGemm queries on, the SIMD policies
+ *        compute queries * candidates^T with gemm_transposed_b instead, reusing
+ *        each loaded candidate across a register tile of queries.
+*/
+template<typename T, typename AllocQ, typename AllocC, typename AllocOut>
+void dot_product_batch(
+    const ExecutionPolicy& policy
+    , const Matrix<T, AllocQ>& queries
+    , const Matrix<T, AllocC>& candidates
+    , Matrix<T, AllocOut>& out)
+{
+    if(queries.num_cols() != candidates.num_cols())
+    {
+        throw std::runtime_error("mismatched matrix dimensions.");
+    }
+    if(out.num_rows() != queries.num_rows() || out.num_cols() != candidates.num_rows())
+    {
+        throw std::runtime_error("output size does not match the number of queries and candidates.");
+    }
+    if(static_cast<const void*>(&out) == &queries || static_cast<const void*>(&out) == &candidates)
+    {
+        throw std::runtime_error("dot_product_batch output aliases an input.");
+    }
+
+    const size_t num_queries = queries.num_rows();
+    const bool use_kernels = policy.uses_simd();
+    if(use_kernels && num_queries >= DotProductBatchConstants::minQueriesForGemm)
+    {
+        gemm_transposed_b(
+            policy
+            , num_queries
+            , candidates.num_rows()
+            , queries.num_cols()
+            , T(1)
+            , queries.data()
+            , queries.leading_dimension()
+            , candidates.data()
+            , candidates.leading_dimension()
+            , T(0)
+            , out.data()
+            , out.leading_dimension());
+        return;
+    }
+
+    const T* query_rows = queries.data();
+    const size_t ldq = queries.leading_dimension();
+    const T* candidate_rows = candidates.data();
+    const size_t ldc = candidates.leading_dimension();
+    const size_t cols = queries.num_cols();
+    T* scores = out.data();
+    const size_t ldo = out.leading_dimension();
+    auto score_block = [=](size_t begin, size_t end) {
+        for(size_t tile = begin; tile < end; tile += DotProductBatchConstants::candidateTile)
+        {
+            const size_t tile_rows = std::min(DotProductBatchConstants::candidateTile, end - tile);
+            for(size_t i = 0; i < num_queries; ++i)
+            {
+                const T* query = query_rows + i * ldq;
+                T* query_scores = scores + i * ldo + tile;
+                if(use_kernels)
+                {
+                    simd::dot_rows(candidate_rows + tile * ldc, ldc, tile_rows, query, cols, query_scores);
+                    continue;
+                }
+                for(size_t j = 0; j < tile_rows; ++j)
+                {
+                    query_scores[j] = dot_block<T>(query, candidate_rows + (tile + j) * ldc, cols, false);
+                }
+            }
+        }
+    };
+
+    if(policy.is_parallel(num_queries * candidates.num_rows() * cols, max_dimensions_for_sequential<T>(Operation::DotProduct)))
+    {
+        parallel_for_blocks(policy.pool(), candidates.num_rows(), score_block);
+    }
+    else
+    {
+        score_block(0, candidates.num_rows());
+    }
+}
+
+template<typename T, typename AllocQ, typename AllocC, typename AllocOut>
+void dot_product_batch(const Matrix<T, AllocQ>& queries, const Matrix<T, AllocC>& candidates, Matrix<T, AllocOut>& out)
+{
+    dot_product_batch(execution::automatic, queries, candidates, out);
+}
+
 } // vctr
 } // arondina
 
-#endif
\ No newline at end of file
+#endif
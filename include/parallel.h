@@ -0,0 +1,257 @@
+#ifndef INCLUDED_ARONDINA_VCTR_PARALLEL
+#define INCLUDED_ARONDINA_VCTR_PARALLEL
+
+// vctr
+#include "execution_policy.h"
+#include "thread_pool.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#ifdef VCTR_USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+namespace arondina
+{
+namespace vctr
+{
+
+struct ParallelConstants
+{
+    /**
+     * @brief Blocks are multiples of this many elements so that neighbouring
+     *        blocks never share a cache line for any element type up to 8 bytes.
+    */
+    static constexpr size_t blockGranularity = 64;
+
+    /**
+     * @brief Blocks per hardware thread, to even out imbalance between workers.
+    */
+    static constexpr size_t blocksPerThread = 4;
+
+    /**
+     * @brief Fixed block size of the reproducible reductions. Independent of the
+     *        thread count by design; large enough to amortize scheduling.
+    */
+    static constexpr size_t reductionBlock = 4096;
+};
+
+/**
+ * @brief Number of threads the parallel kernels spread their work over, on pool if
+ *        given, otherwise on the default backend.
+*/
+inline size_t parallel_thread_count(ThreadPool* pool = nullptr)
+{
+    if(pool != nullptr)
+    {
+        return pool->size();
+    }
+#ifdef VCTR_USE_TBB
+    return static_cast<size_t>(tbb::this_task_arena::max_concurrency());
+#else
+    return default_thread_pool().size();
+#endif
+}
+
+/**
+ * @brief Calls fn(index) for every index in [0, count) in parallel, on pool if given,
+ *        otherwise on the default ThreadPool, or on oneTBB when built with VCTR_USE_TBB.
+*/
+template<typename Fn>
+void parallel_for(ThreadPool* pool, size_t count, Fn&& fn)
+{
+    if(pool != nullptr)
+    {
+        pool->run(count, fn);
+        return;
+    }
+#ifdef VCTR_USE_TBB
+    tbb::parallel_for(size_t(0), count, [&fn](size_t index) { fn(index); });
+#else
+    default_thread_pool().run(count, fn);
+#endif
+}
+
+template<typename Fn>
+void parallel_for(size_t count, Fn&& fn)
+{
+    parallel_for(nullptr, count, std::forward<Fn>(fn));
+}
+
+/**
+ * @brief Size of the blocks parallel_for_blocks cuts [0, n) into for the given
+ *        number of threads.
+*/
+inline size_t parallel_block_size(size_t n, size_t threads)
+{
+    const size_t target_blocks = threads * ParallelConstants::blocksPerThread;
+
+    size_t block_size = (n + target_blocks - 1) / target_blocks;
+    block_size = ((block_size + ParallelConstants::blockGranularity - 1) / ParallelConstants::blockGranularity)
+        * ParallelConstants::blockGranularity;
+
+    return std::max(block_size, ParallelConstants::blockGranularity);
+}
+
+/**
+ * @brief Splits [0, n) into contiguous blocks and calls fn(begin, end) for each of
+ *        them in parallel. Every kernel that runs on a range goes through here, so a
+ *        kernel only ever has to be written for a single contiguous block.
+*/
+template<typename Fn>
+void parallel_for_blocks(ThreadPool* pool, size_t n, Fn&& fn)
+{
+    if(n == 0)
+    {
+        return;
+    }
+
+    const size_t block_size = parallel_block_size(n, parallel_thread_count(pool));
+    const size_t num_blocks = (n + block_size - 1) / block_size;
+    parallel_for(pool, num_blocks, [&fn, n, block_size](size_t block) {
+        const size_t begin = block * block_size;
+        fn(begin, std::min(n, begin + block_size));
+    });
+}
+
+template<typename Fn>
+void parallel_for_blocks(size_t n, Fn&& fn)
+{
+    parallel_for_blocks(nullptr, n, std::forward<Fn>(fn));
+}
+
+/**
+ * @brief Parallel reduction over [0, n): fn(begin, end) reduces one block to an R,
+ *        and the block results are summed in block order starting from init.
+*/
+template<typename R, typename Fn>
+R parallel_sum_blocks(ThreadPool* pool, size_t n, R init, Fn&& fn)
+{
+    if(n == 0)
+    {
+        return init;
+    }
+
+    const size_t block_size = parallel_block_size(n, parallel_thread_count(pool));
+    const size_t num_blocks = (n + block_size - 1) / block_size;
+    std::vector<R> partials(num_blocks, R());
+    parallel_for(pool, num_blocks, [&fn, &partials, n, block_size](size_t block) {
+        const size_t begin = block * block_size;
+        partials[block] = fn(begin, std::min(n, begin + block_size));
+    });
+
+    for(const R& partial : partials)
+    {
+        init += partial;
+    }
+    return init;
+}
+
+template<typename R, typename Fn>
+R parallel_sum_blocks(size_t n, R init, Fn&& fn)
+{
+    return parallel_sum_blocks(nullptr, n, init, std::forward<Fn>(fn));
+}
+
+/**
+ * @brief Sums values in place along a fixed pairwise tree (0 += 1, 2 += 3, ...,
+ *        then 0 += 2, ...) and returns the total. The order depends only on the size.
+*/
+template<typename R>
+R pairwise_sum(std::vector<R>& values)
+{
+    if(values.empty())
+    {
+        return R();
+    }
+    for(size_t stride = 1; stride < values.size(); stride *= 2)
+    {
+        for(size_t i = 0; i + stride < values.size(); i += 2 * stride)
+        {
+            values[i] += values[i + stride];
+        }
+    }
+    return values[0];
+}
+
+/**
+ * @brief Reduction whose result does not depend on the thread count: [0, n) is cut
+ *        into ParallelConstants::reductionBlock blocks whatever the policy, fn(begin,
+ *        end) reduces each, and the block results are combined with pairwise_sum.
+ *        Threads only decide who computes which block.
+*/
+template<typename R, typename Fn>
+R reproducible_sum_blocks(const ExecutionPolicy& policy, size_t n, size_t max_dimensions_for_sequential, Fn&& fn)
+{
+    constexpr size_t block_size = ParallelConstants::reductionBlock;
+    const size_t num_blocks = (n + block_size - 1) / block_size;
+    if(num_blocks <= 1)
+    {
+        return n == 0 ? R() : R(fn(size_t(0), n));
+    }
+
+    std::vector<R> partials(num_blocks, R());
+    auto reduce_block = [&fn, &partials, n](size_t block) {
+        const size_t begin = block * block_size;
+        partials[block] = fn(begin, std::min(n, begin + block_size));
+    };
+
+    if(policy.is_parallel(n, max_dimensions_for_sequential))
+    {
+        parallel_for(policy.pool(), num_blocks, reduce_block);
+    }
+    else
+    {
+        for(size_t block = 0; block < num_blocks; ++block)
+        {
+            reduce_block(block);
+        }
+    }
+    return pairwise_sum(partials);
+}
+
+/**
+ * @brief Runs fn(begin, end) over [0, n) as the policy asks: in one call on the
+ *        calling thread, or split into blocks across threads. Automatic goes
+ *        parallel above max_dimensions_for_sequential.
+*/
+template<typename Fn>
+void for_blocks(const ExecutionPolicy& policy, size_t n, size_t max_dimensions_for_sequential, Fn&& fn)
+{
+    if(policy.is_parallel(n, max_dimensions_for_sequential))
+    {
+        parallel_for_blocks(policy.pool(), n, std::forward<Fn>(fn));
+    }
+    else if(n > 0)
+    {
+        fn(size_t(0), n);
+    }
+}
+
+/**
+ * @brief Reduction counterpart of for_blocks: init plus the sum of fn(begin, end)
+ *        over the blocks.
+*/
+template<typename R, typename Fn>
+R sum_blocks(const ExecutionPolicy& policy, size_t n, size_t max_dimensions_for_sequential, R init, Fn&& fn)
+{
+    if(policy.is_parallel(n, max_dimensions_for_sequential))
+    {
+        return parallel_sum_blocks(policy.pool(), n, init, std::forward<Fn>(fn));
+    }
+    if(n > 0)
+    {
+        init += fn(size_t(0), n);
+    }
+    return init;
+}
+
+} // vctr
+} // arondina
+
+#endif
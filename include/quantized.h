@@ -0,0 +1,306 @@
+#ifndef INCLUDED_ARONDINA_VCTR_QUANTIZED
+#define INCLUDED_ARONDINA_VCTR_QUANTIZED
+
+// vctr
+#include "aligned_allocator.h"
+#include "calibration.h"
+#include "execution_policy.h"
+#include "float16.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace arondina
+{
+namespace vctr
+{
+
+struct QuantizedConstants
+{
+    /**
+     * @brief Largest run of int8 elements handed to one int32 kernel call:
+     *        127 * 127 * 131072 still fits in an int32.
+    */
+    static constexpr size_t maxInt8Block = 131072;
+};
+
+/**
+ * @brief A vector stored in a compact element type E: int8_t, Float16 or BFloat16.
+ *        Dot products and distances between two QuantizedVectors of the same E run
+ *        on the compact form, widening a register at a time, so they read 2x (half
+ *        floats) or 4x (int8) fewer bytes than the float equivalent.
+ *
+ *        int8 is symmetric with one scale per vector: element i stands for
+ *        scale() * data()[i], with the largest magnitude mapped to 127, so every
+ *        element is within scale() / 2 of the original. Float16 and BFloat16 round
+ *        each element to nearest and have scale() 1.
+*/
+template<typename E>
+class QuantizedVector
+{
+    static_assert(std::is_same_v<E, int8_t> || std::is_same_v<E, Float16> || std::is_same_v<E, BFloat16>, "quantized vectors hold int8_t, Float16 or BFloat16.");
+
+public:
+    using element_type = E;
+
+    template<typename T, typename Alloc>
+    explicit QuantizedVector(const Vector<T, Alloc>& source)
+        : m_data(source.dimensions())
+    {
+        const size_t n = source.dimensions();
+        if constexpr (std::is_same_v<E, int8_t>)
+        {
+            double largest = 0.0;
+            for(size_t i = 0; i < n; ++i)
+            {
+                largest = std::max(largest, std::abs(static_cast<double>(source[i])));
+            }
+            m_scale = static_cast<float>(largest / 127.0);
+
+            const double inverse = largest > 0.0 ? 127.0 / largest : 0.0;
+            int64_t squares = 0;
+            for(size_t i = 0; i < n; ++i)
+            {
+                const double q = std::clamp(std::round(static_cast<double>(source[i]) * inverse), -127.0, 127.0);
+                m_data[i] = static_cast<int8_t>(q);
+                squares += static_cast<int64_t>(m_data[i]) * m_data[i];
+            }
+            m_squared_norm = static_cast<double>(m_scale) * m_scale * static_cast<double>(squares);
+        }
+        else
+        {
+            m_scale = 1.0f;
+            double squares = 0.0;
+            for(size_t i = 0; i < n; ++i)
+            {
+                m_data[i] = E::from_float(static_cast<float>(source[i]));
+                const double value = m_data[i].to_float();
+                squares += value * value;
+            }
+            m_squared_norm = squares;
+        }
+    }
+
+    size_t dimensions() const { return m_data.size(); }
+
+    const E* data() const { return m_data.data(); }
+
+    /**
+     * @brief The value one int8 step stands for; 1 for the float types.
+    */
+    float scale() const { return m_scale; }
+
+    /**
+     * @brief The squared L2 norm of the stored (not the original) values.
+    */
+    double squared_norm() const { return m_squared_norm; }
+
+    /**
+     * @brief Bytes taken by the elements.
+    */
+    size_t bytes() const { return m_data.size() * sizeof(E); }
+
+    /**
+     * @brief The stored values widened back to float.
+    */
+    Vector<float> dequantize() const
+    {
+        Vector<float> result(dimensions());
+        for(size_t i = 0; i < dimensions(); ++i)
+        {
+            if constexpr (std::is_same_v<E, int8_t>)
+            {
+                result[i] = m_scale * static_cast<float>(m_data[i]);
+            }
+            else
+            {
+                result[i] = m_data[i].to_float();
+            }
+        }
+        return result;
+    }
+
+private:
+    std::vector<E, AlignedAllocator<E, VectorConstants::alignment>> m_data;
+    float m_scale;
+    double m_squared_norm;
+};
+
+using Int8Vector = QuantizedVector<int8_t>;
+using Float16Vector = QuantizedVector<Float16>;
+using BFloat16Vector = QuantizedVector<BFloat16>;
+
+/**
+ * @brief Whether Q is a QuantizedVector. The free functions below take any Q and
+ *        check it with this trait rather than naming QuantizedVector<E>, so that an
+ *        explicit accumulator argument, as in dot_product<double>(a, b), never
+ *        instantiates a QuantizedVector of that type.
+*/
+template<typename Q>
+struct is_quantized_vector : std::false_type {};
+
+template<typename E>
+struct is_quantized_vector<QuantizedVector<E>> : std::true_type {};
+
+template<typename Q>
+inline constexpr bool is_quantized_vector_v = is_quantized_vector<Q>::value;
+
+/**
+ * @brief Unscaled dot product of n compact elements: exact in int64 for int8, in
+ *        float for the half floats.
+*/
+template<typename E>
+auto quantized_dot_block(const E* a, const E* b, size_t n, bool use_kernels)
+{
+    if constexpr (std::is_same_v<E, int8_t>)
+    {
+        int64_t sum = 0;
+        for(size_t begin = 0; begin < n; begin += QuantizedConstants::maxInt8Block)
+        {
+            const size_t count = std::min(n - begin, QuantizedConstants::maxInt8Block);
+            if(use_kernels)
+            {
+                sum += simd::dot_symmetric_int8(a + begin, b + begin, count);
+                continue;
+            }
+            for(size_t i = begin; i < begin + count; ++i)
+            {
+                sum += static_cast<int32_t>(a[i]) * b[i];
+            }
+        }
+        return sum;
+    }
+    else
+    {
+        if(use_kernels)
+        {
+            return simd::dot_accumulate<float>(a, b, n);
+        }
+        float sum = 0.0f;
+        for(size_t i = 0; i < n; ++i)
+        {
+            sum += a[i].to_float() * b[i].to_float();
+        }
+        return sum;
+    }
+}
+
+/**
+ * @brief Sum of squared differences of n half floats, widened to float.
+*/
+template<typename E>
+float quantized_squared_difference_block(const E* a, const E* b, size_t n, bool use_kernels)
+{
+    if(use_kernels)
+    {
+        return simd::sum_squared_difference(a, b, n);
+    }
+    float sum = 0.0f;
+    for(size_t i = 0; i < n; ++i)
+    {
+        const float difference = a[i].to_float() - b[i].to_float();
+        sum += difference * difference;
+    }
+    return sum;
+}
+
+/**
+ * @brief The dot product of the stored values of a and b, computed on the compact
+ *        form: int8 x int8 products summed exactly in integers and scaled once at
+ *        the end, half floats widened in registers and summed in float. Throws if
+ *        the dimensions differ.
+*/
+template<typename Q, typename = std::enable_if_t<is_quantized_vector_v<Q>>>
+float dot_product(const ExecutionPolicy& policy, const Q& a, const Q& b)
+{
+    using E = typename Q::element_type;
+    if(a.dimensions() != b.dimensions())
+    {
+        throw std::runtime_error("unequal vector sizes.");
+    }
+
+    const E* a_data = a.data();
+    const E* b_data = b.data();
+    const bool use_kernels = policy.uses_simd();
+    using R = decltype(quantized_dot_block(a_data, b_data, 0, use_kernels));
+    const R sum = sum_blocks(
+        policy
+        , a.dimensions()
+        , max_dimensions_for_sequential<float>(Operation::DotProduct)
+        , R()
+        , [a_data, b_data, use_kernels](size_t begin, size_t end) {
+            return quantized_dot_block(a_data + begin, b_data + begin, end - begin, use_kernels);
+        });
+
+    if constexpr (std::is_same_v<E, int8_t>)
+    {
+        return static_cast<float>(static_cast<double>(a.scale()) * b.scale() * static_cast<double>(sum));
+    }
+    else
+    {
+        return sum;
+    }
+}
+
+template<typename Q, typename = std::enable_if_t<is_quantized_vector_v<Q>>>
+float dot_product(const Q& a, const Q& b)
+{
+    return dot_product(execution::automatic, a, b);
+}
+
+/**
+ * @brief The squared L2 distance between the stored values of a and b. The half
+ *        floats subtract in float registers; int8 vectors with different scales
+ *        cannot be subtracted in integers, so their distance is expanded as
+ *        |a|^2 + |b|^2 - 2 a.b from the stored norms and the integer dot product,
+ *        clamped at zero. Throws if the dimensions differ.
+*/
+template<typename Q, typename = std::enable_if_t<is_quantized_vector_v<Q>>>
+float squared_l2_distance(const ExecutionPolicy& policy, const Q& a, const Q& b)
+{
+    using E = typename Q::element_type;
+    if constexpr (std::is_same_v<E, int8_t>)
+    {
+        const double dot = dot_product(policy, a, b);
+        return static_cast<float>(std::max(0.0, a.squared_norm() + b.squared_norm() - 2.0 * dot));
+    }
+    else
+    {
+        if(a.dimensions() != b.dimensions())
+        {
+            throw std::runtime_error("unequal vector sizes.");
+        }
+
+        const E* a_data = a.data();
+        const E* b_data = b.data();
+        const bool use_kernels = policy.uses_simd();
+        return sum_blocks(
+            policy
+            , a.dimensions()
+            , max_dimensions_for_sequential<float>(Operation::DotProduct)
+            , 0.0f
+            , [a_data, b_data, use_kernels](size_t begin, size_t end) {
+                return quantized_squared_difference_block(a_data + begin, b_data + begin, end - begin, use_kernels);
+            });
+    }
+}
+
+template<typename Q, typename = std::enable_if_t<is_quantized_vector_v<Q>>>
+float squared_l2_distance(const Q& a, const Q& b)
+{
+    return squared_l2_distance(execution::automatic, a, b);
+}
+
+} // vctr
+} // arondina
+
+#endif
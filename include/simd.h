@@ -0,0 +1,620 @@
+#ifndef INCLUDED_ARONDINA_VCTR_SIMD
+#define INCLUDED_ARONDINA_VCTR_SIMD
+
+// vctr
+#include "float16.h"
+
+// std
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace arondina
+{
+namespace vctr
+{
+namespace simd
+{
+
+/**
+ * @brief Instruction sets the kernels are compiled for, in increasing order of width.
+ *        AVX2 implies FMA, F16C and POPCNT. AVX512 implies the F, DQ, BW and VL
+ *        extensions.
+*/
+enum class InstructionSet
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+/**
+ * @brief Returns a readable name, e.g. "avx2".
+*/
+const char* to_string(InstructionSet instruction_set);
+
+/**
+ * @brief The widest instruction set that this binary contains kernels for and that
+ *        the CPU (and OS) supports. Determined once via CPUID.
+*/
+InstructionSet detected_instruction_set();
+
+/**
+ * @brief Returns true if kernels for instruction_set can run on this host.
+*/
+bool is_supported(InstructionSet instruction_set);
+
+/**
+ * @brief The instruction set the kernels currently dispatch to.
+ *        Defaults to detected_instruction_set().
+*/
+InstructionSet active_instruction_set();
+
+/**
+ * @brief Forces dispatch to the given instruction set, mostly useful for testing and
+ *        benchmarking. Throws std::runtime_error if the host does not support it.
+*/
+void set_instruction_set(InstructionSet instruction_set);
+
+/**
+ * @brief True for the element types that have hand-written kernels.
+ *        Every other type goes through the generic loops below.
+*/
+template<typename T>
+struct has_kernels : std::false_type {};
+
+template<> struct has_kernels<float> : std::true_type {};
+template<> struct has_kernels<double> : std::true_type {};
+template<> struct has_kernels<int32_t> : std::true_type {};
+template<> struct has_kernels<int64_t> : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_kernels_v = has_kernels<T>::value;
+
+/**
+ * @brief out[i] = a[i] + b[i] for i in [0, n). out may alias a or b.
+*/
+void add(const float* a, const float* b, float* out, size_t n);
+void add(const double* a, const double* b, double* out, size_t n);
+void add(const int32_t* a, const int32_t* b, int32_t* out, size_t n);
+void add(const int64_t* a, const int64_t* b, int64_t* out, size_t n);
+
+template<typename T>
+void add(const T* a, const T* b, T* out, size_t n)
+{
+    for(size_t i = 0; i < n; ++i)
+    {
+        out[i] = a[i] + b[i];
+    }
+}
+
+/**
+ * @brief out[i] = a[i] - b[i] for i in [0, n). out may alias a or b.
+*/
+void subtract(const float* a, const float* b, float* out, size_t n);
+void subtract(const double* a, const double* b, double* out, size_t n);
+void subtract(const int32_t* a, const int32_t* b, int32_t* out, size_t n);
+void subtract(const int64_t* a, const int64_t* b, int64_t* out, size_t n);
+
+template<typename T>
+void subtract(const T* a, const T* b, T* out, size_t n)
+{
+    for(size_t i = 0; i < n; ++i)
+    {
+        out[i] = a[i] - b[i];
+    }
+}
+
+/**
+ * @brief data[i] *= scalar for i in [0, n). The product is formed in double precision
+ *        and converted back to the element type, exactly like the scalar statement.
+*/
+void scale(float* data, double scalar, size_t n);
+void scale(double* data, double scalar, size_t n);
+void scale(int32_t* data, double scalar, size_t n);
+void scale(int64_t* data, double scalar, size_t n);
+
+template<typename T>
+void scale(T* data, double scalar, size_t n)
+{
+    for(size_t i = 0; i < n; ++i)
+    {
+        data[i] *= scalar;
+    }
+}
+
+/**
+ * @brief out[r] = sum over i of rows[r * ld + i] * x[i], for r in [0, num_rows) and
+ *        i in [0, n). Rows are processed four at a time so x is read once per group.
+*/
+void dot_rows(const float* rows, size_t ld, size_t num_rows, const float* x, size_t n, float* out);
+void dot_rows(const double* rows, size_t ld, size_t num_rows, const double* x, size_t n, double* out);
+void dot_rows(const int32_t* rows, size_t ld, size_t num_rows, const int32_t* x, size_t n, int32_t* out);
+void dot_rows(const int64_t* rows, size_t ld, size_t num_rows, const int64_t* x, size_t n, int64_t* out);
+
+template<typename T>
+void dot_rows(const T* rows, size_t ld, size_t num_rows, const T* x, size_t n, T* out)
+{
+    for(size_t r = 0; r < num_rows; ++r)
+    {
+        T sum = T();
+        for(size_t i = 0; i < n; ++i)
+        {
+            sum += rows[r * ld + i] * x[i];
+        }
+        out[r] = sum;
+    }
+}
+
+/**
+ * @brief y[i] += sum over r of alphas[r] * rows[r * ld + i], for r in [0, num_rows)
+ *        and i in [0, n). Rows are processed four at a time so y is read and written
+ *        once per group.
+*/
+void axpy_rows(const float* rows, size_t ld, size_t num_rows, const float* alphas, size_t n, float* y);
+void axpy_rows(const double* rows, size_t ld, size_t num_rows, const double* alphas, size_t n, double* y);
+void axpy_rows(const int32_t* rows, size_t ld, size_t num_rows, const int32_t* alphas, size_t n, int32_t* y);
+void axpy_rows(const int64_t* rows, size_t ld, size_t num_rows, const int64_t* alphas, size_t n, int64_t* y);
+
+template<typename T>
+void axpy_rows(const T* rows, size_t ld, size_t num_rows, const T* alphas, size_t n, T* y)
+{
+    for(size_t r = 0; r < num_rows; ++r)
+    {
+        for(size_t i = 0; i < n; ++i)
+        {
+            y[i] += alphas[r] * rows[r * ld + i];
+        }
+    }
+}
+
+/**
+ * @brief Dot product of a and b over n elements, with products and sums computed in
+ *        Acc. The widening pairs float -> double, int8 -> int32, int32 -> int64,
+ *        Float16 -> float and BFloat16 -> float have kernels that convert a register
+ *        of T into Acc lanes on the fly, so the data stays compact in memory.
+ *        Acc == T goes to dot_rows; every other pair runs the plain loop.
+*/
+template<typename Acc, typename T>
+Acc dot_accumulate(const T* a, const T* b, size_t n)
+{
+    if constexpr (std::is_same_v<Acc, T> && has_kernels_v<T>)
+    {
+        T result = T();
+        dot_rows(a, 0, 1, b, n, &result);
+        return result;
+    }
+    else
+    {
+        Acc sum = Acc();
+        for(size_t i = 0; i < n; ++i)
+        {
+            sum += static_cast<Acc>(a[i]) * static_cast<Acc>(b[i]);
+        }
+        return sum;
+    }
+}
+
+template<> double dot_accumulate<double, float>(const float* a, const float* b, size_t n);
+template<> int32_t dot_accumulate<int32_t, int8_t>(const int8_t* a, const int8_t* b, size_t n);
+template<> int64_t dot_accumulate<int64_t, int32_t>(const int32_t* a, const int32_t* b, size_t n);
+template<> float dot_accumulate<float, Float16>(const Float16* a, const Float16* b, size_t n);
+template<> float dot_accumulate<float, BFloat16>(const BFloat16* a, const BFloat16* b, size_t n);
+
+/**
+ * @brief dot_accumulate<int32_t>(a, b, n) for inputs in [-127, 127], as symmetric
+ *        quantization produces. Leaving out -128 lets the AVX2 kernel multiply 32
+ *        pairs per instruction with maddubs (|a| times b with a's sign) without its
+ *        int16 pair sums saturating. The result is unspecified if either input holds
+ *        -128.
+*/
+int32_t dot_symmetric_int8(const int8_t* a, const int8_t* b, size_t n);
+
+/**
+ * @brief Dot product of a and b over n elements whose result is bit-for-bit the same
+ *        on every instruction set: a fixed 64-byte lane layout, separate multiply and
+ *        add, a fixed pairwise fold of the lanes and the leftover elements added in
+ *        order. Slower than dot_rows only by forgoing FMA.
+*/
+float dot_reproducible(const float* a, const float* b, size_t n);
+double dot_reproducible(const double* a, const double* b, size_t n);
+int32_t dot_reproducible(const int32_t* a, const int32_t* b, size_t n);
+int64_t dot_reproducible(const int64_t* a, const int64_t* b, size_t n);
+
+template<typename T>
+T dot_reproducible(const T* a, const T* b, size_t n)
+{
+    T sum = T();
+    for(size_t i = 0; i < n; ++i)
+    {
+        const T product = a[i] * b[i];
+        sum += product;
+    }
+    return sum;
+}
+
+/**
+ * @brief A sum carried as an unevaluated pair: the rounded sum and the rounding
+ *        errors collected alongside it. Adding two of them recovers the error of
+ *        that addition too (TwoSum), so partial results from separate blocks can be
+ *        combined without giving back what the compensated kernels gained. Integer
+ *        sums are exact and only ever use sum.
+*/
+template<typename T>
+struct Compensated
+{
+    T sum = T();
+    T error = T();
+
+    Compensated& operator+=(const Compensated& rhs)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            const T total = sum + rhs.sum;
+            const T z = total - sum;
+            error += ((sum - (total - z)) + (rhs.sum - z)) + rhs.error;
+            sum = total;
+        }
+        else
+        {
+            sum += rhs.sum;
+            error += rhs.error;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief The sum rounded once to T.
+    */
+    T value() const
+    {
+        return sum + error;
+    }
+};
+
+/**
+ * @brief Compensated dot product of a and b over n elements (Dot2, Ogita, Rump and
+ *        Oishi): every product is split into its rounded value and exact error,
+ *        every addition keeps its rounding error, and the errors are summed on the
+ *        side. The result is as accurate as if computed in twice the working
+ *        precision and then rounded, at a few times the cost of dot_rows. The
+ *        error-free products use FMA on AVX2 and AVX512 and Dekker's split on the
+ *        narrower tables.
+*/
+Compensated<float> dot_compensated(const float* a, const float* b, size_t n);
+Compensated<double> dot_compensated(const double* a, const double* b, size_t n);
+Compensated<int32_t> dot_compensated(const int32_t* a, const int32_t* b, size_t n);
+Compensated<int64_t> dot_compensated(const int64_t* a, const int64_t* b, size_t n);
+
+template<typename T>
+Compensated<T> dot_compensated(const T* a, const T* b, size_t n)
+{
+    Compensated<T> result;
+    for(size_t i = 0; i < n; ++i)
+    {
+        const T product = a[i] * b[i];
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            result += Compensated<T>{product, std::fma(a[i], b[i], -product)};
+        }
+        else
+        {
+            result.sum += product;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief The sum of squares behind an overflow-safe 2-norm, kept in three
+ *        accumulators (Blue's algorithm, as in LAPACK's nrm2): squares of tiny
+ *        values are scaled up, squares of huge values scaled down, and everything
+ *        in between is summed as is. Each element only needs comparisons and a
+ *        multiply, so it vectorizes and needs a single pass, unlike the
+ *        divide-per-element scale updates of the classic nrm2. Infinities land in
+ *        big and NaN in medium, so both propagate to norm().
+*/
+template<typename T>
+struct ScaledSquares
+{
+    static_assert(std::is_floating_point_v<T>, "ScaledSquares needs a floating-point type.");
+
+    /**
+     * @brief 2^e, exactly.
+    */
+    static constexpr T power_of_two(int e)
+    {
+        T result = T(1);
+        for(; e > 0; --e) { result *= T(2); }
+        for(; e < 0; ++e) { result /= T(2); }
+        return result;
+    }
+
+    static constexpr int floor_half(int x)
+    {
+        return x >= 0 ? x / 2 : -((1 - x) / 2);
+    }
+
+    static constexpr int ceil_half(int x)
+    {
+        return -floor_half(-x);
+    }
+
+    static constexpr int digits = std::numeric_limits<T>::digits;
+    static constexpr int min_exponent = std::numeric_limits<T>::min_exponent;
+    static constexpr int max_exponent = std::numeric_limits<T>::max_exponent;
+
+    // Below small_threshold a square may underflow, above big_threshold it may overflow.
+    static constexpr T small_threshold = power_of_two(ceil_half(min_exponent - 1));
+    static constexpr T big_threshold = power_of_two(floor_half(max_exponent - digits + 1));
+    static constexpr T small_scale = power_of_two(-floor_half(min_exponent - digits));
+    static constexpr T big_scale = power_of_two(-ceil_half(max_exponent + digits - 1));
+
+    T small = T();
+    T medium = T();
+    T big = T();
+
+    /**
+     * @brief Adds the square of a single value.
+    */
+    void add(T value)
+    {
+        const T magnitude = std::abs(value);
+        if(magnitude > big_threshold)
+        {
+            big += (magnitude * big_scale) * (magnitude * big_scale);
+        }
+        else if(magnitude < small_threshold)
+        {
+            small += (magnitude * small_scale) * (magnitude * small_scale);
+        }
+        else
+        {
+            medium += magnitude * magnitude;
+        }
+    }
+
+    ScaledSquares& operator+=(const ScaledSquares& rhs)
+    {
+        small += rhs.small;
+        medium += rhs.medium;
+        big += rhs.big;
+        return *this;
+    }
+
+    /**
+     * @brief sqrt of the sum of squares. The largest non-empty accumulator decides
+     *        the scale; the next one down is folded into it, and small values are
+     *        dropped next to big ones, where they cannot change the result.
+    */
+    T norm() const
+    {
+        T scale = T(1);
+        T sum = medium;
+        if(big > T(0))
+        {
+            sum = big;
+            if(medium > T(0) || medium != medium)
+            {
+                sum += (medium * big_scale) * big_scale;
+            }
+            scale = T(1) / big_scale;
+        }
+        else if(small > T(0))
+        {
+            if(medium > T(0) || medium != medium)
+            {
+                const T root_medium = std::sqrt(medium);
+                const T root_small = std::sqrt(small) / small_scale;
+                const T high = root_small > root_medium ? root_small : root_medium;
+                const T low = root_small > root_medium ? root_medium : root_small;
+                const T ratio = low / high;
+                sum = high * high * (T(1) + ratio * ratio);
+            }
+            else
+            {
+                sum = small;
+                scale = T(1) / small_scale;
+            }
+        }
+        return scale * std::sqrt(sum);
+    }
+};
+
+/**
+ * @brief Accumulates the squares of x over n elements into a ScaledSquares in one
+ *        pass; norm() of the result is the 2-norm of x without overflow or underflow.
+ *        Only double has kernels: the square of any float is representable in
+ *        double, so float data is better served by dot_accumulate<double>.
+*/
+ScaledSquares<double> scaled_squares(const double* x, size_t n);
+
+template<typename T>
+ScaledSquares<T> scaled_squares(const T* x, size_t n)
+{
+    ScaledSquares<T> result;
+    for(size_t i = 0; i < n; ++i)
+    {
+        result.add(x[i]);
+    }
+    return result;
+}
+
+/**
+ * @brief Reductions of the difference a[i] - b[i] over n elements in a single pass,
+ *        without materializing it: the sum of its absolute values (L1 distance),
+ *        the sum of its squares (squared L2 distance) and its largest absolute value
+ *        (L-infinity distance). The difference is formed in T, as operator- does.
+*/
+float sum_abs_difference(const float* a, const float* b, size_t n);
+double sum_abs_difference(const double* a, const double* b, size_t n);
+int32_t sum_abs_difference(const int32_t* a, const int32_t* b, size_t n);
+int64_t sum_abs_difference(const int64_t* a, const int64_t* b, size_t n);
+
+template<typename T>
+T sum_abs_difference(const T* a, const T* b, size_t n)
+{
+    T sum = T();
+    for(size_t i = 0; i < n; ++i)
+    {
+        const T difference = a[i] - b[i];
+        sum += difference < T(0) ? -difference : difference;
+    }
+    return sum;
+}
+
+float sum_squared_difference(const float* a, const float* b, size_t n);
+double sum_squared_difference(const double* a, const double* b, size_t n);
+int32_t sum_squared_difference(const int32_t* a, const int32_t* b, size_t n);
+int64_t sum_squared_difference(const int64_t* a, const int64_t* b, size_t n);
+
+/**
+ * @brief Sum of squared differences of compact floats, widened to float before the
+ *        subtraction.
+*/
+float sum_squared_difference(const Float16* a, const Float16* b, size_t n);
+float sum_squared_difference(const BFloat16* a, const BFloat16* b, size_t n);
+
+template<typename T>
+T sum_squared_difference(const T* a, const T* b, size_t n)
+{
+    T sum = T();
+    for(size_t i = 0; i < n; ++i)
+    {
+        const T difference = a[i] - b[i];
+        sum += difference * difference;
+    }
+    return sum;
+}
+
+float max_abs_difference(const float* a, const float* b, size_t n);
+double max_abs_difference(const double* a, const double* b, size_t n);
+int32_t max_abs_difference(const int32_t* a, const int32_t* b, size_t n);
+int64_t max_abs_difference(const int64_t* a, const int64_t* b, size_t n);
+
+template<typename T>
+T max_abs_difference(const T* a, const T* b, size_t n)
+{
+    T largest = T();
+    for(size_t i = 0; i < n; ++i)
+    {
+        const T difference = a[i] - b[i];
+        const T magnitude = difference < T(0) ? -difference : difference;
+        largest = magnitude > largest ? magnitude : largest;
+    }
+    return largest;
+}
+
+/**
+ * @brief The three sums behind a cosine similarity: a . b, a . a and b . b.
+*/
+template<typename T>
+struct CosineSums
+{
+    T dot = T();
+    T squares_a = T();
+    T squares_b = T();
+
+    CosineSums& operator+=(const CosineSums& rhs)
+    {
+        dot += rhs.dot;
+        squares_a += rhs.squares_a;
+        squares_b += rhs.squares_b;
+        return *this;
+    }
+};
+
+/**
+ * @brief Gathers the CosineSums of a and b over n elements in one pass, so each
+ *        element of either input is loaded once instead of twice over three
+ *        separate reductions.
+*/
+CosineSums<float> cosine_sums(const float* a, const float* b, size_t n);
+CosineSums<double> cosine_sums(const double* a, const double* b, size_t n);
+CosineSums<int32_t> cosine_sums(const int32_t* a, const int32_t* b, size_t n);
+CosineSums<int64_t> cosine_sums(const int64_t* a, const int64_t* b, size_t n);
+
+template<typename T>
+CosineSums<T> cosine_sums(const T* a, const T* b, size_t n)
+{
+    CosineSums<T> result;
+    for(size_t i = 0; i < n; ++i)
+    {
+        result.dot += a[i] * b[i];
+        result.squares_a += a[i] * a[i];
+        result.squares_b += b[i] * b[i];
+    }
+    return result;
+}
+
+/**
+ * @brief Layout of the 4-bit product-quantization codes read by pq4_scan. Codes come
+ *        in blocks of blockSize vectors. Within a block every subquantizer takes
+ *        bytesPerSubquantizer bytes, byte j holding the code of vector j in its low
+ *        nibble and that of vector j + 16 in its high nibble.
+*/
+struct Pq4Constants
+{
+    static constexpr size_t blockSize = 32;
+    static constexpr size_t bytesPerSubquantizer = 16;
+};
+
+/**
+ * @brief For every vector of num_blocks blocks of 4-bit codes, the sum over the
+ *        num_subquantizers subquantizers s of luts[16 * s + code], saturated at 65535,
+ *        into out[Pq4Constants::blockSize * block + j]. luts holds 16 entries per
+ *        subquantizer. The AVX2 and AVX-512 tables keep the lookup tables in
+ *        registers, where one pshufb looks up 16 codes at once; SSE2 and scalar use
+ *        the plain loop.
+*/
+void pq4_scan(const uint8_t* codes, size_t num_blocks, size_t num_subquantizers, const uint8_t* luts, uint16_t* out);
+
+/**
+ * @brief The number of set bits in x, by the usual SWAR folding; compilers turn it
+ *        into a single popcnt where the target has one.
+*/
+inline uint64_t popcount(uint64_t x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (x * 0x0101010101010101ull) >> 56;
+}
+
+/**
+ * @brief The set bits of a & b and of a | b over the same words, for the Jaccard
+ *        similarity both / either.
+*/
+struct BitCounts
+{
+    uint64_t both = 0;
+    uint64_t either = 0;
+};
+
+/**
+ * @brief The Hamming distance between two bit strings of n 64-bit words: the set
+ *        bits of a ^ b. Counted with VPOPCNTDQ where the CPU has it and a 4-bit
+ *        lookup table in byte shuffles on AVX2 and AVX-512BW.
+*/
+uint64_t hamming_distance(const uint64_t* a, const uint64_t* b, size_t n);
+
+/**
+ * @brief The BitCounts of a and b over n 64-bit words, in one pass.
+*/
+BitCounts bit_counts(const uint64_t* a, const uint64_t* b, size_t n);
+
+/**
+ * @brief out[r] = hamming_distance(rows + r * ld, x, n) for r in [0, num_rows).
+ *        Dispatches once for the whole batch, so short signatures of a few words
+ *        are not dominated by the call.
+*/
+void hamming_distance_rows(const uint64_t* rows, size_t ld, size_t num_rows, const uint64_t* x, size_t n, uint32_t* out);
+
+} // simd
+} // vctr
+} // arondina
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef INCLUDED_ARONDINA_VCTR_THREAD_POOL
+#define INCLUDED_ARONDINA_VCTR_THREAD_POOL
+
+// vctr
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief How a ThreadPool is set up.
+*/
+struct ThreadPoolOptions
+{
+    /**
+     * @brief Total number of threads that work on a job, counting the thread that
+     *        submits it. 0 means std::thread::hardware_concurrency().
+    */
+    size_t threads = 0;
+
+    /**
+     * @brief Pin worker i to logical CPU i (modulo the CPU count). The submitting
+     *        thread is never pinned. Only honoured on Linux.
+    */
+    bool pin_threads = false;
+};
+
+/**
+ * @brief Fixed-size work-stealing thread pool that runs one parallel loop at a time.
+ *
+ *        run(count, fn) hands every participant (the workers plus the calling thread)
+ *        an even share of [0, count). Each participant works through its own share
+ *        from the front and, once it runs dry, steals the back half of whichever share
+ *        still has work left. Shares are a (begin, end) pair packed into one atomic
+ *        word, so neither taking nor stealing ever locks.
+ *
+ *        Workers are started lazily by the first run() and then sleep between jobs.
+ *        A run() issued from inside a task, or while another thread's run() is in
+ *        flight, executes inline on the calling thread instead of deadlocking.
+*/
+class ThreadPool
+{
+public:
+    explicit ThreadPool(const ThreadPoolOptions& options = ThreadPoolOptions());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Number of threads that work on a job, including the caller.
+    */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief Calls fn(index) for every index in [0, count) and returns once all of
+     *        them have finished. The first exception thrown by a task is rethrown here
+     *        after the remaining tasks complete.
+    */
+    template<typename Fn>
+    void run(size_t count, Fn&& fn)
+    {
+        using Callable = std::remove_reference_t<Fn>;
+        run_tasks(
+            count
+            , [](void* context, size_t index) { (*static_cast<Callable*>(context))(index); }
+            , const_cast<void*>(static_cast<const void*>(std::addressof(fn))));
+    }
+
+private:
+    using Invoke = void (*)(void* context, size_t index);
+
+    /**
+     * @brief One participant's share of the current job: begin in the high 32 bits,
+     *        end in the low 32 bits. Padded to its own cache line.
+    */
+    struct alignas(64) Share
+    {
+        std::atomic<uint64_t> range{0};
+    };
+
+    size_t m_size;
+    bool m_pin_threads;
+
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<Share[]> m_shares;
+
+    std::mutex m_submit;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    // current job, guarded by m_mutex when published
+    Invoke m_invoke;
+    void* m_context;
+    std::atomic<size_t> m_remaining;
+    uint64_t m_generation;
+    bool m_open;
+    size_t m_active;
+    bool m_stop;
+    std::exception_ptr m_error;
+
+    void run_tasks(size_t count, Invoke invoke, void* context);
+    void start();
+    void worker_loop(size_t share);
+    void participate(size_t share);
+    bool take(size_t share, size_t& index);
+    bool steal(size_t thief, size_t& index);
+    void execute(size_t index);
+};
+
+/**
+ * @brief The pool every parallel kernel in vctr runs on, created on first use.
+ *        Its size defaults to the VCTR_NUM_THREADS environment variable when set,
+ *        otherwise to the hardware concurrency.
+*/
+ThreadPool& default_thread_pool();
+
+/**
+ * @brief Replaces the default pool with one built from options. Must not be called
+ *        while a parallel kernel is running.
+*/
+void configure_thread_pool(const ThreadPoolOptions& options);
+
+} // vctr
+} // arondina
+
+#endif
@@ -2,35 +2,310 @@
 #define INCLUDED_ARONDINA_VCTR_VECTOR
 
 // vctr
+#include "accumulator.h"
+#include "aligned_allocator.h"
+#include "calibration.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector_expression.h"
 
 // std
 #include <algorithm>
 #include <cmath>
-#include <execution>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <initializer_list>
+#include <iterator>
 #include <memory>
+#include <numeric>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace arondina
 {
 namespace vctr
 {
 
+/**
+ * @brief Default sequential/parallel crossovers, used until calibrate() measures the host.
+ *        See calibration.h.
+*/
 struct VectorConstants
 {
     static const size_t maxDimensionsForSequentialArithmeticOps;
     static const size_t maxDimensionsForSequentialDotProduct; 
+
+    /**
+     * @brief Byte alignment of the default Vector buffer, and the granularity its
+     *        capacity is rounded up to. One cache line, and one AVX-512 register.
+    */
+    static constexpr size_t alignment = 64;
 };
 
+/**
+ * @brief a . b over n elements accumulated in Acc: with the SIMD kernels when
+ *        use_kernels, otherwise a plain loop.
+*/
+template<typename Acc, typename T>
+Acc dot_block(const T* a, const T* b, size_t n, bool use_kernels)
+{
+    if(use_kernels)
+    {
+        return simd::dot_accumulate<Acc>(a, b, n);
+    }
+    Acc result = Acc();
+    for(size_t i = 0; i < n; ++i)
+    {
+        result += static_cast<Acc>(a[i]) * static_cast<Acc>(b[i]);
+    }
+    return result;
+}
+
+/**
+ * @brief The overflow-safe 2-norm of n contiguous elements on the calling thread,
+ *        see Vector::norm2.
+*/
+template<typename T>
+double norm2_block(const T* data, size_t n, bool use_kernels)
+{
+    if constexpr (std::is_floating_point_v<T> && !std::is_same_v<T, float>)
+    {
+        const simd::ScaledSquares<T> squares = use_kernels ? simd::scaled_squares(data, n) : simd::scaled_squares<T>(data, n);
+        return static_cast<double>(squares.norm());
+    }
+    else
+    {
+        return std::sqrt(dot_block<double>(data, data, n, use_kernels));
+    }
+}
+
+/**
+ * @brief Splits 1 / norm into prescale times the returned factor. prescale is 1
+ *        unless norm is below about 5.6e-309, where 1 / norm overflows; then it is
+ *        2^600, which lifts the (subnormal) elements exactly.
+*/
+inline double unit_scale(double norm, double& prescale)
+{
+    prescale = 1.0;
+    const double scalar = 1.0 / norm;
+    if(std::isfinite(scalar))
+    {
+        return scalar;
+    }
+    prescale = std::ldexp(1.0, 600);
+    return 1.0 / (norm * prescale);
+}
+
+/**
+ * @brief Scales n contiguous elements whose 2-norm is norm > 0 to unit length on the
+ *        calling thread, see Vector::normalize.
+*/
+template<typename T>
+void scale_to_unit_block(T* data, size_t n, double norm, bool use_kernels)
+{
+    double prescale;
+    const double scalar = unit_scale(norm, prescale);
+    for(double factor : {prescale, scalar})
+    {
+        if(factor == 1.0)
+        {
+            continue;
+        }
+        if(use_kernels)
+        {
+            simd::scale(data, factor, n);
+        }
+        else
+        {
+            for(size_t i = 0; i < n; ++i)
+            {
+                data[i] = static_cast<T>(data[i] * factor);
+            }
+        }
+    }
+}
+
+/**
+ * @brief The magnitude of n contiguous elements, carried out as policy asks, see
+ *        Vector::magnitude.
+*/
+template<typename Acc, typename T>
+double contiguous_magnitude(const ExecutionPolicy& policy, const T* data, size_t n)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        if(policy.reduction() == ExecutionPolicy::Reduction::Reproducible)
+        {
+            const double sum_squares = reproducible_sum_blocks<double>(
+                policy
+                , n
+                , max_dimensions_for_sequential<T>(Operation::Magnitude)
+                , [data](size_t begin, size_t end) {
+                    return static_cast<double>(simd::dot_reproducible(data + begin, data + begin, end - begin));
+                });
+            return std::sqrt(sum_squares);
+        }
+        if(policy.reduction() == ExecutionPolicy::Reduction::Compensated)
+        {
+            const bool use_kernels = policy.uses_simd();
+            const simd::Compensated<T> sum_squares = sum_blocks(
+                policy
+                , n
+                , max_dimensions_for_sequential<T>(Operation::Magnitude)
+                , simd::Compensated<T>()
+                , [data, use_kernels](size_t begin, size_t end) {
+                    return use_kernels
+                        ? simd::dot_compensated(data + begin, data + begin, end - begin)
+                        : simd::dot_compensated<T>(data + begin, data + begin, end - begin);
+                });
+            return std::sqrt(static_cast<double>(sum_squares.sum) + static_cast<double>(sum_squares.error));
+        }
+    }
+
+    const bool use_kernels = policy.uses_simd();
+    const Acc sum_squares = sum_blocks(
+        policy
+        , n
+        , max_dimensions_for_sequential<T>(Operation::Magnitude)
+        , Acc()
+        , [data, use_kernels](size_t begin, size_t end) {
+            return dot_block<Acc>(data + begin, data + begin, end - begin, use_kernels);
+        });
+
+    return std::sqrt(static_cast<double>(sum_squares));
+}
+
+/**
+ * @brief The overflow-safe 2-norm of n contiguous elements, carried out as policy
+ *        asks, see Vector::norm2.
+*/
+template<typename T>
+double contiguous_norm2(const ExecutionPolicy& policy, const T* data, size_t n)
+{
+    const bool use_kernels = policy.uses_simd();
+    if constexpr (std::is_floating_point_v<T> && !std::is_same_v<T, float>)
+    {
+        // the explicit template argument selects the plain-loop version for Sequenced and Parallel
+        const simd::ScaledSquares<T> squares = sum_blocks(
+            policy
+            , n
+            , max_dimensions_for_sequential<T>(Operation::Magnitude)
+            , simd::ScaledSquares<T>()
+            , [data, use_kernels](size_t begin, size_t end) {
+                return use_kernels
+                    ? simd::scaled_squares(data + begin, end - begin)
+                    : simd::scaled_squares<T>(data + begin, end - begin);
+            });
+        return static_cast<double>(squares.norm());
+    }
+    else
+    {
+        const double sum_squares = sum_blocks(
+            policy
+            , n
+            , max_dimensions_for_sequential<T>(Operation::Magnitude)
+            , 0.0
+            , [data, use_kernels](size_t begin, size_t end) {
+                return dot_block<double>(data + begin, data + begin, end - begin, use_kernels);
+            });
+        return std::sqrt(sum_squares);
+    }
+}
+
+/**
+ * @brief a . b over n elements a_stride and b_stride apart, accumulated in Acc on the
+ *        calling thread. The strided counterpart of dot_block: always a plain loop,
+ *        as the kernels need contiguous input.
+*/
+template<typename Acc, typename T>
+Acc strided_dot_block(const T* a, size_t a_stride, const T* b, size_t b_stride, size_t n)
+{
+    Acc result = Acc();
+    for(size_t i = 0; i < n; ++i)
+    {
+        result += static_cast<Acc>(a[i * a_stride]) * static_cast<Acc>(b[i * b_stride]);
+    }
+    return result;
+}
+
+/**
+ * @brief lhs . rhs over n strided elements with the Fast reduction, summed in R in
+ *        the same blocks as contiguous_dot_product. max_dimensions_for_sequential is
+ *        the crossover of the calling operation.
+*/
+template<typename R, typename T>
+R strided_dot_product(
+    const ExecutionPolicy& policy
+    , const T* lhs_data
+    , size_t lhs_stride
+    , const T* rhs_data
+    , size_t rhs_stride
+    , size_t n
+    , size_t max_dimensions_for_sequential)
+{
+    return sum_blocks(
+        policy
+        , n
+        , max_dimensions_for_sequential
+        , R()
+        , [lhs_data, lhs_stride, rhs_data, rhs_stride](size_t begin, size_t end) {
+            return strided_dot_block<R>(lhs_data + begin * lhs_stride, lhs_stride, rhs_data + begin * rhs_stride, rhs_stride, end - begin);
+        });
+}
+
+/**
+ * @brief The overflow-safe 2-norm of n elements stride apart, carried out as policy
+ *        asks, see Vector::norm2.
+*/
+template<typename T>
+double strided_norm2(const ExecutionPolicy& policy, const T* data, size_t stride, size_t n)
+{
+    if constexpr (std::is_floating_point_v<T> && !std::is_same_v<T, float>)
+    {
+        const simd::ScaledSquares<T> squares = sum_blocks(
+            policy
+            , n
+            , max_dimensions_for_sequential<T>(Operation::Magnitude)
+            , simd::ScaledSquares<T>()
+            , [data, stride](size_t begin, size_t end) {
+                simd::ScaledSquares<T> result;
+                for(size_t i = begin; i < end; ++i)
+                {
+                    result.add(data[i * stride]);
+                }
+                return result;
+            });
+        return static_cast<double>(squares.norm());
+    }
+    else
+    {
+        return std::sqrt(strided_dot_product<double>(
+            policy, data, stride, data, stride, n, max_dimensions_for_sequential<T>(Operation::Magnitude)));
+    }
+}
+
 /**
  * @brief A class representing a mathematical vector of elements
  *        T must support +, -, *, and /.
+ *
+ *        Storage comes from Alloc, any standard allocator for T that hands out raw
+ *        pointers (arena, pool, NUMA-local, huge-page, pinned, ...). Allocators are
+ *        propagated and compared following the usual allocator_traits rules. The
+ *        default allocator aligns the buffer to VectorConstants::alignment.
+ *
+ *        For arithmetic T the buffer is padded up to a whole number of
+ *        VectorConstants::alignment bytes, and the padding is kept zero, so the SIMD
+ *        kernels can run full-width from data() to data() + padded_dimensions().
 */
-template <typename T>
+template <typename T, typename Alloc = AlignedAllocator<T, VectorConstants::alignment>>
 class Vector
 {
 public:
+    using value_type = T;
+    using allocator_type = Alloc;
+
     /**
      * @brief Iterator class that takes a pointer to a type T
     */
@@ -120,24 +395,26 @@ public:
      * @brief Constructor that initializes the Vector with an initializer list.
      *        This allows for direct list initialization of the Vector, like Vector v{1, 2, 3}.
      */
-    Vector(std::initializer_list<T> list)
-        : m_dimensions(list.size())
-        , m_data(new T[list.size()])
+    Vector(std::initializer_list<T> list, const Alloc& allocator = Alloc())
+        : m_allocator(allocator)
+        , m_data(allocate(list.size()))
+        , m_dimensions(list.size())
     {
-        std::copy(list.begin(), list.end(), m_data);
+        construct_copy(list.begin());
     }
 
     /**
      * @brief Constructor that initializes the Vector with a specific size and a default value for all elements.
      *        For example, Vector<int> v(7, 0) creates a Vector of size 7 with all elements initialized to 0.
      */
-    Vector(size_t dimensions, T default_value)
-        : m_dimensions(dimensions)
-        , m_data(new T[dimensions])
+    Vector(size_t dimensions, T default_value, const Alloc& allocator = Alloc())
+        : m_allocator(allocator)
+        , m_data(allocate(dimensions))
+        , m_dimensions(dimensions)
     {
         for (size_t i = 0; i < m_dimensions; ++i)
         {
-            m_data[i] = default_value;
+            allocator_traits::construct(m_allocator, m_data + i, default_value);
         }
     }
 
@@ -145,21 +422,58 @@ public:
      * @brief Constructor that initializes the Vector with a specific size. 
      *        Elements are default-constructed and may contain garbage values.
      */
-    Vector(size_t dimensions)
-        : m_dimensions(dimensions)
-        , m_data(new T[dimensions])
+    Vector(size_t dimensions, const Alloc& allocator = Alloc())
+        : m_allocator(allocator)
+        , m_data(allocate(dimensions))
+        , m_dimensions(dimensions)
     {
+        construct_default();
     }
 
     /**
      * @brief Copy constructor that creates a new Vector as a copy of an existing Vector.
      *        This constructor is used when a new Vector is directly initialized with another Vector.
      */
-    Vector(const Vector<T>& rhs)
-        : m_dimensions(rhs.dimensions())
-        , m_data(new T[rhs.dimensions()])
+    Vector(const Vector<T, Alloc>& rhs)
+        : m_allocator(allocator_traits::select_on_container_copy_construction(rhs.m_allocator))
+        , m_data(allocate(rhs.dimensions()))
+        , m_dimensions(rhs.dimensions())
+    {
+        construct_copy(rhs.m_data);
+    }
+
+    /**
+     * @brief Materializes an expression such as a + b - c * k in a single pass.
+     *        see vector_expression.h
+     */
+    template<typename E, typename = std::enable_if_t<is_vector_expression_v<E>>>
+    Vector(const E& expr, const Alloc& allocator = Alloc())
+        : Vector(execution::automatic, expr, allocator)
+    {
+    }
+
+    /**
+     * @brief Materializes an expression, carried out as policy asks.
+     *        see execution_policy.h
+     */
+    template<typename E, typename = std::enable_if_t<is_vector_expression_v<E>>>
+    Vector(const ExecutionPolicy& policy, const E& expr, const Alloc& allocator = Alloc())
+        : m_allocator(allocator)
+        , m_data(allocate(expr.dimensions()))
+        , m_dimensions(expr.dimensions())
+    {
+        static_assert(std::is_same_v<typename E::value_type, T>, "expression has a different element type.");
+        construct_default();
+        evaluate(m_data, expr, padded_dimensions(), policy);
+    }
+
+    /**
+     * @brief Copies the elements seen through a view into a new Vector.
+     */
+    template<typename U, typename = std::enable_if_t<std::is_same_v<std::remove_const_t<U>, T>>>
+    explicit Vector(const VectorView<U>& view, const Alloc& allocator = Alloc())
+        : Vector(execution::automatic, as_expression(view), allocator)
     {
-        std::copy(rhs.m_data, rhs.m_data + m_dimensions, m_data);
     }
 
     /**
@@ -167,9 +481,10 @@ public:
      *        This constructor is used to optimize performance when a temporary Vector is moved into a new Vector.
      *        After the move, the original Vector is left in a valid but unspecified state.
      */
-    Vector(Vector<T>&& rhs) noexcept
-        : m_dimensions(rhs.m_dimensions)
-        , m_data(std::move(rhs.m_data))
+    Vector(Vector<T, Alloc>&& rhs) noexcept
+        : m_allocator(std::move(rhs.m_allocator))
+        , m_data(rhs.m_data)
+        , m_dimensions(rhs.m_dimensions)
     {
         rhs.m_dimensions = 0;
         rhs.m_data = nullptr; // Avoid double deletion
@@ -177,311 +492,1088 @@ public:
 
     /**
      * @brief Assignment operator to copy the contents from another Vector.
-     *        If the current Vector already contains data, it is first deleted before copying.
+     *        The buffer is reused when the dimensions match and the allocator does not
+     *        change, otherwise the new buffer is filled before the old one is released.
      */
-    Vector<T>& operator=(const Vector<T>& rhs)
+    Vector<T, Alloc>& operator=(const Vector<T, Alloc>& rhs)
     {
         if(this != &rhs)
         {
-            delete[] m_data;
-
-            m_dimensions = rhs.m_dimensions;
+            constexpr bool propagate = allocator_traits::propagate_on_container_copy_assignment::value;
+            if(m_dimensions == rhs.m_dimensions && (!propagate || m_allocator == rhs.m_allocator))
+            {
+                std::copy(rhs.m_data, rhs.m_data + m_dimensions, m_data);
+                return *this;
+            }
 
-            m_data = new T[m_dimensions];
-            for (size_t dimension = 0; dimension < m_dimensions; ++dimension)
+            Vector<T, Alloc> copy(CopyFrom(), rhs.m_data, rhs.m_dimensions, propagate ? rhs.m_allocator : m_allocator);
+            release();
+            if constexpr (propagate)
             {
-                m_data[dimension] = rhs.m_data[dimension];
+                m_allocator = rhs.m_allocator;
             }
+            take(copy);
         }
         return *this;
     }
 
     /**
      * @brief Move assignment operator to transfer the contents from another Vector.
-     *        The other Vector is left in a valid but unspecified state.
+     *        The other Vector is left in a valid but unspecified state. If the
+     *        allocators differ and do not propagate, the elements are moved one by one
+     *        into storage from this Vector's allocator instead.
      */
-    Vector<T>& operator=(Vector<T>&& rhs) noexcept
+    Vector<T, Alloc>& operator=(Vector<T, Alloc>&& rhs) noexcept(
+        allocator_traits::propagate_on_container_move_assignment::value
+        || allocator_traits::is_always_equal::value)
     {
         if(this != &rhs)
         {
-            delete[] m_data;
-
-            m_dimensions = rhs.m_dimensions;
-            m_data = rhs.m_data;
+            if constexpr (!allocator_traits::propagate_on_container_move_assignment::value
+                && !allocator_traits::is_always_equal::value)
+            {
+                if(m_allocator != rhs.m_allocator)
+                {
+                    Vector<T, Alloc> moved(CopyFrom(), std::make_move_iterator(rhs.m_data), rhs.m_dimensions, m_allocator);
+                    release();
+                    take(moved);
+                    return *this;
+                }
+            }
 
-            rhs.m_dimensions = 0;
-            rhs.m_data = nullptr;
+            release();
+            if constexpr (allocator_traits::propagate_on_container_move_assignment::value)
+            {
+                m_allocator = std::move(rhs.m_allocator);
+            }
+            take(rhs);
         }
         return *this;
     }
 
     /**
-     * @brief Destructor to clean up allocated resources.
+     * @brief Assigns an expression or copies the elements of a VectorView. The
+     *        existing buffer is reused when the dimensions match, so v = v + w
+     *        allocates nothing.
      */
-    ~Vector()
+    template<typename E, typename = std::enable_if_t<is_vector_expression_v<E> || is_vector_view_v<E>>>
+    Vector<T, Alloc>& operator=(const E& expr)
     {
-        delete[] m_data;
+        return assign(execution::automatic, expr);
     }
 
-   /**
-     * @brief Returns the number of elements in the Vector.
+    /**
+     * @brief Assigns an expression or a VectorView, carried out as policy asks.
+     *        Reuses the buffer like operator=.
      */
-    size_t dimensions() const
+    template<typename E, typename = std::enable_if_t<is_vector_expression_v<E> || is_vector_view_v<E>>>
+    Vector<T, Alloc>& assign(const ExecutionPolicy& policy, const E& expr)
     {
-        return m_dimensions;
+        static_assert(std::is_same_v<typename E::value_type, T>, "expression has a different element type.");
+        if(expr.dimensions() != m_dimensions)
+        {
+            Vector<T, Alloc> result(policy, as_expression(expr), m_allocator);
+            release();
+            take(result);
+            return *this;
+        }
+        evaluate(m_data, as_expression(expr), padded_dimensions(), policy);
+        return *this;
     }
 
     /**
-     * @brief Calculates the geometric length (magnitude) of the Vector.
+     * @brief In-place addition of a Vector or an expression. Runs the same kernels and
+     *        serial/parallel split as operator+, writing straight into this buffer.
      */
-    double magnitude() const
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    Vector<T, Alloc>& operator+=(const X& rhs)
     {
-        T sum_squares = 0;
-
-        if(m_dimensions > VectorConstants::maxDimensionsForSequentialArithmeticOps)
-        {
-            sum_squares = std::transform_reduce(
-                std::execution::par
-                , m_data
-                , m_data + m_dimensions
-                , 0.0
-                , std::plus<>()
-                , [](const T& value) { return value * value; });
-        }
-        else
-        {
-            sum_squares = std::transform_reduce(
-                m_data
-                , m_data + m_dimensions
-                , 0.0
-                , std::plus<>()
-                , [](const T& value) { return value * value; });
-        }
-
-        return std::sqrt(sum_squares);
+        return add_assign(execution::automatic, rhs);
     }
 
     /**
-     * @brief scale this vector.
-    */
-    void scale(double scalar)
+     * @brief operator+=, carried out as policy asks.
+     */
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    Vector<T, Alloc>& add_assign(const ExecutionPolicy& policy, const X& rhs)
     {
-        if (m_dimensions > VectorConstants::maxDimensionsForSequentialArithmeticOps)
-        {
-            std::transform(
-                std::execution::par,
-                m_data,
-                m_data + m_dimensions,
-                m_data,
-                [scalar](const T& a) { return scalar * a; });
-        }
-        else
-        {
-            for (int i = 0; i < m_dimensions; ++i)
-            {
-                m_data[i] *= scalar;
-            }
-        }
+        evaluate(m_data, *this + rhs, padded_dimensions(), policy);
+        return *this;
     }
 
     /**
-     * @brief Provides an iterator to the beginning of the Vector.
+     * @brief In-place subtraction of a Vector or an expression.
      */
-    Iterator begin()
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    Vector<T, Alloc>& operator-=(const X& rhs)
     {
-        return Iterator(&m_data[0]);
+        return subtract_assign(execution::automatic, rhs);
     }
 
     /**
-     * @brief Provides an iterator to the end of the Vector.
+     * @brief operator-=, carried out as policy asks.
      */
-    Iterator end()
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    Vector<T, Alloc>& subtract_assign(const ExecutionPolicy& policy, const X& rhs)
     {
-        return Iterator(&m_data[m_dimensions]);
+        evaluate(m_data, *this - rhs, padded_dimensions(), policy);
+        return *this;
     }
 
     /**
-     * @brief Non-const access. If outside dimensions, throws a std::runtime_error.
-    */
-    T& operator[](size_t index)
+     * @brief In-place element-wise multiplication by a Vector or an expression.
+     */
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    Vector<T, Alloc>& operator*=(const X& rhs)
     {
-        if(index > m_dimensions - 1)
-        {
-            throw std::runtime_error("index out of bounds.");
-        }
-        return m_data[index];
+        return multiply_assign(execution::automatic, rhs);
     }
 
     /**
-     * @brief Const access. If outside dimensions, throws a std::runtime_error.
-    */
-    const T& operator[](size_t index) const
+     * @brief Element-wise operator*=, carried out as policy asks.
+     */
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    Vector<T, Alloc>& multiply_assign(const ExecutionPolicy& policy, const X& rhs)
     {
-        if(index > m_dimensions - 1)
-        {
-            throw std::runtime_error("index out of bounds.");
-        }
-        return m_data[index];
+        evaluate(m_data, elementwise_multiply(*this, rhs), padded_dimensions(), policy);
+        return *this;
     }
 
     /**
-     * @brief equality check to another Vector references.
-    */
-    bool operator==(const Vector<T>& rhs)
+     * @brief In-place element-wise division by a Vector or an expression.
+     */
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    Vector<T, Alloc>& operator/=(const X& rhs)
     {
-        if(rhs.dimensions() != m_dimensions)
-        {
-            return false;
-        }
-        for(int i = 0; i < m_dimensions; ++i)
-        {
-            if((*this)[i] != rhs[i])
-            {
-                return false;
-            }
-        }
-        return true;
+        return divide_assign(execution::automatic, rhs);
     }
 
     /**
-     * @brief inequality check. Relies on operator==
-    */
-    bool operator!=(const Vector<T>& rhs)
+     * @brief Element-wise operator/=, carried out as policy asks.
+     */
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    Vector<T, Alloc>& divide_assign(const ExecutionPolicy& policy, const X& rhs)
     {
-        return !(*this == rhs);
+        evaluate(m_data, elementwise_divide(*this, rhs), padded_dimensions(), policy);
+        return *this;
     }
 
     /**
-     * @brief Adds another vector.
-     *        Uses parallelization if large enough.
-     * 
-     *        see std::transform 
-     *        https://en.cppreference.com/w/cpp/algorithm/transform
-    */
-    Vector<T> operator+(const Vector<T>& rhs)
+     * @brief In-place multiplication by a scalar. A double scalar is exactly scale().
+     */
+    template<typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>, typename = void>
+    Vector<T, Alloc>& operator*=(S scalar)
     {
-        if(rhs.dimensions() != m_dimensions)
-        {
-            throw std::runtime_error("unequal vector sizes.");
-        }
-        if(m_dimensions == 0)
-        {
-            return Vector<T>(m_dimensions);
-        }
-
-        Vector<T> result(m_dimensions);
-        if (m_dimensions > VectorConstants::maxDimensionsForSequentialArithmeticOps) {
-            std::transform(
-                std::execution::par
-                , m_data
-                , m_data + m_dimensions
-                , rhs.m_data
-                , result.m_data
-                , [](const T& a, const T& b) { return a + b; });
-        } else {
-            std::transform(
-                m_data
-                , m_data + m_dimensions
-                , rhs.m_data
-                , result.m_data
-                , [](const T& a, const T& b) { return a + b; });
-        }
-
-        return result;
+        return multiply_assign(execution::automatic, scalar);
     }
 
     /**
-     * @brief Subtracts another vector.
-              Uses parallelization if large enough.
-     * 
-     *        see std::transform 
-     *        https://en.cppreference.com/w/cpp/algorithm/transform
-    */
-    Vector<T> operator-(const Vector<T>& rhs)
+     * @brief Scalar operator*=, carried out as policy asks.
+     */
+    template<typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>, typename = void>
+    Vector<T, Alloc>& multiply_assign(const ExecutionPolicy& policy, S scalar)
     {
-        if(rhs.dimensions() != m_dimensions)
+        if constexpr (std::is_same_v<S, double>)
         {
-            throw std::runtime_error("unequal vector sizes.");
+            scale(policy, scalar);
         }
-        if(m_dimensions == 0)
+        else
         {
-            return Vector<T>(m_dimensions);
-        }
-
-        Vector<T> result(m_dimensions);
-        if (m_dimensions > VectorConstants::maxDimensionsForSequentialArithmeticOps) {
-            std::transform(
-                std::execution::par
-                , m_data
-                , m_data + m_dimensions
-                , rhs.m_data
-                , result.m_data
-                , [](const T& a, const T& b) { return a - b; });
-        } else {
-            std::transform(
-                m_data
-                , m_data + m_dimensions
-                , rhs.m_data
-                , result.m_data
-                , [](const T& a, const T& b) { return a - b; });
+            evaluate(m_data, *this * scalar, padded_dimensions(), policy);
         }
-
-        return result;
+        return *this;
     }
 
-private:
-    T* m_data;
-    size_t m_dimensions;
-};
-
-/**
- * @brief Computes the dot product of 2 vectors by utilizing
- *        Uses parallelization if large enough data.
- * 
- *        see transform_reduce
- *        https://en.cppreference.com/w/cpp/algorithm/transform_reduce
-*/
-template<typename T>
-T dot_product(Vector<T>& rhs, Vector<T>& lhs)
-{
-    if(lhs.dimensions() != rhs.dimensions())
+    /**
+     * @brief In-place division by a scalar.
+     */
+    template<typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>, typename = void>
+    Vector<T, Alloc>& operator/=(S scalar)
     {
-        throw std::runtime_error("unequal vector sizes.");
+        return divide_assign(execution::automatic, scalar);
     }
-    if(lhs.dimensions() == 0)
+
+    /**
+     * @brief Scalar operator/=, carried out as policy asks.
+     */
+    template<typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>, typename = void>
+    Vector<T, Alloc>& divide_assign(const ExecutionPolicy& policy, S scalar)
     {
-        throw std::runtime_error("cannot dot product null vectors.");
+        evaluate(m_data, *this / scalar, padded_dimensions(), policy);
+        return *this;
     }
 
-    if(lhs.dimensions() > VectorConstants::maxDimensionsForSequentialDotProduct)
+    /**
+     * @brief Destructor to clean up allocated resources.
+     */
+    ~Vector()
     {
-        return std::transform_reduce(
-            std::execution::par
-            , lhs.begin()
-            , lhs.end()
-            , rhs.begin()
-            , T()
-            , std::plus<>() // reduction
-            , std::multiplies<>()); // transformation
+        release();
     }
-    else
+
+    /**
+     * @brief Returns a copy of the allocator that owns the elements.
+     */
+    allocator_type get_allocator() const
     {
-        T result = T();
-        for(int i = 0; i < lhs.dimensions(); ++i)
-        {
-            result += (lhs[i] * rhs[i]);
-        }
-        return result;
+        return m_allocator;
     }
-}
 
-/**
- * @brief Determines if the vectors are perpendicular by computing 
- *        the dot product in a parallel manner and checking if equals 0.
- * 
-*/
+   /**
+     * @brief Returns the number of elements in the Vector.
+     */
+    size_t dimensions() const
+    {
+        return m_dimensions;
+    }
+
+    /**
+     * @brief Number of elements the buffer holds: dimensions() rounded up to a whole
+     *        number of VectorConstants::alignment bytes for arithmetic T. The elements
+     *        past dimensions() are zero and may be read by kernels.
+     */
+    size_t padded_dimensions() const
+    {
+        return padded_dimensions_for(m_dimensions);
+    }
+
+    /**
+     * @brief True if data() sits on a VectorConstants::alignment boundary. Always the
+     *        case with the default allocator, unless the Vector is empty.
+     */
+    bool is_aligned() const
+    {
+        return reinterpret_cast<std::uintptr_t>(m_data) % VectorConstants::alignment == 0;
+    }
+
+    /**
+     * @brief Calculates the geometric length (magnitude) of the Vector. The squares
+     *        are summed in Acc, by default wide enough that integer squares cannot
+     *        overflow and float data is summed in double. See norm2() for double
+     *        data whose squares may overflow or underflow.
+     */
+    template<typename Acc = wide_accumulator_t<T>>
+    double magnitude() const
+    {
+        return magnitude<Acc>(execution::automatic);
+    }
+
+    /**
+     * @brief Calculates the magnitude, carried out as policy asks. Reproducible and
+     *        compensated reductions of floating-point data use their own kernels and
+     *        combine blocks in double; integer sums of squares in Acc are exact and
+     *        already reproducible.
+     */
+    template<typename Acc = wide_accumulator_t<T>>
+    double magnitude(const ExecutionPolicy& policy) const
+    {
+        return contiguous_magnitude<Acc>(policy, m_data, m_dimensions);
+    }
+
+    /**
+     * @brief The 2-norm, like magnitude(), but safe from overflow and underflow in a
+     *        single pass: no pre-scaling needed for huge or tiny values. Uses the
+     *        SIMD kernels, split across threads if large enough.
+    */
+    double norm2() const
+    {
+        return norm2(execution::automatic);
+    }
+
+    /**
+     * @brief The overflow-safe 2-norm, carried out as policy asks. double goes
+     *        through simd::scaled_squares (Blue's algorithm). The square of any float
+     *        or integer fits in double, so those simply sum their squares in double.
+    */
+    double norm2(const ExecutionPolicy& policy) const
+    {
+        return contiguous_norm2(policy, m_data, m_dimensions);
+    }
+
+    /**
+     * @brief scale this vector.
+     *        Uses the SIMD kernels, split across threads if large enough.
+    */
+    void scale(double scalar)
+    {
+        scale(execution::automatic, scalar);
+    }
+
+    /**
+     * @brief scale this vector, carried out as policy asks. The SIMD kernels run on
+     *        through the padding, which is zeroed again afterwards in case the scalar
+     *        was not finite. The plain loop computes the same values.
+    */
+    void scale(const ExecutionPolicy& policy, double scalar)
+    {
+        T* data = m_data;
+        const size_t dimensions = m_dimensions;
+        const size_t padded = padded_dimensions();
+        const bool use_kernels = policy.uses_simd();
+        for_blocks(
+            policy
+            , m_dimensions
+            , max_dimensions_for_sequential<T>(Operation::Scale)
+            , [data, scalar, dimensions, padded, use_kernels](size_t begin, size_t end) {
+                if(use_kernels)
+                {
+                    simd::scale(data + begin, scalar, (end == dimensions ? padded : end) - begin);
+                }
+                else
+                {
+                    for(size_t i = begin; i < end; ++i)
+                    {
+                        data[i] = static_cast<T>(data[i] * scalar);
+                    }
+                }
+            });
+        std::fill(data + dimensions, data + padded, T());
+    }
+
+    /**
+     * @brief Scales this vector to unit length in place: one pass for norm2(), one
+     *        to scale, no allocation. Returns the norm it divided by. A zero vector
+     *        has no direction and is left unchanged, and 0 returned. Norms so small
+     *        that 1 / norm overflows take a second, exact power-of-two pass.
+    */
+    double normalize()
+    {
+        return normalize(execution::automatic);
+    }
+
+    /**
+     * @brief normalize(), carried out as policy asks.
+    */
+    double normalize(const ExecutionPolicy& policy)
+    {
+        static_assert(std::is_floating_point_v<T>, "normalize needs a floating-point element type.");
+
+        const double norm = norm2(policy);
+        if(norm > 0.0)
+        {
+            double prescale;
+            const double scalar = unit_scale(norm, prescale);
+            if(prescale != 1.0)
+            {
+                scale(policy, prescale);
+            }
+            scale(policy, scalar);
+        }
+        return norm;
+    }
+
+    /**
+     * @brief Pointer to the first element, for handing the contents to kernels.
+     *        padded_dimensions() elements may be read from it, see is_aligned().
+    */
+    T* data()
+    {
+        return m_data;
+    }
+
+    /**
+     * @brief Const pointer to the first element.
+    */
+    const T* data() const
+    {
+        return m_data;
+    }
+
+    /**
+     * @brief A view of count elements starting at begin and step apart, without
+     *        copying. Throws if the last of them is past the end.
+    */
+    VectorView<T> slice(size_t begin, size_t count, size_t step = 1)
+    {
+        return VectorView<T>(m_data, m_dimensions).slice(begin, count, step);
+    }
+
+    /**
+     * @brief A read-only view of count elements starting at begin and step apart.
+    */
+    VectorView<const T> slice(size_t begin, size_t count, size_t step = 1) const
+    {
+        return VectorView<const T>(m_data, m_dimensions).slice(begin, count, step);
+    }
+
+    /**
+     * @brief Provides an iterator to the beginning of the Vector.
+     */
+    Iterator begin()
+    {
+        return Iterator(&m_data[0]);
+    }
+
+    /**
+     * @brief Provides an iterator to the end of the Vector.
+     */
+    Iterator end()
+    {
+        return Iterator(&m_data[m_dimensions]);
+    }
+
+    /**
+     * @brief Non-const access. If outside dimensions, throws a std::runtime_error.
+    */
+    T& operator[](size_t index)
+    {
+        if(index > m_dimensions - 1)
+        {
+            throw std::runtime_error("index out of bounds.");
+        }
+        return m_data[index];
+    }
+
+    /**
+     * @brief Const access. If outside dimensions, throws a std::runtime_error.
+    */
+    const T& operator[](size_t index) const
+    {
+        if(index > m_dimensions - 1)
+        {
+            throw std::runtime_error("index out of bounds.");
+        }
+        return m_data[index];
+    }
+
+    /**
+     * @brief equality check to another Vector references.
+    */
+    bool operator==(const Vector<T, Alloc>& rhs)
+    {
+        if(rhs.dimensions() != m_dimensions)
+        {
+            return false;
+        }
+        for(int i = 0; i < m_dimensions; ++i)
+        {
+            if((*this)[i] != rhs[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief inequality check. Relies on operator==
+    */
+    bool operator!=(const Vector<T, Alloc>& rhs)
+    {
+        return !(*this == rhs);
+    }
+
+private:
+    using allocator_traits = std::allocator_traits<Alloc>;
+
+    static_assert(std::is_same_v<typename allocator_traits::value_type, T>, "allocator value_type must be T.");
+    static_assert(std::is_same_v<typename allocator_traits::pointer, T*>, "allocator must hand out raw pointers.");
+
+    Alloc m_allocator;
+    T* m_data;
+    size_t m_dimensions;
+
+    struct CopyFrom {};
+
+    /**
+     * @brief Builds a Vector from the first dimensions elements at source.
+     */
+    template<typename InputIt>
+    Vector(CopyFrom, InputIt source, size_t dimensions, const Alloc& allocator)
+        : m_allocator(allocator)
+        , m_data(allocate(dimensions))
+        , m_dimensions(dimensions)
+    {
+        construct_copy(source);
+    }
+
+    /**
+     * @brief dimensions rounded up to whole VectorConstants::alignment byte blocks.
+     *        Only arithmetic types are padded.
+     */
+    static size_t padded_dimensions_for(size_t dimensions)
+    {
+        if constexpr (std::is_arithmetic_v<T> && VectorConstants::alignment % sizeof(T) == 0)
+        {
+            constexpr size_t block = VectorConstants::alignment / sizeof(T);
+            return (dimensions + block - 1) / block * block;
+        }
+        else
+        {
+            return dimensions;
+        }
+    }
+
+    /**
+     * @brief Allocates room for dimensions elements plus padding, and zeroes the padding.
+     */
+    T* allocate(size_t dimensions)
+    {
+        if(dimensions == 0)
+        {
+            return nullptr;
+        }
+        const size_t padded = padded_dimensions_for(dimensions);
+        T* data = allocator_traits::allocate(m_allocator, padded);
+        std::fill(data + dimensions, data + padded, T());
+        return data;
+    }
+
+    /**
+     * @brief Default-initializes the elements, which for trivial types means leaving
+     *        them untouched, like new T[n].
+     */
+    void construct_default()
+    {
+        if constexpr (!std::is_trivially_default_constructible_v<T>)
+        {
+            for (size_t i = 0; i < m_dimensions; ++i)
+            {
+                allocator_traits::construct(m_allocator, m_data + i);
+            }
+        }
+    }
+
+    template<typename InputIt>
+    void construct_copy(InputIt source)
+    {
+        for (size_t i = 0; i < m_dimensions; ++i, ++source)
+        {
+            allocator_traits::construct(m_allocator, m_data + i, *source);
+        }
+    }
+
+    /**
+     * @brief Destroys the elements and hands the buffer back to the allocator.
+     */
+    void release()
+    {
+        if(m_data != nullptr)
+        {
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                for (size_t i = 0; i < m_dimensions; ++i)
+                {
+                    allocator_traits::destroy(m_allocator, m_data + i);
+                }
+            }
+            allocator_traits::deallocate(m_allocator, m_data, padded_dimensions());
+            m_data = nullptr;
+            m_dimensions = 0;
+        }
+    }
+
+    /**
+     * @brief Adopts the buffer of rhs, which must come from an allocator equal to ours.
+     *        This Vector must already be released.
+     */
+    void take(Vector<T, Alloc>& rhs)
+    {
+        m_data = rhs.m_data;
+        m_dimensions = rhs.m_dimensions;
+        rhs.m_data = nullptr;
+        rhs.m_dimensions = 0;
+    }
+};
+
+/**
+ * @brief A non-owning window onto dimensions() elements of T spaced stride() apart:
+ *        element i is data()[i * stride()]. Taking a sub-range, a Matrix row or
+ *        column, or wrapping a std::vector costs nothing, and the window goes
+ *        wherever a Vector does: expressions, dot_product, magnitude, norm2.
+ *        VectorView<const T> is read-only; VectorView<T> also writes through.
+ *
+ *        Copying a view copies the window. Assigning to a view writes its elements,
+ *        so m.row(0) = v + w fills the row in place; the dimensions must match.
+ *        The elements must outlive the view, and an expression assigned to a view
+ *        may read the elements it writes only at the same positions.
+ *
+ *        A view owns no padding. Contiguous views (stride 1) run the same kernels
+ *        as a Vector, stopping at the last element. Strided views are reduced in
+ *        place by a plain strided loop for norm2 and the Fast reduction, so their
+ *        floating-point results may differ from a copy's in the last bits; only the
+ *        Reproducible and Compensated reductions gather the elements into a
+ *        temporary Vector first.
+*/
 template<typename T>
-bool are_perpendicular(const Vector<T>& rhs, const Vector<T>& lhs)
+class VectorView
+{
+public:
+    using value_type = std::remove_const_t<T>;
+
+    VectorView(T* data, size_t dimensions, size_t stride = 1)
+        : m_data(data)
+        , m_dimensions(dimensions)
+        , m_stride(stride)
+    {
+    }
+
+    VectorView(const VectorView<T>& rhs) = default;
+
+    /**
+     * @brief A view of all of v.
+    */
+    template<typename Alloc>
+    VectorView(Vector<value_type, Alloc>& v)
+        : VectorView(v.data(), v.dimensions())
+    {
+    }
+
+    template<typename Alloc, typename U = T, typename = std::enable_if_t<std::is_const_v<U>>>
+    VectorView(const Vector<value_type, Alloc>& v)
+        : VectorView(v.data(), v.dimensions())
+    {
+    }
+
+    /**
+     * @brief A view of all of v.
+    */
+    template<typename Alloc>
+    VectorView(std::vector<value_type, Alloc>& v)
+        : VectorView(v.data(), v.size())
+    {
+    }
+
+    template<typename Alloc, typename U = T, typename = std::enable_if_t<std::is_const_v<U>>>
+    VectorView(const std::vector<value_type, Alloc>& v)
+        : VectorView(v.data(), v.size())
+    {
+    }
+
+    /**
+     * @brief A read-only view of a writable one.
+    */
+    template<typename U, typename = std::enable_if_t<std::is_const_v<T> && std::is_same_v<U, value_type>>>
+    VectorView(const VectorView<U>& view)
+        : VectorView(view.data(), view.dimensions(), view.stride())
+    {
+    }
+
+    /**
+     * @brief Copies the elements of rhs into this view's elements.
+    */
+    VectorView<T>& operator=(const VectorView<T>& rhs)
+    {
+        return assign(execution::automatic, rhs);
+    }
+
+    /**
+     * @brief Writes a Vector, a view or an expression into this view's elements.
+    */
+    template<typename E, typename = std::enable_if_t<is_vector_operand_v<E>>>
+    VectorView<T>& operator=(const E& expr)
+    {
+        return assign(execution::automatic, expr);
+    }
+
+    /**
+     * @brief operator=, carried out as policy asks. Throws if the dimensions differ.
+    */
+    template<typename E, typename = std::enable_if_t<is_vector_operand_v<E>>>
+    VectorView<T>& assign(const ExecutionPolicy& policy, const E& expr)
+    {
+        static_assert(!std::is_const_v<T>, "cannot assign through a read-only view.");
+        static_assert(std::is_same_v<typename E::value_type, value_type>, "expression has a different element type.");
+        if(expr.dimensions() != m_dimensions)
+        {
+            throw std::runtime_error("unequal vector sizes.");
+        }
+        if(is_contiguous())
+        {
+            evaluate(m_data, as_expression(expr), m_dimensions, policy);
+        }
+        else
+        {
+            evaluate_strided(m_data, m_stride, as_expression(expr), policy);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief In-place element-wise arithmetic on the viewed elements, like Vector's.
+    */
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    VectorView<T>& operator+=(const X& rhs)
+    {
+        return assign(execution::automatic, *this + rhs);
+    }
+
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    VectorView<T>& operator-=(const X& rhs)
+    {
+        return assign(execution::automatic, *this - rhs);
+    }
+
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    VectorView<T>& operator*=(const X& rhs)
+    {
+        return assign(execution::automatic, elementwise_multiply(*this, rhs));
+    }
+
+    template<typename X, typename = std::enable_if_t<is_vector_operand_v<X>>>
+    VectorView<T>& operator/=(const X& rhs)
+    {
+        return assign(execution::automatic, elementwise_divide(*this, rhs));
+    }
+
+    template<typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>, typename = void>
+    VectorView<T>& operator*=(S scalar)
+    {
+        return assign(execution::automatic, *this * scalar);
+    }
+
+    template<typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>, typename = void>
+    VectorView<T>& operator/=(S scalar)
+    {
+        return assign(execution::automatic, *this / scalar);
+    }
+
+    size_t dimensions() const
+    {
+        return m_dimensions;
+    }
+
+    /**
+     * @brief Distance in elements between consecutive elements of the view.
+    */
+    size_t stride() const
+    {
+        return m_stride;
+    }
+
+    /**
+     * @brief Pointer to element 0.
+    */
+    T* data() const
+    {
+        return m_data;
+    }
+
+    bool is_contiguous() const
+    {
+        return m_stride == 1;
+    }
+
+    /**
+     * @brief Access to element index. If outside dimensions, throws a std::runtime_error.
+    */
+    T& operator[](size_t index) const
+    {
+        if(index >= m_dimensions)
+        {
+            throw std::runtime_error("index out of bounds.");
+        }
+        return m_data[index * m_stride];
+    }
+
+    /**
+     * @brief The view of count elements starting at element begin and step elements
+     *        of this view apart. Throws if the last of them is past the end.
+    */
+    VectorView<T> slice(size_t begin, size_t count, size_t step = 1) const
+    {
+        if(count > 0 && (step == 0 || begin >= m_dimensions || (count - 1) > (m_dimensions - 1 - begin) / step))
+        {
+            throw std::runtime_error("slice out of bounds.");
+        }
+        return VectorView<T>(m_data + begin * m_stride, count, m_stride * step);
+    }
+
+    /**
+     * @brief The magnitude of the viewed elements, see Vector::magnitude.
+    */
+    template<typename Acc = wide_accumulator_t<value_type>>
+    double magnitude() const
+    {
+        return magnitude<Acc>(execution::automatic);
+    }
+
+    template<typename Acc = wide_accumulator_t<value_type>>
+    double magnitude(const ExecutionPolicy& policy) const
+    {
+        if(is_contiguous())
+        {
+            return contiguous_magnitude<Acc>(policy, m_data, m_dimensions);
+        }
+        // Fast reductions run in place with a plain strided loop; only the reproducible
+        // and compensated kernels, which need contiguous input, gather into a Vector
+        if(std::is_floating_point_v<value_type> && policy.reduction() != ExecutionPolicy::Reduction::Fast)
+        {
+            return Vector<value_type>(policy, as_expression(*this)).template magnitude<Acc>(policy);
+        }
+        return std::sqrt(static_cast<double>(strided_dot_product<Acc>(
+            policy, m_data, m_stride, m_data, m_stride, m_dimensions, max_dimensions_for_sequential<value_type>(Operation::Magnitude))));
+    }
+
+    /**
+     * @brief The overflow-safe 2-norm of the viewed elements, see Vector::norm2.
+    */
+    double norm2() const
+    {
+        return norm2(execution::automatic);
+    }
+
+    double norm2(const ExecutionPolicy& policy) const
+    {
+        if(!is_contiguous())
+        {
+            return strided_norm2(policy, m_data, m_stride, m_dimensions);
+        }
+        return contiguous_norm2(policy, m_data, m_dimensions);
+    }
+
+private:
+    T* m_data;
+    size_t m_dimensions;
+    size_t m_stride;
+};
+
+/**
+ * @brief lhs . rhs over n contiguous elements, summed in R as policy asks, see
+ *        dot_product.
+*/
+template<typename R, typename T>
+R contiguous_dot_product(const ExecutionPolicy& policy, const T* lhs_data, const T* rhs_data, size_t n)
+{
+    const bool use_kernels = policy.uses_simd();
+    if constexpr (std::is_floating_point_v<T> || std::is_same_v<R, T>)
+    {
+        if(policy.reduction() == ExecutionPolicy::Reduction::Reproducible)
+        {
+            return reproducible_sum_blocks<R>(
+                policy
+                , n
+                , max_dimensions_for_sequential<T>(Operation::DotProduct)
+                , [lhs_data, rhs_data](size_t begin, size_t end) {
+                    return static_cast<R>(simd::dot_reproducible(lhs_data + begin, rhs_data + begin, end - begin));
+                });
+        }
+        if(policy.reduction() == ExecutionPolicy::Reduction::Compensated)
+        {
+            // the explicit template argument selects the plain-loop version for Sequenced and Parallel
+            const simd::Compensated<T> result = sum_blocks(
+                policy
+                , n
+                , max_dimensions_for_sequential<T>(Operation::DotProduct)
+                , simd::Compensated<T>()
+                , [lhs_data, rhs_data, use_kernels](size_t begin, size_t end) {
+                    return use_kernels
+                        ? simd::dot_compensated(lhs_data + begin, rhs_data + begin, end - begin)
+                        : simd::dot_compensated<T>(lhs_data + begin, rhs_data + begin, end - begin);
+                });
+            return static_cast<R>(result.sum) + static_cast<R>(result.error);
+        }
+    }
+
+    return sum_blocks(
+        policy
+        , n
+        , max_dimensions_for_sequential<T>(Operation::DotProduct)
+        , R()
+        , [lhs_data, rhs_data, use_kernels](size_t begin, size_t end) {
+            return dot_block<R>(lhs_data + begin, rhs_data + begin, end - begin, use_kernels);
+        });
+}
+
+/**
+ * @brief Computes the dot product of 2 vectors, carried out as policy asks. The SIMD
+ *        modes use the dot product kernels from simd.h; blocks are split across
+ *        threads for the parallel modes, or above the calibrated crossover for
+ *        Automatic, and their partial sums added in block order. With a
+ *        reproducible policy the result is bitwise identical on every host; with a
+ *        compensated one it is accurate to about twice the precision of T.
+ *
+ *        Products and sums are computed in Acc, T by default. A wider one keeps the
+ *        data compact while the sum stays exact or precise, e.g.
+ *        dot_product<int64_t>(v1, v2) for int32 data, or dot_product<double> for
+ *        float; wide_accumulator_t<T> names the usual choice. Integer sums in a wider
+ *        Acc are exact, so they skip the reproducible and compensated schemes.
+*/
+template<typename Acc = void, typename T, typename AllocR, typename AllocL>
+accumulator_t<Acc, T> dot_product(const ExecutionPolicy& policy, const Vector<T, AllocR>& rhs, const Vector<T, AllocL>& lhs)
+{
+    using R = accumulator_t<Acc, T>;
+
+    if(lhs.dimensions() != rhs.dimensions())
+    {
+        throw std::runtime_error("unequal vector sizes.");
+    }
+    if(lhs.dimensions() == 0)
+    {
+        throw std::runtime_error("cannot dot product null vectors.");
+    }
+
+    return contiguous_dot_product<R>(policy, lhs.data(), rhs.data(), lhs.dimensions());
+}
+
+/**
+ * @brief Computes the dot product of 2 vectors.
+ *        Uses parallelization if large enough data.
+*/
+template<typename Acc = void, typename T, typename AllocR, typename AllocL>
+accumulator_t<Acc, T> dot_product(const Vector<T, AllocR>& rhs, const Vector<T, AllocL>& lhs)
+{
+    return dot_product<Acc>(execution::automatic, rhs, lhs);
+}
+
+/**
+ * @brief True for the operands dot_product takes: Vectors and VectorViews.
+*/
+template<typename X>
+inline constexpr bool is_dot_product_operand_v = is_vector_v<X> || is_vector_view_v<X>;
+
+/**
+ * @brief The dot product where either side is a VectorView, see dot_product above.
+ *        Contiguous views run the same blocks and kernels as Vectors. Strided views
+ *        are read in place with the Fast reduction; the reproducible and compensated
+ *        ones gather a strided side into a temporary Vector first.
+*/
+template<typename Acc = void, typename X, typename Y, typename = std::enable_if_t<
+    (is_vector_view_v<X> || is_vector_view_v<Y>) && is_dot_product_operand_v<X> && is_dot_product_operand_v<Y>>>
+accumulator_t<Acc, typename X::value_type> dot_product(const ExecutionPolicy& policy, const X& rhs, const Y& lhs)
+{
+    using T = typename X::value_type;
+    using R = accumulator_t<Acc, T>;
+    static_assert(std::is_same_v<T, typename Y::value_type>, "operands must have the same element type.");
+
+    const VectorView<const T> rhs_view(rhs);
+    const VectorView<const T> lhs_view(lhs);
+    if(lhs_view.dimensions() != rhs_view.dimensions())
+    {
+        throw std::runtime_error("unequal vector sizes.");
+    }
+    if(lhs_view.dimensions() == 0)
+    {
+        throw std::runtime_error("cannot dot product null vectors.");
+    }
+
+    if(rhs_view.is_contiguous() && lhs_view.is_contiguous())
+    {
+        return contiguous_dot_product<R>(policy, lhs_view.data(), rhs_view.data(), lhs_view.dimensions());
+    }
+
+    // the reproducible and compensated kernels need contiguous input; contiguous_dot_product
+    // only runs them for floating point or an accumulator of the element type
+    const bool needs_kernels = (std::is_floating_point_v<T> || std::is_same_v<R, T>)
+        && policy.reduction() != ExecutionPolicy::Reduction::Fast;
+    if(!needs_kernels)
+    {
+        return strided_dot_product<R>(
+            policy
+            , lhs_view.data()
+            , lhs_view.stride()
+            , rhs_view.data()
+            , rhs_view.stride()
+            , lhs_view.dimensions()
+            , max_dimensions_for_sequential<T>(Operation::DotProduct));
+    }
+    if(!rhs_view.is_contiguous())
+    {
+        return dot_product<Acc>(policy, Vector<T>(policy, as_expression(rhs_view)), lhs_view);
+    }
+    return dot_product<Acc>(policy, rhs_view, Vector<T>(policy, as_expression(lhs_view)));
+}
+
+template<typename Acc = void, typename X, typename Y, typename = std::enable_if_t<
+    (is_vector_view_v<X> || is_vector_view_v<Y>) && is_dot_product_operand_v<X> && is_dot_product_operand_v<Y>>>
+accumulator_t<Acc, typename X::value_type> dot_product(const X& rhs, const Y& lhs)
+{
+    return dot_product<Acc>(execution::automatic, rhs, lhs);
+}
+
+/**
+ * @brief lhs + rhs materialized as policy asks. Either side may be a Vector or an
+ *        expression; see vector_expression.h.
+*/
+template<typename L, typename R, typename = std::enable_if_t<is_vector_operand_v<L> && is_vector_operand_v<R>>>
+Vector<typename expression_t<L>::value_type> add(const ExecutionPolicy& policy, const L& lhs, const R& rhs)
+{
+    return Vector<typename expression_t<L>::value_type>(policy, lhs + rhs);
+}
+
+/**
+ * @brief lhs - rhs materialized as policy asks.
+*/
+template<typename L, typename R, typename = std::enable_if_t<is_vector_operand_v<L> && is_vector_operand_v<R>>>
+Vector<typename expression_t<L>::value_type> subtract(const ExecutionPolicy& policy, const L& lhs, const R& rhs)
+{
+    return Vector<typename expression_t<L>::value_type>(policy, lhs - rhs);
+}
+
+/**
+ * @brief y += alpha * x, in place. Uses the FMA kernels from simd.h and the same
+ *        serial/parallel split as the arithmetic operators.
+*/
+template<typename T, typename AllocX, typename AllocY>
+void axpy(T alpha, const Vector<T, AllocX>& x, Vector<T, AllocY>& y)
+{
+    axpy(execution::automatic, alpha, x, y);
+}
+
+/**
+ * @brief axpy, carried out as policy asks. The plain loops compute alpha * x[i]
+ *        and y[i] separately, so floating-point results may differ from the fused
+ *        kernels in the last bit.
+*/
+template<typename T, typename AllocX, typename AllocY>
+void axpy(const ExecutionPolicy& policy, T alpha, const Vector<T, AllocX>& x, Vector<T, AllocY>& y)
+{
+    if(x.dimensions() != y.dimensions())
+    {
+        throw std::runtime_error("unequal vector sizes.");
+    }
+
+    const T* x_data = x.data();
+    T* y_data = y.data();
+    const bool use_kernels = policy.uses_simd();
+    for_blocks(
+        policy
+        , y.dimensions()
+        , max_dimensions_for_sequential<T>(Operation::Arithmetic)
+        , [alpha, x_data, y_data, use_kernels](size_t begin, size_t end) {
+            if(use_kernels)
+            {
+                simd::axpy_rows(x_data + begin, 0, 1, &alpha, end - begin, y_data + begin);
+            }
+            else
+            {
+                for(size_t i = begin; i < end; ++i)
+                {
+                    y_data[i] += alpha * x_data[i];
+                }
+            }
+        });
+}
+
+/**
+ * @brief y = alpha * x + beta * y, in place and in a single pass.
+*/
+template<typename T, typename AllocX, typename AllocY>
+void axpby(T alpha, const Vector<T, AllocX>& x, T beta, Vector<T, AllocY>& y)
+{
+    axpby(execution::automatic, alpha, x, beta, y);
+}
+
+/**
+ * @brief axpby, carried out as policy asks.
+*/
+template<typename T, typename AllocX, typename AllocY>
+void axpby(const ExecutionPolicy& policy, T alpha, const Vector<T, AllocX>& x, T beta, Vector<T, AllocY>& y)
+{
+    if(x.dimensions() != y.dimensions())
+    {
+        throw std::runtime_error("unequal vector sizes.");
+    }
+    y.assign(policy, x * alpha + y * beta);
+}
+
+/**
+ * @brief Determines if the vectors are perpendicular by computing 
+ *        the dot product in a parallel manner and checking if equals 0.
+ * 
+*/
+template<typename T, typename AllocR, typename AllocL>
+bool are_perpendicular(const Vector<T, AllocR>& rhs, const Vector<T, AllocL>& lhs)
 {
     return dot_product(lhs, rhs) == 0;
 }
@@ -497,12 +1589,11 @@ bool are_perpendicular(const Vector<T>& rhs, const Vector<T>& lhs)
  *        apply a constant to each dimension
  *        sqrt( (Cx)^2 + (Cy)^2 ) = sqrt(C^2 * ( x^2 + y^2 )) = C * sqrt( x^2 + y^2 ) = C * magnitude.
 */
-template<typename T>
-Vector<T> unit_vector(const Vector<int>& vec)
+template<typename T, typename Alloc>
+Vector<T, Alloc> unit_vector(const Vector<T, Alloc>& vec)
 {
-    Vector<T> copy(vec);
-    double scale = 1.0 / vec.magnitude();
-    copy.scale(scale);
+    Vector<T, Alloc> copy(vec);
+    copy.normalize();
     return copy;
 }
 
@@ -0,0 +1,457 @@
+#ifndef INCLUDED_ARONDINA_VCTR_VECTOR_EXPRESSION
+#define INCLUDED_ARONDINA_VCTR_VECTOR_EXPRESSION
+
+// vctr
+#include "calibration.h"
+#include "execution_policy.h"
+#include "parallel.h"
+#include "simd.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+namespace arondina
+{
+namespace vctr
+{
+
+template<typename T, typename Alloc>
+class Vector;
+
+template<typename T>
+class VectorView;
+
+/**
+ * @brief Lazy element-wise arithmetic on Vectors.
+ *
+ *        a + b - c * k builds a small tree of expression nodes instead of Vectors.
+ *        Nothing is computed until the tree is assigned to (or used to construct)
+ *        a Vector, at which point every element is produced by one fused loop over
+ *        all operands, split across threads if large enough. No temporaries are
+ *        allocated and memory is traversed once.
+ *
+ *        Nodes hold raw pointers into the Vectors they were built from, so an
+ *        expression must not outlive its operands. Prefer assigning to a Vector
+ *        over storing an expression in an auto variable.
+*/
+struct VectorExpressionTag {};
+
+template<typename E>
+struct is_vector_expression : std::is_base_of<VectorExpressionTag, E> {};
+
+template<typename E>
+inline constexpr bool is_vector_expression_v = is_vector_expression<E>::value;
+
+template<typename X>
+struct is_vector : std::false_type {};
+
+template<typename T, typename Alloc>
+struct is_vector<Vector<T, Alloc>> : std::true_type {};
+
+template<typename X>
+inline constexpr bool is_vector_v = is_vector<X>::value;
+
+template<typename X>
+struct is_vector_view : std::false_type {};
+
+template<typename T>
+struct is_vector_view<VectorView<T>> : std::true_type {};
+
+template<typename X>
+inline constexpr bool is_vector_view_v = is_vector_view<X>::value;
+
+/**
+ * @brief True for anything that can appear as an operand: a Vector, a VectorView or
+ *        an expression.
+*/
+template<typename X>
+inline constexpr bool is_vector_operand_v = is_vector_v<X> || is_vector_view_v<X> || is_vector_expression_v<X>;
+
+/**
+ * @brief Leaf node: a contiguous run of elements owned by a Vector. padded_dimensions
+ *        counts the zeroed tail padding that may also be read, see Vector::padded_dimensions.
+*/
+template<typename T>
+class VectorLeaf : public VectorExpressionTag
+{
+public:
+    using value_type = T;
+
+    VectorLeaf(const T* data, size_t dimensions, size_t padded_dimensions)
+        : m_data(data)
+        , m_dimensions(dimensions)
+        , m_padded_dimensions(padded_dimensions)
+    {
+    }
+
+    size_t dimensions() const { return m_dimensions; }
+    size_t padded_dimensions() const { return m_padded_dimensions; }
+    const T* data() const { return m_data; }
+    bool is_contiguous() const { return true; }
+    T operator[](size_t i) const { return m_data[i]; }
+
+private:
+    const T* m_data;
+    size_t m_dimensions;
+    size_t m_padded_dimensions;
+};
+
+/**
+ * @brief Leaf node: dimensions elements stride apart, seen through a VectorView.
+ *        Nothing past the last element may be read, so padded_dimensions is
+ *        dimensions.
+*/
+template<typename T>
+class VectorStridedLeaf : public VectorExpressionTag
+{
+public:
+    using value_type = T;
+
+    VectorStridedLeaf(const T* data, size_t dimensions, size_t stride)
+        : m_data(data)
+        , m_dimensions(dimensions)
+        , m_stride(stride)
+    {
+    }
+
+    size_t dimensions() const { return m_dimensions; }
+    size_t padded_dimensions() const { return m_dimensions; }
+    size_t stride() const { return m_stride; }
+    const T* data() const { return m_data; }
+    bool is_contiguous() const { return m_stride == 1; }
+    T operator[](size_t i) const { return m_data[i * m_stride]; }
+
+private:
+    const T* m_data;
+    size_t m_dimensions;
+    size_t m_stride;
+};
+
+template<typename X>
+struct is_vector_leaf : std::false_type {};
+
+template<typename T>
+struct is_vector_leaf<VectorLeaf<T>> : std::true_type {};
+
+template<typename T>
+struct is_vector_leaf<VectorStridedLeaf<T>> : std::true_type {};
+
+/**
+ * @brief Element-wise binary node, op(lhs[i], rhs[i]).
+ *        Throws if the operands have different dimensions.
+*/
+template<typename L, typename R, typename Op>
+class VectorBinaryExpression : public VectorExpressionTag
+{
+public:
+    using value_type = typename L::value_type;
+    static_assert(std::is_same_v<value_type, typename R::value_type>, "operands must have the same element type.");
+
+    VectorBinaryExpression(const L& lhs, const R& rhs)
+        : m_lhs(lhs)
+        , m_rhs(rhs)
+    {
+        if(lhs.dimensions() != rhs.dimensions())
+        {
+            throw std::runtime_error("unequal vector sizes.");
+        }
+    }
+
+    size_t dimensions() const { return m_lhs.dimensions(); }
+    const L& lhs() const { return m_lhs; }
+    const R& rhs() const { return m_rhs; }
+    value_type operator[](size_t i) const { return Op()(m_lhs[i], m_rhs[i]); }
+
+private:
+    L m_lhs;
+    R m_rhs;
+};
+
+/**
+ * @brief Element-wise node combining each element with one scalar, op(expr[i], scalar).
+ *        The operation is carried out in the common type of the element and the
+ *        scalar and converted back, like Vector::scale.
+*/
+template<typename E, typename S, typename Op>
+class VectorScalarExpression : public VectorExpressionTag
+{
+public:
+    using value_type = typename E::value_type;
+
+    VectorScalarExpression(const E& expr, S scalar)
+        : m_expr(expr)
+        , m_scalar(scalar)
+    {
+    }
+
+    size_t dimensions() const { return m_expr.dimensions(); }
+    const E& expression() const { return m_expr; }
+    S scalar() const { return m_scalar; }
+    value_type operator[](size_t i) const { return static_cast<value_type>(Op()(m_expr[i], m_scalar)); }
+
+private:
+    E m_expr;
+    S m_scalar;
+};
+
+/**
+ * @brief Element-wise unary node, op(expr[i]).
+*/
+template<typename E, typename Op>
+class VectorUnaryExpression : public VectorExpressionTag
+{
+public:
+    using value_type = typename E::value_type;
+
+    explicit VectorUnaryExpression(const E& expr)
+        : m_expr(expr)
+    {
+    }
+
+    size_t dimensions() const { return m_expr.dimensions(); }
+    value_type operator[](size_t i) const { return static_cast<value_type>(Op()(m_expr[i])); }
+
+private:
+    E m_expr;
+};
+
+struct AbsoluteValue
+{
+    template<typename T>
+    T operator()(T value) const
+    {
+        using std::abs;
+        return abs(value);
+    }
+};
+
+struct SquareRoot
+{
+    template<typename T>
+    auto operator()(T value) const
+    {
+        using std::sqrt;
+        return sqrt(value);
+    }
+};
+
+/**
+ * @brief Turns an operand into an expression node: Vectors and VectorViews become
+ *        leaves, expressions are returned as they are.
+*/
+template<typename X>
+auto as_expression(const X& operand)
+{
+    if constexpr (is_vector_v<X>)
+    {
+        return VectorLeaf<typename X::value_type>(operand.data(), operand.dimensions(), operand.padded_dimensions());
+    }
+    else if constexpr (is_vector_view_v<X>)
+    {
+        return VectorStridedLeaf<typename X::value_type>(operand.data(), operand.dimensions(), operand.stride());
+    }
+    else
+    {
+        return operand;
+    }
+}
+
+template<typename X>
+using expression_t = decltype(as_expression(std::declval<const X&>()));
+
+template<typename L, typename R, typename = std::enable_if_t<is_vector_operand_v<L> && is_vector_operand_v<R>>>
+VectorBinaryExpression<expression_t<L>, expression_t<R>, std::plus<>> operator+(const L& lhs, const R& rhs)
+{
+    return {as_expression(lhs), as_expression(rhs)};
+}
+
+template<typename L, typename R, typename = std::enable_if_t<is_vector_operand_v<L> && is_vector_operand_v<R>>>
+VectorBinaryExpression<expression_t<L>, expression_t<R>, std::minus<>> operator-(const L& lhs, const R& rhs)
+{
+    return {as_expression(lhs), as_expression(rhs)};
+}
+
+template<typename E, typename S, typename = std::enable_if_t<is_vector_operand_v<E> && std::is_arithmetic_v<S>>>
+VectorScalarExpression<expression_t<E>, S, std::multiplies<>> operator*(const E& expr, S scalar)
+{
+    return {as_expression(expr), scalar};
+}
+
+template<typename S, typename E, typename = std::enable_if_t<is_vector_operand_v<E> && std::is_arithmetic_v<S>>>
+VectorScalarExpression<expression_t<E>, S, std::multiplies<>> operator*(S scalar, const E& expr)
+{
+    return {as_expression(expr), scalar};
+}
+
+template<typename E, typename S, typename = std::enable_if_t<is_vector_operand_v<E> && std::is_arithmetic_v<S>>>
+VectorScalarExpression<expression_t<E>, S, std::divides<>> operator/(const E& expr, S scalar)
+{
+    return {as_expression(expr), scalar};
+}
+
+/**
+ * @brief Element-wise (Hadamard) product, lhs[i] * rhs[i]. Not spelled operator* to
+ *        keep it distinct from the matrix products.
+*/
+template<typename L, typename R, typename = std::enable_if_t<is_vector_operand_v<L> && is_vector_operand_v<R>>>
+VectorBinaryExpression<expression_t<L>, expression_t<R>, std::multiplies<>> elementwise_multiply(const L& lhs, const R& rhs)
+{
+    return {as_expression(lhs), as_expression(rhs)};
+}
+
+/**
+ * @brief Element-wise quotient, lhs[i] / rhs[i].
+*/
+template<typename L, typename R, typename = std::enable_if_t<is_vector_operand_v<L> && is_vector_operand_v<R>>>
+VectorBinaryExpression<expression_t<L>, expression_t<R>, std::divides<>> elementwise_divide(const L& lhs, const R& rhs)
+{
+    return {as_expression(lhs), as_expression(rhs)};
+}
+
+template<typename E, typename = std::enable_if_t<is_vector_operand_v<E>>>
+VectorUnaryExpression<expression_t<E>, std::negate<>> operator-(const E& expr)
+{
+    return VectorUnaryExpression<expression_t<E>, std::negate<>>(as_expression(expr));
+}
+
+template<typename E, typename = std::enable_if_t<is_vector_operand_v<E>>>
+VectorUnaryExpression<expression_t<E>, AbsoluteValue> abs(const E& expr)
+{
+    return VectorUnaryExpression<expression_t<E>, AbsoluteValue>(as_expression(expr));
+}
+
+template<typename E, typename = std::enable_if_t<is_vector_operand_v<E>>>
+VectorUnaryExpression<expression_t<E>, SquareRoot> sqrt(const E& expr)
+{
+    return VectorUnaryExpression<expression_t<E>, SquareRoot>(as_expression(expr));
+}
+
+/**
+ * @brief True if E is op(lhs, rhs) of two leaves.
+*/
+template<typename E, typename Op>
+struct is_leaf_operation : std::false_type {};
+
+template<typename L, typename R, typename Op>
+struct is_leaf_operation<VectorBinaryExpression<L, R, Op>, Op>
+    : std::bool_constant<is_vector_leaf<L>::value && is_vector_leaf<R>::value> {};
+
+/**
+ * @brief Writes expr[begin, end) to out[begin, end). A plain a + b or a - b of two
+ *        contiguous leaves goes to the hand-written kernels in simd.h; every other
+ *        tree, strided views included, is one fused loop the compiler vectorizes.
+ *
+ *        The block that ends the vector runs the kernels on through the zeroed padding
+ *        shared by out and both leaves, so they never drop into their scalar tail.
+ *        0 + 0 and 0 - 0 keep the padding zero.
+*/
+template<typename E>
+void evaluate_block(
+    typename E::value_type* out
+    , size_t out_padded_dimensions
+    , const E& expr
+    , size_t begin
+    , size_t end
+    , bool use_kernels)
+{
+    using T = typename E::value_type;
+
+    constexpr bool is_leaf_sum = is_leaf_operation<E, std::plus<>>::value;
+    constexpr bool is_leaf_difference = is_leaf_operation<E, std::minus<>>::value;
+
+    if constexpr (simd::has_kernels_v<T> && (is_leaf_sum || is_leaf_difference))
+    {
+        if(!use_kernels || !expr.lhs().is_contiguous() || !expr.rhs().is_contiguous())
+        {
+            for(size_t i = begin; i < end; ++i)
+            {
+                out[i] = expr[i];
+            }
+            return;
+        }
+
+        if(end == expr.dimensions())
+        {
+            end = std::min({out_padded_dimensions, expr.lhs().padded_dimensions(), expr.rhs().padded_dimensions()});
+        }
+
+        if constexpr (is_leaf_sum)
+        {
+            simd::add(expr.lhs().data() + begin, expr.rhs().data() + begin, out + begin, end - begin);
+        }
+        else
+        {
+            simd::subtract(expr.lhs().data() + begin, expr.rhs().data() + begin, out + begin, end - begin);
+        }
+    }
+    else
+    {
+        for(size_t i = begin; i < end; ++i)
+        {
+            out[i] = expr[i];
+        }
+    }
+}
+
+/**
+ * @brief Materializes expr into out, which must hold expr.dimensions() elements.
+ *        If out_padded_dimensions is larger, out[dimensions, out_padded_dimensions)
+ *        is zeroed padding the kernels may run through and must leave zero.
+ *        out may be one of the operands: every node is element-wise, so each
+ *        element is read before it is overwritten.
+*/
+template<typename E>
+void evaluate(
+    typename E::value_type* out
+    , const E& expr
+    , size_t out_padded_dimensions = 0
+    , const ExecutionPolicy& policy = execution::automatic)
+{
+    using T = typename E::value_type;
+    const size_t dimensions = expr.dimensions();
+    out_padded_dimensions = std::max(out_padded_dimensions, dimensions);
+    const bool use_kernels = policy.uses_simd();
+
+    for_blocks(
+        policy
+        , dimensions
+        , max_dimensions_for_sequential<T>(Operation::Arithmetic)
+        , [out, out_padded_dimensions, &expr, use_kernels](size_t begin, size_t end) {
+            evaluate_block(out, out_padded_dimensions, expr, begin, end, use_kernels);
+        });
+}
+
+/**
+ * @brief Materializes expr into out[0], out[stride], ..., the strided counterpart of
+ *        evaluate used to write through a VectorView. Always the fused loop: the
+ *        kernels need contiguous output.
+*/
+template<typename E>
+void evaluate_strided(
+    typename E::value_type* out
+    , size_t stride
+    , const E& expr
+    , const ExecutionPolicy& policy = execution::automatic)
+{
+    using T = typename E::value_type;
+    for_blocks(
+        policy
+        , expr.dimensions()
+        , max_dimensions_for_sequential<T>(Operation::Arithmetic)
+        , [out, stride, &expr](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; ++i)
+            {
+                out[i * stride] = expr[i];
+            }
+        });
+}
+
+} // vctr
+} // arondina
+
+#endif
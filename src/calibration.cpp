@@ -0,0 +1,211 @@
+#include "calibration.h"
+
+// vctr
+#include "parallel.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+constexpr size_t numOperations = 4;
+constexpr size_t numElementTypes = 4;
+
+constexpr size_t minCalibrationDimensions = 1 << 10;
+constexpr size_t maxCalibrationDimensions = 1 << 21;
+constexpr int calibrationRepetitions = 5;
+
+// The parallel run has to beat the sequential one by this factor, at this many
+// consecutive sizes, before it counts as a win rather than timing noise.
+constexpr double requiredSpeedup = 0.8;
+constexpr int requiredConsecutiveWins = 2;
+
+using ThresholdTable = std::array<std::array<std::atomic<size_t>, numElementTypes>, numOperations>;
+
+size_t default_threshold(Operation operation)
+{
+    return operation == Operation::DotProduct
+        ? VectorConstants::maxDimensionsForSequentialDotProduct
+        : VectorConstants::maxDimensionsForSequentialArithmeticOps;
+}
+
+void fill_defaults(ThresholdTable& table)
+{
+    for(size_t op = 0; op < numOperations; ++op)
+    {
+        for(size_t type = 0; type < numElementTypes; ++type)
+        {
+            table[op][type].store(default_threshold(static_cast<Operation>(op)), std::memory_order_relaxed);
+        }
+    }
+}
+
+ThresholdTable& thresholds()
+{
+    static ThresholdTable table;
+    static const bool initialized = (fill_defaults(table), true);
+    (void)initialized;
+    return table;
+}
+
+std::atomic<bool>& calibrated_flag()
+{
+    static std::atomic<bool> flag(false);
+    return flag;
+}
+
+std::atomic<size_t>& slot(Operation operation, ElementType type)
+{
+    return thresholds()[static_cast<size_t>(operation)][static_cast<size_t>(type)];
+}
+
+/**
+ * @brief Best of calibrationRepetitions wall clock runs, in nanoseconds.
+*/
+template<typename Fn>
+long long best_time(Fn&& fn)
+{
+    long long best = std::numeric_limits<long long>::max();
+    for(int rep = 0; rep < calibrationRepetitions; ++rep)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto stop = std::chrono::steady_clock::now();
+        best = std::min<long long>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+    }
+    return best;
+}
+
+/**
+ * @brief Doubles the dimensions until the parallel run clearly beats the sequential
+ *        one at requiredConsecutiveWins sizes in a row. Both paths are forced through
+ *        the public threshold so the measurement covers exactly the code the
+ *        operators execute.
+*/
+template<typename T, typename Fn>
+size_t find_crossover(Operation operation, Fn&& run)
+{
+    constexpr ElementType type = element_type_of<T>();
+
+    // With a single worker the parallel path is the sequential one plus overhead.
+    if(parallel_thread_count() < 2)
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    int wins = 0;
+    size_t first_win = 0;
+    for(size_t dimensions = minCalibrationDimensions; dimensions <= maxCalibrationDimensions; dimensions *= 2)
+    {
+        Vector<T> v1(dimensions, T(1));
+        Vector<T> v2(dimensions, T(1));
+
+        set_max_dimensions_for_sequential(operation, type, std::numeric_limits<size_t>::max());
+        const long long sequential = best_time([&] { run(v1, v2); });
+
+        set_max_dimensions_for_sequential(operation, type, 0);
+        const long long parallel = best_time([&] { run(v1, v2); });
+
+        if(static_cast<double>(parallel) < requiredSpeedup * static_cast<double>(sequential))
+        {
+            if(wins == 0)
+            {
+                first_win = dimensions;
+            }
+            if(++wins == requiredConsecutiveWins)
+            {
+                return first_win / 2;
+            }
+        }
+        else
+        {
+            wins = 0;
+        }
+    }
+    return std::numeric_limits<size_t>::max();
+}
+
+template<typename T>
+void calibrate_type()
+{
+    constexpr ElementType type = element_type_of<T>();
+
+    const size_t arithmetic = find_crossover<T>(
+        Operation::Arithmetic
+        , [](Vector<T>& v1, Vector<T>& v2) { Vector<T> result = v1 + v2; });
+    set_max_dimensions_for_sequential(Operation::Arithmetic, type, arithmetic);
+
+    const size_t scale = find_crossover<T>(
+        Operation::Scale
+        , [](Vector<T>& v1, Vector<T>&) { v1.scale(1.0); });
+    set_max_dimensions_for_sequential(Operation::Scale, type, scale);
+
+    volatile double sink = 0;
+    const size_t magnitude = find_crossover<T>(
+        Operation::Magnitude
+        , [&sink](Vector<T>& v1, Vector<T>&) { sink = v1.magnitude(); });
+    set_max_dimensions_for_sequential(Operation::Magnitude, type, magnitude);
+
+    const size_t dot = find_crossover<T>(
+        Operation::DotProduct
+        , [&sink](Vector<T>& v1, Vector<T>& v2) { sink = dot_product(v1, v2); });
+    set_max_dimensions_for_sequential(Operation::DotProduct, type, dot);
+}
+
+bool calibrate_if_requested()
+{
+    if(std::getenv("VCTR_CALIBRATE") != nullptr)
+    {
+        calibrate();
+        return true;
+    }
+    return false;
+}
+
+const bool calibratedAtStartup = calibrate_if_requested();
+
+} // namespace
+
+size_t max_dimensions_for_sequential(Operation operation, ElementType type)
+{
+    return slot(operation, type).load(std::memory_order_relaxed);
+}
+
+void set_max_dimensions_for_sequential(Operation operation, ElementType type, size_t dimensions)
+{
+    slot(operation, type).store(dimensions, std::memory_order_relaxed);
+}
+
+void calibrate()
+{
+    calibrate_type<int>();
+    calibrate_type<float>();
+    calibrate_type<double>();
+    calibrated_flag().store(true, std::memory_order_release);
+}
+
+bool is_calibrated()
+{
+    return calibrated_flag().load(std::memory_order_acquire);
+}
+
+void reset_calibration()
+{
+    fill_defaults(thresholds());
+    calibrated_flag().store(false, std::memory_order_release);
+}
+
+} // vctr
+} // arondina
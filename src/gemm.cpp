@@ -0,0 +1,308 @@
+#include "gemm.h"
+
+// vctr
+#include "parallel.h"
+#include "simd_kernels.h"
+
+// std
+#include <algorithm>
+#include <memory>
+#include <new>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+constexpr size_t packAlignment = 64;
+
+// Large enough for the widest micro-kernel tile (12 x 32 floats).
+constexpr size_t maxTileElements = 512;
+
+template<typename T>
+struct AlignedDeleter
+{
+    void operator()(T* ptr) const
+    {
+        ::operator delete(ptr, std::align_val_t(packAlignment));
+    }
+};
+
+template<typename T>
+using AlignedArray = std::unique_ptr<T[], AlignedDeleter<T>>;
+
+template<typename T>
+AlignedArray<T> make_aligned(size_t elements)
+{
+    return AlignedArray<T>(static_cast<T*>(::operator new(elements * sizeof(T), std::align_val_t(packAlignment))));
+}
+
+/**
+ * @brief Per-thread scratch for packed blocks of A, grown on demand and reused
+ *        across calls.
+*/
+template<typename T>
+T* thread_local_buffer(size_t elements)
+{
+    thread_local AlignedArray<T> buffer;
+    thread_local size_t capacity = 0;
+    if(capacity < elements)
+    {
+        buffer = make_aligned<T>(elements);
+        capacity = elements;
+    }
+    return buffer.get();
+}
+
+size_t round_up(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+/**
+ * @brief Packs the mc x kc block of a into mr-tall slivers, each stored column by
+ *        column (kc groups of mr values). Rows past mc are zero-filled.
+*/
+template<typename T>
+void pack_a(size_t mc, size_t kc, const T* a, size_t rsa, size_t csa, size_t mr, T* packed)
+{
+    for(size_t i0 = 0; i0 < mc; i0 += mr)
+    {
+        const size_t rows = std::min(mr, mc - i0);
+        for(size_t p = 0; p < kc; ++p)
+        {
+            const T* src = a + i0 * rsa + p * csa;
+            size_t r = 0;
+            for(; r < rows; ++r)
+            {
+                *packed++ = src[r * rsa];
+            }
+            for(; r < mr; ++r)
+            {
+                *packed++ = T(0);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Packs the kc x nc panel of b into nr-wide slivers, each stored row by row
+ *        (kc groups of nr values). Columns past nc are zero-filled.
+*/
+template<typename T>
+void pack_b(size_t kc, size_t nc, const T* b, size_t rsb, size_t csb, size_t nr, T* packed)
+{
+    for(size_t j0 = 0; j0 < nc; j0 += nr)
+    {
+        const size_t cols = std::min(nr, nc - j0);
+        for(size_t p = 0; p < kc; ++p)
+        {
+            const T* src = b + p * rsb + j0 * csb;
+            size_t j = 0;
+            for(; j < cols; ++j)
+            {
+                *packed++ = src[j * csb];
+            }
+            for(; j < nr; ++j)
+            {
+                *packed++ = T(0);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs the micro-kernel over every tile of one packed mc x nc block of c.
+ *        Partial tiles on the edges go through a local tile and are merged after.
+*/
+template<typename T>
+void macro_kernel(
+    size_t mc
+    , size_t nc
+    , size_t kc
+    , T alpha
+    , const T* a_packed
+    , const T* b_packed
+    , T beta
+    , T* c
+    , size_t ldc
+    , const simd::GemmKernel<T>& micro)
+{
+    const size_t mr = micro.mr;
+    const size_t nr = micro.nr;
+    T tile[maxTileElements];
+
+    for(size_t jr = 0; jr < nc; jr += nr)
+    {
+        const size_t cols = std::min(nr, nc - jr);
+        for(size_t ir = 0; ir < mc; ir += mr)
+        {
+            const size_t rows = std::min(mr, mc - ir);
+            const T* a_sliver = a_packed + ir * kc;
+            const T* b_sliver = b_packed + jr * kc;
+            T* c_tile = c + ir * ldc + jr;
+
+            if(rows == mr && cols == nr)
+            {
+                micro.kernel(kc, a_sliver, b_sliver, c_tile, ldc, alpha, beta);
+                continue;
+            }
+
+            micro.kernel(kc, a_sliver, b_sliver, tile, nr, alpha, T(0));
+            for(size_t r = 0; r < rows; ++r)
+            {
+                for(size_t j = 0; j < cols; ++j)
+                {
+                    T& dest = c_tile[r * ldc + j];
+                    dest = beta == T(0) ? tile[r * nr + j] : tile[r * nr + j] + beta * dest;
+                }
+            }
+        }
+    }
+}
+
+template<typename T>
+void scale_c(size_t m, size_t n, T beta, T* c, size_t ldc)
+{
+    for(size_t i = 0; i < m; ++i)
+    {
+        T* row = c + i * ldc;
+        for(size_t j = 0; j < n; ++j)
+        {
+            row[j] = beta == T(0) ? T(0) : beta * row[j];
+        }
+    }
+}
+
+/**
+ * @brief Goto/BLIS style loop nest: panels of B (jc, pc) are packed once and shared,
+ *        blocks of rows of A (ic) are packed per task and spread over threads.
+ *        a(i, p) = a[i * rsa + p * csa] and b(p, j) = b[p * rsb + j * csb], so
+ *        transposed operands only change the strides.
+*/
+template<typename T>
+void gemm_blocked(
+    const ExecutionPolicy& policy
+    , size_t m
+    , size_t n
+    , size_t k
+    , T alpha
+    , const T* a
+    , size_t rsa
+    , size_t csa
+    , const T* b
+    , size_t rsb
+    , size_t csb
+    , T beta
+    , T* c
+    , size_t ldc)
+{
+    if(m == 0 || n == 0)
+    {
+        return;
+    }
+    if(k == 0 || alpha == T(0))
+    {
+        scale_c(m, n, beta, c, ldc);
+        return;
+    }
+
+    const simd::GemmKernel<T> micro = simd::element_kernels<T>(simd::active_kernels()).gemm;
+    const size_t mr = micro.mr;
+    const size_t nr = micro.nr;
+
+    const bool parallel = policy.is_parallel(m * n * k, static_cast<size_t>(GemmConstants::maxOperationsForSequential));
+
+    // Shrink the row blocks so every thread gets at least one.
+    size_t mc = GemmConstants::mc;
+    if(parallel)
+    {
+        const size_t threads = parallel_thread_count(policy.pool());
+        mc = std::min(mc, round_up((m + threads - 1) / threads, mr));
+    }
+    const size_t num_blocks = (m + mc - 1) / mc;
+
+    const size_t kc_max = std::min(GemmConstants::kc, k);
+    const size_t nc_max = std::min(GemmConstants::nc, round_up(n, nr));
+    AlignedArray<T> b_packed = make_aligned<T>(kc_max * nc_max);
+
+    for(size_t jc = 0; jc < n; jc += GemmConstants::nc)
+    {
+        const size_t nc = std::min(GemmConstants::nc, n - jc);
+        for(size_t pc = 0; pc < k; pc += GemmConstants::kc)
+        {
+            const size_t kc = std::min(GemmConstants::kc, k - pc);
+            const T beta_block = pc == 0 ? beta : T(1);
+
+            pack_b(kc, nc, b + pc * rsb + jc * csb, rsb, csb, nr, b_packed.get());
+
+            auto run_block = [&, kc, nc, beta_block](size_t block) {
+                const size_t ic = block * mc;
+                const size_t rows = std::min(mc, m - ic);
+                T* a_packed = thread_local_buffer<T>(round_up(mc, mr) * kc_max);
+                pack_a(rows, kc, a + ic * rsa + pc * csa, rsa, csa, mr, a_packed);
+                macro_kernel(rows, nc, kc, alpha, a_packed, b_packed.get(), beta_block, c + ic * ldc + jc, ldc, micro);
+            };
+
+            if(parallel && num_blocks > 1)
+            {
+                parallel_for(policy.pool(), num_blocks, run_block);
+            }
+            else
+            {
+                for(size_t block = 0; block < num_blocks; ++block)
+                {
+                    run_block(block);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void gemm(size_t m, size_t n, size_t k, float alpha, const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc)
+{
+    gemm_blocked(execution::automatic, m, n, k, alpha, a, lda, 1, b, ldb, 1, beta, c, ldc);
+}
+
+void gemm(size_t m, size_t n, size_t k, double alpha, const double* a, size_t lda, const double* b, size_t ldb, double beta, double* c, size_t ldc)
+{
+    gemm_blocked(execution::automatic, m, n, k, alpha, a, lda, 1, b, ldb, 1, beta, c, ldc);
+}
+
+void gemm(size_t m, size_t n, size_t k, int32_t alpha, const int32_t* a, size_t lda, const int32_t* b, size_t ldb, int32_t beta, int32_t* c, size_t ldc)
+{
+    gemm_blocked(execution::automatic, m, n, k, alpha, a, lda, 1, b, ldb, 1, beta, c, ldc);
+}
+
+void gemm(size_t m, size_t n, size_t k, int64_t alpha, const int64_t* a, size_t lda, const int64_t* b, size_t ldb, int64_t beta, int64_t* c, size_t ldc)
+{
+    gemm_blocked(execution::automatic, m, n, k, alpha, a, lda, 1, b, ldb, 1, beta, c, ldc);
+}
+
+void gemm_transposed_b(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, float alpha, const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc)
+{
+    gemm_blocked(policy, m, n, k, alpha, a, lda, 1, b, 1, ldb, beta, c, ldc);
+}
+
+void gemm_transposed_b(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, double alpha, const double* a, size_t lda, const double* b, size_t ldb, double beta, double* c, size_t ldc)
+{
+    gemm_blocked(policy, m, n, k, alpha, a, lda, 1, b, 1, ldb, beta, c, ldc);
+}
+
+void gemm_transposed_b(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, int32_t alpha, const int32_t* a, size_t lda, const int32_t* b, size_t ldb, int32_t beta, int32_t* c, size_t ldc)
+{
+    gemm_blocked(policy, m, n, k, alpha, a, lda, 1, b, 1, ldb, beta, c, ldc);
+}
+
+void gemm_transposed_b(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, int64_t alpha, const int64_t* a, size_t lda, const int64_t* b, size_t ldb, int64_t beta, int64_t* c, size_t ldc)
+{
+    gemm_blocked(policy, m, n, k, alpha, a, lda, 1, b, 1, ldb, beta, c, ldc);
+}
+
+} // vctr
+} // arondina
@@ -0,0 +1,365 @@
+#include "simd.h"
+
+// vctr
+#include "simd_kernels.h"
+
+// std
+#include <atomic>
+#include <stdexcept>
+
+namespace arondina
+{
+namespace vctr
+{
+namespace simd
+{
+
+namespace
+{
+
+/**
+ * @brief One element per "register". The compiler is free to auto-vectorize these
+ *        for the baseline target; they are the reference the other tables must match.
+*/
+template<typename T>
+struct ScalarRegister
+{
+    using value_type = T;
+    using reg = T;
+    static constexpr size_t width = 1;
+
+    static reg load(const T* p) { return *p; }
+    static void store(T* p, reg v) { *p = v; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg subtract(reg a, reg b) { return a - b; }
+    static reg scale(reg v, double scalar) { v *= scalar; return v; }
+
+    static reg zero() { return T(0); }
+    static reg broadcast(T value) { return value; }
+    static reg multiply(reg a, reg b) { return a * b; }
+    static reg multiply_add(reg a, reg b, reg c) { return a * b + c; }
+    static T reduce_add(reg v) { return v; }
+
+    static reg abs(reg v) { return v < T(0) ? -v : v; }
+    static reg keep_less(reg a, reg b, reg v) { return a < b ? v : T(0); }
+    static reg keep_greater(reg a, reg b, reg v) { return a > b ? v : T(0); }
+    static reg keep_between(reg a, reg low, reg high, reg v) { return (a < low || a > high) ? T(0) : v; }
+    static bool any_outside(reg a, reg low, reg high) { return (a > T(0) && a < low) || a > high; }
+    static reg max(reg a, reg b) { return b > a ? b : a; }
+    static T reduce_max(reg v) { return v; }
+};
+
+/**
+ * @brief One element of T per step, accumulated in Acc.
+*/
+template<typename T, typename Acc>
+struct ScalarWidening
+{
+    using value_type = T;
+    using accumulator_type = Acc;
+    using reg = Acc;
+    static constexpr size_t width = 1;
+
+    static reg zero() { return Acc(0); }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg multiply_accumulate(reg acc, const T* a, const T* b) { return acc + static_cast<Acc>(*a) * static_cast<Acc>(*b); }
+
+    static reg squared_difference_accumulate(reg acc, const T* a, const T* b)
+    {
+        const Acc difference = static_cast<Acc>(*a) - static_cast<Acc>(*b);
+        return acc + difference * difference;
+    }
+    static Acc reduce_add(reg v) { return v; }
+};
+
+/**
+ * @brief One 64-bit word per step.
+*/
+struct ScalarBits
+{
+    using reg = uint64_t;
+    static constexpr size_t width = 1;
+
+    static reg load(const uint64_t* p) { return *p; }
+    static reg zero() { return 0; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg bit_xor(reg a, reg b) { return a ^ b; }
+    static reg bit_and(reg a, reg b) { return a & b; }
+    static reg bit_or(reg a, reg b) { return a | b; }
+    static reg popcount(reg v) { return simd::popcount(v); }
+    static uint64_t reduce_add(reg v) { return v; }
+};
+
+void pq4_scan_scalar(const uint8_t* codes, size_t num_blocks, size_t num_subquantizers, const uint8_t* luts, uint16_t* out)
+{
+    constexpr size_t half = Pq4Constants::blockSize / 2;
+    for(size_t block = 0; block < num_blocks; ++block)
+    {
+        uint32_t sums[Pq4Constants::blockSize] = {};
+        for(size_t s = 0; s < num_subquantizers; ++s)
+        {
+            const uint8_t* c = codes + (block * num_subquantizers + s) * Pq4Constants::bytesPerSubquantizer;
+            const uint8_t* lut = luts + s * 16;
+            for(size_t j = 0; j < half; ++j)
+            {
+                sums[j] += lut[c[j] & 0x0F];
+                sums[half + j] += lut[c[j] >> 4];
+            }
+        }
+        for(size_t j = 0; j < Pq4Constants::blockSize; ++j)
+        {
+            out[block * Pq4Constants::blockSize + j] = static_cast<uint16_t>(sums[j] < 65535 ? sums[j] : 65535);
+        }
+    }
+}
+
+KernelTable make_scalar_table()
+{
+    KernelTable table;
+    set_elementwise_kernels<ScalarRegister<float>>(table.f32);
+    set_elementwise_kernels<ScalarRegister<double>>(table.f64);
+    set_elementwise_kernels<ScalarRegister<int32_t>>(table.i32);
+    set_elementwise_kernels<ScalarRegister<int64_t>>(table.i64);
+
+    set_gemm_kernel<ScalarRegister<float>, 4, 4>(table.f32);
+    set_gemm_kernel<ScalarRegister<double>, 4, 4>(table.f64);
+    set_gemm_kernel<ScalarRegister<int32_t>, 4, 4>(table.i32);
+    set_gemm_kernel<ScalarRegister<int64_t>, 4, 4>(table.i64);
+
+    set_gemv_kernels<ScalarRegister<float>>(table.f32);
+    set_gemv_kernels<ScalarRegister<double>>(table.f64);
+    set_gemv_kernels<ScalarRegister<int32_t>>(table.i32);
+    set_gemv_kernels<ScalarRegister<int64_t>>(table.i64);
+
+    set_reduction_kernels<ScalarRegister<float>>(table.f32);
+    set_reduction_kernels<ScalarRegister<double>>(table.f64);
+    set_reduction_kernels<ScalarRegister<int32_t>>(table.i32);
+    set_reduction_kernels<ScalarRegister<int64_t>>(table.i64);
+
+    set_distance_kernels<ScalarRegister<float>>(table.f32);
+    set_distance_kernels<ScalarRegister<double>>(table.f64);
+    set_distance_kernels<ScalarRegister<int32_t>>(table.i32);
+    set_distance_kernels<ScalarRegister<int64_t>>(table.i64);
+
+    set_widening_kernel<ScalarWidening<float, double>>(table.widening.f32_f64);
+    set_widening_kernel<ScalarWidening<int8_t, int32_t>>(table.widening.i8_i32);
+    set_widening_kernel<ScalarWidening<int32_t, int64_t>>(table.widening.i32_i64);
+    set_widening_kernel<ScalarWidening<Float16, float>>(table.widening.f16_f32);
+    set_widening_kernel<ScalarWidening<BFloat16, float>>(table.widening.bf16_f32);
+    table.widening.i8_i32_symmetric = table.widening.i8_i32;
+    set_squared_difference_widening_kernel<ScalarWidening<Float16, float>>(table.widening.f16_f32_squared_difference);
+    set_squared_difference_widening_kernel<ScalarWidening<BFloat16, float>>(table.widening.bf16_f32_squared_difference);
+
+    table.f64_scaled_squares = &scaled_squares_kernel<ScalarRegister<double>>;
+    table.pq4_scan = &pq4_scan_scalar;
+    set_bit_kernels<ScalarBits>(table.bits);
+    return table;
+}
+
+bool cpu_supports(InstructionSet instruction_set)
+{
+    switch(instruction_set)
+    {
+    case InstructionSet::Scalar:
+        return true;
+#if defined(VCTR_SIMD_X86)
+    case InstructionSet::SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case InstructionSet::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2")
+            && __builtin_cpu_supports("fma")
+            && __builtin_cpu_supports("f16c")
+            && __builtin_cpu_supports("popcnt");
+    case InstructionSet::AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512dq")
+            && __builtin_cpu_supports("avx512bw")
+            && __builtin_cpu_supports("avx512vl")
+            && __builtin_cpu_supports("fma")
+            && __builtin_cpu_supports("f16c")
+            && __builtin_cpu_supports("popcnt");
+#endif
+    default:
+        return false;
+    }
+}
+
+const KernelTable& table_for(InstructionSet instruction_set)
+{
+    switch(instruction_set)
+    {
+#if defined(VCTR_SIMD_X86)
+    case InstructionSet::SSE2:
+        return sse2_kernels();
+    case InstructionSet::AVX2:
+        return avx2_kernels();
+    case InstructionSet::AVX512:
+        return avx512_kernels();
+#endif
+    default:
+        return scalar_kernels();
+    }
+}
+
+std::atomic<InstructionSet>& active()
+{
+    static std::atomic<InstructionSet> instruction_set(detected_instruction_set());
+    return instruction_set;
+}
+
+std::atomic<const KernelTable*>& active_table_slot()
+{
+    static std::atomic<const KernelTable*> table(&table_for(active().load()));
+    return table;
+}
+
+} // namespace
+
+const KernelTable& active_kernels()
+{
+    return *active_table_slot().load(std::memory_order_relaxed);
+}
+
+const KernelTable& scalar_kernels()
+{
+    static const KernelTable table = make_scalar_table();
+    return table;
+}
+
+const char* to_string(InstructionSet instruction_set)
+{
+    switch(instruction_set)
+    {
+    case InstructionSet::Scalar:
+        return "scalar";
+    case InstructionSet::SSE2:
+        return "sse2";
+    case InstructionSet::AVX2:
+        return "avx2";
+    case InstructionSet::AVX512:
+        return "avx512";
+    }
+    return "unknown";
+}
+
+InstructionSet detected_instruction_set()
+{
+    static const InstructionSet detected = [] {
+        for(InstructionSet candidate : {InstructionSet::AVX512, InstructionSet::AVX2, InstructionSet::SSE2})
+        {
+            if(cpu_supports(candidate))
+            {
+                return candidate;
+            }
+        }
+        return InstructionSet::Scalar;
+    }();
+    return detected;
+}
+
+bool is_supported(InstructionSet instruction_set)
+{
+    return cpu_supports(instruction_set);
+}
+
+InstructionSet active_instruction_set()
+{
+    return active().load();
+}
+
+void set_instruction_set(InstructionSet instruction_set)
+{
+    if(!is_supported(instruction_set))
+    {
+        throw std::runtime_error("instruction set not supported on this host.");
+    }
+    active_table_slot().store(&table_for(instruction_set));
+    active().store(instruction_set);
+}
+
+void add(const float* a, const float* b, float* out, size_t n) { active_kernels().f32.add(a, b, out, n); }
+void add(const double* a, const double* b, double* out, size_t n) { active_kernels().f64.add(a, b, out, n); }
+void add(const int32_t* a, const int32_t* b, int32_t* out, size_t n) { active_kernels().i32.add(a, b, out, n); }
+void add(const int64_t* a, const int64_t* b, int64_t* out, size_t n) { active_kernels().i64.add(a, b, out, n); }
+
+void subtract(const float* a, const float* b, float* out, size_t n) { active_kernels().f32.subtract(a, b, out, n); }
+void subtract(const double* a, const double* b, double* out, size_t n) { active_kernels().f64.subtract(a, b, out, n); }
+void subtract(const int32_t* a, const int32_t* b, int32_t* out, size_t n) { active_kernels().i32.subtract(a, b, out, n); }
+void subtract(const int64_t* a, const int64_t* b, int64_t* out, size_t n) { active_kernels().i64.subtract(a, b, out, n); }
+
+void scale(float* data, double scalar, size_t n) { active_kernels().f32.scale(data, scalar, n); }
+void scale(double* data, double scalar, size_t n) { active_kernels().f64.scale(data, scalar, n); }
+void scale(int32_t* data, double scalar, size_t n) { active_kernels().i32.scale(data, scalar, n); }
+void scale(int64_t* data, double scalar, size_t n) { active_kernels().i64.scale(data, scalar, n); }
+
+void dot_rows(const float* rows, size_t ld, size_t num_rows, const float* x, size_t n, float* out) { active_kernels().f32.dot_rows(rows, ld, num_rows, x, n, out); }
+void dot_rows(const double* rows, size_t ld, size_t num_rows, const double* x, size_t n, double* out) { active_kernels().f64.dot_rows(rows, ld, num_rows, x, n, out); }
+void dot_rows(const int32_t* rows, size_t ld, size_t num_rows, const int32_t* x, size_t n, int32_t* out) { active_kernels().i32.dot_rows(rows, ld, num_rows, x, n, out); }
+void dot_rows(const int64_t* rows, size_t ld, size_t num_rows, const int64_t* x, size_t n, int64_t* out) { active_kernels().i64.dot_rows(rows, ld, num_rows, x, n, out); }
+
+void axpy_rows(const float* rows, size_t ld, size_t num_rows, const float* alphas, size_t n, float* y) { active_kernels().f32.axpy_rows(rows, ld, num_rows, alphas, n, y); }
+void axpy_rows(const double* rows, size_t ld, size_t num_rows, const double* alphas, size_t n, double* y) { active_kernels().f64.axpy_rows(rows, ld, num_rows, alphas, n, y); }
+void axpy_rows(const int32_t* rows, size_t ld, size_t num_rows, const int32_t* alphas, size_t n, int32_t* y) { active_kernels().i32.axpy_rows(rows, ld, num_rows, alphas, n, y); }
+void axpy_rows(const int64_t* rows, size_t ld, size_t num_rows, const int64_t* alphas, size_t n, int64_t* y) { active_kernels().i64.axpy_rows(rows, ld, num_rows, alphas, n, y); }
+
+float dot_reproducible(const float* a, const float* b, size_t n) { return active_kernels().f32.dot_reproducible(a, b, n); }
+double dot_reproducible(const double* a, const double* b, size_t n) { return active_kernels().f64.dot_reproducible(a, b, n); }
+int32_t dot_reproducible(const int32_t* a, const int32_t* b, size_t n) { return active_kernels().i32.dot_reproducible(a, b, n); }
+int64_t dot_reproducible(const int64_t* a, const int64_t* b, size_t n) { return active_kernels().i64.dot_reproducible(a, b, n); }
+
+Compensated<float> dot_compensated(const float* a, const float* b, size_t n) { return active_kernels().f32.dot_compensated(a, b, n); }
+Compensated<double> dot_compensated(const double* a, const double* b, size_t n) { return active_kernels().f64.dot_compensated(a, b, n); }
+Compensated<int32_t> dot_compensated(const int32_t* a, const int32_t* b, size_t n) { return active_kernels().i32.dot_compensated(a, b, n); }
+Compensated<int64_t> dot_compensated(const int64_t* a, const int64_t* b, size_t n) { return active_kernels().i64.dot_compensated(a, b, n); }
+
+ScaledSquares<double> scaled_squares(const double* x, size_t n) { return active_kernels().f64_scaled_squares(x, n); }
+
+float sum_abs_difference(const float* a, const float* b, size_t n) { return active_kernels().f32.sum_abs_difference(a, b, n); }
+double sum_abs_difference(const double* a, const double* b, size_t n) { return active_kernels().f64.sum_abs_difference(a, b, n); }
+int32_t sum_abs_difference(const int32_t* a, const int32_t* b, size_t n) { return active_kernels().i32.sum_abs_difference(a, b, n); }
+int64_t sum_abs_difference(const int64_t* a, const int64_t* b, size_t n) { return active_kernels().i64.sum_abs_difference(a, b, n); }
+
+float sum_squared_difference(const float* a, const float* b, size_t n) { return active_kernels().f32.sum_squared_difference(a, b, n); }
+double sum_squared_difference(const double* a, const double* b, size_t n) { return active_kernels().f64.sum_squared_difference(a, b, n); }
+int32_t sum_squared_difference(const int32_t* a, const int32_t* b, size_t n) { return active_kernels().i32.sum_squared_difference(a, b, n); }
+int64_t sum_squared_difference(const int64_t* a, const int64_t* b, size_t n) { return active_kernels().i64.sum_squared_difference(a, b, n); }
+float sum_squared_difference(const Float16* a, const Float16* b, size_t n) { return active_kernels().widening.f16_f32_squared_difference(a, b, n); }
+float sum_squared_difference(const BFloat16* a, const BFloat16* b, size_t n) { return active_kernels().widening.bf16_f32_squared_difference(a, b, n); }
+
+float max_abs_difference(const float* a, const float* b, size_t n) { return active_kernels().f32.max_abs_difference(a, b, n); }
+double max_abs_difference(const double* a, const double* b, size_t n) { return active_kernels().f64.max_abs_difference(a, b, n); }
+int32_t max_abs_difference(const int32_t* a, const int32_t* b, size_t n) { return active_kernels().i32.max_abs_difference(a, b, n); }
+int64_t max_abs_difference(const int64_t* a, const int64_t* b, size_t n) { return active_kernels().i64.max_abs_difference(a, b, n); }
+
+CosineSums<float> cosine_sums(const float* a, const float* b, size_t n) { return active_kernels().f32.cosine_sums(a, b, n); }
+CosineSums<double> cosine_sums(const double* a, const double* b, size_t n) { return active_kernels().f64.cosine_sums(a, b, n); }
+CosineSums<int32_t> cosine_sums(const int32_t* a, const int32_t* b, size_t n) { return active_kernels().i32.cosine_sums(a, b, n); }
+CosineSums<int64_t> cosine_sums(const int64_t* a, const int64_t* b, size_t n) { return active_kernels().i64.cosine_sums(a, b, n); }
+
+void pq4_scan(const uint8_t* codes, size_t num_blocks, size_t num_subquantizers, const uint8_t* luts, uint16_t* out)
+{
+    active_kernels().pq4_scan(codes, num_blocks, num_subquantizers, luts, out);
+}
+
+uint64_t hamming_distance(const uint64_t* a, const uint64_t* b, size_t n) { return active_kernels().bits.hamming(a, b, n); }
+BitCounts bit_counts(const uint64_t* a, const uint64_t* b, size_t n) { return active_kernels().bits.counts(a, b, n); }
+
+void hamming_distance_rows(const uint64_t* rows, size_t ld, size_t num_rows, const uint64_t* x, size_t n, uint32_t* out)
+{
+    active_kernels().bits.hamming_rows(rows, ld, num_rows, x, n, out);
+}
+
+template<> double dot_accumulate<double, float>(const float* a, const float* b, size_t n) { return active_kernels().widening.f32_f64(a, b, n); }
+template<> int32_t dot_accumulate<int32_t, int8_t>(const int8_t* a, const int8_t* b, size_t n) { return active_kernels().widening.i8_i32(a, b, n); }
+template<> int64_t dot_accumulate<int64_t, int32_t>(const int32_t* a, const int32_t* b, size_t n) { return active_kernels().widening.i32_i64(a, b, n); }
+template<> float dot_accumulate<float, Float16>(const Float16* a, const Float16* b, size_t n) { return active_kernels().widening.f16_f32(a, b, n); }
+template<> float dot_accumulate<float, BFloat16>(const BFloat16* a, const BFloat16* b, size_t n) { return active_kernels().widening.bf16_f32(a, b, n); }
+
+int32_t dot_symmetric_int8(const int8_t* a, const int8_t* b, size_t n) { return active_kernels().widening.i8_i32_symmetric(a, b, n); }
+
+} // simd
+} // vctr
+} // arondina
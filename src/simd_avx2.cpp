@@ -0,0 +1,463 @@
+// Compiled with -mavx2 -mfma -mf16c -mpopcnt. Only reached through the dispatch table
+// in simd.cpp.
+
+// vctr
+#include "simd_kernels.h"
+
+// std
+#include <immintrin.h>
+
+namespace arondina
+{
+namespace vctr
+{
+namespace simd
+{
+
+namespace
+{
+
+struct Float32x8
+{
+    using value_type = float;
+    using reg = __m256;
+    static constexpr size_t width = 8;
+
+    static reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg subtract(reg a, reg b) { return _mm256_sub_ps(a, b); }
+
+    static reg scale(reg v, double scalar)
+    {
+        const __m256d s = _mm256_set1_pd(scalar);
+        const __m128 lo = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), s));
+        const __m128 hi = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), s));
+        return _mm256_set_m128(hi, lo);
+    }
+
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg broadcast(float value) { return _mm256_set1_ps(value); }
+    static reg multiply(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+
+    static float reduce_add(reg v)
+    {
+        const __m128 quad = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        const __m128 pairs = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+
+    static reg abs(reg v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+
+    static float reduce_max(reg v)
+    {
+        const __m128 quad = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        const __m128 pairs = _mm_max_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+struct Float64x4
+{
+    using value_type = double;
+    using reg = __m256d;
+    static constexpr size_t width = 4;
+
+    static reg load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static reg subtract(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    static reg scale(reg v, double scalar) { return _mm256_mul_pd(v, _mm256_set1_pd(scalar)); }
+
+    static reg zero() { return _mm256_setzero_pd(); }
+    static reg broadcast(double value) { return _mm256_set1_pd(value); }
+    static reg multiply(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+
+    static double reduce_add(reg v)
+    {
+        const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    }
+
+    static reg abs(reg v) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), v); }
+    static reg keep_less(reg a, reg b, reg v) { return _mm256_and_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ), v); }
+    static reg keep_greater(reg a, reg b, reg v) { return _mm256_and_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ), v); }
+
+    static reg keep_between(reg a, reg low, reg high, reg v)
+    {
+        return _mm256_andnot_pd(_mm256_or_pd(_mm256_cmp_pd(a, low, _CMP_LT_OQ), _mm256_cmp_pd(a, high, _CMP_GT_OQ)), v);
+    }
+
+    static bool any_outside(reg a, reg low, reg high)
+    {
+        const __m256d tiny = _mm256_and_pd(_mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_GT_OQ), _mm256_cmp_pd(a, low, _CMP_LT_OQ));
+        return _mm256_movemask_pd(_mm256_or_pd(tiny, _mm256_cmp_pd(a, high, _CMP_GT_OQ))) != 0;
+    }
+
+    static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+
+    static double reduce_max(reg v)
+    {
+        const __m128d pair = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    }
+};
+
+struct Int32x8
+{
+    using value_type = int32_t;
+    using reg = __m256i;
+    static constexpr size_t width = 8;
+
+    static reg load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(int32_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    static reg subtract(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+
+    static reg scale(reg v, double scalar)
+    {
+        const __m256d s = _mm256_set1_pd(scalar);
+        const __m128i lo = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), s));
+        const __m128i hi = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), s));
+        return _mm256_set_m128i(hi, lo);
+    }
+
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg broadcast(int32_t value) { return _mm256_set1_epi32(value); }
+    static reg multiply(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c); }
+
+    static int32_t reduce_add(reg v)
+    {
+        __m128i quad = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        quad = _mm_add_epi32(quad, _mm_shuffle_epi32(quad, 0x4E));
+        quad = _mm_add_epi32(quad, _mm_shuffle_epi32(quad, 0xB1));
+        return _mm_cvtsi128_si32(quad);
+    }
+
+    static reg abs(reg v) { return _mm256_abs_epi32(v); }
+    static reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+
+    static int32_t reduce_max(reg v)
+    {
+        __m128i quad = _mm_max_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        quad = _mm_max_epi32(quad, _mm_shuffle_epi32(quad, 0x4E));
+        quad = _mm_max_epi32(quad, _mm_shuffle_epi32(quad, 0xB1));
+        return _mm_cvtsi128_si32(quad);
+    }
+};
+
+struct Int64x4
+{
+    using value_type = int64_t;
+    using reg = __m256i;
+    static constexpr size_t width = 4;
+
+    static reg load(const int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(int64_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+    static reg subtract(reg a, reg b) { return _mm256_sub_epi64(a, b); }
+};
+
+/**
+ * @brief Four floats per step, converted and accumulated in double lanes.
+*/
+struct WidenFloat32x4
+{
+    using value_type = float;
+    using accumulator_type = double;
+    using reg = __m256d;
+    static constexpr size_t width = 4;
+
+    static reg zero() { return _mm256_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+
+    static reg multiply_accumulate(reg acc, const float* a, const float* b)
+    {
+        return _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(a)), _mm256_cvtps_pd(_mm_loadu_ps(b)), acc);
+    }
+
+    static double reduce_add(reg v) { return Float64x4::reduce_add(v); }
+};
+
+/**
+ * @brief Sixteen int8 per step, sign-extended to int16 and multiplied pairwise into
+ *        int32 lanes.
+*/
+struct WidenInt8x16
+{
+    using value_type = int8_t;
+    using accumulator_type = int32_t;
+    using reg = __m256i;
+    static constexpr size_t width = 16;
+
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+
+    static reg multiply_accumulate(reg acc, const int8_t* a, const int8_t* b)
+    {
+        const __m256i x = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)));
+        const __m256i y = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+        return _mm256_add_epi32(acc, _mm256_madd_epi16(x, y));
+    }
+
+    static int32_t reduce_add(reg v) { return Int32x8::reduce_add(v); }
+};
+
+/**
+ * @brief Four int32 per step, sign-extended to int64 lanes and multiplied exactly.
+*/
+struct WidenInt32x4
+{
+    using value_type = int32_t;
+    using accumulator_type = int64_t;
+    using reg = __m256i;
+    static constexpr size_t width = 4;
+
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+
+    static reg multiply_accumulate(reg acc, const int32_t* a, const int32_t* b)
+    {
+        const __m256i x = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)));
+        const __m256i y = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+        return _mm256_add_epi64(acc, _mm256_mul_epi32(x, y));
+    }
+
+    static int64_t reduce_add(reg v)
+    {
+        const __m128i pair = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        return _mm_cvtsi128_si64(_mm_add_epi64(pair, _mm_unpackhi_epi64(pair, pair)));
+    }
+};
+
+/**
+ * @brief Thirty-two int8 in [-127, 127] per step. maddubs multiplies unsigned by
+ *        signed bytes, so a goes in as |a| and b takes a's sign; without -128 no
+ *        pair sum exceeds 2 * 127 * 127 and the int16 results never saturate.
+*/
+struct WidenSymmetricInt8x32
+{
+    using value_type = int8_t;
+    using accumulator_type = int32_t;
+    using reg = __m256i;
+    static constexpr size_t width = 32;
+
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+
+    static reg multiply_accumulate(reg acc, const int8_t* a, const int8_t* b)
+    {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        const __m256i pairs = _mm256_maddubs_epi16(_mm256_abs_epi8(x), _mm256_sign_epi8(y, x));
+        return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+    }
+
+    static int32_t reduce_add(reg v) { return Int32x8::reduce_add(v); }
+};
+
+/**
+ * @brief Eight IEEE half floats per step, widened with the F16C conversion.
+*/
+struct WidenFloat16x8
+{
+    using value_type = Float16;
+    using accumulator_type = float;
+    using reg = __m256;
+    static constexpr size_t width = 8;
+
+    static reg load(const Float16* p) { return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg multiply_accumulate(reg acc, const Float16* a, const Float16* b) { return _mm256_fmadd_ps(load(a), load(b), acc); }
+
+    static reg squared_difference_accumulate(reg acc, const Float16* a, const Float16* b)
+    {
+        const __m256 difference = _mm256_sub_ps(load(a), load(b));
+        return _mm256_fmadd_ps(difference, difference, acc);
+    }
+
+    static float reduce_add(reg v) { return Float32x8::reduce_add(v); }
+};
+
+/**
+ * @brief Eight bfloat16 per step, zero-extended to 32 bits and shifted into the upper
+ *        half of a float.
+*/
+struct WidenBFloat16x8
+{
+    using value_type = BFloat16;
+    using accumulator_type = float;
+    using reg = __m256;
+    static constexpr size_t width = 8;
+
+    static reg load(const BFloat16* p)
+    {
+        const __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(x, 16));
+    }
+
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg multiply_accumulate(reg acc, const BFloat16* a, const BFloat16* b) { return _mm256_fmadd_ps(load(a), load(b), acc); }
+
+    static reg squared_difference_accumulate(reg acc, const BFloat16* a, const BFloat16* b)
+    {
+        const __m256 difference = _mm256_sub_ps(load(a), load(b));
+        return _mm256_fmadd_ps(difference, difference, acc);
+    }
+
+    static float reduce_add(reg v) { return Float32x8::reduce_add(v); }
+};
+
+/**
+ * @brief Four 64-bit words per step, counted through a 16-entry table of nibble
+ *        popcounts: one byte shuffle per nibble gives the count of every byte, and
+ *        sad_epu8 against zero sums each group of eight into a 64-bit lane.
+*/
+struct NibbleBits256
+{
+    using reg = __m256i;
+    static constexpr size_t width = 4;
+
+    static reg load(const uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+    static reg bit_xor(reg a, reg b) { return _mm256_xor_si256(a, b); }
+    static reg bit_and(reg a, reg b) { return _mm256_and_si256(a, b); }
+    static reg bit_or(reg a, reg b) { return _mm256_or_si256(a, b); }
+
+    static reg popcount(reg v)
+    {
+        const __m256i table = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+            , 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i nibble = _mm256_set1_epi8(0x0F);
+        const __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(v, nibble));
+        const __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        return _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+    }
+
+    static uint64_t reduce_add(reg v)
+    {
+        const __m128i pairs = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_add_epi64(pairs, _mm_unpackhi_epi64(pairs, pairs))));
+    }
+};
+
+/**
+ * @brief Two subquantizers per step: their codes and lookup tables fill the two
+ *        128-bit lanes, and one shuffle per nibble looks up 16 vectors in each lane.
+ *        The lanes are folded together once per block.
+*/
+void pq4_scan_kernel(const uint8_t* codes, size_t num_blocks, size_t num_subquantizers, const uint8_t* luts, uint16_t* out)
+{
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    for(size_t block = 0; block < num_blocks; ++block)
+    {
+        const uint8_t* c = codes + block * num_subquantizers * Pq4Constants::bytesPerSubquantizer;
+
+        // vectors 0-7, 8-15, 16-23 and 24-31, one subquantizer per lane
+        __m256i acc0 = zero;
+        __m256i acc1 = zero;
+        __m256i acc2 = zero;
+        __m256i acc3 = zero;
+        size_t s = 0;
+        for(; s + 2 <= num_subquantizers; s += 2)
+        {
+            const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + s * Pq4Constants::bytesPerSubquantizer));
+            const __m256i lut = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(luts + s * 16));
+            const __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(packed, low_nibbles));
+            const __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(packed, 4), low_nibbles));
+            acc0 = _mm256_adds_epu16(acc0, _mm256_unpacklo_epi8(lo, zero));
+            acc1 = _mm256_adds_epu16(acc1, _mm256_unpackhi_epi8(lo, zero));
+            acc2 = _mm256_adds_epu16(acc2, _mm256_unpacklo_epi8(hi, zero));
+            acc3 = _mm256_adds_epu16(acc3, _mm256_unpackhi_epi8(hi, zero));
+        }
+
+        __m128i sum0 = _mm_adds_epu16(_mm256_castsi256_si128(acc0), _mm256_extracti128_si256(acc0, 1));
+        __m128i sum1 = _mm_adds_epu16(_mm256_castsi256_si128(acc1), _mm256_extracti128_si256(acc1, 1));
+        __m128i sum2 = _mm_adds_epu16(_mm256_castsi256_si128(acc2), _mm256_extracti128_si256(acc2, 1));
+        __m128i sum3 = _mm_adds_epu16(_mm256_castsi256_si128(acc3), _mm256_extracti128_si256(acc3, 1));
+        if(s < num_subquantizers)
+        {
+            const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + s * Pq4Constants::bytesPerSubquantizer));
+            const __m128i lut = _mm_loadu_si128(reinterpret_cast<const __m128i*>(luts + s * 16));
+            const __m128i mask = _mm256_castsi256_si128(low_nibbles);
+            const __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(packed, mask));
+            const __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(packed, 4), mask));
+            const __m128i zero128 = _mm_setzero_si128();
+            sum0 = _mm_adds_epu16(sum0, _mm_unpacklo_epi8(lo, zero128));
+            sum1 = _mm_adds_epu16(sum1, _mm_unpackhi_epi8(lo, zero128));
+            sum2 = _mm_adds_epu16(sum2, _mm_unpacklo_epi8(hi, zero128));
+            sum3 = _mm_adds_epu16(sum3, _mm_unpackhi_epi8(hi, zero128));
+        }
+
+        __m128i* o = reinterpret_cast<__m128i*>(out + block * Pq4Constants::blockSize);
+        _mm_storeu_si128(o, sum0);
+        _mm_storeu_si128(o + 1, sum1);
+        _mm_storeu_si128(o + 2, sum2);
+        _mm_storeu_si128(o + 3, sum3);
+    }
+}
+
+KernelTable make_table()
+{
+    KernelTable table = sse2_kernels();
+
+    set_elementwise_kernels<Float32x8>(table.f32);
+    set_elementwise_kernels<Float64x4>(table.f64);
+    set_elementwise_kernels<Int32x8>(table.i32);
+
+    set_gemm_kernel<Float32x8, 6, 2>(table.f32);
+    set_gemm_kernel<Float64x4, 6, 2>(table.f64);
+
+    set_gemv_kernels<Float32x8>(table.f32);
+    set_gemv_kernels<Float64x4>(table.f64);
+    set_gemv_kernels<Int32x8>(table.i32);
+
+    set_reduction_kernels<Float32x8, true>(table.f32);
+    set_reduction_kernels<Float64x4, true>(table.f64);
+    set_reduction_kernels<Int32x8>(table.i32);
+
+    set_distance_kernels<Float32x8>(table.f32);
+    set_distance_kernels<Float64x4>(table.f64);
+    set_distance_kernels<Int32x8>(table.i32);
+
+    set_widening_kernel<WidenFloat32x4>(table.widening.f32_f64);
+    set_widening_kernel<WidenInt8x16>(table.widening.i8_i32);
+    set_widening_kernel<WidenInt32x4>(table.widening.i32_i64);
+    set_widening_kernel<WidenSymmetricInt8x32>(table.widening.i8_i32_symmetric);
+    set_widening_kernel<WidenFloat16x8>(table.widening.f16_f32);
+    set_widening_kernel<WidenBFloat16x8>(table.widening.bf16_f32);
+    set_squared_difference_widening_kernel<WidenFloat16x8>(table.widening.f16_f32_squared_difference);
+    set_squared_difference_widening_kernel<WidenBFloat16x8>(table.widening.bf16_f32_squared_difference);
+
+    table.f64_scaled_squares = &scaled_squares_kernel<Float64x4>;
+    table.pq4_scan = &pq4_scan_kernel;
+    set_bit_kernels<NibbleBits256>(table.bits);
+
+    // AVX2 has no packed int64 <-> double conversion, so scale stays scalar.
+    table.i64.add = &add_kernel<Int64x4>;
+    table.i64.subtract = &subtract_kernel<Int64x4>;
+
+    return table;
+}
+
+} // namespace
+
+const KernelTable& avx2_kernels()
+{
+    static const KernelTable table = make_table();
+    return table;
+}
+
+} // simd
+} // vctr
+} // arondina
@@ -0,0 +1,355 @@
+// Compiled with -mavx512f -mavx512dq -mavx512bw -mavx512vl -mfma -mf16c -mpopcnt. Only
+// reached through the dispatch table in simd.cpp.
+
+// vctr
+#include "simd_kernels.h"
+
+// std
+#include <immintrin.h>
+
+namespace arondina
+{
+namespace vctr
+{
+namespace simd
+{
+
+namespace
+{
+
+struct Float32x16
+{
+    using value_type = float;
+    using reg = __m512;
+    static constexpr size_t width = 16;
+
+    static reg load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm512_storeu_ps(p, v); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg subtract(reg a, reg b) { return _mm512_sub_ps(a, b); }
+
+    static reg scale(reg v, double scalar)
+    {
+        const __m512d s = _mm512_set1_pd(scalar);
+        const __m256 lo = _mm512_cvtpd_ps(_mm512_mul_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(v)), s));
+        const __m256 hi = _mm512_cvtpd_ps(_mm512_mul_pd(_mm512_cvtps_pd(_mm512_extractf32x8_ps(v, 1)), s));
+        return _mm512_insertf32x8(_mm512_castps256_ps512(lo), hi, 1);
+    }
+
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg broadcast(float value) { return _mm512_set1_ps(value); }
+    static reg multiply(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static float reduce_add(reg v) { return _mm512_reduce_add_ps(v); }
+
+    static reg abs(reg v) { return _mm512_abs_ps(v); }
+    static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+    static float reduce_max(reg v) { return _mm512_reduce_max_ps(v); }
+};
+
+struct Float64x8
+{
+    using value_type = double;
+    using reg = __m512d;
+    static constexpr size_t width = 8;
+
+    static reg load(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm512_storeu_pd(p, v); }
+    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static reg subtract(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    static reg scale(reg v, double scalar) { return _mm512_mul_pd(v, _mm512_set1_pd(scalar)); }
+
+    static reg zero() { return _mm512_setzero_pd(); }
+    static reg broadcast(double value) { return _mm512_set1_pd(value); }
+    static reg multiply(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static double reduce_add(reg v) { return _mm512_reduce_add_pd(v); }
+
+    static reg abs(reg v) { return _mm512_abs_pd(v); }
+    static reg keep_less(reg a, reg b, reg v) { return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ), v); }
+    static reg keep_greater(reg a, reg b, reg v) { return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ), v); }
+
+    static reg keep_between(reg a, reg low, reg high, reg v)
+    {
+        const __mmask8 outside = _mm512_cmp_pd_mask(a, low, _CMP_LT_OQ) | _mm512_cmp_pd_mask(a, high, _CMP_GT_OQ);
+        return _mm512_maskz_mov_pd(static_cast<__mmask8>(~outside), v);
+    }
+
+    static bool any_outside(reg a, reg low, reg high)
+    {
+        const __mmask8 tiny = _mm512_mask_cmp_pd_mask(_mm512_cmp_pd_mask(a, _mm512_setzero_pd(), _CMP_GT_OQ), a, low, _CMP_LT_OQ);
+        return (tiny | _mm512_cmp_pd_mask(a, high, _CMP_GT_OQ)) != 0;
+    }
+
+    static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+    static double reduce_max(reg v) { return _mm512_reduce_max_pd(v); }
+};
+
+struct Int32x16
+{
+    using value_type = int32_t;
+    using reg = __m512i;
+    static constexpr size_t width = 16;
+
+    static reg load(const int32_t* p) { return _mm512_loadu_si512(p); }
+    static void store(int32_t* p, reg v) { _mm512_storeu_si512(p, v); }
+    static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    static reg subtract(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+
+    static reg scale(reg v, double scalar)
+    {
+        const __m512d s = _mm512_set1_pd(scalar);
+        const __m256i lo = _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(v)), s));
+        const __m256i hi = _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(v, 1)), s));
+        return _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1);
+    }
+
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg broadcast(int32_t value) { return _mm512_set1_epi32(value); }
+    static reg multiply(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c); }
+    static int32_t reduce_add(reg v) { return _mm512_reduce_add_epi32(v); }
+
+    static reg abs(reg v) { return _mm512_abs_epi32(v); }
+    static reg max(reg a, reg b) { return _mm512_max_epi32(a, b); }
+    static int32_t reduce_max(reg v) { return _mm512_reduce_max_epi32(v); }
+};
+
+struct Int64x8
+{
+    using value_type = int64_t;
+    using reg = __m512i;
+    static constexpr size_t width = 8;
+
+    static reg load(const int64_t* p) { return _mm512_loadu_si512(p); }
+    static void store(int64_t* p, reg v) { _mm512_storeu_si512(p, v); }
+    static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+    static reg subtract(reg a, reg b) { return _mm512_sub_epi64(a, b); }
+
+    static reg scale(reg v, double scalar)
+    {
+        return _mm512_cvttpd_epi64(_mm512_mul_pd(_mm512_cvtepi64_pd(v), _mm512_set1_pd(scalar)));
+    }
+
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg broadcast(int64_t value) { return _mm512_set1_epi64(value); }
+    static reg multiply(reg a, reg b) { return _mm512_mullo_epi64(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm512_add_epi64(_mm512_mullo_epi64(a, b), c); }
+    static int64_t reduce_add(reg v) { return _mm512_reduce_add_epi64(v); }
+
+    static reg abs(reg v) { return _mm512_abs_epi64(v); }
+    static reg max(reg a, reg b) { return _mm512_max_epi64(a, b); }
+    static int64_t reduce_max(reg v) { return _mm512_reduce_max_epi64(v); }
+};
+
+/**
+ * @brief Eight floats per step, converted and accumulated in double lanes.
+*/
+struct WidenFloat32x8
+{
+    using value_type = float;
+    using accumulator_type = double;
+    using reg = __m512d;
+    static constexpr size_t width = 8;
+
+    static reg zero() { return _mm512_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+
+    static reg multiply_accumulate(reg acc, const float* a, const float* b)
+    {
+        return _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(a)), _mm512_cvtps_pd(_mm256_loadu_ps(b)), acc);
+    }
+
+    static double reduce_add(reg v) { return _mm512_reduce_add_pd(v); }
+};
+
+/**
+ * @brief Thirty-two int8 per step, sign-extended to int16 and multiplied pairwise
+ *        into int32 lanes.
+*/
+struct WidenInt8x32
+{
+    using value_type = int8_t;
+    using accumulator_type = int32_t;
+    using reg = __m512i;
+    static constexpr size_t width = 32;
+
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+
+    static reg multiply_accumulate(reg acc, const int8_t* a, const int8_t* b)
+    {
+        const __m512i x = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)));
+        const __m512i y = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+        return _mm512_add_epi32(acc, _mm512_madd_epi16(x, y));
+    }
+
+    static int32_t reduce_add(reg v) { return _mm512_reduce_add_epi32(v); }
+};
+
+/**
+ * @brief Eight int32 per step, sign-extended to int64 lanes and multiplied exactly.
+*/
+struct WidenInt32x8
+{
+    using value_type = int32_t;
+    using accumulator_type = int64_t;
+    using reg = __m512i;
+    static constexpr size_t width = 8;
+
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+
+    static reg multiply_accumulate(reg acc, const int32_t* a, const int32_t* b)
+    {
+        const __m512i x = _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)));
+        const __m512i y = _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+        return _mm512_add_epi64(acc, _mm512_mul_epi32(x, y));
+    }
+
+    static int64_t reduce_add(reg v) { return _mm512_reduce_add_epi64(v); }
+};
+
+/**
+ * @brief Sixty-four int8 in [-127, 127] per step, multiplied as |a| times b with a's
+ *        sign through maddubs. AVX-512 has no byte sign instruction, so b is negated
+ *        under the mask of a's sign bits instead.
+*/
+struct WidenSymmetricInt8x64
+{
+    using value_type = int8_t;
+    using accumulator_type = int32_t;
+    using reg = __m512i;
+    static constexpr size_t width = 64;
+
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+
+    static reg multiply_accumulate(reg acc, const int8_t* a, const int8_t* b)
+    {
+        const __m512i x = _mm512_loadu_si512(a);
+        const __m512i y = _mm512_loadu_si512(b);
+        const __m512i signed_y = _mm512_mask_sub_epi8(y, _mm512_movepi8_mask(x), _mm512_setzero_si512(), y);
+        const __m512i pairs = _mm512_maddubs_epi16(_mm512_abs_epi8(x), signed_y);
+        return _mm512_add_epi32(acc, _mm512_madd_epi16(pairs, _mm512_set1_epi16(1)));
+    }
+
+    static int32_t reduce_add(reg v) { return _mm512_reduce_add_epi32(v); }
+};
+
+/**
+ * @brief Sixteen IEEE half floats per step, widened with the AVX-512 conversion.
+*/
+struct WidenFloat16x16
+{
+    using value_type = Float16;
+    using accumulator_type = float;
+    using reg = __m512;
+    static constexpr size_t width = 16;
+
+    static reg load(const Float16* p) { return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))); }
+
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg multiply_accumulate(reg acc, const Float16* a, const Float16* b) { return _mm512_fmadd_ps(load(a), load(b), acc); }
+
+    static reg squared_difference_accumulate(reg acc, const Float16* a, const Float16* b)
+    {
+        const __m512 difference = _mm512_sub_ps(load(a), load(b));
+        return _mm512_fmadd_ps(difference, difference, acc);
+    }
+
+    static float reduce_add(reg v) { return _mm512_reduce_add_ps(v); }
+};
+
+/**
+ * @brief Sixteen bfloat16 per step, zero-extended to 32 bits and shifted into the
+ *        upper half of a float.
+*/
+struct WidenBFloat16x16
+{
+    using value_type = BFloat16;
+    using accumulator_type = float;
+    using reg = __m512;
+    static constexpr size_t width = 16;
+
+    static reg load(const BFloat16* p)
+    {
+        const __m512i x = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(x, 16));
+    }
+
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg multiply_accumulate(reg acc, const BFloat16* a, const BFloat16* b) { return _mm512_fmadd_ps(load(a), load(b), acc); }
+
+    static reg squared_difference_accumulate(reg acc, const BFloat16* a, const BFloat16* b)
+    {
+        const __m512 difference = _mm512_sub_ps(load(a), load(b));
+        return _mm512_fmadd_ps(difference, difference, acc);
+    }
+
+    static float reduce_add(reg v) { return _mm512_reduce_add_ps(v); }
+};
+
+KernelTable make_table()
+{
+    KernelTable table = avx2_kernels();
+
+    set_elementwise_kernels<Float32x16>(table.f32);
+    set_elementwise_kernels<Float64x8>(table.f64);
+    set_elementwise_kernels<Int32x16>(table.i32);
+    set_elementwise_kernels<Int64x8>(table.i64);
+
+    // 12 x 2 accumulators leave room for the B sliver and the A broadcast in 32 zmm.
+    set_gemm_kernel<Float32x16, 12, 2>(table.f32);
+    set_gemm_kernel<Float64x8, 12, 2>(table.f64);
+
+    set_gemv_kernels<Float32x16>(table.f32);
+    set_gemv_kernels<Float64x8>(table.f64);
+    set_gemv_kernels<Int32x16>(table.i32);
+    set_gemv_kernels<Int64x8>(table.i64);
+
+    set_reduction_kernels<Float32x16, true>(table.f32);
+    set_reduction_kernels<Float64x8, true>(table.f64);
+    set_reduction_kernels<Int32x16>(table.i32);
+    set_reduction_kernels<Int64x8>(table.i64);
+
+    set_distance_kernels<Float32x16>(table.f32);
+    set_distance_kernels<Float64x8>(table.f64);
+    set_distance_kernels<Int32x16>(table.i32);
+    set_distance_kernels<Int64x8>(table.i64);
+
+    set_widening_kernel<WidenFloat32x8>(table.widening.f32_f64);
+    set_widening_kernel<WidenInt8x32>(table.widening.i8_i32);
+    set_widening_kernel<WidenInt32x8>(table.widening.i32_i64);
+    set_widening_kernel<WidenSymmetricInt8x64>(table.widening.i8_i32_symmetric);
+    set_widening_kernel<WidenFloat16x16>(table.widening.f16_f32);
+    set_widening_kernel<WidenBFloat16x16>(table.widening.bf16_f32);
+    set_squared_difference_widening_kernel<WidenFloat16x16>(table.widening.f16_f32_squared_difference);
+    set_squared_difference_widening_kernel<WidenBFloat16x16>(table.widening.bf16_f32_squared_difference);
+
+    table.f64_scaled_squares = &scaled_squares_kernel<Float64x8>;
+
+    // Without VPOPCNTDQ the bit kernels stay on the AVX2 nibble table: the wider
+    // shuffles gain little and 256-bit signatures would fall to the scalar tail.
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512vpopcntdq"))
+    {
+        set_vpopcntdq_kernels(table.bits);
+    }
+
+    return table;
+}
+
+} // namespace
+
+const KernelTable& avx512_kernels()
+{
+    static const KernelTable table = make_table();
+    return table;
+}
+
+} // simd
+} // vctr
+} // arondina
@@ -0,0 +1,71 @@
+// Compiled with the AVX-512 flags plus -mavx512vpopcntdq. Only reached through the
+// AVX-512 table, after a CPUID check for the extension.
+
+// vctr
+#include "simd_kernels.h"
+
+// std
+#include <immintrin.h>
+
+namespace arondina
+{
+namespace vctr
+{
+namespace simd
+{
+
+namespace
+{
+
+/**
+ * @brief Eight 64-bit words per step, counted by vpopcntq in their own lanes.
+*/
+struct PopcountBits512
+{
+    using reg = __m512i;
+    static constexpr size_t width = 8;
+
+    static reg load(const uint64_t* p) { return _mm512_loadu_si512(p); }
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+    static reg bit_xor(reg a, reg b) { return _mm512_xor_si512(a, b); }
+    static reg bit_and(reg a, reg b) { return _mm512_and_si512(a, b); }
+    static reg bit_or(reg a, reg b) { return _mm512_or_si512(a, b); }
+    static reg popcount(reg v) { return _mm512_popcnt_epi64(v); }
+    static uint64_t reduce_add(reg v) { return static_cast<uint64_t>(_mm512_reduce_add_epi64(v)); }
+};
+
+/**
+ * @brief Four 64-bit words per step through the VL form of vpopcntq, for rows
+ *        shorter than one 512-bit register.
+*/
+struct PopcountBits256
+{
+    using reg = __m256i;
+    static constexpr size_t width = 4;
+
+    static reg load(const uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+    static reg bit_xor(reg a, reg b) { return _mm256_xor_si256(a, b); }
+    static reg bit_and(reg a, reg b) { return _mm256_and_si256(a, b); }
+    static reg bit_or(reg a, reg b) { return _mm256_or_si256(a, b); }
+    static reg popcount(reg v) { return _mm256_popcnt_epi64(v); }
+
+    static uint64_t reduce_add(reg v)
+    {
+        const __m128i pairs = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_add_epi64(pairs, _mm_unpackhi_epi64(pairs, pairs))));
+    }
+};
+
+} // namespace
+
+void set_vpopcntdq_kernels(BitKernels& kernels)
+{
+    set_bit_kernels<PopcountBits512, PopcountBits256>(kernels);
+}
+
+} // simd
+} // vctr
+} // arondina
@@ -0,0 +1,1159 @@
+#ifndef INCLUDED_ARONDINA_VCTR_SIMD_KERNELS
+#define INCLUDED_ARONDINA_VCTR_SIMD_KERNELS
+
+// Internal to the vctr library: the dispatch table shared by simd.cpp and the
+// per-instruction-set translation units, plus the kernel templates those units
+// instantiate with their own register types.
+
+// vctr
+#include "simd.h"
+
+// std
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace arondina
+{
+namespace vctr
+{
+namespace simd
+{
+
+template<typename T>
+using BinaryKernel = void (*)(const T*, const T*, T*, size_t);
+
+template<typename T>
+using ScaleKernel = void (*)(T*, double, size_t);
+
+/**
+ * @brief Register-tiled GEMM micro-kernel. Computes the mr x nr tile
+ *        c = alpha * a * b + beta * c, where a is an mr-tall sliver and b an nr-wide
+ *        sliver of packed panels, both kc deep. c is row-major with row stride ldc.
+ *        When beta is zero c is only written, never read.
+*/
+template<typename T>
+using GemmMicroKernel = void (*)(size_t kc, const T* a, const T* b, T* c, size_t ldc, T alpha, T beta);
+
+/**
+ * @brief out[r] = dot(rows + r * ld, x) over n elements, for r in [0, num_rows).
+*/
+template<typename T>
+using DotRowsKernel = void (*)(const T* rows, size_t ld, size_t num_rows, const T* x, size_t n, T* out);
+
+/**
+ * @brief y += sum over r of alphas[r] * (rows + r * ld), over n elements.
+*/
+template<typename T>
+using AxpyRowsKernel = void (*)(const T* rows, size_t ld, size_t num_rows, const T* alphas, size_t n, T* y);
+
+/**
+ * @brief Reduces a and b over n elements to a single value.
+*/
+template<typename T>
+using DotKernel = T (*)(const T* a, const T* b, size_t n);
+
+/**
+ * @brief Compensated reduction of a and b over n elements, see simd::dot_compensated.
+*/
+template<typename T>
+using CompensatedDotKernel = Compensated<T> (*)(const T* a, const T* b, size_t n);
+
+/**
+ * @brief Reduces a and b over n elements of T to a sum of products in the wider Acc.
+*/
+template<typename T, typename Acc>
+using WideningDotKernel = Acc (*)(const T* a, const T* b, size_t n);
+
+/**
+ * @brief The squares of x over n elements in the three scaled accumulators, see
+ *        simd::scaled_squares.
+*/
+template<typename T>
+using ScaledSquaresKernel = ScaledSquares<T> (*)(const T* x, size_t n);
+
+/**
+ * @brief The CosineSums of a and b over n elements, see simd::cosine_sums.
+*/
+template<typename T>
+using CosineSumsKernel = CosineSums<T> (*)(const T* a, const T* b, size_t n);
+
+/**
+ * @brief Sums of 4-bit code lookups, see simd::pq4_scan.
+*/
+using Pq4ScanKernel = void (*)(const uint8_t* codes, size_t num_blocks, size_t num_subquantizers, const uint8_t* luts, uint16_t* out);
+
+using HammingKernel = uint64_t (*)(const uint64_t* a, const uint64_t* b, size_t n);
+using BitCountsKernel = BitCounts (*)(const uint64_t* a, const uint64_t* b, size_t n);
+using HammingRowsKernel = void (*)(const uint64_t* rows, size_t ld, size_t num_rows, const uint64_t* x, size_t n, uint32_t* out);
+
+/**
+ * @brief The kernels over bit strings packed in 64-bit words.
+*/
+struct BitKernels
+{
+    HammingKernel hamming;
+    BitCountsKernel counts;
+    HammingRowsKernel hamming_rows;
+};
+
+template<typename T>
+struct GemmKernel
+{
+    GemmMicroKernel<T> kernel;
+    size_t mr;
+    size_t nr;
+};
+
+/**
+ * @brief The kernels available for one element type.
+*/
+template<typename T>
+struct ElementKernels
+{
+    BinaryKernel<T> add;
+    BinaryKernel<T> subtract;
+    ScaleKernel<T> scale;
+    GemmKernel<T> gemm;
+    DotRowsKernel<T> dot_rows;
+    AxpyRowsKernel<T> axpy_rows;
+    DotKernel<T> dot_reproducible;
+    CompensatedDotKernel<T> dot_compensated;
+    DotKernel<T> sum_abs_difference;
+    DotKernel<T> sum_squared_difference;
+    DotKernel<T> max_abs_difference;
+    CosineSumsKernel<T> cosine_sums;
+};
+
+/**
+ * @brief The kernels that read one element type and accumulate in a wider one, see
+ *        simd::dot_accumulate.
+*/
+struct WideningKernels
+{
+    WideningDotKernel<float, double> f32_f64;
+    WideningDotKernel<int8_t, int32_t> i8_i32;
+    WideningDotKernel<int32_t, int64_t> i32_i64;
+    WideningDotKernel<Float16, float> f16_f32;
+    WideningDotKernel<BFloat16, float> bf16_f32;
+    WideningDotKernel<int8_t, int32_t> i8_i32_symmetric;
+    WideningDotKernel<Float16, float> f16_f32_squared_difference;
+    WideningDotKernel<BFloat16, float> bf16_f32_squared_difference;
+};
+
+/**
+ * @brief One complete set of kernels. Every entry is always populated: a table for a
+ *        wider instruction set starts as a copy of the narrower one and only replaces
+ *        the kernels it improves on.
+*/
+struct KernelTable
+{
+    ElementKernels<float> f32;
+    ElementKernels<double> f64;
+    ElementKernels<int32_t> i32;
+    ElementKernels<int64_t> i64;
+    WideningKernels widening;
+    ScaledSquaresKernel<double> f64_scaled_squares;
+    Pq4ScanKernel pq4_scan;
+    BitKernels bits;
+};
+
+/**
+ * @brief Selects the ElementKernels for T out of a table.
+*/
+template<typename T>
+const ElementKernels<T>& element_kernels(const KernelTable& table)
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        return table.f32;
+    }
+    else if constexpr (std::is_same_v<T, double>)
+    {
+        return table.f64;
+    }
+    else if constexpr (std::is_same_v<T, int32_t>)
+    {
+        return table.i32;
+    }
+    else
+    {
+        static_assert(std::is_same_v<T, int64_t>, "no kernels for this element type.");
+        return table.i64;
+    }
+}
+
+/**
+ * @brief The table selected by set_instruction_set(), or the detected one.
+*/
+const KernelTable& active_kernels();
+
+const KernelTable& scalar_kernels();
+
+#if defined(VCTR_SIMD_X86)
+const KernelTable& sse2_kernels();
+const KernelTable& avx2_kernels();
+const KernelTable& avx512_kernels();
+
+/**
+ * @brief Replaces the bit kernels with the VPOPCNTDQ ones. Those live in their own
+ *        translation unit, since an AVX-512 CPU need not have the extension.
+*/
+void set_vpopcntdq_kernels(BitKernels& kernels);
+#endif
+
+// The templates below are instantiated once per instruction set. They live in an
+// unnamed namespace so that no copy compiled for a wide instruction set can be
+// picked by the linker for a caller running on a narrower CPU.
+namespace
+{
+
+/**
+ * @brief Element-wise kernels over a register type P. P provides value_type, width,
+ *        load, store and the arithmetic used by each kernel.
+*/
+template<typename P>
+void add_kernel(const typename P::value_type* a, const typename P::value_type* b, typename P::value_type* out, size_t n)
+{
+    size_t i = 0;
+    for(; i + P::width <= n; i += P::width)
+    {
+        P::store(out + i, P::add(P::load(a + i), P::load(b + i)));
+    }
+    for(; i < n; ++i)
+    {
+        out[i] = a[i] + b[i];
+    }
+}
+
+template<typename P>
+void subtract_kernel(const typename P::value_type* a, const typename P::value_type* b, typename P::value_type* out, size_t n)
+{
+    size_t i = 0;
+    for(; i + P::width <= n; i += P::width)
+    {
+        P::store(out + i, P::subtract(P::load(a + i), P::load(b + i)));
+    }
+    for(; i < n; ++i)
+    {
+        out[i] = a[i] - b[i];
+    }
+}
+
+template<typename P>
+void scale_kernel(typename P::value_type* data, double scalar, size_t n)
+{
+    size_t i = 0;
+    for(; i + P::width <= n; i += P::width)
+    {
+        P::store(data + i, P::scale(P::load(data + i), scalar));
+    }
+    for(; i < n; ++i)
+    {
+        data[i] *= scalar;
+    }
+}
+
+/**
+ * @brief Fills the element-wise entries of kernels from the register type P.
+*/
+template<typename P, typename T>
+void set_elementwise_kernels(ElementKernels<T>& kernels)
+{
+    kernels.add = &add_kernel<P>;
+    kernels.subtract = &subtract_kernel<P>;
+    kernels.scale = &scale_kernel<P>;
+}
+
+/**
+ * @brief GEMM micro-kernel over a register type P, MR rows by NR_REGS registers.
+ *        P additionally provides zero, broadcast, multiply and multiply_add(a, b, c)
+ *        returning a * b + c. The accumulators are a fixed-size array the compiler
+ *        keeps entirely in registers.
+*/
+template<typename P, size_t MR, size_t NR_REGS>
+void gemm_micro_kernel(
+    size_t kc
+    , const typename P::value_type* a
+    , const typename P::value_type* b
+    , typename P::value_type* c
+    , size_t ldc
+    , typename P::value_type alpha
+    , typename P::value_type beta)
+{
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+    constexpr size_t NR = NR_REGS * W;
+
+    reg acc[MR][NR_REGS];
+    for(size_t r = 0; r < MR; ++r)
+    {
+        for(size_t j = 0; j < NR_REGS; ++j)
+        {
+            acc[r][j] = P::zero();
+        }
+    }
+
+    for(size_t p = 0; p < kc; ++p, a += MR, b += NR)
+    {
+        reg bv[NR_REGS];
+        for(size_t j = 0; j < NR_REGS; ++j)
+        {
+            bv[j] = P::load(b + j * W);
+        }
+        for(size_t r = 0; r < MR; ++r)
+        {
+            const reg av = P::broadcast(a[r]);
+            for(size_t j = 0; j < NR_REGS; ++j)
+            {
+                acc[r][j] = P::multiply_add(av, bv[j], acc[r][j]);
+            }
+        }
+    }
+
+    const reg alpha_v = P::broadcast(alpha);
+    if(beta == typename P::value_type(0))
+    {
+        for(size_t r = 0; r < MR; ++r)
+        {
+            for(size_t j = 0; j < NR_REGS; ++j)
+            {
+                P::store(c + r * ldc + j * W, P::multiply(alpha_v, acc[r][j]));
+            }
+        }
+    }
+    else
+    {
+        const reg beta_v = P::broadcast(beta);
+        for(size_t r = 0; r < MR; ++r)
+        {
+            for(size_t j = 0; j < NR_REGS; ++j)
+            {
+                typename P::value_type* tile = c + r * ldc + j * W;
+                P::store(tile, P::multiply_add(beta_v, P::load(tile), P::multiply(alpha_v, acc[r][j])));
+            }
+        }
+    }
+}
+
+template<typename P, size_t MR, size_t NR_REGS, typename T>
+void set_gemm_kernel(ElementKernels<T>& kernels)
+{
+    kernels.gemm = GemmKernel<T>{&gemm_micro_kernel<P, MR, NR_REGS>, MR, NR_REGS * P::width};
+}
+
+/**
+ * @brief Dot products of R rows against one x. Each x register is loaded once and
+ *        used for all R rows; U independent accumulators per row hide FMA latency.
+ *        P additionally provides reduce_add, the horizontal sum of a register.
+*/
+template<typename P, size_t R, size_t U>
+void dot_rows_block(const typename P::value_type* rows, size_t ld, const typename P::value_type* x, size_t n, typename P::value_type* out)
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+
+    reg acc[R][U];
+    for(size_t r = 0; r < R; ++r)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            acc[r][u] = P::zero();
+        }
+    }
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            const reg xv = P::load(x + i + u * W);
+            for(size_t r = 0; r < R; ++r)
+            {
+                acc[r][u] = P::multiply_add(P::load(rows + r * ld + i + u * W), xv, acc[r][u]);
+            }
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        const reg xv = P::load(x + i);
+        for(size_t r = 0; r < R; ++r)
+        {
+            acc[r][0] = P::multiply_add(P::load(rows + r * ld + i), xv, acc[r][0]);
+        }
+    }
+
+    for(size_t r = 0; r < R; ++r)
+    {
+        reg total = acc[r][0];
+        for(size_t u = 1; u < U; ++u)
+        {
+            total = P::add(total, acc[r][u]);
+        }
+        T sum = P::reduce_add(total);
+        for(size_t j = i; j < n; ++j)
+        {
+            sum += rows[r * ld + j] * x[j];
+        }
+        out[r] = sum;
+    }
+}
+
+template<typename P>
+void dot_rows_kernel(const typename P::value_type* rows, size_t ld, size_t num_rows, const typename P::value_type* x, size_t n, typename P::value_type* out)
+{
+    size_t r = 0;
+    for(; r + 4 <= num_rows; r += 4)
+    {
+        dot_rows_block<P, 4, 2>(rows + r * ld, ld, x, n, out + r);
+    }
+    for(; r < num_rows; ++r)
+    {
+        dot_rows_block<P, 1, 4>(rows + r * ld, ld, x, n, out + r);
+    }
+}
+
+/**
+ * @brief y += sum of alphas[r] * row r for R rows, loading and storing y once.
+*/
+template<typename P, size_t R>
+void axpy_rows_block(const typename P::value_type* rows, size_t ld, const typename P::value_type* alphas, size_t n, typename P::value_type* y)
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+
+    reg alpha_v[R];
+    for(size_t r = 0; r < R; ++r)
+    {
+        alpha_v[r] = P::broadcast(alphas[r]);
+    }
+
+    size_t i = 0;
+    for(; i + W <= n; i += W)
+    {
+        reg acc = P::load(y + i);
+        for(size_t r = 0; r < R; ++r)
+        {
+            acc = P::multiply_add(alpha_v[r], P::load(rows + r * ld + i), acc);
+        }
+        P::store(y + i, acc);
+    }
+    for(; i < n; ++i)
+    {
+        T value = y[i];
+        for(size_t r = 0; r < R; ++r)
+        {
+            value += alphas[r] * rows[r * ld + i];
+        }
+        y[i] = value;
+    }
+}
+
+template<typename P>
+void axpy_rows_kernel(const typename P::value_type* rows, size_t ld, size_t num_rows, const typename P::value_type* alphas, size_t n, typename P::value_type* y)
+{
+    size_t r = 0;
+    for(; r + 4 <= num_rows; r += 4)
+    {
+        axpy_rows_block<P, 4>(rows + r * ld, ld, alphas + r, n, y);
+    }
+    for(; r < num_rows; ++r)
+    {
+        axpy_rows_block<P, 1>(rows + r * ld, ld, alphas + r, n, y);
+    }
+}
+
+template<typename P, typename T>
+void set_gemv_kernels(ElementKernels<T>& kernels)
+{
+    kernels.dot_rows = &dot_rows_kernel<P>;
+    kernels.axpy_rows = &axpy_rows_kernel<P>;
+}
+
+/**
+ * @brief Dot product with the same rounding on every instruction set. Products are
+ *        spread over one 64-byte line of lanes (lane j takes the elements i with
+ *        i % L == j), accumulated with a separate multiply and add, folded pairwise
+ *        (lane j += lane j + L / 2, ...), and the elements past the last whole line
+ *        are added on in order. A wider register only covers more lanes at once, so
+ *        every table performs exactly the same operations. The units are built with
+ *        -ffp-contract=off so the compiler cannot fuse them either.
+*/
+template<typename P>
+typename P::value_type dot_reproducible_kernel(const typename P::value_type* a, const typename P::value_type* b, size_t n)
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+    constexpr size_t L = 64 / sizeof(T);
+    constexpr size_t R = L / W;
+    static_assert(L % W == 0, "registers must tile a 64-byte line.");
+
+    reg acc[R];
+    for(size_t r = 0; r < R; ++r)
+    {
+        acc[r] = P::zero();
+    }
+
+    size_t i = 0;
+    for(; i + L <= n; i += L)
+    {
+        for(size_t r = 0; r < R; ++r)
+        {
+            acc[r] = P::add(acc[r], P::multiply(P::load(a + i + r * W), P::load(b + i + r * W)));
+        }
+    }
+
+    T lanes[L];
+    for(size_t r = 0; r < R; ++r)
+    {
+        P::store(lanes + r * W, acc[r]);
+    }
+    for(size_t width = L / 2; width > 0; width /= 2)
+    {
+        for(size_t j = 0; j < width; ++j)
+        {
+            lanes[j] += lanes[j + width];
+        }
+    }
+
+    T tail = T();
+    for(; i < n; ++i)
+    {
+        const T product = a[i] * b[i];
+        tail += product;
+    }
+    return lanes[0] + tail;
+}
+
+/**
+ * @brief The exact rounding error of product = a * b. With Fused, P::multiply_add is
+ *        a true FMA and the error is a * b - product in one rounding. Otherwise both
+ *        factors are split into halves whose products are exact (Veltkamp/Dekker),
+ *        which only needs multiply, add and subtract.
+*/
+template<typename P, bool Fused>
+typename P::reg product_error(typename P::reg a, typename P::reg b, typename P::reg product)
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+
+    if constexpr (Fused)
+    {
+        return P::multiply_add(a, b, P::subtract(P::zero(), product));
+    }
+    else
+    {
+        // 2^ceil(digits / 2) + 1
+        const reg factor = P::broadcast(std::is_same_v<T, float> ? T(4097) : T(134217729));
+        auto split = [&factor](reg x, reg& high, reg& low) {
+            const reg c = P::multiply(factor, x);
+            high = P::subtract(c, P::subtract(c, x));
+            low = P::subtract(x, high);
+        };
+
+        reg a_high, a_low, b_high, b_low;
+        split(a, a_high, a_low);
+        split(b, b_high, b_low);
+        reg error = P::subtract(P::multiply(a_high, b_high), product);
+        error = P::add(error, P::multiply(a_high, b_low));
+        error = P::add(error, P::multiply(a_low, b_high));
+        return P::add(error, P::multiply(a_low, b_low));
+    }
+}
+
+/**
+ * @brief Dot2 over a register type P. U independent (sum, error) register pairs hide
+ *        the latency of the TwoSum chain; the lanes are merged with Compensated so
+ *        the final fold stays error-free as well.
+*/
+template<typename P, bool Fused>
+Compensated<typename P::value_type> dot_compensated_kernel(const typename P::value_type* a, const typename P::value_type* b, size_t n)
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+    constexpr size_t U = 2;
+
+    reg sum[U];
+    reg error[U];
+    for(size_t u = 0; u < U; ++u)
+    {
+        sum[u] = P::zero();
+        error[u] = P::zero();
+    }
+
+    auto accumulate = [&sum, &error](size_t u, reg x, reg y) {
+        const reg product = P::multiply(x, y);
+        const reg total = P::add(sum[u], product);
+        const reg z = P::subtract(total, sum[u]);
+        const reg add_error = P::add(P::subtract(sum[u], P::subtract(total, z)), P::subtract(product, z));
+        error[u] = P::add(error[u], P::add(add_error, product_error<P, Fused>(x, y, product)));
+        sum[u] = total;
+    };
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            accumulate(u, P::load(a + i + u * W), P::load(b + i + u * W));
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        accumulate(0, P::load(a + i), P::load(b + i));
+    }
+
+    T sums[U * W];
+    T errors[U * W];
+    for(size_t u = 0; u < U; ++u)
+    {
+        P::store(sums + u * W, sum[u]);
+        P::store(errors + u * W, error[u]);
+    }
+
+    Compensated<T> result;
+    for(size_t j = 0; j < U * W; ++j)
+    {
+        result += Compensated<T>{sums[j], errors[j]};
+    }
+    for(; i < n; ++i)
+    {
+        const T product = a[i] * b[i];
+        result += Compensated<T>{product, std::fma(a[i], b[i], -product)};
+    }
+    return result;
+}
+
+/**
+ * @brief Integer dot products are exact, so the compensated entry is the plain one.
+*/
+template<typename P>
+Compensated<typename P::value_type> exact_dot_kernel(const typename P::value_type* a, const typename P::value_type* b, size_t n)
+{
+    return Compensated<typename P::value_type>{dot_reproducible_kernel<P>(a, b, n), 0};
+}
+
+/**
+ * @brief Fills the reduction entries of kernels from the register type P. Fused says
+ *        whether P::multiply_add is a true FMA.
+*/
+template<typename P, bool Fused = false, typename T>
+void set_reduction_kernels(ElementKernels<T>& kernels)
+{
+    kernels.dot_reproducible = &dot_reproducible_kernel<P>;
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        kernels.dot_compensated = &dot_compensated_kernel<P, Fused>;
+    }
+    else
+    {
+        kernels.dot_compensated = &exact_dot_kernel<P>;
+    }
+}
+
+/**
+ * @brief Dot product accumulated in a wider type over a widening register type P.
+ *        P provides value_type (what is read), accumulator_type, width (elements of
+ *        value_type consumed per step), zero, add, reduce_add and
+ *        multiply_accumulate(acc, a, b), which loads width elements of a and b,
+ *        converts them to accumulator lanes and adds their products to acc.
+*/
+template<typename P>
+typename P::accumulator_type dot_widening_kernel(const typename P::value_type* a, const typename P::value_type* b, size_t n)
+{
+    using Acc = typename P::accumulator_type;
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+    constexpr size_t U = 4;
+
+    reg acc[U];
+    for(size_t u = 0; u < U; ++u)
+    {
+        acc[u] = P::zero();
+    }
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            acc[u] = P::multiply_accumulate(acc[u], a + i + u * W, b + i + u * W);
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        acc[0] = P::multiply_accumulate(acc[0], a + i, b + i);
+    }
+
+    reg total = acc[0];
+    for(size_t u = 1; u < U; ++u)
+    {
+        total = P::add(total, acc[u]);
+    }
+    Acc sum = P::reduce_add(total);
+    for(; i < n; ++i)
+    {
+        sum += static_cast<Acc>(a[i]) * static_cast<Acc>(b[i]);
+    }
+    return sum;
+}
+
+template<typename P>
+void set_widening_kernel(WideningDotKernel<typename P::value_type, typename P::accumulator_type>& kernel)
+{
+    kernel = &dot_widening_kernel<P>;
+}
+
+/**
+ * @brief Sum of squared differences accumulated in a wider type over a widening
+ *        register type P. On top of what dot_widening_kernel needs, P provides
+ *        squared_difference_accumulate(acc, a, b), which adds the squares of the
+ *        converted lanes' differences to acc.
+*/
+template<typename P>
+typename P::accumulator_type squared_difference_widening_kernel(const typename P::value_type* a, const typename P::value_type* b, size_t n)
+{
+    using Acc = typename P::accumulator_type;
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+    constexpr size_t U = 4;
+
+    reg acc[U];
+    for(size_t u = 0; u < U; ++u)
+    {
+        acc[u] = P::zero();
+    }
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            acc[u] = P::squared_difference_accumulate(acc[u], a + i + u * W, b + i + u * W);
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        acc[0] = P::squared_difference_accumulate(acc[0], a + i, b + i);
+    }
+
+    reg total = acc[0];
+    for(size_t u = 1; u < U; ++u)
+    {
+        total = P::add(total, acc[u]);
+    }
+    Acc sum = P::reduce_add(total);
+    for(; i < n; ++i)
+    {
+        const Acc difference = static_cast<Acc>(a[i]) - static_cast<Acc>(b[i]);
+        sum += difference * difference;
+    }
+    return sum;
+}
+
+template<typename P>
+void set_squared_difference_widening_kernel(WideningDotKernel<typename P::value_type, typename P::accumulator_type>& kernel)
+{
+    kernel = &squared_difference_widening_kernel<P>;
+}
+
+/**
+ * @brief Hamming distance over a bit register type P. P provides reg, width (64-bit
+ *        words per register), load, zero, add, bit_xor, bit_and, bit_or,
+ *        popcount (the set bits of each lane, in lanes add and reduce_add sum) and
+ *        reduce_add. Leftover words go through the scalar popcount.
+*/
+template<typename P>
+uint64_t hamming_kernel(const uint64_t* a, const uint64_t* b, size_t n)
+{
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+    constexpr size_t U = 4;
+
+    reg acc[U];
+    for(size_t u = 0; u < U; ++u)
+    {
+        acc[u] = P::zero();
+    }
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            acc[u] = P::add(acc[u], P::popcount(P::bit_xor(P::load(a + i + u * W), P::load(b + i + u * W))));
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        acc[0] = P::add(acc[0], P::popcount(P::bit_xor(P::load(a + i), P::load(b + i))));
+    }
+
+    reg total = acc[0];
+    for(size_t u = 1; u < U; ++u)
+    {
+        total = P::add(total, acc[u]);
+    }
+    uint64_t sum = P::reduce_add(total);
+    for(; i < n; ++i)
+    {
+        sum += popcount(a[i] ^ b[i]);
+    }
+    return sum;
+}
+
+/**
+ * @brief BitCounts over a bit register type P, see hamming_kernel.
+*/
+template<typename P>
+BitCounts bit_counts_kernel(const uint64_t* a, const uint64_t* b, size_t n)
+{
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+    constexpr size_t U = 2;
+
+    reg both[U];
+    reg either[U];
+    for(size_t u = 0; u < U; ++u)
+    {
+        both[u] = P::zero();
+        either[u] = P::zero();
+    }
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            const reg x = P::load(a + i + u * W);
+            const reg y = P::load(b + i + u * W);
+            both[u] = P::add(both[u], P::popcount(P::bit_and(x, y)));
+            either[u] = P::add(either[u], P::popcount(P::bit_or(x, y)));
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        const reg x = P::load(a + i);
+        const reg y = P::load(b + i);
+        both[0] = P::add(both[0], P::popcount(P::bit_and(x, y)));
+        either[0] = P::add(either[0], P::popcount(P::bit_or(x, y)));
+    }
+
+    BitCounts counts;
+    counts.both = P::reduce_add(P::add(both[0], both[1]));
+    counts.either = P::reduce_add(P::add(either[0], either[1]));
+    for(; i < n; ++i)
+    {
+        counts.both += popcount(a[i] & b[i]);
+        counts.either += popcount(a[i] | b[i]);
+    }
+    return counts;
+}
+
+/**
+ * @brief hamming_kernel for every row, on two accumulators per row: signatures are
+ *        usually a few registers long, too short for hamming_kernel's four to pay
+ *        for their reduction.
+*/
+template<typename P>
+void hamming_rows_loop(const uint64_t* rows, size_t ld, size_t num_rows, const uint64_t* x, size_t n, uint32_t* out)
+{
+    constexpr size_t W = P::width;
+    for(size_t r = 0; r < num_rows; ++r)
+    {
+        const uint64_t* row = rows + r * ld;
+        typename P::reg even = P::zero();
+        typename P::reg odd = P::zero();
+        size_t i = 0;
+        for(; i + 2 * W <= n; i += 2 * W)
+        {
+            even = P::add(even, P::popcount(P::bit_xor(P::load(row + i), P::load(x + i))));
+            odd = P::add(odd, P::popcount(P::bit_xor(P::load(row + i + W), P::load(x + i + W))));
+        }
+        if(i + W <= n)
+        {
+            even = P::add(even, P::popcount(P::bit_xor(P::load(row + i), P::load(x + i))));
+            i += W;
+        }
+        uint64_t sum = P::reduce_add(P::add(even, odd));
+        for(; i < n; ++i)
+        {
+            sum += popcount(row[i] ^ x[i]);
+        }
+        out[r] = static_cast<uint32_t>(sum);
+    }
+}
+
+/**
+ * @brief hamming_rows_loop over P, or over the narrower register type Narrow when
+ *        the rows are shorter than one P register, so that a 256-bit signature is
+ *        not left entirely to the scalar tail of a 512-bit loop.
+*/
+template<typename P, typename Narrow>
+void hamming_rows_kernel(const uint64_t* rows, size_t ld, size_t num_rows, const uint64_t* x, size_t n, uint32_t* out)
+{
+    if(n < P::width)
+    {
+        hamming_rows_loop<Narrow>(rows, ld, num_rows, x, n, out);
+        return;
+    }
+    hamming_rows_loop<P>(rows, ld, num_rows, x, n, out);
+}
+
+template<typename P, typename Narrow = P>
+void set_bit_kernels(BitKernels& kernels)
+{
+    kernels.hamming = &hamming_kernel<P>;
+    kernels.counts = &bit_counts_kernel<P>;
+    kernels.hamming_rows = &hamming_rows_kernel<P, Narrow>;
+}
+
+/**
+ * @brief Blue's sum of squares over a register type P, one pass, no division, with
+ *        U independent sets of accumulators to hide FMA latency. P
+ *        additionally provides abs, keep_less(a, b, v) and keep_greater(a, b, v)
+ *        (v where a < b, resp. a > b, zero elsewhere), keep_between(a, low, high, v)
+ *        (v unless a < low or a > high, so NaN lanes are kept) and any_outside(a,
+ *        low, high) (some lane has 0 < a < low or a > high). Registers without such
+ *        a lane, nearly all of them in practice, skip the three-way split.
+*/
+template<typename P>
+ScaledSquares<typename P::value_type> scaled_squares_kernel(const typename P::value_type* x, size_t n)
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+    using Squares = ScaledSquares<T>;
+    constexpr size_t W = P::width;
+    constexpr size_t U = 4;
+
+    const reg small_threshold = P::broadcast(Squares::small_threshold);
+    const reg big_threshold = P::broadcast(Squares::big_threshold);
+    const reg small_scale = P::broadcast(Squares::small_scale);
+    const reg big_scale = P::broadcast(Squares::big_scale);
+
+    reg small[U], medium[U], big[U];
+    for(size_t u = 0; u < U; ++u)
+    {
+        small[u] = P::zero();
+        medium[u] = P::zero();
+        big[u] = P::zero();
+    }
+
+    auto accumulate = [&](size_t u, reg value) {
+        const reg magnitude = P::abs(value);
+        if(!P::any_outside(magnitude, small_threshold, big_threshold))
+        {
+            medium[u] = P::multiply_add(magnitude, magnitude, medium[u]);
+            return;
+        }
+        const reg s = P::multiply(P::keep_less(magnitude, small_threshold, magnitude), small_scale);
+        const reg m = P::keep_between(magnitude, small_threshold, big_threshold, magnitude);
+        const reg b = P::multiply(P::keep_greater(magnitude, big_threshold, magnitude), big_scale);
+        small[u] = P::multiply_add(s, s, small[u]);
+        medium[u] = P::multiply_add(m, m, medium[u]);
+        big[u] = P::multiply_add(b, b, big[u]);
+    };
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            accumulate(u, P::load(x + i + u * W));
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        accumulate(0, P::load(x + i));
+    }
+
+    T smalls[U * W], mediums[U * W], bigs[U * W];
+    for(size_t u = 0; u < U; ++u)
+    {
+        P::store(smalls + u * W, small[u]);
+        P::store(mediums + u * W, medium[u]);
+        P::store(bigs + u * W, big[u]);
+    }
+
+    Squares result;
+    for(size_t j = 0; j < U * W; ++j)
+    {
+        result += Squares{smalls[j], mediums[j], bigs[j]};
+    }
+    for(; i < n; ++i)
+    {
+        result.add(x[i]);
+    }
+    return result;
+}
+
+/**
+ * @brief The per-register steps of the difference reductions, over a register type P
+ *        that additionally provides abs, max(a, b) and reduce_max, the horizontal
+ *        maximum of a register. step folds one register of differences into an
+ *        accumulator, combine merges two accumulators, reduce folds the lanes and
+ *        scalar handles one leftover element.
+*/
+template<typename P>
+struct AbsDifferenceSum
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+
+    static reg step(reg acc, reg difference) { return P::add(acc, P::abs(difference)); }
+    static reg combine(reg a, reg b) { return P::add(a, b); }
+    static T reduce(reg v) { return P::reduce_add(v); }
+    static T scalar(T acc, T difference) { return acc + (difference < T(0) ? -difference : difference); }
+};
+
+template<typename P>
+struct SquaredDifferenceSum
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+
+    static reg step(reg acc, reg difference) { return P::multiply_add(difference, difference, acc); }
+    static reg combine(reg a, reg b) { return P::add(a, b); }
+    static T reduce(reg v) { return P::reduce_add(v); }
+    static T scalar(T acc, T difference) { return acc + difference * difference; }
+};
+
+template<typename P>
+struct MaxAbsDifference
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+
+    static reg step(reg acc, reg difference) { return P::max(acc, P::abs(difference)); }
+    static reg combine(reg a, reg b) { return P::max(a, b); }
+    static T reduce(reg v) { return P::reduce_max(v); }
+
+    static T scalar(T acc, T difference)
+    {
+        const T magnitude = difference < T(0) ? -difference : difference;
+        return magnitude > acc ? magnitude : acc;
+    }
+};
+
+/**
+ * @brief Reduces a - b over n elements with one of the Metric steps above, U
+ *        independent accumulators hiding the latency of each step. Every metric
+ *        starts from zero, which is also the identity of the maximum of absolute
+ *        values.
+*/
+template<typename P, template<typename> class Metric>
+typename P::value_type difference_kernel(const typename P::value_type* a, const typename P::value_type* b, size_t n)
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+    using M = Metric<P>;
+    constexpr size_t W = P::width;
+    constexpr size_t U = 4;
+
+    reg acc[U];
+    for(size_t u = 0; u < U; ++u)
+    {
+        acc[u] = P::zero();
+    }
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            acc[u] = M::step(acc[u], P::subtract(P::load(a + i + u * W), P::load(b + i + u * W)));
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        acc[0] = M::step(acc[0], P::subtract(P::load(a + i), P::load(b + i)));
+    }
+
+    reg total = acc[0];
+    for(size_t u = 1; u < U; ++u)
+    {
+        total = M::combine(total, acc[u]);
+    }
+    T result = M::reduce(total);
+    for(; i < n; ++i)
+    {
+        result = M::scalar(result, a[i] - b[i]);
+    }
+    return result;
+}
+
+/**
+ * @brief a . b, a . a and b . b in one pass over a register type P, with U sets of
+ *        three accumulators.
+*/
+template<typename P>
+CosineSums<typename P::value_type> cosine_sums_kernel(const typename P::value_type* a, const typename P::value_type* b, size_t n)
+{
+    using T = typename P::value_type;
+    using reg = typename P::reg;
+    constexpr size_t W = P::width;
+    constexpr size_t U = 2;
+
+    reg dot[U], squares_a[U], squares_b[U];
+    for(size_t u = 0; u < U; ++u)
+    {
+        dot[u] = P::zero();
+        squares_a[u] = P::zero();
+        squares_b[u] = P::zero();
+    }
+
+    auto accumulate = [&](size_t u, reg x, reg y) {
+        dot[u] = P::multiply_add(x, y, dot[u]);
+        squares_a[u] = P::multiply_add(x, x, squares_a[u]);
+        squares_b[u] = P::multiply_add(y, y, squares_b[u]);
+    };
+
+    size_t i = 0;
+    for(; i + U * W <= n; i += U * W)
+    {
+        for(size_t u = 0; u < U; ++u)
+        {
+            accumulate(u, P::load(a + i + u * W), P::load(b + i + u * W));
+        }
+    }
+    for(; i + W <= n; i += W)
+    {
+        accumulate(0, P::load(a + i), P::load(b + i));
+    }
+
+    CosineSums<T> result;
+    for(size_t u = 0; u < U; ++u)
+    {
+        result += CosineSums<T>{P::reduce_add(dot[u]), P::reduce_add(squares_a[u]), P::reduce_add(squares_b[u])};
+    }
+    for(; i < n; ++i)
+    {
+        result += CosineSums<T>{a[i] * b[i], a[i] * a[i], b[i] * b[i]};
+    }
+    return result;
+}
+
+/**
+ * @brief Fills the distance entries of kernels from the register type P.
+*/
+template<typename P, typename T>
+void set_distance_kernels(ElementKernels<T>& kernels)
+{
+    kernels.sum_abs_difference = &difference_kernel<P, AbsDifferenceSum>;
+    kernels.sum_squared_difference = &difference_kernel<P, SquaredDifferenceSum>;
+    kernels.max_abs_difference = &difference_kernel<P, MaxAbsDifference>;
+    kernels.cosine_sums = &cosine_sums_kernel<P>;
+}
+
+} // namespace
+
+} // simd
+} // vctr
+} // arondina
+
+#endif
@@ -0,0 +1,266 @@
+// Compiled with -msse2. Only reached through the dispatch table in simd.cpp.
+
+// vctr
+#include "simd_kernels.h"
+
+// std
+#include <emmintrin.h>
+
+namespace arondina
+{
+namespace vctr
+{
+namespace simd
+{
+
+namespace
+{
+
+struct Float32x4
+{
+    using value_type = float;
+    using reg = __m128;
+    static constexpr size_t width = 4;
+
+    static reg load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg subtract(reg a, reg b) { return _mm_sub_ps(a, b); }
+
+    static reg scale(reg v, double scalar)
+    {
+        const __m128d s = _mm_set1_pd(scalar);
+        const __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(v), s));
+        const __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), s));
+        return _mm_movelh_ps(lo, hi);
+    }
+
+    static reg zero() { return _mm_setzero_ps(); }
+    static reg broadcast(float value) { return _mm_set1_ps(value); }
+    static reg multiply(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+    static float reduce_add(reg v)
+    {
+        const __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+
+    static reg abs(reg v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+    static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+
+    static float reduce_max(reg v)
+    {
+        const __m128 pairs = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+struct Float64x2
+{
+    using value_type = double;
+    using reg = __m128d;
+    static constexpr size_t width = 2;
+
+    static reg load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm_storeu_pd(p, v); }
+    static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+    static reg subtract(reg a, reg b) { return _mm_sub_pd(a, b); }
+    static reg scale(reg v, double scalar) { return _mm_mul_pd(v, _mm_set1_pd(scalar)); }
+
+    static reg zero() { return _mm_setzero_pd(); }
+    static reg broadcast(double value) { return _mm_set1_pd(value); }
+    static reg multiply(reg a, reg b) { return _mm_mul_pd(a, b); }
+    static reg multiply_add(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+
+    static double reduce_add(reg v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+
+    static reg abs(reg v) { return _mm_andnot_pd(_mm_set1_pd(-0.0), v); }
+    static reg keep_less(reg a, reg b, reg v) { return _mm_and_pd(_mm_cmplt_pd(a, b), v); }
+    static reg keep_greater(reg a, reg b, reg v) { return _mm_and_pd(_mm_cmpgt_pd(a, b), v); }
+    static reg keep_between(reg a, reg low, reg high, reg v) { return _mm_andnot_pd(_mm_or_pd(_mm_cmplt_pd(a, low), _mm_cmpgt_pd(a, high)), v); }
+
+    static bool any_outside(reg a, reg low, reg high)
+    {
+        const __m128d tiny = _mm_and_pd(_mm_cmpgt_pd(a, _mm_setzero_pd()), _mm_cmplt_pd(a, low));
+        return _mm_movemask_pd(_mm_or_pd(tiny, _mm_cmpgt_pd(a, high))) != 0;
+    }
+
+    static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+    static double reduce_max(reg v) { return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v))); }
+};
+
+struct Int32x4
+{
+    using value_type = int32_t;
+    using reg = __m128i;
+    static constexpr size_t width = 4;
+
+    static reg load(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(int32_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static reg add(reg a, reg b) { return _mm_add_epi32(a, b); }
+    static reg subtract(reg a, reg b) { return _mm_sub_epi32(a, b); }
+
+    static reg scale(reg v, double scalar)
+    {
+        const __m128d s = _mm_set1_pd(scalar);
+        const __m128i lo = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(v), s));
+        const __m128i hi = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(v, v)), s));
+        return _mm_unpacklo_epi64(lo, hi);
+    }
+};
+
+struct Int64x2
+{
+    using value_type = int64_t;
+    using reg = __m128i;
+    static constexpr size_t width = 2;
+
+    static reg load(const int64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(int64_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static reg add(reg a, reg b) { return _mm_add_epi64(a, b); }
+    static reg subtract(reg a, reg b) { return _mm_sub_epi64(a, b); }
+};
+
+/**
+ * @brief Two floats per step, converted and accumulated in double lanes.
+*/
+struct WidenFloat32x2
+{
+    using value_type = float;
+    using accumulator_type = double;
+    using reg = __m128d;
+    static constexpr size_t width = 2;
+
+    static reg zero() { return _mm_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+
+    static reg multiply_accumulate(reg acc, const float* a, const float* b)
+    {
+        const __m128d x = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a))));
+        const __m128d y = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b))));
+        return _mm_add_pd(acc, _mm_mul_pd(x, y));
+    }
+
+    static double reduce_add(reg v) { return Float64x2::reduce_add(v); }
+};
+
+/**
+ * @brief Sixteen int8 per step, sign-extended to int16 and multiplied pairwise into
+ *        int32 lanes. SSE2 has no sign-extending load, so each byte is duplicated
+ *        into an int16 and shifted back down arithmetically.
+*/
+struct WidenInt8x16
+{
+    using value_type = int8_t;
+    using accumulator_type = int32_t;
+    using reg = __m128i;
+    static constexpr size_t width = 16;
+
+    static reg zero() { return _mm_setzero_si128(); }
+    static reg add(reg a, reg b) { return _mm_add_epi32(a, b); }
+
+    static reg multiply_accumulate(reg acc, const int8_t* a, const int8_t* b)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        const __m128i low = _mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8), _mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8));
+        const __m128i high = _mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8), _mm_srai_epi16(_mm_unpackhi_epi8(y, y), 8));
+        return _mm_add_epi32(acc, _mm_add_epi32(low, high));
+    }
+
+    static int32_t reduce_add(reg v)
+    {
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xB1));
+        return _mm_cvtsi128_si32(v);
+    }
+};
+
+/**
+ * @brief Four bfloat16 per step. A bfloat16 is the upper half of a float, so
+ *        interleaving zeros below each one widens it exactly.
+*/
+struct WidenBFloat16x4
+{
+    using value_type = BFloat16;
+    using accumulator_type = float;
+    using reg = __m128;
+    static constexpr size_t width = 4;
+
+    static reg load(const BFloat16* p)
+    {
+        const __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), x));
+    }
+
+    static reg zero() { return _mm_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+
+    static reg multiply_accumulate(reg acc, const BFloat16* a, const BFloat16* b)
+    {
+        return _mm_add_ps(acc, _mm_mul_ps(load(a), load(b)));
+    }
+
+    static reg squared_difference_accumulate(reg acc, const BFloat16* a, const BFloat16* b)
+    {
+        const __m128 difference = _mm_sub_ps(load(a), load(b));
+        return _mm_add_ps(acc, _mm_mul_ps(difference, difference));
+    }
+
+    static float reduce_add(reg v) { return Float32x4::reduce_add(v); }
+};
+
+KernelTable make_table()
+{
+    KernelTable table = scalar_kernels();
+
+    set_elementwise_kernels<Float32x4>(table.f32);
+    set_elementwise_kernels<Float64x2>(table.f64);
+    set_elementwise_kernels<Int32x4>(table.i32);
+
+    set_gemm_kernel<Float32x4, 6, 2>(table.f32);
+    set_gemm_kernel<Float64x2, 6, 2>(table.f64);
+
+    set_gemv_kernels<Float32x4>(table.f32);
+    set_gemv_kernels<Float64x2>(table.f64);
+
+    set_reduction_kernels<Float32x4>(table.f32);
+    set_reduction_kernels<Float64x2>(table.f64);
+
+    // abs and max of packed int32 need SSSE3 and SSE4.1, so int32 distances stay scalar.
+    set_distance_kernels<Float32x4>(table.f32);
+    set_distance_kernels<Float64x2>(table.f64);
+
+    // int32 -> int64 needs the signed 32 x 32 -> 64 multiply from SSE4.1, so it stays scalar.
+    set_widening_kernel<WidenFloat32x2>(table.widening.f32_f64);
+    set_widening_kernel<WidenInt8x16>(table.widening.i8_i32);
+    table.widening.i8_i32_symmetric = table.widening.i8_i32;
+
+    // Float16 needs the F16C conversions, so it stays scalar.
+    set_widening_kernel<WidenBFloat16x4>(table.widening.bf16_f32);
+    set_squared_difference_widening_kernel<WidenBFloat16x4>(table.widening.bf16_f32_squared_difference);
+
+    table.f64_scaled_squares = &scaled_squares_kernel<Float64x2>;
+
+    // the byte shuffle pq4_scan looks codes up with is SSSE3, so it stays scalar.
+    // So does the nibble lookup of the bit kernels.
+
+    // SSE2 has no packed int64 <-> double conversion, so scale stays scalar.
+    table.i64.add = &add_kernel<Int64x2>;
+    table.i64.subtract = &subtract_kernel<Int64x2>;
+
+    return table;
+}
+
+} // namespace
+
+const KernelTable& sse2_kernels()
+{
+    static const KernelTable table = make_table();
+    return table;
+}
+
+} // simd
+} // vctr
+} // arondina
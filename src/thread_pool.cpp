@@ -0,0 +1,316 @@
+#include "thread_pool.h"
+
+// vctr
+
+// std
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+/**
+ * @brief Set on pool workers and on a thread while it is inside run(), so nested
+ *        parallel loops run inline.
+*/
+thread_local bool t_inside_pool = false;
+
+constexpr uint64_t pack(uint64_t begin, uint64_t end)
+{
+    return (begin << 32) | end;
+}
+
+constexpr uint64_t begin_of(uint64_t range)
+{
+    return range >> 32;
+}
+
+constexpr uint64_t end_of(uint64_t range)
+{
+    return range & 0xFFFFFFFFu;
+}
+
+size_t resolve_size(size_t threads)
+{
+    if(threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    return std::max<size_t>(1, threads);
+}
+
+void pin_to_cpu(std::thread& thread, size_t cpu)
+{
+#ifdef __linux__
+    const size_t cpus = std::max<size_t>(1, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % cpus, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+    (void)thread;
+    (void)cpu;
+#endif
+}
+
+/**
+ * @brief Shifts the indices of a job by offset, for jobs too large for the 32-bit shares.
+*/
+struct OffsetJob
+{
+    void (*invoke)(void*, size_t);
+    void* context;
+    size_t offset;
+};
+
+ThreadPoolOptions options_from_environment()
+{
+    ThreadPoolOptions options;
+    if(const char* threads = std::getenv("VCTR_NUM_THREADS"))
+    {
+        options.threads = std::strtoul(threads, nullptr, 10);
+    }
+    return options;
+}
+
+std::mutex g_default_pool_mutex;
+std::unique_ptr<ThreadPool> g_default_pool;
+
+} // namespace
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& options)
+    : m_size(resolve_size(options.threads))
+    , m_pin_threads(options.pin_threads)
+    , m_shares(new Share[resolve_size(options.threads)])
+    , m_invoke(nullptr)
+    , m_context(nullptr)
+    , m_remaining(0)
+    , m_generation(0)
+    , m_open(false)
+    , m_active(0)
+    , m_stop(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for(std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::run_tasks(size_t count, Invoke invoke, void* context)
+{
+    constexpr size_t maxTasksPerJob = std::numeric_limits<uint32_t>::max();
+    if(count > maxTasksPerJob)
+    {
+        for(size_t offset = 0; offset < count; offset += maxTasksPerJob)
+        {
+            OffsetJob job{invoke, context, offset};
+            run_tasks(
+                std::min(maxTasksPerJob, count - offset)
+                , [](void* job, size_t index) {
+                    OffsetJob& offset_job = *static_cast<OffsetJob*>(job);
+                    offset_job.invoke(offset_job.context, offset_job.offset + index);
+                }
+                , &job);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> submit(m_submit, std::defer_lock);
+    if(count <= 1 || m_size == 1 || t_inside_pool || !submit.try_lock())
+    {
+        for(size_t index = 0; index < count; ++index)
+        {
+            invoke(context, index);
+        }
+        return;
+    }
+
+    if(m_workers.empty())
+    {
+        start();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_invoke = invoke;
+        m_context = context;
+        m_remaining.store(count);
+        m_error = nullptr;
+        for(size_t share = 0; share < m_size; ++share)
+        {
+            m_shares[share].range.store(pack(count * share / m_size, count * (share + 1) / m_size));
+        }
+        m_open = true;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    t_inside_pool = true;
+    participate(m_size - 1);
+    t_inside_pool = false;
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_remaining.load() == 0; });
+        m_open = false;
+        m_done.wait(lock, [this] { return m_active == 0; });
+        std::swap(error, m_error);
+    }
+
+    if(error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::start()
+{
+    m_workers.reserve(m_size - 1);
+    for(size_t worker = 0; worker + 1 < m_size; ++worker)
+    {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this, worker);
+        if(m_pin_threads)
+        {
+            pin_to_cpu(m_workers.back(), worker);
+        }
+    }
+}
+
+void ThreadPool::worker_loop(size_t share)
+{
+    t_inside_pool = true;
+
+    uint64_t seen = 0;
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seen] { return m_stop || (m_open && m_generation != seen); });
+            if(m_stop)
+            {
+                return;
+            }
+            seen = m_generation;
+            ++m_active;
+        }
+
+        participate(share);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(--m_active == 0)
+            {
+                m_done.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::participate(size_t share)
+{
+    size_t index;
+    while(take(share, index) || steal(share, index))
+    {
+        execute(index);
+    }
+}
+
+bool ThreadPool::take(size_t share, size_t& index)
+{
+    std::atomic<uint64_t>& range = m_shares[share].range;
+    uint64_t current = range.load();
+    while(begin_of(current) < end_of(current))
+    {
+        if(range.compare_exchange_weak(current, pack(begin_of(current) + 1, end_of(current))))
+        {
+            index = begin_of(current);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::steal(size_t thief, size_t& index)
+{
+    for(size_t offset = 1; offset < m_size; ++offset)
+    {
+        std::atomic<uint64_t>& victim = m_shares[(thief + offset) % m_size].range;
+        uint64_t current = victim.load();
+        while(begin_of(current) < end_of(current))
+        {
+            // leave the victim the front half, take the back half
+            const uint64_t begin = begin_of(current);
+            const uint64_t end = end_of(current);
+            const uint64_t middle = begin + (end - begin) / 2;
+            if(victim.compare_exchange_weak(current, pack(begin, middle)))
+            {
+                index = middle;
+                m_shares[thief].range.store(pack(middle + 1, end));
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(size_t index)
+{
+    try
+    {
+        m_invoke(m_context, index);
+    }
+    catch(...)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_error)
+        {
+            m_error = std::current_exception();
+        }
+    }
+
+    if(m_remaining.fetch_sub(1) == 1)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.notify_all();
+    }
+}
+
+ThreadPool& default_thread_pool()
+{
+    std::lock_guard<std::mutex> lock(g_default_pool_mutex);
+    if(!g_default_pool)
+    {
+        g_default_pool = std::make_unique<ThreadPool>(options_from_environment());
+    }
+    return *g_default_pool;
+}
+
+void configure_thread_pool(const ThreadPoolOptions& options)
+{
+    std::lock_guard<std::mutex> lock(g_default_pool_mutex);
+    g_default_pool = std::make_unique<ThreadPool>(options);
+}
+
+} // vctr
+} // arondina
@@ -0,0 +1,177 @@
+#include "aligned_allocator.h"
+
+// vctr
+#include "matrix.h"
+#include "vector.h"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+/**
+ * @brief Stateful allocator that counts live allocations per arena id. Allocators
+ *        with different ids compare unequal and do not propagate, the awkward case.
+*/
+template<typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator(int id, int* live)
+        : m_id(id)
+        , m_live(live)
+    {
+    }
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& rhs)
+        : m_id(rhs.id())
+        , m_live(rhs.live())
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        ++*m_live;
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* data, size_t count)
+    {
+        --*m_live;
+        std::allocator<T>().deallocate(data, count);
+    }
+
+    int id() const { return m_id; }
+    int* live() const { return m_live; }
+
+    bool operator==(const ArenaAllocator& rhs) const { return m_id == rhs.m_id; }
+    bool operator!=(const ArenaAllocator& rhs) const { return m_id != rhs.m_id; }
+
+private:
+    int m_id;
+    int* m_live;
+};
+
+} // namespace
+
+TEST(AlignedAllocatorTests, alignment)
+{
+    AlignedAllocator<char, 256> allocator;
+    char* data = allocator.allocate(3);
+
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(data) % 256);
+    allocator.deallocate(data, 3);
+}
+
+TEST(AlignedAllocatorTests, defaultVectorAllocatorIsAligned)
+{
+    EXPECT_TRUE((std::is_same_v<Vector<int>, Vector<int, AlignedAllocator<int, VectorConstants::alignment>>>));
+}
+
+TEST(AlignedAllocatorTests, vectorUsesAllocator)
+{
+    int live = 0;
+    {
+        ArenaAllocator<double> arena(1, &live);
+        Vector<double, ArenaAllocator<double>> v1(5, 2.0, arena);
+        Vector<double, ArenaAllocator<double>> v2({1.0, 2.0, 3.0, 4.0, 5.0}, arena);
+        EXPECT_EQ(2, live);
+
+        Vector<double, ArenaAllocator<double>> sum(v1 + v2, arena);
+        EXPECT_EQ(3, live);
+        EXPECT_EQ(7.0, sum[4]);
+        EXPECT_EQ(1, sum.get_allocator().id());
+
+        Vector<double, ArenaAllocator<double>> copy(sum);
+        EXPECT_EQ(4, live);
+        EXPECT_TRUE(copy == sum);
+    }
+    EXPECT_EQ(0, live);
+}
+
+TEST(AlignedAllocatorTests, vectorMoveAssignAcrossArenas)
+{
+    int live = 0;
+    {
+        Vector<int, ArenaAllocator<int>> v1({1, 2, 3}, ArenaAllocator<int>(1, &live));
+        Vector<int, ArenaAllocator<int>> v2({4, 5}, ArenaAllocator<int>(2, &live));
+
+        // unequal, non-propagating allocators: the elements are copied into v1's arena
+        v1 = std::move(v2);
+
+        EXPECT_EQ(1, v1.get_allocator().id());
+        EXPECT_EQ(2u, v1.dimensions());
+        EXPECT_EQ(5, v1[1]);
+    }
+    EXPECT_EQ(0, live);
+}
+
+TEST(AlignedAllocatorTests, vectorExpressionAssignKeepsArena)
+{
+    int live = 0;
+    {
+        Vector<int, ArenaAllocator<int>> v1({1, 2, 3}, ArenaAllocator<int>(1, &live));
+        Vector<int> v2{1, 1, 1, 1};
+
+        v1 = v2 + v2;
+
+        EXPECT_EQ(1, v1.get_allocator().id());
+        EXPECT_EQ(4u, v1.dimensions());
+        EXPECT_EQ(1, live);
+        EXPECT_EQ(dot_product(v1, v2), 8);
+    }
+    EXPECT_EQ(0, live);
+}
+
+TEST(AlignedAllocatorTests, matrixUsesAllocator)
+{
+    int live = 0;
+    {
+        ArenaAllocator<float> arena(3, &live);
+        Matrix<float, ArenaAllocator<float>> a(4, 3, 1.0f, arena);
+        Matrix<float, ArenaAllocator<float>> b(3, 2, 2.0f, arena);
+
+        Matrix<float, ArenaAllocator<float>> c = a * b;
+        EXPECT_EQ(3, live);
+        EXPECT_EQ(6.0f, c(3, 1));
+        EXPECT_EQ(3, c.get_allocator().id());
+
+        Vector<float> x(3, 1.0f);
+        Vector<float> y = a * x;
+        EXPECT_EQ(3.0f, y[0]);
+    }
+    EXPECT_EQ(0, live);
+}
+
+TEST(AlignedAllocatorTests, matrixMoveAssignAcrossArenas)
+{
+    int live = 0;
+    {
+        Matrix<int, ArenaAllocator<int>> a(2, 2, 1, ArenaAllocator<int>(1, &live));
+        Matrix<int, ArenaAllocator<int>> b(3, 1, 7, ArenaAllocator<int>(2, &live));
+
+        a = std::move(b);
+
+        EXPECT_EQ(1, a.get_allocator().id());
+        EXPECT_EQ(3u, a.num_rows());
+        EXPECT_EQ(7, a(2, 0));
+    }
+    EXPECT_EQ(0, live);
+}
+
+} // vctr
+} // arondina
@@ -0,0 +1,155 @@
+#include "binary.h"
+
+// vctr
+#include "matrix.h"
+#include "vector.h"
+
+// std
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+BinaryVector random_bits(size_t bits, std::mt19937& rng)
+{
+    std::bernoulli_distribution coin(0.5);
+    BinaryVector v(bits);
+    for(size_t i = 0; i < bits; ++i)
+    {
+        v.set(i, coin(rng));
+    }
+    return v;
+}
+
+} // namespace
+
+TEST(BinaryTests, setAndTest)
+{
+    BinaryVector v(130);
+    EXPECT_EQ(130, v.size());
+    EXPECT_EQ(3, v.num_words());
+    EXPECT_EQ(0, v.count());
+
+    v.set(0);
+    v.set(64);
+    v.set(129);
+    EXPECT_TRUE(v.test(0));
+    EXPECT_FALSE(v.test(1));
+    EXPECT_TRUE(v.test(64));
+    EXPECT_TRUE(v.test(129));
+    EXPECT_EQ(3, v.count());
+
+    v.set(64, false);
+    EXPECT_FALSE(v.test(64));
+    EXPECT_EQ(2, v.count());
+
+    EXPECT_EQ(BinaryVector({true, false, true}), BinaryVector::from_signs(Vector<float>{0.5f, -1.0f, 2.0f}));
+    EXPECT_NE(BinaryVector({true, false, true}), BinaryVector({true, false, false}));
+}
+
+TEST(BinaryTests, hammingAndJaccard)
+{
+    const BinaryVector a{true, true, false, false, true};
+    const BinaryVector b{true, false, true, false, true};
+    EXPECT_EQ(2, hamming_distance(a, b));
+    EXPECT_EQ(0, hamming_distance(a, a));
+    EXPECT_DOUBLE_EQ(0.5, jaccard_similarity(a, b));
+    EXPECT_DOUBLE_EQ(1.0, jaccard_similarity(a, a));
+    EXPECT_DOUBLE_EQ(1.0, jaccard_similarity(BinaryVector(70), BinaryVector(70)));
+
+    // signatures of the usual lengths, against a bit-by-bit count
+    std::mt19937 rng(3);
+    for(size_t bits : {size_t(1), size_t(63), size_t(256), size_t(1000), size_t(1024)})
+    {
+        const BinaryVector x = random_bits(bits, rng);
+        const BinaryVector y = random_bits(bits, rng);
+        size_t differ = 0;
+        size_t both = 0;
+        size_t either = 0;
+        for(size_t i = 0; i < bits; ++i)
+        {
+            differ += x.test(i) != y.test(i);
+            both += x.test(i) && y.test(i);
+            either += x.test(i) || y.test(i);
+        }
+        EXPECT_EQ(differ, hamming_distance(x, y)) << "bits=" << bits;
+        EXPECT_DOUBLE_EQ(either == 0 ? 1.0 : double(both) / double(either), jaccard_similarity(x, y)) << "bits=" << bits;
+    }
+}
+
+TEST(BinaryTests, batchMatchesSingle)
+{
+    std::mt19937 rng(7);
+    ThreadPool pool(ThreadPoolOptions{3, false});
+    for(size_t bits : {size_t(100), size_t(256), size_t(1024)})
+    {
+        BinaryMatrix candidates(2000, bits);
+        for(size_t r = 0; r < candidates.num_rows(); ++r)
+        {
+            candidates.set_row(r, random_bits(bits, rng));
+        }
+        const BinaryVector query = random_bits(bits, rng);
+
+        Vector<uint32_t> expected(candidates.num_rows());
+        for(size_t r = 0; r < candidates.num_rows(); ++r)
+        {
+            BinaryVector row(bits);
+            for(size_t i = 0; i < bits; ++i)
+            {
+                row.set(i, candidates.test(r, i));
+            }
+            expected[r] = static_cast<uint32_t>(hamming_distance(query, row));
+        }
+
+        for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd, execution::on(pool)})
+        {
+            Vector<uint32_t> actual(candidates.num_rows());
+            hamming_distance_batch(policy, query, candidates, actual);
+            for(size_t r = 0; r < candidates.num_rows(); ++r)
+            {
+                ASSERT_EQ(expected[r], actual[r]) << "bits=" << bits << " row=" << r;
+            }
+        }
+    }
+}
+
+TEST(BinaryTests, fromSignsMatrix)
+{
+    const Matrix<double> m{{1.0, -1.0, 0.0}, {-2.0, 3.0, 4.0}};
+    const BinaryMatrix signs = BinaryMatrix::from_signs(m);
+    EXPECT_EQ(2, signs.num_rows());
+    EXPECT_EQ(3, signs.bits());
+    EXPECT_TRUE(signs.test(0, 0));
+    EXPECT_FALSE(signs.test(0, 1));
+    EXPECT_FALSE(signs.test(0, 2));
+    EXPECT_FALSE(signs.test(1, 0));
+    EXPECT_TRUE(signs.test(1, 1));
+    EXPECT_TRUE(signs.test(1, 2));
+}
+
+TEST(BinaryTests, throwsOnMismatchedLengths)
+{
+    EXPECT_THROW(hamming_distance(BinaryVector(3), BinaryVector(4)), std::runtime_error);
+    EXPECT_THROW(jaccard_similarity(BinaryVector(3), BinaryVector(4)), std::runtime_error);
+
+    BinaryMatrix candidates(5, 10);
+    EXPECT_THROW(candidates.set_row(0, BinaryVector(11)), std::runtime_error);
+
+    Vector<uint32_t> out(5);
+    EXPECT_THROW(hamming_distance_batch(BinaryVector(11), candidates, out), std::runtime_error);
+    Vector<uint32_t> short_out(4);
+    EXPECT_THROW(hamming_distance_batch(BinaryVector(10), candidates, short_out), std::runtime_error);
+}
+
+} // vctr
+} // arondina
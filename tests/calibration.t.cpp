@@ -0,0 +1,110 @@
+#include "calibration.h"
+
+// vctr
+#include "thread_pool.h"
+#include "vector.h"
+
+// std
+#include <limits>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+class CalibrationTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        reset_calibration();
+        configure_thread_pool(ThreadPoolOptions());
+    }
+};
+
+TEST_F(CalibrationTest, defaultsMatchVectorConstants)
+{
+    EXPECT_FALSE(is_calibrated());
+    EXPECT_EQ(VectorConstants::maxDimensionsForSequentialArithmeticOps, max_dimensions_for_sequential<int>(Operation::Arithmetic));
+    EXPECT_EQ(VectorConstants::maxDimensionsForSequentialArithmeticOps, max_dimensions_for_sequential<float>(Operation::Scale));
+    EXPECT_EQ(VectorConstants::maxDimensionsForSequentialArithmeticOps, max_dimensions_for_sequential<double>(Operation::Magnitude));
+    EXPECT_EQ(VectorConstants::maxDimensionsForSequentialDotProduct, max_dimensions_for_sequential<long>(Operation::DotProduct));
+}
+
+TEST_F(CalibrationTest, elementTypeOf)
+{
+    EXPECT_EQ(ElementType::Int, element_type_of<int>());
+    EXPECT_EQ(ElementType::Float, element_type_of<float>());
+    EXPECT_EQ(ElementType::Double, element_type_of<double>());
+    EXPECT_EQ(ElementType::Other, element_type_of<short>());
+}
+
+TEST_F(CalibrationTest, overrideIsPerOperationAndType)
+{
+    set_max_dimensions_for_sequential(Operation::DotProduct, ElementType::Float, 12345);
+
+    EXPECT_EQ(12345, max_dimensions_for_sequential<float>(Operation::DotProduct));
+    EXPECT_EQ(VectorConstants::maxDimensionsForSequentialDotProduct, max_dimensions_for_sequential<double>(Operation::DotProduct));
+    EXPECT_EQ(VectorConstants::maxDimensionsForSequentialArithmeticOps, max_dimensions_for_sequential<float>(Operation::Scale));
+}
+
+TEST_F(CalibrationTest, resetRestoresDefaults)
+{
+    set_max_dimensions_for_sequential(Operation::Arithmetic, ElementType::Int, 0);
+    reset_calibration();
+    EXPECT_EQ(VectorConstants::maxDimensionsForSequentialArithmeticOps, max_dimensions_for_sequential<int>(Operation::Arithmetic));
+}
+
+TEST_F(CalibrationTest, forcedPathsAgree)
+{
+    Vector<int> v1(5000, 3);
+    Vector<int> v2(5000, 2);
+
+    set_max_dimensions_for_sequential(Operation::Arithmetic, ElementType::Int, 0);
+    set_max_dimensions_for_sequential(Operation::DotProduct, ElementType::Int, 0);
+    Vector<int> parallel_sum = v1 + v2;
+    int parallel_dot = dot_product(v1, v2);
+
+    set_max_dimensions_for_sequential(Operation::Arithmetic, ElementType::Int, std::numeric_limits<size_t>::max());
+    set_max_dimensions_for_sequential(Operation::DotProduct, ElementType::Int, std::numeric_limits<size_t>::max());
+    Vector<int> sequential_sum = v1 + v2;
+    int sequential_dot = dot_product(v1, v2);
+
+    EXPECT_TRUE(parallel_sum == sequential_sum);
+    EXPECT_EQ(30000, parallel_dot);
+    EXPECT_EQ(30000, sequential_dot);
+}
+
+TEST_F(CalibrationTest, calibrate)
+{
+    calibrate();
+    EXPECT_TRUE(is_calibrated());
+
+    Vector<double> v1(3000, 2.0);
+    Vector<double> v2(3000, 0.5);
+    EXPECT_EQ(3000.0, dot_product(v1, v2));
+    EXPECT_EQ(2.5, (v1 + v2)[2999]);
+}
+
+#ifndef VCTR_USE_TBB
+TEST_F(CalibrationTest, singleThreadPoolNeverRunsParallel)
+{
+    configure_thread_pool(ThreadPoolOptions{1, false});
+
+    calibrate();
+
+    const size_t never = std::numeric_limits<size_t>::max();
+    for(Operation operation : {Operation::Arithmetic, Operation::Scale, Operation::Magnitude, Operation::DotProduct})
+    {
+        EXPECT_EQ(never, max_dimensions_for_sequential<int>(operation));
+        EXPECT_EQ(never, max_dimensions_for_sequential<float>(operation));
+        EXPECT_EQ(never, max_dimensions_for_sequential<double>(operation));
+    }
+}
+#endif
+
+} // vctr
+} // arondina
@@ -0,0 +1,114 @@
+#include "distance.h"
+
+// vctr
+#include "test_helpers.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+TEST(DistanceTests, small)
+{
+    Vector<double> a{1.0, -2.0, 3.0};
+    Vector<double> b{4.0, 2.0, 3.0};
+
+    EXPECT_EQ(7.0, l1_distance(a, b));
+    EXPECT_EQ(25.0, squared_l2_distance(a, b));
+    EXPECT_EQ(5.0, l2_distance(a, b));
+    EXPECT_EQ(4.0, linf_distance(a, b));
+    EXPECT_DOUBLE_EQ(9.0 / (std::sqrt(14.0) * std::sqrt(29.0)), cosine_similarity(a, b));
+    EXPECT_DOUBLE_EQ(1.0 - 9.0 / (std::sqrt(14.0) * std::sqrt(29.0)), cosine_distance(a, b));
+
+    Vector<int> i{3, 0};
+    Vector<int> j{0, 4};
+    EXPECT_EQ(7, l1_distance(i, j));
+    EXPECT_EQ(25, squared_l2_distance(i, j));
+    EXPECT_EQ(5.0, l2_distance(i, j));
+    EXPECT_EQ(4, linf_distance(i, j));
+    EXPECT_EQ(0.0, cosine_similarity(i, j));
+}
+
+TEST(DistanceTests, agreeAcrossPolicies)
+{
+    ThreadPool pool(ThreadPoolOptions{3, false});
+
+    for(size_t dimensions : {1u, 31u, 4096u, 100'003u})
+    {
+        Vector<float> a(dimensions);
+        Vector<float> b(dimensions);
+        double l1 = 0.0;
+        double squared_l2 = 0.0;
+        double linf = 0.0;
+        double dot = 0.0;
+        double squares_a = 0.0;
+        double squares_b = 0.0;
+        // small integers, so every sum stays exact in float
+        for(size_t k = 0; k < dimensions; ++k)
+        {
+            a[k] = static_cast<float>(k % 11) - 5.0f;
+            b[k] = static_cast<float>(k % 7) + 1.0f;
+            const double difference = static_cast<double>(a[k]) - b[k];
+            l1 += std::abs(difference);
+            squared_l2 += difference * difference;
+            linf = std::max(linf, std::abs(difference));
+            dot += static_cast<double>(a[k]) * b[k];
+            squares_a += static_cast<double>(a[k]) * a[k];
+            squares_b += static_cast<double>(b[k]) * b[k];
+        }
+        const double cosine = dot / (std::sqrt(squares_a) * std::sqrt(squares_b));
+
+        for(const ExecutionPolicy& policy : all_policies(pool))
+        {
+            EXPECT_NEAR(l1, l1_distance(policy, a, b), 1e-6 * l1);
+            EXPECT_NEAR(squared_l2, squared_l2_distance(policy, a, b), 1e-6 * squared_l2);
+            EXPECT_NEAR(std::sqrt(squared_l2), l2_distance(policy, a, b), 1e-6 * std::sqrt(squared_l2));
+            EXPECT_EQ(linf, linf_distance(policy, a, b));
+            EXPECT_NEAR(cosine, cosine_similarity(policy, a, b), 1e-6);
+        }
+    }
+}
+
+TEST(DistanceTests, identicalVectors)
+{
+    Vector<double> a{0.5, -1.5, 2.0, 8.0, -3.25};
+    EXPECT_EQ(0.0, l1_distance(a, a));
+    EXPECT_EQ(0.0, l2_distance(a, a));
+    EXPECT_EQ(0.0, linf_distance(a, a));
+    EXPECT_DOUBLE_EQ(1.0, cosine_similarity(a, a));
+    EXPECT_DOUBLE_EQ(-1.0, cosine_similarity(a, Vector<double>(a * -2.0)));
+}
+
+TEST(DistanceTests, zeroVectorHasNoAngle)
+{
+    Vector<float> zero(17, 0.0f);
+    Vector<float> b(17, 1.0f);
+    EXPECT_EQ(0.0, cosine_similarity(zero, b));
+    EXPECT_EQ(1.0, cosine_distance(zero, b));
+}
+
+TEST(DistanceTests, throwsOnUnequalSizes)
+{
+    Vector<double> a{1.0, 2.0, 3.0};
+    Vector<double> b{1.0, 2.0};
+
+    EXPECT_THROW(l1_distance(a, b), std::runtime_error);
+    EXPECT_THROW(squared_l2_distance(a, b), std::runtime_error);
+    EXPECT_THROW(l2_distance(execution::par, a, b), std::runtime_error);
+    EXPECT_THROW(linf_distance(a, b), std::runtime_error);
+    EXPECT_THROW(cosine_similarity(a, b), std::runtime_error);
+}
+
+} // vctr
+} // arondina
@@ -0,0 +1,329 @@
+#include "execution_policy.h"
+
+// vctr
+#include "test_helpers.h"
+#include "vector.h"
+
+// std
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+template<typename T>
+Vector<T> iota_vector(size_t dimensions, T start)
+{
+    Vector<T> v(dimensions);
+    for(size_t i = 0; i < dimensions; ++i)
+    {
+        v[i] = start + static_cast<T>(i % 97);
+    }
+    return v;
+}
+
+} // namespace
+
+TEST(ExecutionPolicyTests, modes)
+{
+    EXPECT_FALSE(execution::seq.is_parallel(1'000'000, 10));
+    EXPECT_FALSE(execution::simd.is_parallel(1'000'000, 10));
+    EXPECT_TRUE(execution::par.is_parallel(3, 10));
+    EXPECT_TRUE(execution::par_simd.is_parallel(3, 10));
+    EXPECT_FALSE(execution::automatic.is_parallel(10, 10));
+    EXPECT_TRUE(execution::automatic.is_parallel(11, 10));
+
+    EXPECT_FALSE(execution::seq.uses_simd());
+    EXPECT_FALSE(execution::par.uses_simd());
+    EXPECT_TRUE(execution::simd.uses_simd());
+    EXPECT_TRUE(execution::par_simd.uses_simd());
+    EXPECT_TRUE(execution::automatic.uses_simd());
+
+    ThreadPool pool(ThreadPoolOptions{2, false});
+    EXPECT_EQ(&pool, execution::on(pool).pool());
+    EXPECT_EQ(nullptr, execution::par.pool());
+}
+
+TEST(ExecutionPolicyTests, addAndSubtractAgreeAcrossPolicies)
+{
+    ThreadPool pool(ThreadPoolOptions{3, false});
+
+    for(size_t dimensions : {0u, 1u, 17u, 1000u, 5003u})
+    {
+        Vector<int32_t> v1 = iota_vector<int32_t>(dimensions, 5);
+        Vector<int32_t> v2 = iota_vector<int32_t>(dimensions, -40);
+        Vector<int32_t> expected_sum = v1 + v2;
+        Vector<int32_t> expected_difference = v1 - v2;
+
+        for(const ExecutionPolicy& policy : all_policies(pool))
+        {
+            Vector<int32_t> sum = add(policy, v1, v2);
+            Vector<int32_t> difference = subtract(policy, v1, v2);
+            Vector<int32_t> fused = add(policy, v1 * 2, v2 - v1);
+
+            EXPECT_TRUE(expected_sum == sum);
+            EXPECT_TRUE(expected_difference == difference);
+            EXPECT_TRUE(expected_sum == fused);
+        }
+    }
+}
+
+TEST(ExecutionPolicyTests, assignReusesBuffer)
+{
+    Vector<double> v1(3000, 1.0);
+    Vector<double> v2(3000, 2.0);
+    const double* buffer = v1.data();
+
+    v1.assign(execution::par, v1 + v2);
+
+    EXPECT_EQ(buffer, v1.data());
+    EXPECT_EQ(3.0, v1[2999]);
+}
+
+TEST(ExecutionPolicyTests, scaleAgreesAcrossPolicies)
+{
+    ThreadPool pool(ThreadPoolOptions{3, false});
+
+    for(size_t dimensions : {1u, 33u, 4001u})
+    {
+        Vector<int64_t> expected = iota_vector<int64_t>(dimensions, -20);
+        expected.scale(execution::seq, 1.75);
+
+        for(const ExecutionPolicy& policy : all_policies(pool))
+        {
+            Vector<int64_t> v = iota_vector<int64_t>(dimensions, -20);
+            v.scale(policy, 1.75);
+            EXPECT_TRUE(expected == v);
+        }
+    }
+}
+
+TEST(ExecutionPolicyTests, compoundAssignmentAgreesAcrossPolicies)
+{
+    ThreadPool pool(ThreadPoolOptions{3, false});
+
+    for(size_t dimensions : {0u, 1u, 17u, 1000u, 5003u})
+    {
+        const Vector<int32_t> v1 = iota_vector<int32_t>(dimensions, 5);
+        const Vector<int32_t> v2 = iota_vector<int32_t>(dimensions, 1);
+
+        Vector<int32_t> expected(v1);
+        expected += v2;
+        expected -= v2 * 3;
+        expected *= v2;
+        expected /= v2;
+        expected *= 7;
+        expected /= 2;
+        expected *= 0.5;
+
+        for(const ExecutionPolicy& policy : all_policies(pool))
+        {
+            Vector<int32_t> v(v1);
+            const int32_t* buffer = v.data();
+            v.add_assign(policy, v2);
+            v.subtract_assign(policy, v2 * 3);
+            v.multiply_assign(policy, v2);
+            v.divide_assign(policy, v2);
+            v.multiply_assign(policy, 7);
+            v.divide_assign(policy, 2);
+            v.multiply_assign(policy, 0.5);
+            EXPECT_TRUE(expected == v);
+            EXPECT_EQ(buffer, v.data());
+        }
+    }
+}
+
+TEST(ExecutionPolicyTests, axpyAgreesAcrossPolicies)
+{
+    ThreadPool pool(ThreadPoolOptions{3, false});
+
+    for(size_t dimensions : {0u, 1u, 33u, 4001u})
+    {
+        const Vector<int64_t> x = iota_vector<int64_t>(dimensions, -20);
+        const Vector<int64_t> y0 = iota_vector<int64_t>(dimensions, 3);
+
+        Vector<int64_t> expected_axpy(y0);
+        axpy(execution::seq, int64_t(3), x, expected_axpy);
+        Vector<int64_t> expected_axpby(y0);
+        axpby(execution::seq, int64_t(3), x, int64_t(-2), expected_axpby);
+
+        for(const ExecutionPolicy& policy : all_policies(pool))
+        {
+            Vector<int64_t> y(y0);
+            axpy(policy, int64_t(3), x, y);
+            EXPECT_TRUE(expected_axpy == y);
+
+            Vector<int64_t> z(y0);
+            axpby(policy, int64_t(3), x, int64_t(-2), z);
+            EXPECT_TRUE(expected_axpby == z);
+        }
+
+        Vector<int64_t> y(y0);
+        axpy(int64_t(3), x, y);
+        EXPECT_TRUE(expected_axpy == y);
+        if(dimensions > 0)
+        {
+            EXPECT_EQ(3 * x[dimensions - 1] + y0[dimensions - 1], y[dimensions - 1]);
+        }
+    }
+
+    Vector<double> shorter(2, 1.0);
+    Vector<double> longer(3, 1.0);
+    for(const ExecutionPolicy& policy : all_policies(pool))
+    {
+        EXPECT_THROW(axpy(policy, 1.0, shorter, longer), std::runtime_error);
+        EXPECT_THROW(axpby(policy, 1.0, shorter, 1.0, longer), std::runtime_error);
+    }
+}
+
+TEST(ExecutionPolicyTests, reductionsAgreeAcrossPolicies)
+{
+    ThreadPool pool(ThreadPoolOptions{4, false});
+
+    for(size_t dimensions : {1u, 31u, 4096u, 10007u})
+    {
+        Vector<int32_t> i1 = iota_vector<int32_t>(dimensions, -48);
+        Vector<int32_t> i2 = iota_vector<int32_t>(dimensions, 3);
+        Vector<double> d1 = iota_vector<double>(dimensions, 0.25);
+        Vector<double> d2 = iota_vector<double>(dimensions, -7.5);
+
+        const int32_t expected_int = dot_product(execution::seq, i1, i2);
+        const double expected_double = dot_product(execution::seq, d1, d2);
+        const double expected_magnitude = d1.magnitude(execution::seq);
+
+        for(const ExecutionPolicy& policy : all_policies(pool))
+        {
+            EXPECT_EQ(expected_int, dot_product(policy, i1, i2));
+            EXPECT_NEAR(expected_double, dot_product(policy, d1, d2), 1e-9 * std::abs(expected_double) + 1e-9);
+            EXPECT_NEAR(expected_magnitude, d1.magnitude(policy), 1e-12 * expected_magnitude);
+        }
+    }
+}
+
+TEST(ExecutionPolicyTests, reproducibleReductionsAreBitwiseIdentical)
+{
+    const size_t dimensions = 100'003;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    Vector<float> v1(dimensions);
+    Vector<float> v2(dimensions);
+    for(size_t i = 0; i < dimensions; ++i)
+    {
+        v1[i] = dist(rng);
+        v2[i] = dist(rng) * 1e4f;
+    }
+
+    simd::set_instruction_set(simd::InstructionSet::Scalar);
+    const float expected_dot = dot_product(execution::seq.reproducible(), v1, v2);
+    const double expected_magnitude = v2.magnitude(execution::seq.reproducible());
+
+    const simd::InstructionSet instruction_sets[] = {
+        simd::InstructionSet::Scalar
+        , simd::InstructionSet::SSE2
+        , simd::InstructionSet::AVX2
+        , simd::InstructionSet::AVX512};
+    for(simd::InstructionSet instruction_set : instruction_sets)
+    {
+        if(!simd::is_supported(instruction_set))
+        {
+            continue;
+        }
+        simd::set_instruction_set(instruction_set);
+
+        for(size_t threads : {1u, 2u, 3u, 5u, 8u})
+        {
+            ThreadPool pool(ThreadPoolOptions{threads, false});
+            for(const ExecutionPolicy& policy : all_policies(pool))
+            {
+                const float dot = dot_product(policy.reproducible(), v1, v2);
+                const double magnitude = v2.magnitude(policy.reproducible());
+                EXPECT_EQ(0, std::memcmp(&expected_dot, &dot, sizeof(float)))
+                    << simd::to_string(instruction_set) << " threads " << threads;
+                EXPECT_EQ(0, std::memcmp(&expected_magnitude, &magnitude, sizeof(double)))
+                    << simd::to_string(instruction_set) << " threads " << threads;
+            }
+        }
+    }
+    simd::set_instruction_set(simd::detected_instruction_set());
+
+    // still a good dot product
+    double reference = 0.0;
+    for(size_t i = 0; i < dimensions; ++i)
+    {
+        reference += static_cast<double>(v1[i]) * v2[i];
+    }
+    EXPECT_NEAR(reference, expected_dot, 1e-5 * std::abs(reference) + 1.0);
+    EXPECT_EQ(dot_product(execution::reproducible, v1, v2), expected_dot);
+}
+
+TEST(ExecutionPolicyTests, reproducibleIntegerReductionsAreExact)
+{
+    Vector<int32_t> v1 = iota_vector<int32_t>(20'000, -48);
+    Vector<int32_t> v2 = iota_vector<int32_t>(20'000, 3);
+
+    EXPECT_EQ(dot_product(execution::seq, v1, v2), dot_product(execution::par.reproducible(), v1, v2));
+    EXPECT_EQ(v1.magnitude(execution::seq), v1.magnitude(execution::reproducible));
+}
+
+TEST(ExecutionPolicyTests, compensatedReductionsAreAccurate)
+{
+    // pairs of products that cancel exactly, interleaved with small ones
+    const size_t pairs = 150'000;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    Vector<float> v1(3 * pairs);
+    Vector<float> v2(3 * pairs);
+    double expected_dot = 0.0;
+    double expected_squares = 0.0;
+    for(size_t i = 0; i < pairs; ++i)
+    {
+        const float x = dist(rng);
+        const float y = dist(rng);
+        const float small = dist(rng) * 1e-3f;
+        v1[3 * i] = x;
+        v2[3 * i] = y;
+        v1[3 * i + 1] = small;
+        v2[3 * i + 1] = 1.0f;
+        v1[3 * i + 2] = -x;
+        v2[3 * i + 2] = y;
+        expected_dot += small;
+        expected_squares += 2.0 * static_cast<double>(x) * x + static_cast<double>(small) * small;
+    }
+
+    ThreadPool pool(ThreadPoolOptions{3, false});
+    for(const ExecutionPolicy& policy : all_policies(pool))
+    {
+        EXPECT_NEAR(expected_dot, dot_product(policy.compensated(), v1, v2), 1e-6 * std::abs(expected_dot) + 1e-6);
+        EXPECT_NEAR(std::sqrt(expected_squares), v1.magnitude(policy.compensated()), 1e-8 * std::sqrt(expected_squares));
+    }
+    EXPECT_EQ(ExecutionPolicy::Reduction::Compensated, execution::compensated.reduction());
+
+    Vector<int64_t> i1 = iota_vector<int64_t>(10'000, -40);
+    EXPECT_EQ(dot_product(execution::seq, i1, i1), dot_product(execution::par_simd.compensated(), i1, i1));
+}
+
+TEST(ExecutionPolicyTests, reductionsThrowForEveryPolicy)
+{
+    Vector<int> v1{1, 2, 3};
+    Vector<int> v2{1, 2};
+    Vector<int> empty(0);
+
+    EXPECT_THROW(dot_product(execution::par, v1, v2), std::runtime_error);
+    EXPECT_THROW(dot_product(execution::seq, empty, empty), std::runtime_error);
+    EXPECT_THROW(add(execution::simd, v1, v2), std::runtime_error);
+}
+
+} // vctr
+} // arondina
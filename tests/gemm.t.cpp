@@ -0,0 +1,224 @@
+#include "gemm.h"
+
+// vctr
+#include "matrix.h"
+#include "simd.h"
+#include "test_helpers.h"
+
+// std
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+/**
+ * @brief Plain triple loop, c = alpha * a * b + beta * c.
+*/
+template<typename T>
+Matrix<T> reference_gemm(T alpha, const Matrix<T>& a, const Matrix<T>& b, T beta, const Matrix<T>& c)
+{
+    Matrix<T> result(c);
+    for(size_t i = 0; i < a.num_rows(); ++i)
+    {
+        for(size_t j = 0; j < b.num_cols(); ++j)
+        {
+            T sum = T(0);
+            for(size_t p = 0; p < a.num_cols(); ++p)
+            {
+                sum += a(i, p) * b(p, j);
+            }
+            result(i, j) = alpha * sum + beta * c(i, j);
+        }
+    }
+    return result;
+}
+
+template<typename T>
+void expect_matrix_eq(const Matrix<T>& expected, const Matrix<T>& actual, const char* context)
+{
+    ASSERT_EQ(expected.num_rows(), actual.num_rows()) << context;
+    ASSERT_EQ(expected.num_cols(), actual.num_cols()) << context;
+    for(size_t i = 0; i < expected.num_rows(); ++i)
+    {
+        for(size_t j = 0; j < expected.num_cols(); ++j)
+        {
+            // Small integer inputs keep every partial sum exact in float and double.
+            ASSERT_EQ(expected(i, j), actual(i, j)) << context << " (" << i << ", " << j << ")";
+        }
+    }
+}
+
+template<typename T>
+void check_shapes(simd::InstructionSet instruction_set)
+{
+    const size_t shapes[][3] = {
+        {1, 1, 1}, {3, 5, 7}, {6, 16, 4}, {13, 33, 17}, {64, 64, 64},
+        {121, 70, 300}, {250, 40, 513}, {7, 3100, 9}
+    };
+
+    std::mt19937 rng(7);
+    simd::set_instruction_set(instruction_set);
+    for(const auto& shape : shapes)
+    {
+        const size_t m = shape[0];
+        const size_t n = shape[1];
+        const size_t k = shape[2];
+
+        const Matrix<T> a = random_matrix<T>(m, k, rng, k + 3);
+        const Matrix<T> b = random_matrix<T>(k, n, rng);
+        Matrix<T> c = random_matrix<T>(m, n, rng, n + 5);
+
+        const Matrix<T> expected = reference_gemm(T(2), a, b, T(-3), c);
+        gemm(T(2), a, b, T(-3), c);
+        expect_matrix_eq(expected, c, simd::to_string(instruction_set));
+
+        const Matrix<T> product = a * b;
+        const Matrix<T> zero(m, n, T(0));
+        expect_matrix_eq(reference_gemm(T(1), a, b, T(0), zero), product, simd::to_string(instruction_set));
+
+        // b stored as its n x k transpose
+        Matrix<T> b_transposed(n, k, T(0), k + 1);
+        for(size_t p = 0; p < k; ++p)
+        {
+            for(size_t j = 0; j < n; ++j)
+            {
+                b_transposed(j, p) = b(p, j);
+            }
+        }
+        for(const ExecutionPolicy& policy : {execution::seq, execution::par})
+        {
+            Matrix<T> c_transposed = random_matrix<T>(m, n, rng, n + 2);
+            const Matrix<T> expected_transposed = reference_gemm(T(2), a, b, T(-1), c_transposed);
+            gemm_transposed_b(
+                policy
+                , m
+                , n
+                , k
+                , T(2)
+                , a.data()
+                , a.leading_dimension()
+                , b_transposed.data()
+                , b_transposed.leading_dimension()
+                , T(-1)
+                , c_transposed.data()
+                , c_transposed.leading_dimension());
+            expect_matrix_eq(expected_transposed, c_transposed, simd::to_string(instruction_set));
+        }
+    }
+}
+
+} // namespace
+
+class GemmTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        simd::set_instruction_set(simd::detected_instruction_set());
+    }
+};
+
+TEST_F(GemmTest, multiplySmall)
+{
+    Matrix<int> a{{1, 2, 3}, {4, 5, 6}};
+    Matrix<int> b{{7, 8}, {9, 10}, {11, 12}};
+    Matrix<int> product = a * b;
+
+    EXPECT_EQ(2, product.num_rows());
+    EXPECT_EQ(2, product.num_cols());
+    EXPECT_EQ(58, product(0, 0));
+    EXPECT_EQ(64, product(0, 1));
+    EXPECT_EQ(139, product(1, 0));
+    EXPECT_EQ(154, product(1, 1));
+}
+
+TEST_F(GemmTest, multiplyThrowsMismatchedDimensions)
+{
+    Matrix<double> a(2, 3, 1.0);
+    Matrix<double> b(2, 3, 1.0);
+
+    EXPECT_THROW({
+        try
+        {
+            Matrix<double> product = a * b;
+        }
+        catch(const std::runtime_error& e)
+        {
+            EXPECT_STREQ("mismatched matrix dimensions.", e.what());
+            throw;
+        }
+    }
+    , std::runtime_error);
+
+    Matrix<double> c(3, 3, 0.0);
+    EXPECT_THROW(gemm(1.0, a, b, 0.0, c), std::runtime_error);
+}
+
+TEST_F(GemmTest, gemmThrowsOnAliasing)
+{
+    Matrix<double> a(3, 3, 1.0);
+    Matrix<double> b(3, 3, 1.0);
+    EXPECT_THROW(gemm(1.0, a, b, 0.0, a), std::runtime_error);
+}
+
+TEST_F(GemmTest, betaZeroIgnoresNaN)
+{
+    Matrix<double> a(4, 4, 1.0);
+    Matrix<double> b(4, 4, 2.0);
+    Matrix<double> c(4, 4, std::nan(""));
+    gemm(1.0, a, b, 0.0, c);
+    EXPECT_EQ(8.0, c(3, 3));
+}
+
+TEST_F(GemmTest, emptyInnerDimensionScalesC)
+{
+    Matrix<float> a(3, 0, 0.0f);
+    Matrix<float> b(0, 2, 0.0f);
+    Matrix<float> c(3, 2, 4.0f);
+    gemm(1.0f, a, b, 0.5f, c);
+    EXPECT_EQ(2.0f, c(2, 1));
+}
+
+TEST_F(GemmTest, matchesReferenceOnEveryInstructionSet)
+{
+    for(simd::InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!simd::is_supported(instruction_set))
+        {
+            continue;
+        }
+        check_shapes<float>(instruction_set);
+        check_shapes<double>(instruction_set);
+        check_shapes<int32_t>(instruction_set);
+        check_shapes<int64_t>(instruction_set);
+    }
+}
+
+TEST_F(GemmTest, genericElementType)
+{
+    Matrix<short> a{{1, 2}, {3, 4}};
+    Matrix<short> b{{5, 6}, {7, 8}};
+    Matrix<short> product = a * b;
+    EXPECT_EQ(19, product(0, 0));
+    EXPECT_EQ(50, product(1, 1));
+
+    Matrix<short> scores(2, 2, short(0));
+    gemm_transposed_b(execution::automatic, 2, 2, 2, short(1), a.data(), 2, b.data(), 2, short(0), scores.data(), 2);
+    EXPECT_EQ(17, scores(0, 0));
+    EXPECT_EQ(53, scores(1, 1));
+}
+
+} // vctr
+} // arondina
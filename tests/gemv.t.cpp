@@ -0,0 +1,193 @@
+#include "gemv.h"
+
+// vctr
+#include "matrix.h"
+#include "simd.h"
+#include "test_helpers.h"
+#include "vector.h"
+
+// std
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+template<typename T>
+Vector<T> random_vector(size_t dimensions, std::mt19937& rng)
+{
+    Vector<T> v(dimensions);
+    std::uniform_int_distribution<int> dist(-8, 8);
+    for(size_t i = 0; i < dimensions; ++i)
+    {
+        v[i] = T(dist(rng));
+    }
+    return v;
+}
+
+/**
+ * @brief Small integer inputs keep every partial sum exact in float and double,
+ *        so all kernels must agree with the plain loops exactly.
+*/
+template<typename T>
+void check_shapes(simd::InstructionSet instruction_set)
+{
+    const size_t shapes[][2] = {{1, 1}, {3, 5}, {4, 16}, {5, 17}, {37, 63}, {64, 129}, {9, 4500}, {300, 33}};
+
+    std::mt19937 rng(11);
+    simd::set_instruction_set(instruction_set);
+    for(const auto& shape : shapes)
+    {
+        const size_t m = shape[0];
+        const size_t n = shape[1];
+        const Matrix<T> a = random_matrix<T>(m, n, rng, n + 3);
+        const Vector<T> x = random_vector<T>(n, rng);
+        const Vector<T> xt = random_vector<T>(m, rng);
+        const Vector<T> y0 = random_vector<T>(m, rng);
+        const Vector<T> yt0 = random_vector<T>(n, rng);
+
+        Vector<T> y(y0);
+        gemv(m, n, T(2), a.data(), a.leading_dimension(), x.data(), T(-1), y.data());
+        Vector<T> product = a * x;
+        for(size_t i = 0; i < m; ++i)
+        {
+            T dot = T(0);
+            for(size_t j = 0; j < n; ++j)
+            {
+                dot += a(i, j) * x[j];
+            }
+            ASSERT_EQ(T(2) * dot - y0[i], y[i]) << simd::to_string(instruction_set) << " " << m << "x" << n;
+            ASSERT_EQ(dot, product[i]) << simd::to_string(instruction_set) << " " << m << "x" << n;
+        }
+
+        Vector<T> yt(yt0);
+        gemv_transposed(m, n, T(3), a.data(), a.leading_dimension(), xt.data(), T(2), yt.data());
+        Vector<T> transposed_product = xt * a;
+        for(size_t j = 0; j < n; ++j)
+        {
+            T dot = T(0);
+            for(size_t i = 0; i < m; ++i)
+            {
+                dot += a(i, j) * xt[i];
+            }
+            ASSERT_EQ(T(3) * dot + T(2) * yt0[j], yt[j]) << simd::to_string(instruction_set) << " " << m << "x" << n;
+            ASSERT_EQ(dot, transposed_product[j]) << simd::to_string(instruction_set) << " " << m << "x" << n;
+        }
+    }
+}
+
+} // namespace
+
+class GemvTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        simd::set_instruction_set(simd::detected_instruction_set());
+        reset_calibration();
+    }
+};
+
+TEST_F(GemvTest, matrixTimesVector)
+{
+    Matrix<int> a{{1, 2, 3}, {4, 5, 6}};
+    Vector<int> x{1, 0, -1};
+    Vector<int> expected{-2, -2};
+    EXPECT_TRUE(expected == a * x);
+}
+
+TEST_F(GemvTest, vectorTimesMatrix)
+{
+    Matrix<int> a{{1, 2, 3}, {4, 5, 6}};
+    Vector<int> x{1, -1};
+    Vector<int> expected{-3, -3, -3};
+    EXPECT_TRUE(expected == x * a);
+}
+
+TEST_F(GemvTest, throwsMismatchedDimensions)
+{
+    Matrix<double> a(2, 3, 1.0);
+    Vector<double> x(2, 1.0);
+    Vector<double> xt(3, 1.0);
+
+    EXPECT_THROW({
+        try
+        {
+            Vector<double> y = a * xt;
+            y = a * x;
+        }
+        catch(const std::runtime_error& e)
+        {
+            EXPECT_STREQ("mismatched matrix dimensions.", e.what());
+            throw;
+        }
+    }
+    , std::runtime_error);
+    EXPECT_THROW(xt * a, std::runtime_error);
+}
+
+TEST_F(GemvTest, betaZeroIgnoresNaN)
+{
+    Matrix<double> a(3, 3, 1.0);
+    Vector<double> x(3, 1.0);
+    Vector<double> y(3, std::nan(""));
+    gemv(3, 3, 1.0, a.data(), a.leading_dimension(), x.data(), 0.0, y.data());
+    EXPECT_EQ(3.0, y[2]);
+
+    Vector<double> yt(3, std::nan(""));
+    gemv_transposed(3, 3, 1.0, a.data(), a.leading_dimension(), x.data(), 0.0, yt.data());
+    EXPECT_EQ(3.0, yt[0]);
+}
+
+TEST_F(GemvTest, matchesReferenceOnEveryInstructionSet)
+{
+    for(simd::InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!simd::is_supported(instruction_set))
+        {
+            continue;
+        }
+        check_shapes<float>(instruction_set);
+        check_shapes<double>(instruction_set);
+        check_shapes<int32_t>(instruction_set);
+        check_shapes<int64_t>(instruction_set);
+    }
+}
+
+TEST_F(GemvTest, parallelMatchesSequential)
+{
+    std::mt19937 rng(3);
+    const Matrix<double> a = random_matrix<double>(513, 700, rng);
+    const Vector<double> x = random_vector<double>(700, rng);
+    const Vector<double> xt = random_vector<double>(513, rng);
+
+    set_max_dimensions_for_sequential(Operation::DotProduct, ElementType::Double, std::numeric_limits<size_t>::max());
+    Vector<double> sequential = a * x;
+    Vector<double> sequential_transposed = xt * a;
+
+    set_max_dimensions_for_sequential(Operation::DotProduct, ElementType::Double, 0);
+    EXPECT_TRUE(sequential == a * x);
+    EXPECT_TRUE(sequential_transposed == xt * a);
+}
+
+TEST_F(GemvTest, genericElementType)
+{
+    Matrix<short> a{{1, 2}, {3, 4}};
+    Vector<short> x{1, 1};
+    Vector<short> expected{3, 7};
+    EXPECT_TRUE(expected == a * x);
+}
+
+} // vctr
+} // arondina
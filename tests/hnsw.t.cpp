@@ -0,0 +1,180 @@
+#include "hnsw.h"
+
+// vctr
+#include "knn.h"
+#include "matrix.h"
+#include "test_helpers.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+/**
+ * @brief Fraction of the exact neighbours of every query that the approximate
+ *        search also returned.
+*/
+double recall(const std::vector<std::vector<Neighbor<float>>>& exact, const std::vector<std::vector<Neighbor<float>>>& approximate)
+{
+    size_t hits = 0;
+    size_t total = 0;
+    for(size_t q = 0; q < exact.size(); ++q)
+    {
+        for(const Neighbor<float>& neighbor : exact[q])
+        {
+            hits += std::any_of(approximate[q].begin(), approximate[q].end(), [&neighbor](const Neighbor<float>& n) {
+                return n.index == neighbor.index;
+            });
+        }
+        total += exact[q].size();
+    }
+    return static_cast<double>(hits) / static_cast<double>(total);
+}
+
+} // namespace
+
+TEST(HnswTests, small)
+{
+    HnswIndex<float> index(2);
+    EXPECT_EQ(0, index.add(Vector<float>{0.0f, 0.0f}));
+    EXPECT_EQ(1, index.add(Vector<float>{3.0f, 4.0f}));
+    EXPECT_EQ(2, index.add(Vector<float>{1.0f, 1.0f}));
+    EXPECT_EQ(3, index.size());
+
+    // a graph this small is searched exhaustively
+    const std::vector<Neighbor<float>> neighbors = index.search(Vector<float>{1.0f, 0.0f}, 3);
+    ASSERT_EQ(3, neighbors.size());
+    EXPECT_EQ(0, neighbors[0].index);
+    EXPECT_EQ(1.0f, neighbors[0].score);
+    EXPECT_EQ(2, neighbors[1].index);
+    EXPECT_EQ(1.0f, neighbors[1].score);
+    EXPECT_EQ(1, neighbors[2].index);
+    EXPECT_EQ(20.0f, neighbors[2].score);
+
+    EXPECT_TRUE(index.search(Vector<float>{1.0f, 0.0f}, 0).empty());
+}
+
+TEST(HnswTests, emptyIndex)
+{
+    HnswIndex<float> index(4);
+    EXPECT_TRUE(index.search(Vector<float>(4, 1.0f), 3).empty());
+    EXPECT_EQ(0, index.add(Matrix<float>(0, 4, 0.0f)));
+    EXPECT_TRUE(index.search(Vector<float>(4, 1.0f), 3).empty());
+}
+
+TEST(HnswTests, recallAgainstExactSearch)
+{
+    std::mt19937 rng(3);
+    const Matrix<float> collection = random_rows<float>(3000, 16, rng);
+    const Matrix<float> queries = random_rows<float>(50, 16, rng);
+    ThreadPool pool(ThreadPoolOptions{4, false});
+
+    for(Metric metric : {Metric::SquaredL2, Metric::InnerProduct, Metric::Cosine})
+    {
+        KnnIndex<float> exact(16, metric);
+        exact.add(collection);
+        const std::vector<std::vector<Neighbor<float>>> expected = exact.search(queries, 10);
+
+        // built one row at a time, then as a parallel batch
+        HnswIndex<float> sequential(16, metric);
+        for(size_t i = 0; i < collection.num_rows(); ++i)
+        {
+            Vector<float> row(16);
+            for(size_t j = 0; j < 16; ++j)
+            {
+                row[j] = collection(i, j);
+            }
+            sequential.add(row);
+        }
+        HnswIndex<float> parallel(16, metric);
+        EXPECT_EQ(0, parallel.add(collection, execution::on(pool)));
+        ASSERT_EQ(3000, parallel.size());
+
+        for(const HnswIndex<float>* index : {&sequential, &parallel})
+        {
+            EXPECT_GT(recall(expected, index->search(queries, 10)), 0.9);
+            EXPECT_GT(recall(expected, index->search(queries, 10, execution::on(pool))), 0.9);
+        }
+    }
+}
+
+TEST(HnswTests, efSearchTradesSpeedForRecall)
+{
+    std::mt19937 rng(4);
+    const Matrix<float> collection = random_rows<float>(4000, 24, rng);
+    const Matrix<float> queries = random_rows<float>(40, 24, rng);
+
+    KnnIndex<float> exact(24);
+    exact.add(collection);
+    const std::vector<std::vector<Neighbor<float>>> expected = exact.search(queries, 10);
+
+    HnswOptions options;
+    options.M = 8;
+    options.efConstruction = 64;
+    HnswIndex<float> index(24, Metric::SquaredL2, options);
+    index.add(collection);
+
+    index.set_ef_search(10);
+    const double low = recall(expected, index.search(queries, 10));
+    index.set_ef_search(400);
+    const double high = recall(expected, index.search(queries, 10));
+    EXPECT_LE(low, high);
+    EXPECT_GT(high, 0.97);
+}
+
+TEST(HnswTests, resultsAreSortedAndScored)
+{
+    std::mt19937 rng(6);
+    const Matrix<float> collection = random_rows<float>(500, 8, rng);
+    HnswIndex<float> index(8);
+    index.add(collection);
+
+    Vector<float> query(8, 0.25f);
+    const std::vector<Neighbor<float>> neighbors = index.search(query, 20, 100);
+    ASSERT_EQ(20, neighbors.size());
+    for(size_t i = 0; i < neighbors.size(); ++i)
+    {
+        float expected = 0.0f;
+        for(size_t j = 0; j < 8; ++j)
+        {
+            const float difference = collection(neighbors[i].index, j) - query[j];
+            expected += difference * difference;
+        }
+        EXPECT_NEAR(expected, neighbors[i].score, 1e-5f);
+        if(i > 0)
+        {
+            EXPECT_LE(neighbors[i - 1].score, neighbors[i].score);
+        }
+    }
+}
+
+TEST(HnswTests, throwsOnBadArguments)
+{
+    EXPECT_THROW(HnswIndex<float>(0), std::runtime_error);
+    HnswOptions options;
+    options.M = 1;
+    EXPECT_THROW(HnswIndex<float>(4, Metric::SquaredL2, options), std::runtime_error);
+
+    HnswIndex<float> index(3);
+    EXPECT_THROW(index.add(Vector<float>(4, 1.0f)), std::runtime_error);
+    EXPECT_THROW(index.add(Matrix<float>(2, 2, 1.0f)), std::runtime_error);
+    EXPECT_THROW(index.search(Vector<float>(2, 1.0f), 1), std::runtime_error);
+    EXPECT_THROW(index.search(Matrix<float>(2, 4, 1.0f), 1), std::runtime_error);
+}
+
+} // vctr
+} // arondina
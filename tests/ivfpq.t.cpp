@@ -0,0 +1,216 @@
+#include "ivfpq.h"
+
+// vctr
+#include "knn.h"
+#include "matrix.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+/**
+ * @brief rows points of dimension cols in 20 gaussian clusters.
+*/
+Matrix<float> clustered_rows(size_t rows, size_t cols, std::mt19937& rng)
+{
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    Matrix<float> centers(20, cols, 0.0f);
+    for(size_t c = 0; c < 20; ++c)
+    {
+        for(size_t j = 0; j < cols; ++j)
+        {
+            centers(c, j) = 5.0f * noise(rng);
+        }
+    }
+
+    Matrix<float> m(rows, cols, 0.0f);
+    std::uniform_int_distribution<size_t> cluster(0, 19);
+    for(size_t i = 0; i < rows; ++i)
+    {
+        const size_t c = cluster(rng);
+        for(size_t j = 0; j < cols; ++j)
+        {
+            m(i, j) = centers(c, j) + noise(rng);
+        }
+    }
+    return m;
+}
+
+/**
+ * @brief count queries, each a row of collection plus unit noise, so they fall in
+ *        the same clusters.
+*/
+Matrix<float> perturbed_rows(const Matrix<float>& collection, size_t count, std::mt19937& rng)
+{
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::uniform_int_distribution<size_t> any_row(0, collection.num_rows() - 1);
+    Matrix<float> m(count, collection.num_cols(), 0.0f);
+    for(size_t i = 0; i < count; ++i)
+    {
+        const size_t source = any_row(rng);
+        for(size_t j = 0; j < collection.num_cols(); ++j)
+        {
+            m(i, j) = collection(source, j) + noise(rng);
+        }
+    }
+    return m;
+}
+
+Vector<float> row_of(const Matrix<float>& m, size_t i)
+{
+    Vector<float> v(m.num_cols());
+    std::copy(&m(i, 0), &m(i, 0) + m.num_cols(), v.data());
+    return v;
+}
+
+/**
+ * @brief Fraction of queries whose exact nearest neighbour is among the results.
+*/
+double recall_at(const std::vector<std::vector<Neighbor<float>>>& exact, const std::vector<std::vector<Neighbor<float>>>& approximate)
+{
+    size_t hits = 0;
+    for(size_t q = 0; q < exact.size(); ++q)
+    {
+        const size_t nearest = exact[q].front().index;
+        hits += std::any_of(approximate[q].begin(), approximate[q].end(), [nearest](const Neighbor<float>& n) {
+            return n.index == nearest;
+        });
+    }
+    return static_cast<double>(hits) / static_cast<double>(exact.size());
+}
+
+IvfPqOptions small_options()
+{
+    IvfPqOptions options;
+    options.numLists = 16;
+    options.numSubquantizers = 16;
+    options.numProbes = 4;
+    return options;
+}
+
+} // namespace
+
+TEST(IvfPqTests, recallAgainstExactSearch)
+{
+    std::mt19937 rng(8);
+    const Matrix<float> collection = clustered_rows(4000, 32, rng);
+    const Matrix<float> queries = perturbed_rows(collection, 100, rng);
+
+    KnnIndex<float> exact(32);
+    exact.add(collection);
+    const std::vector<std::vector<Neighbor<float>>> expected = exact.search(queries, 1);
+
+    IvfPqIndex<float> index(32, small_options());
+    EXPECT_FALSE(index.is_trained());
+    index.train(collection);
+    EXPECT_TRUE(index.is_trained());
+    EXPECT_EQ(0, index.add(collection));
+    EXPECT_EQ(4000, index.size());
+    EXPECT_EQ(8, index.code_size());
+
+    for(const ExecutionPolicy& policy : {execution::seq, execution::par_simd})
+    {
+        EXPECT_GT(recall_at(expected, index.search(queries, 10, policy)), 0.8);
+    }
+
+    // scanning every list finds at least as much as scanning a few
+    std::vector<std::vector<Neighbor<float>>> all_lists;
+    std::vector<std::vector<Neighbor<float>>> one_list;
+    for(size_t q = 0; q < queries.num_rows(); ++q)
+    {
+        all_lists.push_back(index.search(row_of(queries, q), 10, 16));
+        one_list.push_back(index.search(row_of(queries, q), 10, 1));
+    }
+    EXPECT_GE(recall_at(expected, all_lists), recall_at(expected, one_list));
+}
+
+TEST(IvfPqTests, scoresApproximateSquaredDistances)
+{
+    std::mt19937 rng(12);
+    const Matrix<float> collection = clustered_rows(2000, 16, rng);
+
+    IvfPqIndex<float> index(16, small_options());
+    index.train(collection);
+    index.add(collection);
+
+    const Vector<float> query = row_of(collection, 7);
+    const std::vector<Neighbor<float>> neighbors = index.search(query, 20, 16);
+    ASSERT_EQ(20, neighbors.size());
+    double error = 0.0;
+    double total = 0.0;
+    for(size_t i = 0; i < neighbors.size(); ++i)
+    {
+        float expected = 0.0f;
+        for(size_t j = 0; j < 16; ++j)
+        {
+            const float difference = collection(neighbors[i].index, j) - query[j];
+            expected += difference * difference;
+        }
+        error += std::abs(expected - neighbors[i].score);
+        total += expected;
+        if(i > 0)
+        {
+            EXPECT_LE(neighbors[i - 1].score, neighbors[i].score);
+        }
+    }
+    EXPECT_LT(error, 0.25 * total);
+}
+
+TEST(IvfPqTests, addOneAtATime)
+{
+    std::mt19937 rng(13);
+    const Matrix<float> collection = clustered_rows(500, 8, rng);
+
+    IvfPqOptions options = small_options();
+    options.numSubquantizers = 3;
+    EXPECT_THROW(IvfPqIndex<float>(8, options), std::runtime_error);
+
+    options.numSubquantizers = 8;
+    IvfPqIndex<float> index(8, options);
+    index.train(collection);
+    for(size_t i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(i, index.add(row_of(collection, i)));
+    }
+
+    // a vector filed once is its own best match
+    const std::vector<Neighbor<float>> neighbors = index.search(row_of(collection, 42), 5, 16);
+    ASSERT_EQ(5, neighbors.size());
+    EXPECT_TRUE(std::any_of(neighbors.begin(), neighbors.end(), [](const Neighbor<float>& n) { return n.index == 42; }));
+}
+
+TEST(IvfPqTests, throwsOnBadArguments)
+{
+    EXPECT_THROW(IvfPqIndex<float>(0), std::runtime_error);
+    EXPECT_THROW(IvfPqIndex<float>(30), std::runtime_error);
+
+    IvfPqIndex<float> index(16, small_options());
+    EXPECT_THROW(index.add(Matrix<float>(2, 16, 1.0f)), std::runtime_error);
+    EXPECT_THROW(index.train(Matrix<float>(10, 16, 1.0f)), std::runtime_error);
+    EXPECT_THROW(index.train(Matrix<float>(100, 8, 1.0f)), std::runtime_error);
+    EXPECT_TRUE(index.search(Vector<float>(16, 1.0f), 3).empty());
+
+    std::mt19937 rng(14);
+    const Matrix<float> collection = clustered_rows(200, 16, rng);
+    index.train(collection);
+    index.add(collection);
+    EXPECT_THROW(index.train(collection), std::runtime_error);
+    EXPECT_THROW(index.search(Vector<float>(8, 1.0f), 3), std::runtime_error);
+}
+
+} // vctr
+} // arondina
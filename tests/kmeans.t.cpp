@@ -0,0 +1,69 @@
+#include "kmeans.h"
+
+// vctr
+#include "matrix.h"
+
+// std
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+TEST(KMeansTests, findsSeparatedClusters)
+{
+    const double centers[3][2] = {{-10.0, 0.0}, {0.0, 10.0}, {10.0, 0.0}};
+    std::mt19937 rng(2);
+    std::normal_distribution<double> noise(0.0, 0.5);
+    Matrix<double> samples(300, 2, 0.0);
+    for(size_t i = 0; i < 300; ++i)
+    {
+        samples(i, 0) = centers[i % 3][0] + noise(rng);
+        samples(i, 1) = centers[i % 3][1] + noise(rng);
+    }
+
+    for(const ExecutionPolicy& policy : {execution::seq, execution::par_simd})
+    {
+        const Matrix<double> centroids = kmeans(samples, 3, KMeansOptions(), policy);
+        ASSERT_EQ(3, centroids.num_rows());
+        ASSERT_EQ(2, centroids.num_cols());
+
+        // every center has a centroid close by
+        for(const auto& center : centers)
+        {
+            double closest = 1e9;
+            for(size_t c = 0; c < 3; ++c)
+            {
+                closest = std::min(closest, std::hypot(centroids(c, 0) - center[0], centroids(c, 1) - center[1]));
+            }
+            EXPECT_LT(closest, 0.5);
+        }
+    }
+}
+
+TEST(KMeansTests, asManyCentroidsAsSamples)
+{
+    Matrix<float> samples{{1.0f, 2.0f}, {3.0f, 4.0f}, {5.0f, 6.0f}};
+    const Matrix<float> centroids = kmeans(samples, 3);
+    float total = 0.0f;
+    for(size_t c = 0; c < 3; ++c)
+    {
+        total += centroids(c, 0) + centroids(c, 1);
+    }
+    EXPECT_EQ(21.0f, total);
+}
+
+TEST(KMeansTests, throwsWithTooFewSamples)
+{
+    EXPECT_THROW(kmeans(Matrix<float>(3, 2, 0.0f), 4), std::runtime_error);
+    EXPECT_THROW(kmeans(Matrix<float>(3, 2, 0.0f), 0), std::runtime_error);
+}
+
+} // vctr
+} // arondina
@@ -0,0 +1,205 @@
+#include "knn.h"
+
+// vctr
+#include "matrix.h"
+#include "test_helpers.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+/**
+ * @brief The k best rows of collection for the query in row q of queries, scored
+ *        directly rather than through dot products.
+*/
+std::vector<Neighbor<double>> reference_knn(const Matrix<double>& collection, const Matrix<double>& queries, size_t q, size_t k, Metric metric)
+{
+    std::vector<std::pair<double, size_t>> keyed;
+    double query_norm = 0.0;
+    for(size_t j = 0; j < queries.num_cols(); ++j)
+    {
+        query_norm += queries(q, j) * queries(q, j);
+    }
+    for(size_t i = 0; i < collection.num_rows(); ++i)
+    {
+        double squared_distance = 0.0;
+        double dot = 0.0;
+        double norm = 0.0;
+        for(size_t j = 0; j < collection.num_cols(); ++j)
+        {
+            const double difference = collection(i, j) - queries(q, j);
+            squared_distance += difference * difference;
+            dot += collection(i, j) * queries(q, j);
+            norm += collection(i, j) * collection(i, j);
+        }
+        switch(metric)
+        {
+            case Metric::SquaredL2:
+                keyed.emplace_back(squared_distance, i);
+                break;
+            case Metric::InnerProduct:
+                keyed.emplace_back(-dot, i);
+                break;
+            case Metric::Cosine:
+                keyed.emplace_back(-dot / (std::sqrt(norm) * std::sqrt(query_norm)), i);
+                break;
+        }
+    }
+
+    std::sort(keyed.begin(), keyed.end());
+    std::vector<Neighbor<double>> result;
+    for(size_t i = 0; i < std::min(k, keyed.size()); ++i)
+    {
+        const double score = metric == Metric::SquaredL2 ? keyed[i].first : -keyed[i].first;
+        result.push_back({keyed[i].second, score});
+    }
+    return result;
+}
+
+void expect_neighbors(const std::vector<Neighbor<double>>& expected, const std::vector<Neighbor<double>>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for(size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(expected[i].index, actual[i].index) << "rank " << i;
+        EXPECT_NEAR(expected[i].score, actual[i].score, 1e-9) << "rank " << i;
+    }
+}
+
+} // namespace
+
+TEST(KnnTests, small)
+{
+    KnnIndex<float> index(2);
+    EXPECT_EQ(0, index.add(Vector<float>{0.0f, 0.0f}));
+    EXPECT_EQ(1, index.add(Vector<float>{3.0f, 4.0f}));
+    EXPECT_EQ(2, index.add(Vector<float>{1.0f, 1.0f}));
+    EXPECT_EQ(3, index.size());
+
+    const std::vector<Neighbor<float>> neighbors = index.search(Vector<float>{1.0f, 0.0f}, 2);
+    ASSERT_EQ(2, neighbors.size());
+    EXPECT_EQ(0, neighbors[0].index);
+    EXPECT_EQ(1.0f, neighbors[0].score);
+    EXPECT_EQ(2, neighbors[1].index);
+    EXPECT_EQ(1.0f, neighbors[1].score);
+
+    // k beyond the collection returns all of it
+    EXPECT_EQ(3, index.search(Vector<float>{1.0f, 0.0f}, 10).size());
+    EXPECT_TRUE(index.search(Vector<float>{1.0f, 0.0f}, 0).empty());
+}
+
+TEST(KnnTests, emptyIndex)
+{
+    KnnIndex<double> index(4);
+    EXPECT_TRUE(index.search(Vector<double>(4, 1.0), 3).empty());
+    EXPECT_TRUE(index.search(Vector<double>(4, 1.0), 3, execution::par).empty());
+
+    const std::vector<std::vector<Neighbor<double>>> batch = index.search(Matrix<double>(2, 4, 1.0), 3);
+    ASSERT_EQ(2, batch.size());
+    EXPECT_TRUE(batch[0].empty());
+    EXPECT_TRUE(batch[1].empty());
+}
+
+TEST(KnnTests, matchesReference)
+{
+    std::mt19937 rng(5);
+    const Matrix<double> collection = random_rows<double>(1500, 37, rng);
+    const Matrix<double> queries = random_rows<double>(3, 37, rng);
+
+    for(Metric metric : {Metric::SquaredL2, Metric::InnerProduct, Metric::Cosine})
+    {
+        KnnIndex<double> index(37, metric);
+        index.add(collection);
+        ASSERT_EQ(1500, index.size());
+
+        for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd})
+        {
+            for(size_t q = 0; q < queries.num_rows(); ++q)
+            {
+                Vector<double> query(37);
+                for(size_t j = 0; j < 37; ++j)
+                {
+                    query[j] = queries(q, j);
+                }
+                expect_neighbors(reference_knn(collection, queries, q, 10, metric), index.search(query, 10, policy));
+            }
+        }
+    }
+}
+
+TEST(KnnTests, batchMatchesReference)
+{
+    std::mt19937 rng(9);
+    const Matrix<double> collection = random_rows<double>(1100, 20, rng);
+
+    // below and above the switch to gemm_transposed_b
+    for(size_t num_queries : {size_t(5), DotProductBatchConstants::minQueriesForGemm + 3})
+    {
+        const Matrix<double> queries = random_rows<double>(num_queries, 20, rng);
+        for(Metric metric : {Metric::SquaredL2, Metric::InnerProduct, Metric::Cosine})
+        {
+            KnnIndex<double> index(20, metric);
+            index.add(collection);
+
+            for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd})
+            {
+                const std::vector<std::vector<Neighbor<double>>> results = index.search(queries, 7, policy);
+                ASSERT_EQ(num_queries, results.size());
+                for(size_t q = 0; q < num_queries; ++q)
+                {
+                    expect_neighbors(reference_knn(collection, queries, q, 7, metric), results[q]);
+                }
+            }
+        }
+    }
+}
+
+TEST(KnnTests, tiesGoToSmallerIndex)
+{
+    // every row is the same distance from the query, so only the tie-break decides
+    KnnIndex<float> index(3);
+    for(size_t i = 0; i < 2000; ++i)
+    {
+        index.add(Vector<float>(3, i % 2 == 0 ? 1.0f : -1.0f));
+    }
+
+    for(const ExecutionPolicy& policy : {execution::seq, execution::par})
+    {
+        const std::vector<Neighbor<float>> neighbors = index.search(Vector<float>(3, 0.0f), 5, policy);
+        ASSERT_EQ(5, neighbors.size());
+        for(size_t i = 0; i < 5; ++i)
+        {
+            EXPECT_EQ(i, neighbors[i].index);
+        }
+    }
+}
+
+TEST(KnnTests, throwsOnMismatchedDimensions)
+{
+    EXPECT_THROW(KnnIndex<float>(0), std::runtime_error);
+
+    KnnIndex<float> index(3);
+    EXPECT_THROW(index.add(Vector<float>(4, 1.0f)), std::runtime_error);
+    EXPECT_THROW(index.add(Matrix<float>(2, 2, 1.0f)), std::runtime_error);
+    EXPECT_THROW(index.search(Vector<float>(2, 1.0f), 1), std::runtime_error);
+    EXPECT_THROW(index.search(Matrix<float>(2, 4, 1.0f), 1), std::runtime_error);
+}
+
+} // vctr
+} // arondina
@@ -0,0 +1,334 @@
+#include "matrix.h"
+
+// vctr
+#include "vector.h"
+
+// std
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+template<typename T>
+bool is_aligned(const T* ptr)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % MatrixConstants::alignment == 0;
+}
+
+} // namespace
+
+TEST(MatrixTests, constructDefaultValue)
+{
+    Matrix<int> m(3, 4, 7);
+    EXPECT_EQ(3, m.num_rows());
+    EXPECT_EQ(4, m.num_cols());
+    EXPECT_EQ(4, m.leading_dimension());
+    for(size_t i = 0; i < 3; ++i)
+    {
+        for(size_t j = 0; j < 4; ++j)
+        {
+            EXPECT_EQ(7, m(i, j));
+        }
+    }
+}
+
+TEST(MatrixTests, constructInitList)
+{
+    Matrix<int> m{{1, 2, 3}, {4, 5, 6}};
+    EXPECT_EQ(2, m.num_rows());
+    EXPECT_EQ(3, m.num_cols());
+    EXPECT_EQ(1, m(0, 0));
+    EXPECT_EQ(3, m(0, 2));
+    EXPECT_EQ(4, m(1, 0));
+    EXPECT_EQ(6, m(1, 2));
+}
+
+TEST(MatrixTests, constructInitListThrowsMismatchedColumns)
+{
+    EXPECT_THROW({
+        try
+        {
+            Matrix<int> m({{1, 2, 3}, {4, 5}});
+        }
+        catch(const std::runtime_error& e)
+        {
+            EXPECT_STREQ("Invalid column size.", e.what());
+            throw;
+        }
+    }
+    , std::runtime_error);
+}
+
+TEST(MatrixTests, constructVectors)
+{
+    Vector<double> v1{1.0, 2.0};
+    Vector<double> v2{3.0, 4.0};
+    Vector<double> v3{5.0, 6.0};
+    Matrix<double> m{v1, v2, v3};
+    EXPECT_EQ(3, m.num_rows());
+    EXPECT_EQ(2, m.num_cols());
+    EXPECT_EQ(2.0, m(0, 1));
+    EXPECT_EQ(5.0, m(2, 0));
+}
+
+TEST(MatrixTests, constructVectorsThrowsMismatchedColumns)
+{
+    Vector<double> v1{1.0, 2.0};
+    Vector<double> v2{3.0};
+    EXPECT_THROW((Matrix<double>{v1, v2}), std::runtime_error);
+}
+
+TEST(MatrixTests, storageIsContiguousRowMajor)
+{
+    Matrix<float> m{{1, 2, 3}, {4, 5, 6}};
+    const float* data = m.data();
+    for(int i = 0; i < 6; ++i)
+    {
+        EXPECT_EQ(float(i + 1), data[i]);
+    }
+    EXPECT_TRUE(is_aligned(data));
+}
+
+TEST(MatrixTests, leadingDimension)
+{
+    Matrix<double> m(3, 5, 2.0, 8);
+    EXPECT_EQ(8, m.leading_dimension());
+    EXPECT_TRUE(is_aligned(m.data()));
+
+    m(1, 4) = 9.0;
+    EXPECT_EQ(9.0, m.data()[1 * 8 + 4]);
+    EXPECT_EQ(0.0, m.data()[1 * 8 + 5]); // padding
+
+    EXPECT_THROW(Matrix<double>(3, 5, 2.0, 4), std::runtime_error);
+}
+
+TEST(MatrixTests, copyConstructor)
+{
+    Matrix<int> m1(4, 3, 1, 16);
+    m1(3, 2) = 5;
+    Matrix<int> m2(m1);
+
+    EXPECT_EQ(4, m2.num_rows());
+    EXPECT_EQ(3, m2.num_cols());
+    EXPECT_EQ(16, m2.leading_dimension());
+    EXPECT_EQ(5, m2(3, 2));
+    EXPECT_NE(m1.data(), m2.data());
+    EXPECT_TRUE(is_aligned(m2.data()));
+
+    m2(0, 0) = 8;
+    EXPECT_EQ(1, m1(0, 0));
+}
+
+TEST(MatrixTests, moveConstructor)
+{
+    Matrix<int> m1(4, 3, 1);
+    const int* data = m1.data();
+    Matrix<int> m2(std::move(m1));
+
+    EXPECT_EQ(data, m2.data());
+    EXPECT_EQ(0, m1.num_rows());
+    EXPECT_EQ(nullptr, m1.data());
+}
+
+TEST(MatrixTests, assignment)
+{
+    Matrix<int> m1{{1, 2}, {3, 4}};
+    Matrix<int> m2(5, 5, 0);
+    m2 = m1;
+
+    EXPECT_EQ(2, m2.num_rows());
+    EXPECT_EQ(2, m2.num_cols());
+    EXPECT_EQ(4, m2(1, 1));
+
+    m2 = m2;
+    EXPECT_EQ(4, m2(1, 1));
+}
+
+TEST(MatrixTests, moveAssignment)
+{
+    Matrix<int> m1{{1, 2}, {3, 4}};
+    Matrix<int> m2(5, 5, 0);
+    m2 = std::move(m1);
+
+    EXPECT_EQ(2, m2.num_rows());
+    EXPECT_EQ(3, m2(1, 0));
+    EXPECT_EQ(0, m1.num_rows());
+}
+
+TEST(MatrixTests, emptyMatrix)
+{
+    Matrix<int> m(0, 0, 0);
+    EXPECT_EQ(0, m.num_rows());
+    EXPECT_EQ(nullptr, m.data());
+    Matrix<int> copy(m);
+    EXPECT_EQ(0, copy.num_rows());
+}
+
+TEST(MatrixTests, normalizeRows)
+{
+    for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd})
+    {
+        // padded rows, a zero row, and enough rows to split across threads
+        Matrix<float> m(1000, 37, 0.0f, 40);
+        for(size_t i = 0; i < m.num_rows(); ++i)
+        {
+            for(size_t j = 0; j < m.num_cols(); ++j)
+            {
+                m(i, j) = i == 3 ? 0.0f : static_cast<float>((i + 1) * (j % 5) + 1);
+            }
+            for(size_t j = m.num_cols(); j < m.leading_dimension(); ++j)
+            {
+                m.data()[i * m.leading_dimension() + j] = 7.0f;
+            }
+        }
+
+        normalize_rows(m, policy);
+
+        for(size_t i = 0; i < m.num_rows(); ++i)
+        {
+            double sum_squares = 0.0;
+            for(size_t j = 0; j < m.num_cols(); ++j)
+            {
+                sum_squares += static_cast<double>(m(i, j)) * m(i, j);
+            }
+            EXPECT_NEAR(i == 3 ? 0.0 : 1.0, sum_squares, 1e-5) << "row " << i;
+            EXPECT_EQ(7.0f, m.data()[i * m.leading_dimension() + m.num_cols()]);
+        }
+    }
+}
+
+TEST(MatrixTests, normalizeRowsMatchesVectorNormalize)
+{
+    Matrix<double> m{{3e200, 4e200}, {1.0, 2.0}};
+    normalize_rows(m);
+
+    Vector<double> v{1.0, 2.0};
+    v.normalize();
+
+    EXPECT_DOUBLE_EQ(0.6, m(0, 0));
+    EXPECT_DOUBLE_EQ(0.8, m(0, 1));
+    EXPECT_EQ(v[0], m(1, 0));
+    EXPECT_EQ(v[1], m(1, 1));
+}
+
+TEST(MatrixTests, normalizeRowsSubnormal)
+{
+    for(const ExecutionPolicy& policy : {execution::seq, execution::simd})
+    {
+        Matrix<double> m{{3e-320, 4e-320}, {1e-320, 1e-320}};
+        normalize_rows(m, policy);
+
+        EXPECT_NEAR(0.6, m(0, 0), 1e-3);
+        EXPECT_NEAR(0.8, m(0, 1), 1e-3);
+        EXPECT_NEAR(1.0 / std::sqrt(2.0), m(1, 1), 1e-3);
+    }
+}
+
+TEST(MatrixTests, dotProductBatchOneToMany)
+{
+    // padded rows, and enough of them to split across threads
+    Matrix<int32_t> candidates(1000, 37, 0, 40);
+    Vector<int32_t> query(37);
+    for(size_t j = 0; j < query.dimensions(); ++j)
+    {
+        query[j] = static_cast<int32_t>(j % 7) - 3;
+    }
+    for(size_t i = 0; i < candidates.num_rows(); ++i)
+    {
+        for(size_t j = 0; j < candidates.num_cols(); ++j)
+        {
+            candidates(i, j) = static_cast<int32_t>((i + j) % 11) - 5;
+        }
+    }
+
+    for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd})
+    {
+        Vector<int32_t> scores(candidates.num_rows(), -1);
+        dot_product_batch(policy, query, candidates, scores);
+        for(size_t i = 0; i < candidates.num_rows(); ++i)
+        {
+            Vector<int32_t> row(candidates.num_cols());
+            for(size_t j = 0; j < candidates.num_cols(); ++j)
+            {
+                row[j] = candidates(i, j);
+            }
+            ASSERT_EQ(dot_product(row, query), scores[i]) << "row " << i;
+        }
+    }
+
+    Vector<double> q{1.0, 2.0};
+    Matrix<double> c{{3.0, 4.0}, {-1.0, 0.5}, {0.0, 0.0}};
+    Vector<double> out(3);
+    dot_product_batch(q, c, out);
+    EXPECT_EQ(11.0, out[0]);
+    EXPECT_EQ(0.0, out[1]);
+    EXPECT_EQ(0.0, out[2]);
+
+    Vector<double> wrong_size(2);
+    EXPECT_THROW(dot_product_batch(q, c, wrong_size), std::runtime_error);
+    Vector<double> wrong_query{1.0, 2.0, 3.0};
+    EXPECT_THROW(dot_product_batch(wrong_query, c, out), std::runtime_error);
+}
+
+TEST(MatrixTests, dotProductBatchManyToMany)
+{
+    Matrix<float> candidates(700, 33, 0.0f);
+    for(size_t i = 0; i < candidates.num_rows(); ++i)
+    {
+        for(size_t j = 0; j < candidates.num_cols(); ++j)
+        {
+            candidates(i, j) = static_cast<float>((i + 2 * j) % 9) - 4.0f;
+        }
+    }
+
+    // below and above the switch to gemm_transposed_b
+    for(size_t num_queries : {size_t(9), DotProductBatchConstants::minQueriesForGemm + 3})
+    {
+        Matrix<float> queries(num_queries, 33, 0.0f, 48);
+        for(size_t i = 0; i < queries.num_rows(); ++i)
+        {
+            for(size_t j = 0; j < queries.num_cols(); ++j)
+            {
+                queries(i, j) = static_cast<float>((i * 3 + j) % 5) - 2.0f;
+            }
+        }
+
+        for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd})
+        {
+            Matrix<float> scores(num_queries, candidates.num_rows(), 0.0f, 704);
+            dot_product_batch(policy, queries, candidates, scores);
+            for(size_t i = 0; i < num_queries; ++i)
+            {
+                for(size_t j = 0; j < candidates.num_rows(); ++j)
+                {
+                    // small integers, so every partial sum is exact
+                    float expected = 0.0f;
+                    for(size_t p = 0; p < queries.num_cols(); ++p)
+                    {
+                        expected += queries(i, p) * candidates(j, p);
+                    }
+                    ASSERT_EQ(expected, scores(i, j)) << i << ", " << j;
+                }
+            }
+        }
+    }
+
+    Matrix<float> queries(9, 33, 0.0f);
+    Matrix<float> wrong_size(9, 699, 0.0f);
+    EXPECT_THROW(dot_product_batch(queries, candidates, wrong_size), std::runtime_error);
+    Matrix<float> square(3, 3, 1.0f);
+    EXPECT_THROW(dot_product_batch(square, square, square), std::runtime_error);
+}
+
+} // vctr
+} // arondina
@@ -0,0 +1,214 @@
+#include "quantized.h"
+
+// vctr
+#include "float16.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+namespace
+{
+
+Vector<float> random_vector(size_t n, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    Vector<float> v(n);
+    for(size_t i = 0; i < n; ++i)
+    {
+        v[i] = dist(rng);
+    }
+    return v;
+}
+
+/**
+ * @brief Dot product and squared distance of the dequantized values, in double.
+*/
+template<typename E>
+std::pair<double, double> reference(const QuantizedVector<E>& a, const QuantizedVector<E>& b)
+{
+    const Vector<float> x = a.dequantize();
+    const Vector<float> y = b.dequantize();
+    double dot = 0.0;
+    double squared_distance = 0.0;
+    for(size_t i = 0; i < x.dimensions(); ++i)
+    {
+        dot += static_cast<double>(x[i]) * y[i];
+        squared_distance += (static_cast<double>(x[i]) - y[i]) * (static_cast<double>(x[i]) - y[i]);
+    }
+    return {dot, squared_distance};
+}
+
+template<typename E>
+void expect_matches_reference(const Vector<float>& x, const Vector<float>& y)
+{
+    const QuantizedVector<E> a(x);
+    const QuantizedVector<E> b(y);
+    const std::pair<double, double> expected = reference(a, b);
+    const double n = static_cast<double>(x.dimensions());
+    for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd})
+    {
+        EXPECT_NEAR(expected.first, dot_product(policy, a, b), 1e-5 * n) << " n=" << n;
+        EXPECT_NEAR(expected.second, squared_l2_distance(policy, a, b), 1e-4 * n) << " n=" << n;
+    }
+}
+
+} // namespace
+
+TEST(QuantizedTests, float16Conversion)
+{
+    EXPECT_EQ(0x3C00, Float16::from_float(1.0f).bits);
+    EXPECT_EQ(0x3800, Float16::from_float(0.5f).bits);
+    EXPECT_EQ(0xC000, Float16::from_float(-2.0f).bits);
+    EXPECT_EQ(0x8000, Float16::from_float(-0.0f).bits);
+    EXPECT_EQ(0x7BFF, Float16::from_float(65504.0f).bits);
+    EXPECT_EQ(0x7BFF, Float16::from_float(65519.0f).bits);
+    EXPECT_EQ(0x7C00, Float16::from_float(65520.0f).bits);
+    EXPECT_EQ(0xFC00, Float16::from_float(-std::numeric_limits<float>::infinity()).bits);
+    EXPECT_TRUE(std::isnan(Float16::from_float(std::numeric_limits<float>::quiet_NaN()).to_float()));
+
+    // ties to even, in the normal and the subnormal range
+    EXPECT_EQ(0x3C00, Float16::from_float(1.0f + std::ldexp(1.0f, -11)).bits);
+    EXPECT_EQ(0x3C02, Float16::from_float(1.0f + 3.0f * std::ldexp(1.0f, -11)).bits);
+    EXPECT_EQ(0x0400, Float16::from_float(std::ldexp(1.0f, -14)).bits);
+    EXPECT_EQ(0x0001, Float16::from_float(std::ldexp(1.0f, -24)).bits);
+    EXPECT_EQ(0x0000, Float16::from_float(std::ldexp(1.0f, -25)).bits);
+    EXPECT_EQ(0x0002, Float16::from_float(3.0f * std::ldexp(1.0f, -25)).bits);
+
+    // every value survives a round trip through float
+    for(uint32_t bits = 0; bits < 0x10000; ++bits)
+    {
+        const Float16 value{static_cast<uint16_t>(bits)};
+        if(!std::isnan(value.to_float()))
+        {
+            EXPECT_EQ(bits, Float16::from_float(value.to_float()).bits);
+        }
+    }
+}
+
+TEST(QuantizedTests, bfloat16Conversion)
+{
+    EXPECT_EQ(0x3F80, BFloat16::from_float(1.0f).bits);
+    EXPECT_EQ(0xC000, BFloat16::from_float(-2.0f).bits);
+    EXPECT_EQ(0x3F80, BFloat16::from_float(1.0f + std::ldexp(1.0f, -8)).bits);
+    EXPECT_EQ(0x3F82, BFloat16::from_float(1.0f + 3.0f * std::ldexp(1.0f, -8)).bits);
+    EXPECT_EQ(0x7F80, BFloat16::from_float(std::numeric_limits<float>::max()).bits);
+    EXPECT_TRUE(std::isnan(BFloat16::from_float(std::numeric_limits<float>::quiet_NaN()).to_float()));
+
+    for(uint32_t bits = 0; bits < 0x10000; ++bits)
+    {
+        const BFloat16 value{static_cast<uint16_t>(bits)};
+        if(!std::isnan(value.to_float()))
+        {
+            EXPECT_EQ(bits, BFloat16::from_float(value.to_float()).bits);
+        }
+    }
+}
+
+TEST(QuantizedTests, int8Quantization)
+{
+    std::mt19937 rng(3);
+    const Vector<float> x = random_vector(300, rng);
+    const Int8Vector q(x);
+    EXPECT_EQ(300, q.dimensions());
+    EXPECT_EQ(300, q.bytes());
+
+    float largest = 0.0f;
+    for(size_t i = 0; i < x.dimensions(); ++i)
+    {
+        largest = std::max(largest, std::abs(x[i]));
+    }
+    EXPECT_FLOAT_EQ(largest / 127.0f, q.scale());
+
+    const Vector<float> restored = q.dequantize();
+    double squared_norm = 0.0;
+    for(size_t i = 0; i < x.dimensions(); ++i)
+    {
+        EXPECT_LE(std::abs(q.data()[i]), 127);
+        EXPECT_LE(std::abs(restored[i] - x[i]), 0.5f * q.scale() * 1.0001f);
+        squared_norm += static_cast<double>(restored[i]) * restored[i];
+    }
+    EXPECT_NEAR(squared_norm, q.squared_norm(), 1e-9 * squared_norm);
+
+    const Int8Vector zero(Vector<double>(5, 0.0));
+    EXPECT_EQ(0.0f, zero.scale());
+    EXPECT_EQ(0.0f, zero.dequantize()[4]);
+    EXPECT_EQ(0.0f, dot_product(zero, zero));
+}
+
+TEST(QuantizedTests, halfFloatStorage)
+{
+    const Vector<double> x{1.0, -0.333, 70000.0};
+    const Float16Vector f16(x);
+    const BFloat16Vector bf16(x);
+    EXPECT_EQ(6, f16.bytes());
+    EXPECT_EQ(6, bf16.bytes());
+    EXPECT_EQ(1.0f, f16.scale());
+
+    EXPECT_EQ(1.0f, f16.dequantize()[0]);
+    EXPECT_NEAR(-0.333f, f16.dequantize()[1], 1e-3f);
+    EXPECT_TRUE(std::isinf(f16.dequantize()[2]));
+    EXPECT_NEAR(-0.333f, bf16.dequantize()[1], 2e-3f);
+    EXPECT_NEAR(70000.0f, bf16.dequantize()[2], 300.0f);
+}
+
+TEST(QuantizedTests, dotAndDistanceMatchDequantized)
+{
+    std::mt19937 rng(7);
+    for(size_t n : {size_t(1), size_t(31), size_t(1000), size_t(70000)})
+    {
+        const Vector<float> x = random_vector(n, rng);
+        const Vector<float> y = random_vector(n, rng);
+        expect_matches_reference<int8_t>(x, y);
+        expect_matches_reference<Float16>(x, y);
+        expect_matches_reference<BFloat16>(x, y);
+    }
+}
+
+TEST(QuantizedTests, closeToFullPrecision)
+{
+    std::mt19937 rng(11);
+    const Vector<float> x = random_vector(768, rng);
+    const Vector<float> y = random_vector(768, rng);
+
+    double dot = 0.0;
+    double squared_distance = 0.0;
+    for(size_t i = 0; i < x.dimensions(); ++i)
+    {
+        dot += static_cast<double>(x[i]) * y[i];
+        squared_distance += (static_cast<double>(x[i]) - y[i]) * (static_cast<double>(x[i]) - y[i]);
+    }
+
+    EXPECT_NEAR(dot, dot_product(Float16Vector(x), Float16Vector(y)), 1e-2);
+    EXPECT_NEAR(dot, dot_product(BFloat16Vector(x), BFloat16Vector(y)), 1e-1);
+    EXPECT_NEAR(dot, dot_product(Int8Vector(x), Int8Vector(y)), 1e-1);
+    EXPECT_NEAR(squared_distance, squared_l2_distance(Float16Vector(x), Float16Vector(y)), 1e-2 * squared_distance);
+    EXPECT_NEAR(squared_distance, squared_l2_distance(BFloat16Vector(x), BFloat16Vector(y)), 1e-2 * squared_distance);
+    EXPECT_NEAR(squared_distance, squared_l2_distance(Int8Vector(x), Int8Vector(y)), 1e-2 * squared_distance);
+}
+
+TEST(QuantizedTests, throwsOnMismatchedDimensions)
+{
+    EXPECT_THROW(dot_product(Int8Vector(Vector<float>(3, 1.0f)), Int8Vector(Vector<float>(4, 1.0f))), std::runtime_error);
+    EXPECT_THROW(dot_product(Float16Vector(Vector<float>(3, 1.0f)), Float16Vector(Vector<float>(4, 1.0f))), std::runtime_error);
+    EXPECT_THROW(squared_l2_distance(Int8Vector(Vector<float>(3, 1.0f)), Int8Vector(Vector<float>(4, 1.0f))), std::runtime_error);
+    EXPECT_THROW(squared_l2_distance(BFloat16Vector(Vector<float>(3, 1.0f)), BFloat16Vector(Vector<float>(4, 1.0f))), std::runtime_error);
+}
+
+} // vctr
+} // arondina
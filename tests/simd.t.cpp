@@ -0,0 +1,599 @@
+#include "simd.h"
+
+// vctr
+#include "test_helpers.h"
+#include "vector.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+namespace simd
+{
+
+namespace
+{
+
+// Covers empty input, partial registers, whole registers plus every tail length.
+const size_t testSizes[] = {0, 1, 3, 7, 8, 15, 16, 17, 31, 33, 63, 64, 65, 127, 1000, 1031};
+
+template<typename T>
+std::vector<T> random_values(size_t n, std::mt19937& rng)
+{
+    std::vector<T> values(n);
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        std::uniform_real_distribution<T> dist(-1000, 1000);
+        for(T& value : values) { value = dist(rng); }
+    }
+    else
+    {
+        // Keeps products with the test scalars inside the range of T.
+        std::uniform_int_distribution<T> dist(std::numeric_limits<T>::min() / 8, std::numeric_limits<T>::max() / 8);
+        for(T& value : values) { value = dist(rng); }
+    }
+    return values;
+}
+
+/**
+ * @brief Like random_values, but integers are bounded by sqrt(max / n) so that a dot
+ *        product of n of them cannot overflow T.
+*/
+template<typename T>
+std::vector<T> random_dot_values(size_t n, std::mt19937& rng)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        return random_values<T>(n, rng);
+    }
+    else
+    {
+        const T bound = static_cast<T>(std::sqrt(static_cast<double>(std::numeric_limits<T>::max()) / std::max<size_t>(n, 1)));
+        std::uniform_int_distribution<T> dist(-bound, bound);
+        std::vector<T> values(n);
+        for(T& value : values) { value = dist(rng); }
+        return values;
+    }
+}
+
+template<typename T>
+bool bitwise_equal(const std::vector<T>& lhs, const std::vector<T>& rhs)
+{
+    if(lhs.size() != rhs.size())
+    {
+        return false;
+    }
+    // data() may be null for an empty vector, which memcmp does not allow
+    return lhs.empty() || std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(T)) == 0;
+}
+
+/**
+ * @brief Runs every element-wise kernel under instruction_set and under the scalar
+ *        table and requires bitwise identical output.
+*/
+template<typename T>
+void expect_matches_scalar(InstructionSet instruction_set)
+{
+    std::mt19937 rng(42);
+    for(size_t n : testSizes)
+    {
+        const std::vector<T> a = random_values<T>(n, rng);
+        const std::vector<T> b = random_values<T>(n, rng);
+        const std::vector<T> dot_a = random_dot_values<T>(n, rng);
+        const std::vector<T> dot_b = random_dot_values<T>(n, rng);
+
+        std::vector<T> expected_sum(n), expected_difference(n), actual_sum(n), actual_difference(n);
+        std::vector<T> expected_scaled(a), actual_scaled(a);
+
+        set_instruction_set(InstructionSet::Scalar);
+        add(a.data(), b.data(), expected_sum.data(), n);
+        subtract(a.data(), b.data(), expected_difference.data(), n);
+        scale(expected_scaled.data(), -3.75, n);
+        const std::vector<T> expected_dot{dot_reproducible(dot_a.data(), dot_b.data(), n)};
+
+        set_instruction_set(instruction_set);
+        add(a.data(), b.data(), actual_sum.data(), n);
+        subtract(a.data(), b.data(), actual_difference.data(), n);
+        scale(actual_scaled.data(), -3.75, n);
+        const std::vector<T> actual_dot{dot_reproducible(dot_a.data(), dot_b.data(), n)};
+
+        EXPECT_TRUE(bitwise_equal(expected_sum, actual_sum)) << to_string(instruction_set) << " n=" << n;
+        EXPECT_TRUE(bitwise_equal(expected_dot, actual_dot)) << to_string(instruction_set) << " n=" << n;
+        EXPECT_TRUE(bitwise_equal(expected_difference, actual_difference)) << to_string(instruction_set) << " n=" << n;
+        EXPECT_TRUE(bitwise_equal(expected_scaled, actual_scaled)) << to_string(instruction_set) << " n=" << n;
+    }
+}
+
+} // namespace
+
+class SimdTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        set_instruction_set(detected_instruction_set());
+    }
+};
+
+TEST_F(SimdTest, detectedIsSupported)
+{
+    EXPECT_TRUE(is_supported(InstructionSet::Scalar));
+    EXPECT_TRUE(is_supported(detected_instruction_set()));
+    EXPECT_EQ(detected_instruction_set(), active_instruction_set());
+}
+
+TEST_F(SimdTest, setInstructionSet)
+{
+    set_instruction_set(InstructionSet::Scalar);
+    EXPECT_EQ(InstructionSet::Scalar, active_instruction_set());
+
+    for(InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!is_supported(instruction_set))
+        {
+            EXPECT_THROW(set_instruction_set(instruction_set), std::runtime_error);
+        }
+    }
+}
+
+TEST_F(SimdTest, kernelsMatchScalarBitwise)
+{
+    for(InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!is_supported(instruction_set))
+        {
+            continue;
+        }
+        expect_matches_scalar<float>(instruction_set);
+        expect_matches_scalar<double>(instruction_set);
+        expect_matches_scalar<int32_t>(instruction_set);
+        expect_matches_scalar<int64_t>(instruction_set);
+    }
+}
+
+/**
+ * @brief a . b where every product is cancelled by its negation somewhere else in the
+ *        shuffled input except for 0.75 * 0.5, so the exact result is 0.375 while the
+ *        partial sums are many orders of magnitude larger.
+*/
+template<typename T>
+void expect_compensated_dot_is_accurate(InstructionSet instruction_set, T tolerance)
+{
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<T> dist(-1, 1);
+    for(size_t n : testSizes)
+    {
+        std::vector<T> a, b;
+        for(size_t i = 0; i < n / 2; ++i)
+        {
+            const T x = dist(rng) * T(1e4);
+            const T y = dist(rng);
+            a.insert(a.end(), {x, x});
+            b.insert(b.end(), {y, -y});
+        }
+        a.push_back(T(0.75));
+        b.push_back(T(0.5));
+
+        std::vector<size_t> order(a.size());
+        for(size_t i = 0; i < order.size(); ++i) { order[i] = i; }
+        std::shuffle(order.begin(), order.end(), rng);
+        std::vector<T> shuffled_a(a.size()), shuffled_b(b.size());
+        for(size_t i = 0; i < order.size(); ++i)
+        {
+            shuffled_a[i] = a[order[i]];
+            shuffled_b[i] = b[order[i]];
+        }
+
+        set_instruction_set(instruction_set);
+        const Compensated<T> result = dot_compensated(shuffled_a.data(), shuffled_b.data(), shuffled_a.size());
+        EXPECT_NEAR(0.375, result.value(), tolerance) << to_string(instruction_set) << " n=" << n;
+
+        const Compensated<T> generic = dot_compensated<T>(shuffled_a.data(), shuffled_b.data(), shuffled_a.size());
+        EXPECT_NEAR(0.375, generic.value(), tolerance) << " n=" << n;
+    }
+}
+
+TEST_F(SimdTest, compensatedDotIsAccurate)
+{
+    for(InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!is_supported(instruction_set))
+        {
+            continue;
+        }
+        expect_compensated_dot_is_accurate<float>(instruction_set, 1e-5f);
+        expect_compensated_dot_is_accurate<double>(instruction_set, 1e-13);
+
+        std::mt19937 rng(5);
+        const std::vector<int32_t> a = random_dot_values<int32_t>(1031, rng);
+        const std::vector<int32_t> b(1031, 3);
+        set_instruction_set(instruction_set);
+        EXPECT_EQ(dot_reproducible(a.data(), b.data(), a.size()), dot_compensated(a.data(), b.data(), a.size()).value());
+    }
+}
+
+/**
+ * @brief dot_accumulate<Acc> under instruction_set against a plain loop in Acc.
+*/
+template<typename T, typename Acc>
+void expect_accumulate_matches_loop(InstructionSet instruction_set, T low, T high)
+{
+    std::mt19937 rng(9);
+    for(size_t n : testSizes)
+    {
+        std::vector<T> a(n), b(n);
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            std::uniform_real_distribution<T> dist(low, high);
+            for(size_t i = 0; i < n; ++i) { a[i] = dist(rng); b[i] = dist(rng); }
+        }
+        else
+        {
+            std::uniform_int_distribution<int64_t> dist(low, high);
+            for(size_t i = 0; i < n; ++i) { a[i] = static_cast<T>(dist(rng)); b[i] = static_cast<T>(dist(rng)); }
+        }
+
+        Acc expected = Acc();
+        for(size_t i = 0; i < n; ++i)
+        {
+            expected += static_cast<Acc>(a[i]) * static_cast<Acc>(b[i]);
+        }
+
+        set_instruction_set(instruction_set);
+        const Acc actual = dot_accumulate<Acc>(a.data(), b.data(), n);
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            EXPECT_NEAR(expected, actual, 1e-12 * n) << to_string(instruction_set) << " n=" << n;
+        }
+        else
+        {
+            EXPECT_EQ(expected, actual) << to_string(instruction_set) << " n=" << n;
+        }
+    }
+}
+
+TEST_F(SimdTest, widenedDotMatchesLoop)
+{
+    for(InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!is_supported(instruction_set))
+        {
+            continue;
+        }
+        expect_accumulate_matches_loop<float, double>(instruction_set, -1.0f, 1.0f);
+        expect_accumulate_matches_loop<int8_t, int32_t>(instruction_set, -128, 127);
+        expect_accumulate_matches_loop<int32_t, int64_t>(instruction_set, -(1 << 26), 1 << 26);
+        expect_accumulate_matches_loop<double, double>(instruction_set, -1.0, 1.0);
+    }
+}
+
+/**
+ * @brief dot_accumulate<float> and sum_squared_difference over compact floats E
+ *        under instruction_set, against a loop over the widened values in double.
+*/
+template<typename E>
+void expect_compact_matches_loop(InstructionSet instruction_set)
+{
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for(size_t n : testSizes)
+    {
+        std::vector<E> a(n), b(n);
+        for(size_t i = 0; i < n; ++i) { a[i] = E::from_float(dist(rng)); b[i] = E::from_float(dist(rng)); }
+
+        double dot = 0.0;
+        double squared_difference = 0.0;
+        for(size_t i = 0; i < n; ++i)
+        {
+            const double x = a[i].to_float();
+            const double y = b[i].to_float();
+            dot += x * y;
+            squared_difference += (x - y) * (x - y);
+        }
+
+        set_instruction_set(instruction_set);
+        EXPECT_NEAR(dot, dot_accumulate<float>(a.data(), b.data(), n), 1e-6 * n) << to_string(instruction_set) << " n=" << n;
+        EXPECT_NEAR(squared_difference, sum_squared_difference(a.data(), b.data(), n), 1e-6 * n) << to_string(instruction_set) << " n=" << n;
+    }
+}
+
+TEST_F(SimdTest, compactDotMatchesLoop)
+{
+    std::mt19937 rng(19);
+    std::uniform_int_distribution<int> symmetric(-127, 127);
+    for(InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!is_supported(instruction_set))
+        {
+            continue;
+        }
+        expect_compact_matches_loop<Float16>(instruction_set);
+        expect_compact_matches_loop<BFloat16>(instruction_set);
+
+        for(size_t n : testSizes)
+        {
+            // all extremes, so every maddubs pair sum reaches 2 * 127 * 127
+            std::vector<int8_t> a(n), b(n), extreme_a(n, -127), extreme_b(n, -127);
+            for(size_t i = 0; i < n; ++i) { a[i] = static_cast<int8_t>(symmetric(rng)); b[i] = static_cast<int8_t>(symmetric(rng)); }
+
+            set_instruction_set(instruction_set);
+            EXPECT_EQ(dot_accumulate<int32_t>(a.data(), b.data(), n), dot_symmetric_int8(a.data(), b.data(), n)) << to_string(instruction_set) << " n=" << n;
+            EXPECT_EQ(static_cast<int32_t>(127 * 127 * n), dot_symmetric_int8(extreme_a.data(), extreme_b.data(), n)) << to_string(instruction_set) << " n=" << n;
+        }
+    }
+}
+
+TEST_F(SimdTest, scaledSquaresMatchLoop)
+{
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+    std::uniform_int_distribution<int> exponent(-1000, 1000);
+    for(InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!is_supported(instruction_set))
+        {
+            continue;
+        }
+        for(size_t n : testSizes)
+        {
+            // every size has values for all three accumulators
+            std::vector<double> x(n);
+            for(double& value : x) { value = std::ldexp(mantissa(rng), exponent(rng)); }
+
+            const ScaledSquares<double> expected = scaled_squares<double>(x.data(), n);
+            set_instruction_set(instruction_set);
+            const ScaledSquares<double> actual = scaled_squares(x.data(), n);
+
+            EXPECT_NEAR(expected.small, actual.small, 1e-14 * expected.small) << to_string(instruction_set) << " n=" << n;
+            EXPECT_NEAR(expected.medium, actual.medium, 1e-14 * expected.medium) << to_string(instruction_set) << " n=" << n;
+            EXPECT_NEAR(expected.big, actual.big, 1e-14 * expected.big) << to_string(instruction_set) << " n=" << n;
+            EXPECT_NEAR(expected.norm(), actual.norm(), 1e-14 * expected.norm()) << to_string(instruction_set) << " n=" << n;
+        }
+    }
+}
+
+template<typename T>
+void expect_distances_match_loop(InstructionSet instruction_set)
+{
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+    for(size_t n : testSizes)
+    {
+        std::vector<T> a(n);
+        std::vector<T> b(n);
+        for(size_t i = 0; i < n; ++i)
+        {
+            a[i] = static_cast<T>(dist(rng)) / (std::is_floating_point_v<T> ? T(7) : T(1));
+            b[i] = static_cast<T>(dist(rng));
+        }
+
+        const T abs_sum = sum_abs_difference<T>(a.data(), b.data(), n);
+        const T squared_sum = sum_squared_difference<T>(a.data(), b.data(), n);
+        const T largest = max_abs_difference<T>(a.data(), b.data(), n);
+        const CosineSums<T> sums = cosine_sums<T>(a.data(), b.data(), n);
+
+        set_instruction_set(instruction_set);
+        const CosineSums<T> actual_sums = cosine_sums(a.data(), b.data(), n);
+        EXPECT_NEAR(static_cast<double>(abs_sum), static_cast<double>(sum_abs_difference(a.data(), b.data(), n)), 1e-5 * static_cast<double>(abs_sum)) << to_string(instruction_set) << " n=" << n;
+        EXPECT_NEAR(static_cast<double>(squared_sum), static_cast<double>(sum_squared_difference(a.data(), b.data(), n)), 1e-5 * static_cast<double>(squared_sum)) << to_string(instruction_set) << " n=" << n;
+        EXPECT_EQ(largest, max_abs_difference(a.data(), b.data(), n)) << to_string(instruction_set) << " n=" << n;
+
+        // the dot product may cancel, so it is held to the scale of the squares
+        const double scale = 1e-5 * std::sqrt(static_cast<double>(sums.squares_a) * static_cast<double>(sums.squares_b));
+        EXPECT_NEAR(static_cast<double>(sums.dot), static_cast<double>(actual_sums.dot), scale) << to_string(instruction_set) << " n=" << n;
+        EXPECT_NEAR(static_cast<double>(sums.squares_a), static_cast<double>(actual_sums.squares_a), 1e-5 * static_cast<double>(sums.squares_a)) << to_string(instruction_set) << " n=" << n;
+        EXPECT_NEAR(static_cast<double>(sums.squares_b), static_cast<double>(actual_sums.squares_b), 1e-5 * static_cast<double>(sums.squares_b)) << to_string(instruction_set) << " n=" << n;
+        set_instruction_set(InstructionSet::Scalar);
+    }
+}
+
+TEST_F(SimdTest, distancesMatchLoop)
+{
+    for(InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!is_supported(instruction_set))
+        {
+            continue;
+        }
+        expect_distances_match_loop<float>(instruction_set);
+        expect_distances_match_loop<double>(instruction_set);
+        expect_distances_match_loop<int32_t>(instruction_set);
+        expect_distances_match_loop<int64_t>(instruction_set);
+    }
+}
+
+TEST_F(SimdTest, pq4ScanMatchesLoop)
+{
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<int> byte(0, 255);
+    const size_t num_blocks = 3;
+
+    // odd counts leave one subquantizer for the tail; 300 saturates
+    for(size_t num_subquantizers : {1u, 2u, 3u, 8u, 17u, 300u})
+    {
+        std::vector<uint8_t> codes(num_blocks * num_subquantizers * Pq4Constants::bytesPerSubquantizer);
+        std::vector<uint8_t> luts(num_subquantizers * 16);
+        for(uint8_t& code : codes) { code = static_cast<uint8_t>(byte(rng)); }
+        for(uint8_t& entry : luts) { entry = static_cast<uint8_t>(byte(rng)); }
+
+        std::vector<uint16_t> expected(num_blocks * Pq4Constants::blockSize);
+        for(size_t block = 0; block < num_blocks; ++block)
+        {
+            for(size_t j = 0; j < Pq4Constants::blockSize; ++j)
+            {
+                uint32_t sum = 0;
+                for(size_t s = 0; s < num_subquantizers; ++s)
+                {
+                    const uint8_t packed = codes[(block * num_subquantizers + s) * Pq4Constants::bytesPerSubquantizer + j % 16];
+                    sum += luts[s * 16 + (j < 16 ? packed & 0x0F : packed >> 4)];
+                }
+                expected[block * Pq4Constants::blockSize + j] = static_cast<uint16_t>(std::min<uint32_t>(sum, 65535));
+            }
+        }
+
+        for(InstructionSet instruction_set : allInstructionSets)
+        {
+            if(!is_supported(instruction_set))
+            {
+                continue;
+            }
+            set_instruction_set(instruction_set);
+            std::vector<uint16_t> actual(expected.size());
+            pq4_scan(codes.data(), num_blocks, num_subquantizers, luts.data(), actual.data());
+            EXPECT_TRUE(actual == expected) << to_string(instruction_set) << " subquantizers=" << num_subquantizers;
+        }
+        set_instruction_set(InstructionSet::Scalar);
+    }
+}
+
+TEST_F(SimdTest, bitKernelsMatchLoop)
+{
+    std::mt19937_64 rng(29);
+    for(uint64_t x : {uint64_t(0), uint64_t(1), ~uint64_t(0), uint64_t(0x8000000000000001), rng()})
+    {
+        uint64_t expected = 0;
+        for(size_t bit = 0; bit < 64; ++bit)
+        {
+            expected += (x >> bit) & 1;
+        }
+        EXPECT_EQ(expected, popcount(x));
+    }
+
+    for(size_t n : testSizes)
+    {
+        // three rows of n words, one row apart plus a gap
+        const size_t ld = n + 3;
+        std::vector<uint64_t> rows(3 * ld), x(n);
+        for(uint64_t& word : rows) { word = rng(); }
+        for(uint64_t& word : x) { word = rng(); }
+
+        std::vector<uint32_t> expected_rows(3);
+        for(size_t r = 0; r < 3; ++r)
+        {
+            for(size_t i = 0; i < n; ++i)
+            {
+                expected_rows[r] += static_cast<uint32_t>(popcount(rows[r * ld + i] ^ x[i]));
+            }
+        }
+        uint64_t both = 0;
+        uint64_t either = 0;
+        for(size_t i = 0; i < n; ++i)
+        {
+            both += popcount(rows[i] & x[i]);
+            either += popcount(rows[i] | x[i]);
+        }
+
+        for(InstructionSet instruction_set : allInstructionSets)
+        {
+            if(!is_supported(instruction_set))
+            {
+                continue;
+            }
+            set_instruction_set(instruction_set);
+            EXPECT_EQ(expected_rows[0], hamming_distance(rows.data(), x.data(), n)) << to_string(instruction_set) << " n=" << n;
+
+            const BitCounts counts = bit_counts(rows.data(), x.data(), n);
+            EXPECT_EQ(both, counts.both) << to_string(instruction_set) << " n=" << n;
+            EXPECT_EQ(either, counts.either) << to_string(instruction_set) << " n=" << n;
+
+            std::vector<uint32_t> actual_rows(3);
+            hamming_distance_rows(rows.data(), ld, 3, x.data(), n, actual_rows.data());
+            EXPECT_TRUE(actual_rows == expected_rows) << to_string(instruction_set) << " n=" << n;
+        }
+        set_instruction_set(InstructionSet::Scalar);
+    }
+}
+
+TEST(ScaledSquaresTests, constants)
+{
+    using Squares = ScaledSquares<double>;
+    EXPECT_EQ(std::ldexp(1.0, -511), Squares::small_threshold);
+    EXPECT_EQ(std::ldexp(1.0, 486), Squares::big_threshold);
+    EXPECT_EQ(std::ldexp(1.0, 537), Squares::small_scale);
+    EXPECT_EQ(std::ldexp(1.0, -538), Squares::big_scale);
+
+    using FloatSquares = ScaledSquares<float>;
+    EXPECT_EQ(std::ldexp(1.0f, -63), FloatSquares::small_threshold);
+    EXPECT_EQ(std::ldexp(1.0f, 52), FloatSquares::big_threshold);
+    EXPECT_EQ(std::ldexp(1.0f, 75), FloatSquares::small_scale);
+    EXPECT_EQ(std::ldexp(1.0f, -76), FloatSquares::big_scale);
+}
+
+TEST(CompensatedTests, keepsTheErrorOfEachAddition)
+{
+    Compensated<float> sum{1.0f, 0.0f};
+    for(int i = 0; i < 1000; ++i)
+    {
+        sum += Compensated<float>{1e-8f, 0.0f};
+    }
+    EXPECT_EQ(1.0f, sum.sum);
+    EXPECT_NEAR(1e-5f, sum.error, 1e-10f);
+
+    Compensated<int64_t> integer{5, 0};
+    integer += Compensated<int64_t>{7, 0};
+    EXPECT_EQ(12, integer.value());
+}
+
+TEST_F(SimdTest, kernelsWorkInPlace)
+{
+    Vector<int> v{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    const Vector<int> expected{2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22};
+    int* data = &v[0];
+    add(data, data, data, v.dimensions());
+    EXPECT_TRUE(v == expected);
+}
+
+TEST_F(SimdTest, genericFallback)
+{
+    short a[] = {1, 2, 3};
+    short b[] = {4, 5, 6};
+    short out[3];
+    add(a, b, out, 3);
+    EXPECT_EQ(9, out[2]);
+    subtract(a, b, out, 3);
+    EXPECT_EQ(-3, out[0]);
+    scale(a, 2.5, 3);
+    EXPECT_EQ(7, a[2]);
+}
+
+TEST_F(SimdTest, vectorOperatorsMatchAcrossInstructionSets)
+{
+    Vector<int> v1(VectorConstants::maxDimensionsForSequentialArithmeticOps + 203, 7);
+    Vector<int> v2(VectorConstants::maxDimensionsForSequentialArithmeticOps + 203, -3);
+    v1[5] = 1 << 20;
+
+    set_instruction_set(InstructionSet::Scalar);
+    Vector<int> expected = v1 + v2;
+    Vector<int> expected_scaled(v1);
+    expected_scaled.scale(0.3);
+
+    for(InstructionSet instruction_set : allInstructionSets)
+    {
+        if(!is_supported(instruction_set))
+        {
+            continue;
+        }
+        set_instruction_set(instruction_set);
+        Vector<int> actual = v1 + v2;
+        Vector<int> actual_scaled(v1);
+        actual_scaled.scale(0.3);
+        EXPECT_TRUE(expected == actual) << to_string(instruction_set);
+        EXPECT_TRUE(expected_scaled == actual_scaled) << to_string(instruction_set);
+    }
+}
+
+} // simd
+} // vctr
+} // arondina
@@ -0,0 +1,85 @@
+#ifndef INCLUDED_ARONDINA_VCTR_TEST_HELPERS
+#define INCLUDED_ARONDINA_VCTR_TEST_HELPERS
+
+// vctr
+#include "execution_policy.h"
+#include "matrix.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace arondina
+{
+namespace vctr
+{
+
+/**
+ * @brief Every instruction set; tests skip the ones the host does not support.
+*/
+inline const simd::InstructionSet allInstructionSets[] = {
+    simd::InstructionSet::Scalar,
+    simd::InstructionSet::SSE2,
+    simd::InstructionSet::AVX2,
+    simd::InstructionSet::AVX512
+};
+
+/**
+ * @brief Every execution mode, plus one that runs on pool.
+*/
+inline std::vector<ExecutionPolicy> all_policies(ThreadPool& pool)
+{
+    return {
+        execution::automatic
+        , execution::seq
+        , execution::simd
+        , execution::par
+        , execution::par_simd
+        , execution::on(pool)};
+}
+
+/**
+ * @brief A rows x cols matrix of small integers in [-8, 8], which keep every
+ *        partial sum of a product exact in float and double.
+*/
+template<typename T>
+Matrix<T> random_matrix(size_t rows, size_t cols, std::mt19937& rng, size_t leading_dimension = 0)
+{
+    Matrix<T> m(rows, cols, T(0), std::max(cols, leading_dimension));
+    std::uniform_int_distribution<int> dist(-8, 8);
+    for(size_t i = 0; i < rows; ++i)
+    {
+        for(size_t j = 0; j < cols; ++j)
+        {
+            m(i, j) = T(dist(rng));
+        }
+    }
+    return m;
+}
+
+/**
+ * @brief A rows x cols matrix uniform in [-1, 1).
+*/
+template<typename T>
+Matrix<T> random_rows(size_t rows, size_t cols, std::mt19937& rng)
+{
+    std::uniform_real_distribution<T> dist(T(-1), T(1));
+    Matrix<T> m(rows, cols, T(0));
+    for(size_t i = 0; i < rows; ++i)
+    {
+        for(size_t j = 0; j < cols; ++j)
+        {
+            m(i, j) = dist(rng);
+        }
+    }
+    return m;
+}
+
+} // vctr
+} // arondina
+
+#endif
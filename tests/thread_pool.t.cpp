@@ -0,0 +1,181 @@
+#include "thread_pool.h"
+
+// vctr
+#include "parallel.h"
+#include "vector.h"
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+class ThreadPoolTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        configure_thread_pool(ThreadPoolOptions());
+    }
+};
+
+TEST_F(ThreadPoolTest, size)
+{
+    ThreadPool pool(ThreadPoolOptions{3, false});
+    EXPECT_EQ(3u, pool.size());
+
+    ThreadPool hardware;
+    EXPECT_EQ(std::max<size_t>(1, std::thread::hardware_concurrency()), hardware.size());
+}
+
+TEST_F(ThreadPoolTest, runsEveryIndexOnce)
+{
+    ThreadPool pool(ThreadPoolOptions{4, false});
+
+    for(size_t count : {0u, 1u, 2u, 3u, 7u, 64u, 1000u})
+    {
+        std::vector<std::atomic<int>> hits(count);
+        pool.run(count, [&hits](size_t index) { ++hits[index]; });
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            EXPECT_EQ(1, hits[i].load()) << "count " << count << " index " << i;
+        }
+    }
+}
+
+TEST_F(ThreadPoolTest, stealsFromSlowShares)
+{
+    ThreadPool pool(ThreadPoolOptions{4, false});
+
+    // the first quarter of the indices is slow, so the other threads have to steal it
+    std::vector<std::atomic<int>> hits(64);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    pool.run(hits.size(), [&](size_t index) {
+        if(index < 16)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        ++hits[index];
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    });
+
+    for(const std::atomic<int>& hit : hits)
+    {
+        EXPECT_EQ(1, hit.load());
+    }
+    EXPECT_GT(threads.size(), 1u);
+}
+
+TEST_F(ThreadPoolTest, reusedAcrossJobs)
+{
+    ThreadPool pool(ThreadPoolOptions{4, true});
+
+    std::atomic<size_t> sum{0};
+    for(size_t job = 0; job < 200; ++job)
+    {
+        pool.run(100, [&sum](size_t index) { sum += index; });
+    }
+    EXPECT_EQ(200u * 4950u, sum.load());
+}
+
+TEST_F(ThreadPoolTest, rethrowsTaskException)
+{
+    ThreadPool pool(ThreadPoolOptions{4, false});
+
+    std::atomic<int> ran{0};
+    EXPECT_THROW(
+        pool.run(100, [&ran](size_t index) {
+            ++ran;
+            if(index == 37)
+            {
+                throw std::runtime_error("task failed.");
+            }
+        })
+        , std::runtime_error);
+    EXPECT_EQ(100, ran.load());
+
+    // the pool is still usable afterwards
+    std::atomic<int> after{0};
+    pool.run(10, [&after](size_t) { ++after; });
+    EXPECT_EQ(10, after.load());
+}
+
+TEST_F(ThreadPoolTest, nestedRunExecutesInline)
+{
+    ThreadPool pool(ThreadPoolOptions{4, false});
+
+    std::atomic<int> inner{0};
+    pool.run(8, [&pool, &inner](size_t) {
+        pool.run(8, [&inner](size_t) { ++inner; });
+    });
+    EXPECT_EQ(64, inner.load());
+}
+
+TEST_F(ThreadPoolTest, concurrentSubmitters)
+{
+    ThreadPool pool(ThreadPoolOptions{4, false});
+
+    std::atomic<size_t> sum{0};
+    auto submit = [&pool, &sum] {
+        for(size_t job = 0; job < 50; ++job)
+        {
+            pool.run(100, [&sum](size_t index) { sum += index; });
+        }
+    };
+    std::thread other(submit);
+    submit();
+    other.join();
+
+    EXPECT_EQ(100u * 4950u, sum.load());
+}
+
+TEST_F(ThreadPoolTest, configureDefaultPool)
+{
+    configure_thread_pool(ThreadPoolOptions{3, false});
+    EXPECT_EQ(3u, default_thread_pool().size());
+
+    std::vector<int> hits(10000, 0);
+    parallel_for_blocks(hits.size(), [&hits](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; ++i)
+        {
+            ++hits[i];
+        }
+    });
+    for(int hit : hits)
+    {
+        EXPECT_EQ(1, hit);
+    }
+}
+
+TEST_F(ThreadPoolTest, vectorKernelsOnPool)
+{
+    configure_thread_pool(ThreadPoolOptions{4, false});
+
+    const size_t dimensions = VectorConstants::maxDimensionsForSequentialDotProduct * 10 + 17;
+    Vector<double> v1(dimensions, 2.0);
+    Vector<double> v2(dimensions, 0.5);
+
+    EXPECT_EQ(static_cast<double>(dimensions), dot_product(v1, v2));
+    EXPECT_DOUBLE_EQ(std::sqrt(4.0 * dimensions), v1.magnitude());
+
+    Vector<double> sum = v1 + v2;
+    EXPECT_EQ(2.5, sum[dimensions - 1]);
+}
+
+} // vctr
+} // arondina
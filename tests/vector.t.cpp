@@ -4,7 +4,9 @@
 
 // std
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 
 // gtest
@@ -236,6 +238,197 @@ TEST(VectorTests, subtractVectorsThrowsUnequalSizes)
     , std::runtime_error);
 }
 
+TEST(VectorTests, addAssign)
+{
+    Vector<int> v1{7, 8, 9, 12};
+    Vector<int> v2{2, 3, 4, 14};
+    const int* buffer = v1.data();
+
+    v1 += v2;
+    Vector<int> expected{9, 11, 13, 26};
+
+    EXPECT_TRUE(expected == v1);
+    EXPECT_EQ(buffer, v1.data());
+}
+
+TEST(VectorTests, addAssignParallel)
+{
+    Vector<int> v1(VectorConstants::maxDimensionsForSequentialArithmeticOps + 200, 3);
+    Vector<int> v2(VectorConstants::maxDimensionsForSequentialArithmeticOps + 200, 1);
+
+    v1 += v2;
+    Vector<int> expected(VectorConstants::maxDimensionsForSequentialArithmeticOps + 200, 4);
+
+    EXPECT_TRUE(expected == v1);
+}
+
+TEST(VectorTests, addAssignExpression)
+{
+    Vector<int> v1{1, 2, 3};
+    Vector<int> v2{1, 1, 1};
+
+    v1 += v2 * 2 - v1;
+    Vector<int> expected{2, 2, 2};
+
+    EXPECT_TRUE(expected == v1);
+}
+
+TEST(VectorTests, subtractAssign)
+{
+    Vector<int> v1{7, 3, 9, 12};
+    Vector<int> v2{2, 8, 4, 17};
+
+    v1 -= v2;
+    Vector<int> expected{5, -5, 5, -5};
+
+    EXPECT_TRUE(expected == v1);
+}
+
+TEST(VectorTests, compoundAssignThrowsUnequalSizes)
+{
+    Vector<int> v1{7, 8, 9, 12};
+    Vector<int> v2{2, 3, 4, 14, 7};
+
+    EXPECT_THROW({
+        try
+        {
+            v1 += v2;
+        }
+        catch(const std::runtime_error& e)
+        {
+            EXPECT_STREQ("unequal vector sizes.", e.what());
+            throw;
+        }
+    }
+    , std::runtime_error);
+    EXPECT_THROW(v1 -= v2, std::runtime_error);
+    EXPECT_THROW(v1 *= v2, std::runtime_error);
+    EXPECT_THROW(v1 /= v2, std::runtime_error);
+}
+
+TEST(VectorTests, multiplyAssignElementwise)
+{
+    Vector<double> v1{1.0, 2.0, 3.0};
+    Vector<double> v2{4.0, 0.5, -1.0};
+
+    v1 *= v2;
+    Vector<double> expected{4.0, 1.0, -3.0};
+
+    EXPECT_TRUE(expected == v1);
+}
+
+TEST(VectorTests, divideAssignElementwise)
+{
+    Vector<int> v1{8, 9, -10};
+    Vector<int> v2{2, 3, 5};
+
+    v1 /= v2;
+    Vector<int> expected{4, 3, -2};
+
+    EXPECT_TRUE(expected == v1);
+}
+
+TEST(VectorTests, multiplyAndDivideAssignScalar)
+{
+    Vector<int> v1{1, 2, 3};
+    v1 *= 3;
+    EXPECT_TRUE((Vector<int>{3, 6, 9}) == v1);
+
+    v1 *= 0.5;
+    EXPECT_TRUE((Vector<int>{1, 3, 4}) == v1);
+
+    v1 /= 2;
+    EXPECT_TRUE((Vector<int>{0, 1, 2}) == v1);
+}
+
+TEST(VectorTests, axpy)
+{
+    Vector<double> x{1.0, 2.0, 3.0};
+    Vector<double> y{10.0, 20.0, 30.0};
+
+    axpy(2.0, x, y);
+    Vector<double> expected{12.0, 24.0, 36.0};
+
+    EXPECT_TRUE(expected == y);
+}
+
+TEST(VectorTests, axpyParallel)
+{
+    Vector<float> x(VectorConstants::maxDimensionsForSequentialArithmeticOps + 213, 2.0f);
+    Vector<float> y(VectorConstants::maxDimensionsForSequentialArithmeticOps + 213, 1.0f);
+
+    axpy(0.5f, x, y);
+    Vector<float> expected(VectorConstants::maxDimensionsForSequentialArithmeticOps + 213, 2.0f);
+
+    EXPECT_TRUE(expected == y);
+}
+
+TEST(VectorTests, axpby)
+{
+    Vector<int> x{1, 2, 3};
+    Vector<int> y{10, 20, 30};
+    const int* buffer = y.data();
+
+    axpby(2, x, -1, y);
+    Vector<int> expected{-8, -16, -24};
+
+    EXPECT_TRUE(expected == y);
+    EXPECT_EQ(buffer, y.data());
+}
+
+TEST(VectorTests, axpyThrowsUnequalSizes)
+{
+    Vector<int> x{1, 2, 3};
+    Vector<int> y{1, 2};
+
+    EXPECT_THROW(axpy(1, x, y), std::runtime_error);
+    EXPECT_THROW(axpby(1, x, 1, y), std::runtime_error);
+}
+
+TEST(VectorTests, alignedAndPadded)
+{
+    for(size_t dimensions : {1u, 15u, 16u, 17u, 1000u, 1003u})
+    {
+        Vector<float> v(dimensions, 1.0f);
+
+        EXPECT_TRUE(v.is_aligned());
+        EXPECT_EQ(0u, v.padded_dimensions() % 16);
+        EXPECT_GE(v.padded_dimensions(), dimensions);
+        EXPECT_LT(v.padded_dimensions() - dimensions, 16u);
+        for(size_t i = dimensions; i < v.padded_dimensions(); ++i)
+        {
+            EXPECT_EQ(0.0f, v.data()[i]);
+        }
+    }
+
+    Vector<double> empty(0);
+    EXPECT_EQ(0u, empty.padded_dimensions());
+}
+
+TEST(VectorTests, paddingStaysZero)
+{
+    const size_t dimensions = VectorConstants::maxDimensionsForSequentialArithmeticOps + 3;
+    Vector<double> v1(dimensions, 1.0);
+    Vector<double> v2(dimensions, 2.0);
+
+    Vector<double> sum = v1 + v2;
+    sum -= v1;
+    sum.scale(std::numeric_limits<double>::infinity());
+    Vector<double> small{1.0, 2.0, 3.0};
+    small.scale(std::numeric_limits<double>::quiet_NaN());
+    small = small - small;
+
+    EXPECT_TRUE(std::isinf(sum[dimensions - 1]));
+    for(size_t i = dimensions; i < sum.padded_dimensions(); ++i)
+    {
+        EXPECT_EQ(0.0, sum.data()[i]);
+    }
+    for(size_t i = small.dimensions(); i < small.padded_dimensions(); ++i)
+    {
+        EXPECT_EQ(0.0, small.data()[i]);
+    }
+}
+
 TEST(VectorTests, dotProduct)
 {
     Vector<int> v1{7, 3, 9, 12};
@@ -295,6 +488,47 @@ TEST(VectorTests, dotProductEmptyVectors)
     , std::runtime_error);
 }
 
+TEST(VectorTests, dotProductWideAccumulator)
+{
+    // every product overflows int32 on its own
+    const size_t dimensions = VectorConstants::maxDimensionsForSequentialDotProduct + 200;
+    Vector<int32_t> v1(dimensions, 50'000);
+    Vector<int32_t> v2(dimensions, -60'000);
+    const int64_t expected = -3'000'000'000LL * static_cast<int64_t>(dimensions);
+
+    EXPECT_EQ(expected, dot_product<int64_t>(v1, v2));
+    EXPECT_EQ(expected, dot_product<int64_t>(execution::seq, v1, v2));
+    EXPECT_EQ(expected, dot_product<wide_accumulator_t<int32_t>>(execution::par.reproducible(), v1, v2));
+
+    Vector<int8_t> small1(1000, int8_t(-128));
+    Vector<int8_t> small2(1000, int8_t(127));
+    EXPECT_EQ(-128 * 127 * 1000, dot_product<int32_t>(small1, small2));
+}
+
+TEST(VectorTests, dotProductDoubleAccumulatorForFloat)
+{
+    // 0.1f summed two million times drifts far in float
+    Vector<float> v1(2'000'000, 0.1f);
+    Vector<float> v2(2'000'000, 1.0f);
+    const double expected = 2'000'000 * static_cast<double>(0.1f);
+
+    const double result = dot_product<double>(v1, v2);
+    EXPECT_NEAR(expected, result, 1e-9 * expected);
+    EXPECT_NEAR(expected, dot_product<double>(execution::seq, v1, v2), 1e-9 * expected);
+    EXPECT_GT(std::abs(expected - dot_product(v1, v2)), 1e-6 * expected);
+}
+
+TEST(VectorTests, magnitudeWideAccumulator)
+{
+    // squares overflow int32
+    Vector<int32_t> v1(10'000, 100'000);
+    EXPECT_EQ(10'000'000.0, v1.magnitude());
+
+    Vector<float> v2(4'000'000, 0.5f);
+    EXPECT_DOUBLE_EQ(1000.0, v2.magnitude());
+    EXPECT_DOUBLE_EQ(v2.magnitude<double>(execution::seq), v2.magnitude());
+}
+
 TEST(VectorTests, magnitudeTwoDimensions)
 {
     Vector<int> v1{3, 4};
@@ -324,6 +558,107 @@ TEST(VectorTests, magnitudeParallel)
     EXPECT_EQ(80, v1.magnitude());
 }
 
+TEST(VectorTests, norm2NeitherOverflowsNorUnderflows)
+{
+    Vector<double> huge{3e200, 4e200};
+    EXPECT_TRUE(std::isinf(huge.magnitude()));
+    EXPECT_DOUBLE_EQ(5e200, huge.norm2());
+
+    Vector<double> tiny{3e-200, 4e-200};
+    EXPECT_EQ(0.0, tiny.magnitude());
+    EXPECT_DOUBLE_EQ(5e-200, tiny.norm2());
+
+    Vector<double> mixed{3e-200, 4.0, 3.0};
+    EXPECT_DOUBLE_EQ(5.0, mixed.norm2());
+
+    Vector<float> huge_float{3e30f, 4e30f};
+    EXPECT_NEAR(5e30, huge_float.norm2(), 1e24);
+}
+
+TEST(VectorTests, norm2Parallel)
+{
+    const size_t dimensions = VectorConstants::maxDimensionsForSequentialDotProduct * 4 + 3;
+    Vector<double> v(dimensions, 1e300);
+    v[7] = 1e-300;
+    v[dimensions - 1] = 2.0;
+    const double expected = 1e300 * std::sqrt(static_cast<double>(dimensions - 2));
+
+    EXPECT_NEAR(expected, v.norm2(), 1e-13 * expected);
+    EXPECT_NEAR(expected, v.norm2(execution::par), 1e-13 * expected);
+    EXPECT_NEAR(expected, v.norm2(execution::seq), 1e-13 * expected);
+
+    Vector<int> ints(6400, 1);
+    EXPECT_EQ(80.0, ints.norm2(execution::par_simd));
+}
+
+TEST(VectorTests, norm2PropagatesInfAndNaN)
+{
+    Vector<double> v(100, 1.0);
+    v[50] = std::numeric_limits<double>::infinity();
+    EXPECT_TRUE(std::isinf(v.norm2()));
+
+    v[50] = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_TRUE(std::isnan(v.norm2()));
+}
+
+TEST(VectorTests, normalize)
+{
+    Vector<double> v{3.0, 4.0};
+    const double* buffer = v.data();
+
+    EXPECT_EQ(5.0, v.normalize());
+    EXPECT_EQ(buffer, v.data());
+    EXPECT_DOUBLE_EQ(0.6, v[0]);
+    EXPECT_DOUBLE_EQ(0.8, v[1]);
+    EXPECT_DOUBLE_EQ(1.0, v.magnitude());
+
+    Vector<double> huge{3e200, 4e200};
+    huge.normalize();
+    EXPECT_DOUBLE_EQ(0.6, huge[0]);
+}
+
+TEST(VectorTests, normalizeParallel)
+{
+    const size_t dimensions = VectorConstants::maxDimensionsForSequentialArithmeticOps * 3 + 5;
+    for(const ExecutionPolicy& policy : {execution::seq, execution::par, execution::par_simd})
+    {
+        Vector<float> v(dimensions, 2.0f);
+        v.normalize(policy);
+        EXPECT_NEAR(1.0, v.norm2(), 1e-6);
+        EXPECT_FLOAT_EQ(static_cast<float>(1.0 / std::sqrt(static_cast<double>(dimensions))), v[dimensions - 1]);
+        EXPECT_EQ(0.0f, v.data()[v.padded_dimensions() - 1]);
+    }
+}
+
+TEST(VectorTests, normalizeSubnormal)
+{
+    // 1 / norm overflows to inf for a norm this small
+    for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd})
+    {
+        Vector<double> v(8, 1e-320);
+        EXPECT_GT(v.normalize(policy), 0.0);
+        for(size_t i = 0; i < v.dimensions(); ++i)
+        {
+            EXPECT_NEAR(1.0 / std::sqrt(8.0), v[i], 1e-3);
+        }
+    }
+}
+
+TEST(VectorTests, normalizeLeavesZeroVector)
+{
+    Vector<double> v(5, 0.0);
+    EXPECT_EQ(0.0, v.normalize());
+    EXPECT_TRUE(v == Vector<double>(5, 0.0));
+}
+
+TEST(VectorTests, unitVector)
+{
+    const Vector<double> v{2.0, 0.0, 0.0};
+    Vector<double> unit = unit_vector(v);
+    EXPECT_TRUE(unit == Vector<double>({1.0, 0.0, 0.0}));
+    EXPECT_EQ(2.0, v[0]);
+}
+
 TEST(VectorTests, compareVectors_SameElementsDifferentOrder)
 {
     Vector<int> v1{1, 2, 3, 4};
@@ -0,0 +1,166 @@
+#include "vector_expression.h"
+
+// vctr
+#include "vector.h"
+
+// std
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+class VectorExpressionTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        reset_calibration();
+    }
+};
+
+TEST_F(VectorExpressionTest, operatorsBuildExpressions)
+{
+    Vector<int> a{1, 2, 3};
+    Vector<int> b{4, 5, 6};
+
+    static_assert(is_vector_expression_v<decltype(a + b)>);
+    static_assert(is_vector_expression_v<decltype(a - b * 2)>);
+    static_assert(is_vector_expression_v<decltype(-(a + b))>);
+    static_assert(!is_vector_expression_v<Vector<int>>);
+    static_assert(is_vector_operand_v<Vector<int>>);
+
+    auto expr = a + b;
+    EXPECT_EQ(3, expr.dimensions());
+    EXPECT_EQ(9, expr[2]);
+}
+
+TEST_F(VectorExpressionTest, chainedExpression)
+{
+    Vector<int> a{1, 2, 3, 4};
+    Vector<int> b{10, 20, 30, 40};
+    Vector<int> c{1, 1, 2, 2};
+
+    Vector<int> result = a + b - c * 3;
+    Vector<int> expected{8, 19, 27, 38};
+    EXPECT_TRUE(expected == result);
+}
+
+TEST_F(VectorExpressionTest, scalarOnEitherSide)
+{
+    Vector<double> a{1.0, 2.0, 4.0};
+
+    Vector<double> left = 0.5 * a;
+    Vector<double> right = a * 0.5;
+    Vector<double> divided = a / 4.0;
+    Vector<double> expected{0.5, 1.0, 2.0};
+    EXPECT_TRUE(expected == left);
+    EXPECT_TRUE(expected == right);
+    EXPECT_TRUE((Vector<double>{0.25, 0.5, 1.0}) == divided);
+}
+
+TEST_F(VectorExpressionTest, scalarMatchesScale)
+{
+    Vector<int> a{7, -7, 100, 3};
+    Vector<int> scaled(a);
+    scaled.scale(0.3);
+
+    Vector<int> result = a * 0.3;
+    EXPECT_TRUE(scaled == result);
+}
+
+TEST_F(VectorExpressionTest, unaryExpressions)
+{
+    Vector<double> a{-4.0, 9.0, -16.0};
+
+    Vector<double> negated = -a;
+    Vector<double> roots = sqrt(abs(a));
+    Vector<double> combined = -(a + a) / 2.0;
+
+    EXPECT_TRUE((Vector<double>{4.0, -9.0, 16.0}) == negated);
+    EXPECT_TRUE((Vector<double>{2.0, 3.0, 4.0}) == roots);
+    EXPECT_TRUE((Vector<double>{4.0, -9.0, 16.0}) == combined);
+}
+
+TEST_F(VectorExpressionTest, unequalSizesThrowWhenBuilt)
+{
+    Vector<int> a{1, 2, 3};
+    Vector<int> b{1, 2};
+    Vector<int> c{1, 2, 3};
+
+    EXPECT_THROW({
+        try
+        {
+            (void)(a + c - b);
+        }
+        catch(const std::runtime_error& e)
+        {
+            EXPECT_STREQ("unequal vector sizes.", e.what());
+            throw;
+        }
+    }
+    , std::runtime_error);
+}
+
+TEST_F(VectorExpressionTest, assignmentReusesBuffer)
+{
+    Vector<int> a{1, 2, 3};
+    Vector<int> b{1, 1, 1};
+    const int* buffer = a.data();
+
+    a = a + b * 2;
+    EXPECT_EQ(buffer, a.data());
+    EXPECT_TRUE((Vector<int>{3, 4, 5}) == a);
+}
+
+TEST_F(VectorExpressionTest, assignmentResizes)
+{
+    Vector<int> a{1, 2};
+    Vector<int> b{1, 2, 3};
+
+    a = b + b;
+    EXPECT_EQ(3, a.dimensions());
+    EXPECT_TRUE((Vector<int>{2, 4, 6}) == a);
+}
+
+TEST_F(VectorExpressionTest, emptyExpression)
+{
+    Vector<int> a{};
+    Vector<int> b{};
+    Vector<int> result = a - b * 2;
+    EXPECT_EQ(0, result.dimensions());
+}
+
+TEST_F(VectorExpressionTest, parallelMatchesSequential)
+{
+    const size_t dimensions = 10007;
+    Vector<float> a(dimensions, 1.5f);
+    Vector<float> b(dimensions, 2.0f);
+    Vector<float> c(dimensions, -0.25f);
+    for(size_t i = 0; i < dimensions; ++i)
+    {
+        a[i] = float(i % 13);
+    }
+
+    set_max_dimensions_for_sequential(Operation::Arithmetic, ElementType::Float, std::numeric_limits<size_t>::max());
+    Vector<float> sequential = a + b - c * 4.0f;
+    Vector<float> sequential_sum = a + b;
+
+    set_max_dimensions_for_sequential(Operation::Arithmetic, ElementType::Float, 0);
+    Vector<float> parallel = a + b - c * 4.0f;
+    Vector<float> parallel_sum = a + b;
+
+    EXPECT_TRUE(sequential == parallel);
+    EXPECT_TRUE(sequential_sum == parallel_sum);
+    EXPECT_EQ(float(10006 % 13) + 3.0f, parallel[10006]);
+}
+
+} // vctr
+} // arondina
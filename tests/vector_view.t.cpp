@@ -0,0 +1,210 @@
+#include "vector.h"
+
+// vctr
+#include "matrix.h"
+#include "test_helpers.h"
+
+// std
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// gtest
+#include <gtest/gtest.h>
+
+namespace arondina
+{
+namespace vctr
+{
+
+TEST(VectorViewTests, sliceReadsAndWritesThrough)
+{
+    Vector<int> v{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    VectorView<int> middle = v.slice(2, 5);
+    EXPECT_EQ(5, middle.dimensions());
+    EXPECT_EQ(1, middle.stride());
+    EXPECT_TRUE(middle.is_contiguous());
+    EXPECT_EQ(2, middle[0]);
+    EXPECT_EQ(6, middle[4]);
+
+    middle[1] = 30;
+    EXPECT_EQ(30, v[3]);
+
+    VectorView<int> odd = v.slice(1, 5, 2);
+    EXPECT_FALSE(odd.is_contiguous());
+    EXPECT_EQ(9, odd[4]);
+    EXPECT_EQ(30, odd[1]);
+    EXPECT_EQ(7, odd.slice(1, 2, 2)[1]);
+
+    const Vector<int>& read_only = v;
+    VectorView<const int> tail = read_only.slice(7, 3);
+    static_assert(std::is_same_v<const int&, decltype(tail[0])>);
+    EXPECT_EQ(9, tail[2]);
+
+    VectorView<const int> converted = middle;
+    EXPECT_EQ(middle.data(), converted.data());
+    EXPECT_EQ(0, v.slice(10, 0).dimensions());
+}
+
+TEST(VectorViewTests, matrixRowsAndColumns)
+{
+    Matrix<double> m{{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+
+    EXPECT_EQ(3, m.row(1).dimensions());
+    EXPECT_EQ(5.0, m.row(1)[1]);
+    EXPECT_EQ(2, m.col(2).dimensions());
+    EXPECT_EQ(m.leading_dimension(), m.col(2).stride());
+    EXPECT_EQ(6.0, m.col(2)[1]);
+
+    m.col(0) = m.col(1) + m.col(2);
+    EXPECT_EQ(5.0, m(0, 0));
+    EXPECT_EQ(11.0, m(1, 0));
+
+    m.row(1) *= 2.0;
+    EXPECT_EQ(22.0, m(1, 0));
+    EXPECT_EQ(12.0, m(1, 2));
+    EXPECT_EQ(2.0, m(0, 1));
+
+    const Matrix<double>& read_only = m;
+    const Vector<double> copy(read_only.col(1));
+    EXPECT_EQ(2, copy.dimensions());
+    EXPECT_EQ(10.0, copy[1]);
+}
+
+TEST(VectorViewTests, expressionsMixViewsAndVectors)
+{
+    std::mt19937 rng(5);
+    const Matrix<double> m = random_rows<double>(300, 200, rng);
+    Vector<double> v(200, 0.5);
+
+    for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd})
+    {
+        const Vector<double> rows = add(policy, m.row(3), m.row(7));
+        const Vector<double> mixed = subtract(policy, m.row(3), v);
+        const Vector<double> columns(policy, m.col(4) * 2.0 - m.col(9));
+        for(size_t i = 0; i < 200; ++i)
+        {
+            ASSERT_EQ(m(3, i) + m(7, i), rows[i]);
+            ASSERT_EQ(m(3, i) - 0.5, mixed[i]);
+        }
+        for(size_t i = 0; i < 300; ++i)
+        {
+            ASSERT_EQ(m(i, 4) * 2.0 - m(i, 9), columns[i]);
+        }
+    }
+
+    Vector<double> sum(200, 0.0);
+    sum += m.row(0);
+    sum -= m.row(1);
+    sum = sum + m.row(2).slice(0, 200);
+    for(size_t i = 0; i < 200; ++i)
+    {
+        ASSERT_EQ(m(0, i) - m(1, i) + m(2, i), sum[i]);
+    }
+
+    Matrix<double> n = m;
+    n.col(0) += n.col(1);
+    n.row(0).slice(0, 100, 2) -= v.slice(0, 100);
+    EXPECT_EQ(m(5, 0) + m(5, 1), n(5, 0));
+    EXPECT_EQ(m(0, 0) + m(0, 1) - 0.5, n(0, 0));
+    EXPECT_EQ(m(0, 1), n(0, 1));
+    EXPECT_EQ(m(0, 198) - 0.5, n(0, 198));
+}
+
+TEST(VectorViewTests, reductionsMatchCopies)
+{
+    std::mt19937 rng(9);
+    const Matrix<double> m = random_rows<double>(1000, 70, rng);
+    const Vector<double> row(m.row(11));
+    const Vector<double> other_row(m.row(12));
+    const Vector<double> col(m.col(5));
+    const Vector<double> other_col(m.col(6));
+
+    for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par_simd, execution::reproducible, execution::compensated})
+    {
+        EXPECT_EQ(dot_product(policy, row, other_row), dot_product(policy, m.row(11), m.row(12)));
+        EXPECT_EQ(dot_product(policy, row, other_row), dot_product(policy, m.row(11), other_row));
+        EXPECT_EQ(row.magnitude(policy), m.row(11).magnitude(policy));
+        EXPECT_EQ(row.norm2(policy), m.row(11).norm2(policy));
+
+        if(policy.reduction() == ExecutionPolicy::Reduction::Fast)
+        {
+            // columns are summed in place by a strided loop, in a different order than the kernels
+            EXPECT_NEAR(dot_product(policy, col, other_col), dot_product(policy, m.col(5), m.col(6)), 1e-12);
+            EXPECT_NEAR(dot_product(policy, col, other_col), dot_product(policy, col, m.col(6)), 1e-12);
+            EXPECT_NEAR(col.magnitude(policy), m.col(5).magnitude(policy), 1e-12);
+        }
+        else
+        {
+            EXPECT_EQ(dot_product(policy, col, other_col), dot_product(policy, m.col(5), m.col(6)));
+            EXPECT_EQ(dot_product(policy, col, other_col), dot_product(policy, col, m.col(6)));
+            EXPECT_EQ(col.magnitude(policy), m.col(5).magnitude(policy));
+        }
+        EXPECT_NEAR(col.norm2(policy), m.col(5).norm2(policy), 1e-12);
+    }
+    EXPECT_EQ(dot_product(execution::seq, col, other_col), dot_product(execution::seq, m.col(5), m.col(6)));
+    EXPECT_EQ(col.magnitude(execution::seq), m.col(5).magnitude(execution::seq));
+    EXPECT_EQ(col.norm2(execution::seq), m.col(5).norm2(execution::seq));
+    EXPECT_EQ(dot_product<long double>(col, other_col), dot_product<long double>(m.col(5), m.col(6)));
+}
+
+TEST(VectorViewTests, stridedReductionsAreExactForIntegers)
+{
+    Matrix<int32_t> m(5000, 3, 0);
+    int64_t expected_dot = 0;
+    int64_t expected_squares = 0;
+    for(size_t r = 0; r < m.num_rows(); ++r)
+    {
+        m(r, 0) = static_cast<int32_t>(r % 101) - 50;
+        m(r, 2) = static_cast<int32_t>(r % 37) - 18;
+        expected_dot += static_cast<int64_t>(m(r, 0)) * m(r, 2);
+        expected_squares += static_cast<int64_t>(m(r, 0)) * m(r, 0);
+    }
+
+    for(const ExecutionPolicy& policy : {execution::seq, execution::simd, execution::par, execution::par_simd, execution::reproducible})
+    {
+        EXPECT_EQ(expected_dot, dot_product<int64_t>(policy, m.col(0), m.col(2)));
+        EXPECT_EQ(expected_dot, dot_product(policy, m.col(0), m.col(2)));
+        EXPECT_DOUBLE_EQ(std::sqrt(static_cast<double>(expected_squares)), m.col(0).magnitude(policy));
+        EXPECT_DOUBLE_EQ(std::sqrt(static_cast<double>(expected_squares)), m.col(0).norm2(policy));
+    }
+}
+
+TEST(VectorViewTests, wrapsStdVector)
+{
+    std::vector<int32_t> x{1, 2, 3, 4};
+    const std::vector<int32_t> y{5, 6, 7, 8};
+
+    EXPECT_EQ(70, dot_product(VectorView<int32_t>(x), VectorView<const int32_t>(y)));
+    EXPECT_EQ(70, dot_product<int64_t>(VectorView<const int32_t>(x), VectorView<const int32_t>(y)));
+
+    VectorView<int32_t> view(x);
+    view += VectorView<const int32_t>(y);
+    EXPECT_EQ(12, x[3]);
+    EXPECT_DOUBLE_EQ(std::sqrt(6.0 * 6.0 + 8.0 * 8.0), VectorView<const int32_t>(x).slice(0, 2).magnitude());
+}
+
+TEST(VectorViewTests, throwsOnBadShapes)
+{
+    Vector<double> v(10, 1.0);
+    Matrix<double> m(3, 4, 1.0);
+
+    EXPECT_THROW(v.slice(8, 3), std::runtime_error);
+    EXPECT_THROW(v.slice(0, 6, 2), std::runtime_error);
+    EXPECT_THROW(v.slice(0, 2, 0), std::runtime_error);
+    EXPECT_THROW(v.slice(0, 10)[10], std::runtime_error);
+    EXPECT_THROW(m.row(3), std::runtime_error);
+    EXPECT_THROW(m.col(4), std::runtime_error);
+
+    EXPECT_THROW(m.row(0) = m.col(0), std::runtime_error);
+    EXPECT_THROW(dot_product(m.row(0), v), std::runtime_error);
+    EXPECT_THROW(dot_product(v.slice(0, 0), v.slice(1, 0)), std::runtime_error);
+    EXPECT_THROW(m.col(0) + v, std::runtime_error);
+}
+
+} // vctr
+} // arondina